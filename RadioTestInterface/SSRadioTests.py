@@ -127,7 +127,9 @@ if __name__ == '__main__':
                                  [sg.Button('Send Test Data Packet Command', size=30)],
                                  [sg.Button('Send Test Remote Command', size=30)],
                                  [sg.Button('Send random-string packets', size=30)],
-                                 [sg.Button('Print Stats', size=30)]]
+                                 [sg.Button('Print Stats', size=30)],
+                                 [sg.Button('Print SPI Profile', size=30)],
+                                 [sg.Button('Print Latency', size=30)]]
                                  #[sg.Button('Send File via FTP', size=30)]]
 
     radio_test_layout = [[sg.Text('Tx Duration (Seconds)', size=22), sg.Push(),
@@ -475,6 +477,16 @@ if __name__ == '__main__':
                     statscmd = b'\xC0\x1E\xC0'
                     window2['output'].print(statscmd)
                     ser.write(statscmd)
+                elif event3 == "Print SPI Profile":
+                    window2['output'].print('SPI profile printed to debug')
+                    spiprofilecmd = b'\xC0\x20\xC0'
+                    window2['output'].print(spiprofilecmd)
+                    ser.write(spiprofilecmd)
+                elif event3 == "Print Latency":
+                    window2['output'].print('Latency histograms printed to debug')
+                    latencycmd = b'\xC0\x22\xC0'
+                    window2['output'].print(latencycmd)
+                    ser.write(latencycmd)
                 elif event == 'Modify Frequency':
                     window2['output'].print('Permanently changing to specified frequency')
                     newfreq = values['frequency'].encode('utf-8')
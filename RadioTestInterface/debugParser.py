@@ -7,6 +7,7 @@ from serial.tools import list_ports
 from datetime import datetime
 import os
 import argparse
+from eventlog import EventDecoder
 
 def main(args):
     sg.theme('Light Blue 2')
@@ -61,6 +62,7 @@ def main(args):
     window3['offset'].update('OFFSET: 0')
     window4['packet_count'].update('COUNT: 0')
     count = 0
+    decoder = EventDecoder()  # rssi, offset and CRC lines come from the radio's deferred log now
 
     # event loop
     while True:
@@ -78,10 +80,11 @@ def main(args):
                 while ser.in_waiting > 0:
                     serinput += ser.read()
                 if serinput != b"":
-                    window2['output'].print(serinput.decode('utf-8'))
-                    logfile.write(serinput.decode('utf-8').replace('\r\n', '\r'))
+                    text = decoder.feed(serinput.decode('utf-8'))
+                    window2['output'].print(text)
+                    logfile.write(text.replace('\r\n', '\r'))
                     # print(serinput)
-                    parsedinput = serinput.decode('utf-8').split('N: ')
+                    parsedinput = text.split('N: ')
                     for strings in parsedinput:
                         if strings.split(' ')[0] == 'rssi':
                             rssi_string = 'RSSI: ' + strings.split(' ')[1]
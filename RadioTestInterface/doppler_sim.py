@@ -1,4 +1,6 @@
 import serial
+import sys
+from math import tanh
 from time import sleep
 
 frequency1 = "433000000"
@@ -8,8 +10,24 @@ cmd = b'\xC0\x0D' + frequency1.encode('utf-8') + b'\x20' + frequency2.encode('ut
 
 cmd2 = b'\xC0\x0D'+ frequency2.encode('utf-8') + b'\x20' + frequency1.encode('utf-8') + b'\xC0'
 
+# python doppler_sim.py schedule
+# uploads one doppler schedule (command 0x21) for a made up 10 minute pass instead of toggling with 0x0D.
+# <tx base> <rx base> <t>,<tx offset>,<rx offset>;...   see doppler.h
+def pass_schedule(base=437175000, max_doppler=10000, duration=600, points=14):  # 14 keeps it under the 254 byte command body
+    table = []
+    for i in range(points):
+        t = i * duration // (points - 1)
+        doppler = int(max_doppler * tanh((duration / 2 - t) / (duration / 8)))
+        table.append("%d,%d,%d" % (t, -doppler, doppler))  # uplink is pre-compensated the other way
+    return b'\xC0\x21' + ("%d %d " % (base, base)).encode('utf-8') + ";".join(table).encode('utf-8') + b'\xC0'
+
 try:
     ser = serial.Serial('/dev/ttyUSB0', 19200, timeout=0, write_timeout=2)
+    if len(sys.argv) > 1 and sys.argv[1] == "schedule":
+        schedule = pass_schedule()
+        print(len(schedule), schedule)
+        ser.write(schedule)
+        quit()
     while(1):
         #print(cmd)
         ser.write(cmd)
@@ -20,5 +38,3 @@ try:
 except KeyboardInterrupt:
     print('exiting')
     quit()
-        
-
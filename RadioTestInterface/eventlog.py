@@ -0,0 +1,101 @@
+# eventlog.py - turns the radio's deferred log lines back into text
+#
+# The radio stores some of its log messages as (message number, micros, numbers) and prints them later as
+#   ~<id> <micros> <arg> <arg>      (hex)
+# The format strings are only in silversat_radio/eventlog.h (EVENT_LOG_MESSAGES), this reads them from there.
+# Everything that isn't an event line passes straight through.
+#
+# python eventlog.py capture.txt          decode a saved capture
+# python eventlog.py --port COM5          decode live from the debug port (57600)
+# some_program | python eventlog.py       or from stdin
+#
+# Decoded lines come out as "<seconds> N: <text>", so debugParser's "N: " parsing still works on them.
+
+import os
+import re
+import sys
+
+EVENTLOG_H = os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', 'silversat_radio', 'eventlog.h')
+
+
+def load_formats(path=EVENTLOG_H):
+    formats = []
+    with open(path) as header:
+        for line in header:
+            match = re.match(r'\s*X\((\w+),\s*"(.*)"\)', line)
+            if match:
+                formats.append(match.group(2))
+    return formats
+
+
+def signed(value):
+    return value - (1 << 32) if value & 0x80000000 else value
+
+
+def format_event(fmt, args):
+    args = list(args)
+
+    def field(match):
+        spec = match.group(1)
+        if spec == '%':
+            return '%'
+        value = args.pop(0) if args else 0
+        if spec in 'di':
+            return str(signed(value))
+        if spec == 'u':
+            return str(value)
+        if spec == 'x':
+            return '%x' % value
+        return '%X' % value
+
+    return re.sub(r'%([diuxX%])', field, fmt)
+
+
+class EventDecoder:
+    def __init__(self, path=EVENTLOG_H):
+        self.formats = load_formats(path)
+        self.partial = ''
+
+    def line(self, text):
+        fields = text.strip().split(' ')
+        if not fields[0].startswith('~'):
+            return text
+        try:
+            values = [int(f, 16) for f in [fields[0][1:]] + fields[1:]]
+        except ValueError:
+            return text
+        if len(values) < 2:
+            return text
+        event, micros, args = values[0], values[1], values[2:]
+        if event < len(self.formats):
+            message = format_event(self.formats[event], args)
+        else:
+            message = 'unknown event %d %s' % (event, ' '.join(str(signed(a)) for a in args))
+        return '%.6f N: %s\r\n' % (micros / 1e6, message)
+
+    # serial reads come in pieces, this keeps the end of an unfinished line for next time
+    def feed(self, text):
+        text = self.partial + text
+        lines = text.split('\n')
+        self.partial = lines.pop()
+        return ''.join(self.line(l + '\n') for l in lines)
+
+
+def main():
+    decoder = EventDecoder()
+    if len(sys.argv) > 2 and sys.argv[1] == '--port':
+        import serial
+        ser = serial.Serial(sys.argv[2], baudrate=57600, timeout=0.1)
+        try:
+            while True:
+                sys.stdout.write(decoder.feed(ser.read(256).decode('utf-8', errors='replace')))
+                sys.stdout.flush()
+        except KeyboardInterrupt:
+            return
+    source = open(sys.argv[1]) if len(sys.argv) > 1 else sys.stdin
+    for text in source:
+        sys.stdout.write(decoder.line(text))
+
+
+if __name__ == '__main__':
+    main()
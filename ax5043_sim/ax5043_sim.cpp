@@ -0,0 +1,500 @@
+/**
+ * @file ax5043_sim.cpp
+ * @brief software model of the AX5043 that sits behind ax_config::spi_transfer
+ */
+
+#include "ax5043_sim.h"
+
+#include <Arduino.h>
+#include "ax_reg.h"
+#include "ax_reg_values.h"
+#include "ax_fifo.h"
+
+AX5043Sim *AX5043Sim::slot[4]{};
+
+static const uint64_t no_frame = UINT64_MAX;
+
+AX5043Sim::AX5043Sim(uint32_t f_xtal) : _f_xtal(f_xtal)
+{
+    reset();
+}
+
+void AX5043Sim::reset()
+{
+    memset(_reg, 0, sizeof(_reg));
+    _reg[AX_REG_SCRATCH] = 0xC5;
+    _reg[AX_REG_PWRMODE] = AX_PWRMODE_REFEN | AX_PWRMODE_XOEN | AX_PWRMODE_POWERDOWN;
+
+    _fifo.clear();
+    _uncommitted.clear();
+    _fifo_errors = 0;
+    _tx_busy_until = 0;
+    _tx_active = false;
+    _in_frame = false;
+    _frame_start = no_frame;
+    _frame.clear();
+    _incoming.clear();
+}
+
+void AX5043Sim::connect(AX5043Sim &peer)
+{
+    _peer = &peer;
+    peer._peer = this;
+}
+
+uint32_t AX5043Sim::frequency_hz() const
+{
+    uint16_t reg = (_reg[AX_REG_PLLLOOP] & 0x80) ? AX_REG_FREQB : AX_REG_FREQA;
+    uint32_t value = ((uint32_t)_reg[reg] << 24) | ((uint32_t)_reg[reg + 1] << 16) |
+                     ((uint32_t)_reg[reg + 2] << 8) | _reg[reg + 3];
+
+    return (uint32_t)(((uint64_t)value * _f_xtal) >> 24);
+}
+
+uint32_t AX5043Sim::tx_bitrate() const
+{
+    uint32_t txrate = ((uint32_t)_reg[AX_REG_TXRATE] << 16) | ((uint32_t)_reg[AX_REG_TXRATE + 1] << 8) |
+                      _reg[AX_REG_TXRATE + 2];
+    uint32_t bitrate = (uint32_t)(((uint64_t)txrate * _f_xtal) >> 24);
+
+    return bitrate ? bitrate : 9600;
+}
+
+/**
+ * one SPI transaction.  The first byte (or two for a long access) is the address, and the status
+ * is shifted back out over it, the same as the chip.
+ */
+void AX5043Sim::spi_transfer(unsigned char *data, uint8_t length)
+{
+    // the processor waits for the bus if a DMA transfer still has it
+    if (host_clock_ns() < _bus_free_ns) host_clock_advance_ns(_bus_free_ns - host_clock_ns());
+    host_clock_advance_ns(spi_overhead_ns + (uint64_t)length * 8 * 1000000000 / sclk_hz);
+    service();
+    transfer(data, length);
+}
+
+/**
+ * a DMA transfer.  The bus is busy for the length of it, but the processor only pays for setting it up.
+ * The register/FIFO effects happen straight away rather than at the end, which is close enough, and done
+ * is called before returning (it can start another one, it goes on the bus after this one).
+ */
+void AX5043Sim::spi_transfer_async(unsigned char *data, uint16_t length, void (*done)(void))
+{
+    uint64_t start = host_clock_ns() > _bus_free_ns ? host_clock_ns() : _bus_free_ns;
+    _bus_free_ns = start + spi_overhead_ns + (uint64_t)length * 8 * 1000000000 / sclk_hz;
+    host_clock_advance_ns(dma_setup_ns);
+    service();
+    transfer(data, length);
+    if (done) done();
+}
+
+void AX5043Sim::transfer(unsigned char *data, uint16_t length)
+{
+    spi_transactions++;
+    spi_bytes += length;
+
+    if (length == 0) return;
+
+    uint16_t reg;
+    bool write = data[0] & 0x80;
+    int i;
+    if ((data[0] & 0x70) == 0x70)
+    { /* long access */
+        if (length < 2) return;
+        reg = ((data[0] & 0x0F) << 8) | data[1];
+        data[0] = powstat();
+        data[1] = fifostat();
+        i = 2;
+    }
+    else
+    { /* short access */
+        reg = data[0] & 0x7F;
+        data[0] = powstat();
+        i = 1;
+    }
+
+    for (; i < length; i++)
+    {
+        if (write) write_register(reg, data[i]);
+        else data[i] = read_register(reg);
+
+        if (reg != AX_REG_FIFODATA) reg = (reg + 1) & 0xFFF;
+    }
+}
+
+/**
+ * brings the transmitter and receiver up to the current time
+ */
+void AX5043Sim::service()
+{
+    uint64_t now = host_clock_ns();
+
+    // the peer only moves when its own spi is used, so catch its transmitter up too
+    advance_tx(now);
+    if (_peer) _peer->advance_tx(now);
+
+    while (!_incoming.empty() && _incoming.front().end_ns <= now)
+    {
+        deliver(_incoming.front());
+        _incoming.pop_front();
+    }
+}
+
+void AX5043Sim::advance_tx(uint64_t now)
+{
+    if (pwrmode() != AX_PWRMODE_FULLTX) return;
+
+    while (_tx_busy_until <= now)
+    {
+        if (chunk_size(0) == 0)
+        {
+            _tx_active = false; // out of data
+            break;
+        }
+        start_chunk();
+    }
+}
+
+/**
+ * takes the next committed chunk off the FIFO and puts it on the air
+ */
+void AX5043Sim::start_chunk()
+{
+    uint64_t start = _tx_active ? _tx_busy_until : host_clock_ns();
+    int size = chunk_size(0);
+    std::vector<uint8_t> chunk(_fifo.begin(), _fifo.begin() + size);
+    _fifo.erase(_fifo.begin(), _fifo.begin() + size);
+
+    uint32_t airtime_bytes = 0;
+    bool frame_end = false;
+    if (chunk[0] == AX_FIFO_CHUNK_REPEATDATA)
+    {
+        airtime_bytes = chunk[2];
+    }
+    else if (chunk[0] == AX_FIFO_CHUNK_DATA && size > 2)
+    {
+        uint8_t flags = chunk[2];
+        airtime_bytes = size - 3;
+
+        if (flags & AX_FIFO_TXDATA_PKTSTART)
+        {
+            _in_frame = true;
+            _frame.clear();
+        }
+        if (_in_frame) _frame.insert(_frame.end(), chunk.begin() + 3, chunk.end());
+        if (_in_frame && (flags & AX_FIFO_TXDATA_PKTEND))
+        {
+            frame_end = true;
+
+            // the chip appends the crc unless it's told not to
+            if ((_reg[AX_REG_FRAMING] & 0x70) != AX_FRAMING_CRCMODE_OFF && !(flags & AX_FIFO_TXDATA_NOCRC))
+            {
+                uint16_t crc = 0xFFFF;
+                for (uint8_t b : _frame)
+                {
+                    crc ^= b;
+                    for (int k = 0; k < 8; k++) crc = (crc & 1) ? (crc >> 1) ^ 0x8408 : (crc >> 1);
+                }
+                crc = ~crc;
+                _frame.push_back(crc & 0xFF);
+                _frame.push_back(crc >> 8);
+                airtime_bytes += 2;
+            }
+        }
+    }
+
+    if (_frame_start == no_frame) _frame_start = start; // the preamble is part of the frame on the air
+    _tx_busy_until = start + (uint64_t)airtime_bytes * 8 * 1000000000 / tx_bitrate();
+    _tx_active = true;
+
+    if (frame_end)
+    {
+        frames_sent++;
+        if (_peer)
+        {
+            Incoming frame;
+            frame.start_ns = _frame_start;
+            frame.end_ns = _tx_busy_until;
+            frame.data = _frame;
+            frame.rssi_dbm = link.rssi_dbm;
+            frame.offset_hz = (int32_t)frequency_hz() + link.offset_hz;
+            _peer->_incoming.push_back(frame);
+        }
+        _in_frame = false;
+        _frame_start = no_frame;
+    }
+}
+
+/**
+ * a frame has finished arriving.  Put it in the FIFO the way the packet controller would.
+ * offset_hz holds the transmit frequency until here, where it becomes the offset from ours.
+ */
+void AX5043Sim::deliver(const Incoming &frame)
+{
+    int32_t offset = frame.offset_hz - (int32_t)frequency_hz();
+
+    if (pwrmode() != AX_PWRMODE_FULLRX || (uint32_t)abs(offset) > _peer->link.capture_hz || lose())
+    {
+        frames_dropped++;
+        return;
+    }
+
+    std::vector<uint8_t> chunks;
+    size_t sent = 0;
+    do
+    {
+        size_t length = frame.data.size() - sent;
+        if (length > 240) length = 240;
+        uint8_t flags = 0;
+        if (sent == 0) flags |= AX_FIFO_RXDATA_PKTSTART;
+        if (sent + length == frame.data.size()) flags |= AX_FIFO_RXDATA_PKTEND;
+
+        chunks.push_back(AX_FIFO_CHUNK_DATA);
+        chunks.push_back(length + 1);
+        chunks.push_back(flags);
+        chunks.insert(chunks.end(), frame.data.begin() + sent, frame.data.begin() + sent + length);
+        sent += length;
+    } while (sent < frame.data.size());
+
+    uint8_t store = _reg[AX_REG_PKTSTOREFLAGS];
+    if (store & AX_PKT_STORE_TIMER)
+    {
+        uint32_t timer = micros() & 0xFFFFFF;
+        chunks.insert(chunks.end(), {AX_FIFO_CHUNK_TIMER, (uint8_t)(timer >> 16), (uint8_t)(timer >> 8), (uint8_t)timer});
+    }
+    if (store & AX_PKT_STORE_FREQUENCY_OFFSET)
+    {
+        chunks.insert(chunks.end(), {AX_FIFO_CHUNK_FREQOFFS, 0, 0});
+    }
+    if (store & AX_PKT_STORE_RF_OFFSET)
+    {
+        // same units as the FREQ registers, f_xtal / 2^24
+        int32_t rffreqoffs = (int32_t)(((int64_t)offset << 24) / (int64_t)_f_xtal);
+        chunks.insert(chunks.end(), {AX_FIFO_CHUNK_RFFREQOFFS, (uint8_t)(rffreqoffs >> 16),
+                                     (uint8_t)(rffreqoffs >> 8), (uint8_t)rffreqoffs});
+    }
+    if (store & AX_PKT_STORE_DATARATE_OFFSET)
+    {
+        chunks.insert(chunks.end(), {AX_FIFO_CHUNK_DATARATE, 0, 0, 0});
+    }
+    if (store & AX_PKT_STORE_RSSI)
+    {
+        chunks.insert(chunks.end(), {AX_FIFO_CHUNK_RSSI, (uint8_t)frame.rssi_dbm});
+    }
+
+    if (chunks.size() > fifo_free())
+    {
+        _fifo_errors |= 0x08; // overflow
+        frames_dropped++;
+        return;
+    }
+    _fifo.insert(_fifo.end(), chunks.begin(), chunks.end());
+    frames_received++;
+}
+
+uint8_t AX5043Sim::read_register(uint16_t reg)
+{
+    switch (reg)
+    {
+    case AX_REG_SILICONREVISION:
+        return 0x51;
+    case AX_REG_POWSTAT:
+    case AX_REG_POWSTICKYSTAT:
+        return powstat();
+    case AX_REG_RADIOSTATE:
+        return radiostate();
+    case AX_REG_XTALSTATUS:
+        return ((_reg[AX_REG_PWRMODE] & AX_PWRMODE_XOEN) || pwrmode() >= AX_PWRMODE_STANDBY) ? AX_XTALSTATUS_RUNNING : 0;
+    case AX_REG_FIFOSTAT:
+        return fifostat();
+    case AX_REG_FIFODATA:
+    {
+        if (_fifo.empty())
+        {
+            _fifo_errors |= 0x04; // underflow
+            return 0;
+        }
+        uint8_t value = _fifo.front();
+        _fifo.pop_front();
+        return value;
+    }
+    case AX_REG_FIFOCOUNT:
+        return _fifo.size() >> 8;
+    case AX_REG_FIFOCOUNT + 1:
+        return _fifo.size() & 0xFF;
+    case AX_REG_FIFOFREE:
+        return fifo_free() >> 8;
+    case AX_REG_FIFOFREE + 1:
+        return fifo_free() & 0xFF;
+    case AX_REG_RSSI:
+        if (carrier()) return (uint8_t)_incoming.front().rssi_dbm;
+        return (uint8_t)noise_floor_dbm;
+    case AX_REG_BGNDRSSI:
+        return (uint8_t)noise_floor_dbm;
+    default:
+        return _reg[reg];
+    }
+}
+
+void AX5043Sim::write_register(uint16_t reg, uint8_t value)
+{
+    switch (reg)
+    {
+    case AX_REG_PWRMODE:
+    {
+        if (value & AX_PWRMODE_RST)
+        {
+            reset();
+            _reg[AX_REG_PWRMODE] = value;
+            return;
+        }
+        uint8_t old_mode = pwrmode();
+        _reg[AX_REG_PWRMODE] = value;
+
+        if (pwrmode() < AX_PWRMODE_FIFOON)
+        { /* the FIFO isn't powered */
+            _fifo.clear();
+            _uncommitted.clear();
+        }
+        if (old_mode == AX_PWRMODE_FULLTX && pwrmode() != AX_PWRMODE_FULLTX)
+        { /* whatever was still going out is cut off */
+            _tx_active = false;
+            _in_frame = false;
+            _frame_start = no_frame;
+        }
+        if (pwrmode() == AX_PWRMODE_FULLTX) service();
+        return;
+    }
+    case AX_REG_FIFOSTAT:
+        switch (value & 0x3F)
+        {
+        case AX_FIFOCMD_CLEAR_FIFO_DATA:
+            _fifo.clear();
+            _uncommitted.clear();
+            break;
+        case AX_FIFOCMD_CLEAR_FIFO_ERROR_FLAGS:
+            _fifo_errors = 0;
+            break;
+        case AX_FIFOCMD_CLEAR_FIFO_DATA_AND_FLAGS:
+            _fifo.clear();
+            _uncommitted.clear();
+            _fifo_errors = 0;
+            break;
+        case AX_FIFOCMD_COMMIT:
+            _fifo.insert(_fifo.end(), _uncommitted.begin(), _uncommitted.end());
+            _uncommitted.clear();
+            service(); // an idle transmitter starts on the commit
+            break;
+        case AX_FIFOCMD_ROLLBACK:
+            _uncommitted.clear();
+            break;
+        }
+        return;
+    case AX_REG_FIFODATA:
+        if (fifo_free()) _uncommitted.push_back(value);
+        else _fifo_errors |= 0x08;
+        return;
+    case AX_REG_PLLRANGINGA:
+    case AX_REG_PLLRANGINGB:
+        // ranging finishes straight away on the VCOR it was started with, and always locks
+        _reg[reg] = (value & 0x0F) | 0x40;
+        return;
+    case AX_REG_SILICONREVISION:
+    case AX_REG_POWSTAT:
+    case AX_REG_POWSTICKYSTAT:
+    case AX_REG_RADIOSTATE:
+    case AX_REG_XTALSTATUS:
+    case AX_REG_FIFOCOUNT:
+    case AX_REG_FIFOCOUNT + 1:
+    case AX_REG_FIFOFREE:
+    case AX_REG_FIFOFREE + 1:
+    case AX_REG_RSSI:
+        return; // read only
+    default:
+        _reg[reg] = value;
+        return;
+    }
+}
+
+bool AX5043Sim::modem_powered() const
+{
+    uint8_t mode = pwrmode();
+    return mode >= AX_PWRMODE_FIFOON && mode != AX_PWRMODE_WORRX;
+}
+
+uint8_t AX5043Sim::powstat() const
+{
+    return AX_POWSTAT_SSUM | AX_POWSTAT_SREF | AX_POWSTAT_SVREF | AX_POWSTAT_SVANA |
+           AX_POWSTAT_SBEVANA | AX_POWSTAT_SBEVMODEM | AX_POWSTAT_SVIO |
+           (modem_powered() ? AX_POWSTAT_SVMODEM : 0);
+}
+
+uint8_t AX5043Sim::radiostate()
+{
+    switch (pwrmode())
+    {
+    case AX_PWRMODE_FULLTX:
+        return _tx_active ? AX_RADIOSTATE_TX : AX_RADIOSTATE_IDLE;
+    case AX_PWRMODE_FULLRX:
+        return carrier() ? AX_RADIOSTATE_RX : AX_RADIOSTATE_RX_PREAMBLE_1;
+    case AX_PWRMODE_POWERDOWN:
+        return AX_RADIOSTATE_POWERDOWN;
+    default:
+        return AX_RADIOSTATE_IDLE;
+    }
+}
+
+uint8_t AX5043Sim::fifostat() const
+{
+    uint16_t threshold = ((uint16_t)_reg[AX_REG_FIFOTHRESH] << 8) | _reg[AX_REG_FIFOTHRESH + 1];
+    uint8_t value = _fifo_errors;
+
+    if (_fifo.empty()) value |= 0x01;
+    if (fifo_free() == 0) value |= 0x02;
+    if (_fifo.size() > threshold) value |= 0x10;
+    if (fifo_free() > threshold) value |= 0x20;
+
+    return value;
+}
+
+/**
+ * length of the chunk at offset, or 0 if it isn't all committed yet.
+ * The top three bits of the header give the payload length, 7 means a length byte follows.
+ */
+int AX5043Sim::chunk_size(size_t offset) const
+{
+    if (offset >= _fifo.size()) return 0;
+
+    int size;
+    switch (_fifo[offset] >> 5)
+    {
+    case 0: size = 1; break;
+    case 1: size = 2; break;
+    case 2: size = 3; break;
+    case 3: size = 4; break;
+    case 7:
+        if (offset + 1 >= _fifo.size()) return 0;
+        size = _fifo[offset + 1] + 2;
+        break;
+    default: size = 1; break;
+    }
+
+    return (offset + size <= _fifo.size()) ? size : 0;
+}
+
+bool AX5043Sim::carrier()
+{
+    uint64_t now = host_clock_ns();
+    return pwrmode() == AX_PWRMODE_FULLRX && !_incoming.empty() && _incoming.front().start_ns <= now;
+}
+
+bool AX5043Sim::lose()
+{
+    if (_peer->link.loss_percent == 0) return false;
+
+    // xorshift, so a run is repeatable
+    _lfsr ^= _lfsr << 13;
+    _lfsr ^= _lfsr >> 17;
+    _lfsr ^= _lfsr << 5;
+    return (_lfsr % 100) < _peer->link.loss_percent;
+}
@@ -0,0 +1,129 @@
+/**
+ * @file ax5043_sim.h
+ * @brief software model of the AX5043 that sits behind ax_config::spi_transfer
+ *
+ * The driver only ever talks to the chip through spi_transfer, so pointing that at one of these
+ * lets ax.cpp/ax_hw.cpp run unmodified on a workstation.  It models what the driver depends on:
+ *  - short (addr <= 0x70) and long register access, with address auto-increment except for FIFODATA
+ *  - PWRMODE -> POWSTAT.SVMODEM and RADIOSTATE, XTALSTATUS, SCRATCH and SILICONREVISION
+ *  - PLL ranging (finishes immediately and reports lock)
+ *  - the 256 byte FIFO: commit, clear, FIFOCOUNT/FIFOFREE/FIFOSTAT
+ *  - transmit: committed chunks (DATA, REPEATDATA) are clocked out at TXRATE, and each packet
+ *    (PKTSTART..PKTEND) is handed to the connected peer
+ *  - receive: the peer's packets show up as DATA chunks followed by the metadata chunks
+ *    PKTSTOREFLAGS asks for (RSSI, RFFREQOFFS, ...), if the peer is in FULLRX on a close enough frequency
+ *
+ * It doesn't model the modem.  Bits go in one end and come out the other unless the link drops them.
+ * Time is the virtual clock in host/Arduino.h, advanced by the SPI clock for every transfer.
+ */
+
+#ifndef AX5043_SIM_H
+#define AX5043_SIM_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <deque>
+#include <vector>
+
+class AX5043Sim
+{
+public:
+    AX5043Sim(uint32_t f_xtal = 48000000);
+
+    void reset();
+    void spi_transfer(unsigned char *data, uint8_t length);
+    void spi_transfer_async(unsigned char *data, uint16_t length, void (*done)(void)); // ax_config::spi_transfer_async
+
+    // packets transmitted by either one are received by the other
+    void connect(AX5043Sim &peer);
+
+    // what the peer sees when this one transmits
+    struct Link
+    {
+        int8_t rssi_dbm{-70};
+        uint8_t loss_percent{0};
+        int32_t offset_hz{0};        // doppler + crystal error added to our transmit frequency
+        uint32_t capture_hz{10000};  // peer doesn't hear us if it's tuned further away than this
+    } link;
+
+    int8_t noise_floor_dbm{-110};
+    uint32_t sclk_hz{8000000};      // constants::spi_clock
+    uint32_t spi_overhead_ns{1000}; // chip select and call overhead per transfer
+    uint32_t dma_setup_ns{2000};    // processor time to start a DMA transfer
+
+    // counters
+    uint32_t spi_transactions{0};
+    uint32_t spi_bytes{0};
+    uint32_t frames_sent{0};
+    uint32_t frames_received{0};
+    uint32_t frames_dropped{0}; // lost on the link, not listening, off frequency or the FIFO was full
+
+    uint8_t peek_register(uint16_t reg) const { return _reg[reg & 0xFFF]; }
+    uint32_t frequency_hz() const; // whichever of FREQA/FREQB PLLLOOP selects
+    uint32_t tx_bitrate() const;
+
+    // lets a plain function pointer reach an instance, see ax5043_sim_spi_transfer below
+    static AX5043Sim *slot[4];
+
+private:
+    struct Incoming
+    {
+        uint64_t start_ns, end_ns;
+        std::vector<uint8_t> data;
+        int8_t rssi_dbm;
+        int32_t offset_hz;
+    };
+
+    void transfer(unsigned char *data, uint16_t length);
+    void service();
+    void advance_tx(uint64_t now);
+    void start_chunk();
+    void deliver(const Incoming &frame);
+    uint8_t read_register(uint16_t reg);
+    void write_register(uint16_t reg, uint8_t value);
+    uint8_t pwrmode() const { return _reg[0x002] & 0x0F; }
+    bool modem_powered() const;
+    uint8_t powstat() const;
+    uint8_t radiostate();
+    uint8_t fifostat() const;
+    uint16_t fifo_free() const { return 256 - _fifo.size() - _uncommitted.size(); }
+    int chunk_size(size_t offset) const; // 0 if the chunk isn't all there yet
+    bool carrier();
+    bool lose();
+
+    uint32_t _f_xtal;
+    uint8_t _reg[0x1000];
+
+    std::deque<uint8_t> _fifo;          // committed (tx) or received (rx) bytes
+    std::vector<uint8_t> _uncommitted;  // written but not committed yet
+    uint8_t _fifo_errors{0};            // FIFOSTAT under/overflow bits
+    uint64_t _bus_free_ns{0};           // end of the DMA transfer on the bus, if there is one
+
+    // transmitter
+    uint64_t _tx_busy_until{0};
+    bool _tx_active{false};
+    bool _in_frame{false};
+    uint64_t _frame_start{0};
+    std::vector<uint8_t> _frame;
+
+    // receiver
+    std::deque<Incoming> _incoming;
+    AX5043Sim *_peer{nullptr};
+    uint32_t _lfsr{0xACE1};
+};
+
+// spi_transfer has no context argument, so each simulated radio gets its own trampoline:
+//   AX5043Sim::slot[0] = &sim; config.spi_transfer = ax5043_sim_spi_transfer<0>;
+template <int N>
+void ax5043_sim_spi_transfer(unsigned char *data, uint8_t length)
+{
+    AX5043Sim::slot[N]->spi_transfer(data, length);
+}
+
+template <int N>
+void ax5043_sim_spi_transfer_async(unsigned char *data, uint16_t length, void (*done)(void))
+{
+    AX5043Sim::slot[N]->spi_transfer_async(data, length, done);
+}
+
+#endif
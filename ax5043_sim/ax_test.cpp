@@ -0,0 +1,293 @@
+/**
+ * @file ax_test.cpp
+ * @brief checks the driver's arithmetic shortcuts against the calculations they replaced, on a simulated AX5043
+ *
+ * usage: ax_test [-q]
+ *   -q  quick, the frequency sweep in 10 Hz steps instead of 1 Hz
+ *
+ * ax_set_freq_register: the 64-bit integer FREQA/FREQB against the old double expression, for every 1 Hz step of the
+ * 420-450 MHz band with the board's 48 MHz TCXO, and a coarser sweep of the chip's whole range.  Then what one call
+ * costs: the arithmetic alone on this machine, both ways, and the whole call through the sim (the register write is
+ * most of it on the board).
+ *
+ * ax_populate_params: every mode in ax_modes.cpp, at a few bitrates, through the parameter cache.  Each one is computed
+ * with nothing cached (the cache is filled with other bitrates first) and then loaded again from the cache, and the two
+ * have to be the same byte for byte, max_delta_carrier included.  Then how long a miss and a hit take.
+ *
+ * ax_tx_turnaround/ax_rx_turnaround: for each mode, the whole register file after a full ax_tx_on and ax_rx_on, against
+ * what the turnarounds leave.  They only write the registers ax_prepare_turnaround lists, so anything
+ * ax_set_registers_tx or ax_set_registers_rx sets that isn't in its list shows up here.
+ * Returns non-zero if anything doesn't match.
+ */
+
+#include <Arduino.h>
+#include <ArduinoLog.h>
+#include <chrono>
+#include <vector>
+
+#include "ax.h"
+#include "ax_modes.h"
+#include "ax_params.h"
+#include "ax_reg.h"
+#include "constants.h"
+
+#include "ax5043_sim.h"
+
+static int bad = 0;
+
+static double seconds_since(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// what ax_set_freq_register did before, less the LSB
+static uint32_t freq_double(uint32_t frequency, uint32_t f_xtal)
+{
+    return (uint32_t)(((double)frequency * (1 << 23)) / (float)f_xtal);
+}
+
+static uint32_t freq_integer(uint32_t frequency, uint32_t f_xtal)
+{
+    return (uint32_t)(((uint64_t)frequency << 23) / f_xtal);
+}
+
+static void sweep(uint32_t crystal, uint32_t from, uint32_t to, uint32_t step)
+{
+    volatile uint32_t f_xtal = crystal;  // not a constant, so it's a real divide like the driver's
+    unsigned long checked = 0, mismatches = 0;
+    for (uint32_t frequency = from; frequency <= to; frequency += step)
+    {
+        if (freq_integer(frequency, f_xtal) != freq_double(frequency, f_xtal))
+        {
+            if (mismatches++ < 5) printf("  MISMATCH at %u Hz: %u, was %u\r\n", frequency, freq_integer(frequency, f_xtal), freq_double(frequency, f_xtal));
+        }
+        checked++;
+    }
+    printf("f_xtal %u, %u to %u Hz in %u Hz steps: %lu checked, %lu different\r\n", f_xtal, from, to, step, checked, mismatches);
+    bad += mismatches;
+}
+
+static void freq_register_test(ax_config &config, AX5043Sim &sim, bool quick)
+{
+    printf("ax_set_freq_register\r\n");
+    sweep(48000000, 420000000, 450000000, quick ? 10 : 1);
+    sweep(48000000, 27000000, 1050000000, 997);  // the chip's whole range, and a step that lands all over the fraction
+
+    // the driver's own call, through the sim's registers
+    for (uint32_t frequency = 420000000; frequency <= 450000000; frequency += 1234567)
+    {
+        uint32_t value = ax_set_freq_register(&config, AX_REG_FREQA, frequency);
+        uint32_t in_chip = ((uint32_t)sim.peek_register(AX_REG_FREQA) << 24) | ((uint32_t)sim.peek_register(AX_REG_FREQA + 1) << 16) |
+                           ((uint32_t)sim.peek_register(AX_REG_FREQA + 2) << 8) | sim.peek_register(AX_REG_FREQA + 3);
+        uint32_t expected = (freq_double(frequency, config.f_xtal) << 1) | 1;
+        if ((value != expected) || (in_chip != expected))
+        {
+            printf("  MISMATCH at %u Hz: returned %X, FREQA %X, expected %X\r\n", frequency, value, in_chip, expected);
+            bad++;
+        }
+    }
+
+    // per call.  The volatile sum keeps the compiler from dropping the loops
+    const int calls = 10000000;
+    volatile uint32_t sum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < calls; i++) sum += freq_double(435000000 + i, config.f_xtal);
+    double as_double = seconds_since(start);
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < calls; i++) sum += freq_integer(435000000 + i, config.f_xtal);
+    double as_integer = seconds_since(start);
+    printf("  arithmetic per call on this machine: double %.1f ns, integer %.1f ns\r\n", as_double * 1e9 / calls,
+           as_integer * 1e9 / calls);
+
+    const int register_calls = 100000;
+    unsigned long virtual_start = micros();
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < register_calls; i++) ax_set_freq_register(&config, AX_REG_FREQA, 435000000 + i);
+    double whole = seconds_since(start);
+    printf("  whole call: %.1f ns on this machine, %.1f us of SPI at the sim's clock\r\n", whole * 1e9 / register_calls,
+           (double)(micros() - virtual_start) / register_calls);
+    printf("  (there's no FPU on the M0+, so the double version is a soft-float multiply and divide there, and the\r\n"
+           "  integer one a 64-bit shift and a __aeabi_uldivmod.  Time them on the board to compare)\r\n");
+}
+
+// each mode, at its own bitrate and a couple of others
+static std::vector<ax_modulation> test_modes()
+{
+    std::vector<ax_modulation> modes;
+    const ax_modulation *table[] = {&gmsk_modulation, &fsk_modulation, &ask_modulation, &aprs_modulation,
+                                    &gmsk_modulation_raw, &gmsk_modulation_il2p, &gmsk_modulation_il2p_4800};
+    for (const ax_modulation *mode : table)
+    {
+        for (uint32_t bitrate : {mode->bitrate, (uint32_t)1200, (uint32_t)19200})
+        {
+            ax_modulation m = *mode;
+            m.bitrate = bitrate;
+            m.max_delta_carrier = 0;  // defaulted, the way Radio::begin leaves it
+            modes.push_back(m);
+        }
+    }
+    return modes;
+}
+
+// more loads of a bitrate nothing else uses than the cache holds (AX_PARAMS_CACHE_ENTRIES, 4)
+static void flush_params_cache(ax_config &config)
+{
+    for (uint32_t bitrate = 1001; bitrate <= 1008; bitrate++)
+    {
+        ax_modulation m = fsk_modulation;
+        m.bitrate = bitrate;
+        ax_params par;
+        ax_populate_params(&config, &m, &par);
+    }
+}
+
+static void params_cache_test(ax_config &config)
+{
+    printf("ax_populate_params\r\n");
+    std::vector<ax_modulation> modes = test_modes();
+    std::vector<ax_params> uncached(modes.size());
+    std::vector<uint32_t> uncached_delta(modes.size());
+
+    // computed: the cache gets filled with other bitrates first, so there's nothing there to hit.  Some of the modes
+    // differ only in things the parameters don't depend on (framing, encoding), so they'd hit each other otherwise
+    for (size_t i = 0; i < modes.size(); i++)
+    {
+        flush_params_cache(config);
+        ax_modulation m = modes[i];
+        memset(&uncached[i], 0, sizeof(ax_params));
+        ax_populate_params(&config, &m, &uncached[i]);
+        uncached_delta[i] = m.max_delta_carrier;
+    }
+
+    // again, straight after a load of the same mode so it's a hit
+    int checked = 0, mismatches = 0;
+    for (size_t i = 0; i < modes.size(); i++)
+    {
+        ax_modulation m = modes[i];
+        ax_params par;
+        memset(&par, 0, sizeof(ax_params));
+        ax_populate_params(&config, &m, &par);
+        m = modes[i];
+        memset(&par, 0, sizeof(ax_params));
+        ax_populate_params(&config, &m, &par);
+        if ((memcmp(&par, &uncached[i], sizeof(ax_params)) != 0) || (m.max_delta_carrier != uncached_delta[i]))
+        {
+            printf("  MISMATCH: modulation %d at %u bps, cached params differ\r\n", modes[i].modulation, modes[i].bitrate);
+            mismatches++;
+        }
+        checked++;
+    }
+    bad += mismatches;
+    printf("  %d modes, cached and uncached the same in %d\r\n", (int)modes.size(), checked - mismatches);
+
+    // a miss is the float/log2/sqrt path, a hit a memcmp and a memcpy
+    const int loads = 20000;
+    volatile uint32_t sum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < loads; i++)
+    {
+        ax_modulation m = modes[i % modes.size()];
+        ax_params par;
+        ax_populate_params(&config, &m, &par);
+        sum += par.rx_data_rate;
+    }
+    double misses = seconds_since(start);
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < loads; i++)
+    {
+        ax_modulation m = modes[0];
+        ax_params par;
+        ax_populate_params(&config, &m, &par);
+        sum += par.rx_data_rate;
+    }
+    double hits = seconds_since(start);
+    printf("  per load on this machine: computed %.0f ns, cached %.0f ns\r\n", misses * 1e9 / loads, hits * 1e9 / loads);
+}
+
+static void snapshot(AX5043Sim &sim, uint8_t *registers)
+{
+    for (uint16_t reg = 0; reg < 0x1000; reg++) registers[reg] = sim.peek_register(reg);
+}
+
+// registers the chip changes itself, or that only matter as commands
+static bool volatile_register(uint16_t reg)
+{
+    return (reg == AX_REG_FIFOSTAT) || (reg == AX_REG_FIFODATA) || (reg == AX_REG_FIFOCOUNT) || (reg == AX_REG_FIFOCOUNT + 1) ||
+           (reg == AX_REG_FIFOFREE) || (reg == AX_REG_FIFOFREE + 1);
+}
+
+static int compare(const uint8_t *expected, const uint8_t *got, const char *what, const char *name)
+{
+    int differences = 0;
+    for (uint16_t reg = 0; reg < 0x1000; reg++)
+    {
+        if (volatile_register(reg) || (expected[reg] == got[reg])) continue;
+        printf("  MISMATCH: %s, %s: register 0x%03X is %02X, full setup leaves %02X\r\n", name, what, reg, got[reg], expected[reg]);
+        differences++;
+    }
+    return differences;
+}
+
+static void turnaround_test(ax_config &config, AX5043Sim &sim)
+{
+    printf("ax_tx_turnaround/ax_rx_turnaround\r\n");
+    static uint8_t full_tx[0x1000], full_rx[0x1000], turned[0x1000];
+    struct
+    {
+        const char *name;
+        ax_modulation *mode;
+    } modes[] = {{"gmsk", &gmsk_modulation}, {"fsk", &fsk_modulation}, {"ask", &ask_modulation}, {"aprs", &aprs_modulation},
+                 {"gmsk_raw", &gmsk_modulation_raw}, {"gmsk_il2p", &gmsk_modulation_il2p}, {"gmsk_il2p_4800", &gmsk_modulation_il2p_4800}};
+    int differences = 0;
+    for (auto &m : modes)
+    {
+        ax_modulation mod = *m.mode;
+        ax_default_params(&config, &mod);
+        ax_rx_on(&config, &mod);  // the full setups start from the other direction too, like the turnarounds
+        ax_tx_on(&config, &mod);
+        snapshot(sim, full_tx);
+        ax_rx_on(&config, &mod);
+        snapshot(sim, full_rx);
+
+        ax_tx_turnaround(&config, &mod);
+        snapshot(sim, turned);
+        differences += compare(full_tx, turned, "rx to tx", m.name);
+        ax_rx_turnaround(&config, &mod);
+        snapshot(sim, turned);
+        differences += compare(full_rx, turned, "tx to rx", m.name);
+        printf("  %s: %d registers in the delta%s\r\n", m.name, config.turnaround.count, config.turnaround.valid ? "" : ", AFSK takes the full path");
+    }
+    bad += differences;
+    printf("  %d registers different from a full setup\r\n", differences);
+}
+
+int main(int argc, char **argv)
+{
+    bool quick = (argc > 1) && (strcmp(argv[1], "-q") == 0);
+    Log.begin(LOG_LEVEL_WARNING);
+
+    AX5043Sim sim;
+    AX5043Sim::slot[0] = &sim;
+
+    ax_config config;
+    memset(&config, 0, sizeof(ax_config));
+    config.synthesiser.vco_type = AX_VCO_INTERNAL;
+    config.synthesiser.A.frequency = constants::frequency;
+    config.synthesiser.B.frequency = constants::frequency;
+    config.clock_source = AX_CLOCK_SOURCE_TCXO;
+    config.f_xtal = 48000000;
+    config.transmit_power_limit = 1;
+    config.spi_transfer = ax5043_sim_spi_transfer<0>;
+    if (ax_init(&config) != AX_INIT_OK)
+    {
+        printf("ax_init failed\r\n");
+        return 2;
+    }
+
+    freq_register_test(config, sim, quick);
+    params_cache_test(config);
+    turnaround_test(config, sim);
+
+    printf(bad ? "FAILED, %d wrong\r\n" : "all ok\r\n", bad);
+    return bad ? 1 : 0;
+}
@@ -0,0 +1,168 @@
+/**
+ * @file headercomp_test.cpp
+ * @brief TCP/IP header compression (silversat_radio/headercomp.h) round trip, and frames that have to be dropped
+ *
+ * usage: headercomp_test
+ *
+ * Two interleaved TCP flows the way tncattach sends them (tun header, IPv4, TCP with timestamps), 200 segments, through
+ * HeaderCompressor::compress on one side and decompress on the other, checked byte for byte.  One frame is lost on the
+ * way and one is a retransmission, so a flow has to drop compressed frames until it's sent whole again.  Then frames
+ * that are too short to be what their command byte says, which have to be dropped without reading past their end.
+ * Returns non-zero if anything comes out wrong.
+ */
+
+#include <Arduino.h>
+#include <ArduinoLog.h>
+
+#include "constants.h"
+#include "headercomp.h"
+
+static int bad = 0;
+
+static uint16_t checksum(const byte *data, int length, uint32_t sum)
+{
+    for (int i = 0; i + 1 < length; i += 2) sum += (data[i] << 8) | data[i + 1];
+    if (length & 1) sum += data[length - 1] << 8;
+    while (sum >> 16) sum = (sum & 0xFFFF) + (sum >> 16);
+    return ~sum;
+}
+
+static void put32(byte *p, uint32_t value)
+{
+    p[0] = value >> 24;
+    p[1] = value >> 16;
+    p[2] = value >> 8;
+    p[3] = value;
+}
+
+struct Flow
+{
+    uint32_t seq, ack, tsval, tsecr;
+    uint16_t id, window, port;
+};
+
+// a data frame: command byte, tun header, IPv4, TCP with the timestamp option, payload.  Returns its length
+static int make_frame(byte *frame, Flow &flow, int payload)
+{
+    int n = 0;
+    frame[n++] = 0x00;  // data
+    frame[n++] = 0;
+    frame[n++] = 0;
+    frame[n++] = 8;
+    frame[n++] = 0;
+    byte *ip = frame + n;
+    int total = 20 + 32 + payload;
+    byte ip_header[20] = {0x45, 0, (byte)(total >> 8), (byte)total, (byte)(flow.id >> 8), (byte)flow.id, 0x40, 0, 64, 6, 0, 0,
+                          10, 0, 0, 1, 10, 0, 0, 2};
+    memcpy(ip, ip_header, 20);
+    uint16_t sum = checksum(ip, 20, 0);
+    ip[10] = sum >> 8;
+    ip[11] = sum;
+
+    byte *tcp = ip + 20;
+    memset(tcp, 0, 32);
+    tcp[0] = flow.port >> 8;
+    tcp[1] = flow.port;
+    tcp[3] = 22;
+    put32(tcp + 4, flow.seq);
+    put32(tcp + 8, flow.ack);
+    tcp[12] = 0x80;  // 32 bytes
+    tcp[13] = 0x18;  // PSH ACK
+    tcp[14] = flow.window >> 8;
+    tcp[15] = flow.window;
+    tcp[20] = 1;  // NOP NOP timestamps
+    tcp[21] = 1;
+    tcp[22] = 8;
+    tcp[23] = 10;
+    put32(tcp + 24, flow.tsval);
+    put32(tcp + 28, flow.tsecr);
+    for (int i = 0; i < payload; i++) tcp[32 + i] = rand();
+    uint32_t pseudo = ((ip[12] << 8) | ip[13]) + ((ip[14] << 8) | ip[15]) + ((ip[16] << 8) | ip[17]) + ((ip[18] << 8) | ip[19]) + 6 +
+                      32 + payload;
+    sum = checksum(tcp, 32 + payload, pseudo);
+    tcp[16] = sum >> 8;
+    tcp[17] = sum;
+    return n + total;
+}
+
+// two flows, one frame lost and one retransmitted.  Returns the slot the last compressed frame used
+static int round_trip(HeaderCompressor &sender, HeaderCompressor &receiver)
+{
+    Flow a{1000, 5000, 100, 200, 7, 500, 40000}, b{9, 9, 1, 1, 100, 600, 40001};
+    int good = 0, dropped = 0, frames = 0, before = 0, after = 0, slot = -1;
+    for (int i = 0; i < 200; i++)
+    {
+        Flow &flow = ((i % 3 == 0) && (i != 60)) ? b : a;
+        byte frame[300], original[300], out[300 + HC_HEADER_MAX];
+        int payload = (i % 5 == 0) ? 100 : 0;
+        if (i == 60) a.seq -= 300;  // a retransmission, goes whole
+        int length = make_frame(frame, flow, payload);
+        memcpy(original, frame, length);
+        int compressed = sender.compress(frame, length, sizeof(frame));
+        if (frame[0] == constants::hc_compressed_code) slot = frame[1];
+        before += length;
+        after += compressed;
+        frames++;
+        if (i != 50)  // lost on the air
+        {
+            int got = compressed;
+            if (frame[0] == 0x00) memcpy(out, frame, compressed);
+            else got = receiver.decompress(frame, compressed, out, sizeof(out));
+            if ((got == length) && (memcmp(out, original, length) == 0)) good++;
+            else dropped++;
+        }
+        flow.seq += payload;
+        flow.ack += (i % 4) ? 100 : 0;
+        flow.tsval += i % 2;
+        flow.tsecr += (i % 7 == 0);
+        flow.id++;
+        if (i % 10 == 0) flow.window += 3;
+        if (i == 60) a.seq += 300;
+    }
+    printf("round trip: %d of %d frames back the same, %d dropped after the loss, %d bytes down to %d\r\n", good, frames,
+           dropped, before, after);
+    // the one lost, and whatever of its flow came after it until it went whole again.  Nothing else
+    if ((good + dropped != frames - 1) || (dropped > 10)) bad++;
+    return slot;
+}
+
+// frames that end before their command byte says they do.  Each one is in a buffer exactly its own length, so a build
+// with -fsanitize=address stops on any read past the end
+static void short_frames(HeaderCompressor &receiver, int slot)
+{
+    byte out[64 + HC_HEADER_MAX];
+    struct
+    {
+        const char *name;
+        byte command;
+        int length;
+    } cases[] = {{"compressed, no change mask", constants::hc_compressed_code, 2},
+                 {"compressed, command byte only", constants::hc_compressed_code, 1},
+                 {"uncompressed, command byte only", constants::hc_uncompressed_code, 1}};
+    for (auto &c : cases)
+    {
+        byte *frame = new byte[c.length];
+        frame[0] = c.command;
+        if (c.length > 1) frame[1] = slot;
+        int got = receiver.decompress(frame, c.length, out, sizeof(out));
+        delete[] frame;
+        printf("short frame, %s: %s\r\n", c.name, got ? "NOT DROPPED" : "dropped");
+        if (got) bad++;
+    }
+}
+
+int main()
+{
+    Log.begin(LOG_LEVEL_WARNING);
+    srand(1);
+    static HeaderCompressor sender, receiver;
+    int slot = round_trip(sender, receiver);
+    if (slot < 0)
+    {
+        printf("nothing was compressed\r\n");
+        return 1;
+    }
+    short_frames(receiver, slot);
+    printf(bad ? "FAILED\r\n" : "all ok\r\n");
+    return bad ? 1 : 0;
+}
@@ -0,0 +1,27 @@
+/**
+ * @file Arduino.cpp
+ * @brief virtual clock for the host build
+ */
+
+#include "Arduino.h"
+#include <stdlib.h>
+
+static uint64_t clock_ns{0};
+
+uint64_t host_clock_ns() { return clock_ns; }
+
+void host_clock_advance_ns(uint64_t ns) { clock_ns += ns; }
+
+unsigned long micros() { return (unsigned long)(clock_ns / 1000); }
+
+unsigned long millis() { return (unsigned long)(clock_ns / 1000000); }
+
+void delay(unsigned long ms) { clock_ns += (uint64_t)ms * 1000000; }
+
+void delayMicroseconds(unsigned int us) { clock_ns += (uint64_t)us * 1000; }
+
+long random(long howbig) { return howbig > 0 ? random() % howbig : 0; }
+
+long random(long howsmall, long howbig) { return howsmall >= howbig ? howsmall : howsmall + random(howbig - howsmall); }
+
+void randomSeed(unsigned long seed) { if (seed != 0) srandom(seed); }
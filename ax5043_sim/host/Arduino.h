@@ -0,0 +1,61 @@
+/**
+ * @file Arduino.h
+ * @brief Just enough of the Arduino core to build the AX5043 driver on a workstation
+ *
+ * Time is virtual.  The simulator advances the clock for every SPI transfer and
+ * delay() advances it directly, so micros()/millis() measure what the firmware
+ * would see on the board instead of how fast the host happens to be.
+ */
+
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <math.h>
+#include <string>
+#include <algorithm>
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+// the real String is a lot more, but the driver only ever stores version text in one
+typedef std::string String;
+
+#define F(string_literal) (string_literal)
+#define PROGMEM
+
+#define HIGH 0x1
+#define LOW 0x0
+#define INPUT 0x0
+#define OUTPUT 0x1
+#define INPUT_PULLUP 0x2
+
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+using std::min;  // the SAMD core does the same in C++
+using std::max;
+
+// virtual clock
+uint64_t host_clock_ns();
+void host_clock_advance_ns(uint64_t ns);
+
+unsigned long micros();
+unsigned long millis();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+// Arduino's random(), next to the C library's random(void)
+long random(long howbig);
+long random(long howsmall, long howbig);
+void randomSeed(unsigned long seed);
+
+// there are no pins on the host, so these do nothing
+inline void pinMode(uint32_t, uint32_t) {}
+inline void digitalWrite(uint32_t, uint32_t) {}
+inline int digitalRead(uint32_t) { return LOW; }
+inline void interrupts() {}
+inline void noInterrupts() {}
+
+#endif
@@ -0,0 +1,71 @@
+/**
+ * @file ArduinoLog.cpp
+ * @brief host stand-in for thijse/ArduinoLog
+ */
+
+#include "ArduinoLog.h"
+
+Logging Log;
+
+#define LOG_METHOD(name, level)                 \
+    void Logging::name(const char *format, ...) \
+    {                                           \
+        va_list args;                           \
+        va_start(args, format);                 \
+        print(level, format, args);             \
+        va_end(args);                           \
+    }
+
+LOG_METHOD(fatal, LOG_LEVEL_FATAL)
+LOG_METHOD(error, LOG_LEVEL_ERROR)
+LOG_METHOD(warning, LOG_LEVEL_WARNING)
+LOG_METHOD(notice, LOG_LEVEL_NOTICE)
+LOG_METHOD(trace, LOG_LEVEL_TRACE)
+LOG_METHOD(verbose, LOG_LEVEL_VERBOSE)
+
+// longs are 32 bits on the SAMD21, so the driver passes ints and longs interchangeably.
+// everything integral is read as an int, which is what it was promoted to on the board.
+void Logging::print(int level, const char *format, va_list args)
+{
+    if (level > _level) return;
+
+    for (; *format != 0; ++format)
+    {
+        if (*format != '%')
+        {
+            putchar(*format);
+            continue;
+        }
+        ++format;
+        if (*format == 0) break;
+        switch (*format)
+        {
+        case '%': putchar('%'); break;
+        case 's':
+        case 'S': fputs(va_arg(args, const char *), stdout); break;
+        case 'c': putchar((char)va_arg(args, int)); break;
+        case 'd':
+        case 'i':
+        case 'l': printf("%d", va_arg(args, int)); break;
+        case 'u': printf("%u", va_arg(args, unsigned int)); break;
+        case 'x': printf("%x", va_arg(args, unsigned int)); break;
+        case 'X': printf("%X", va_arg(args, unsigned int)); break;
+        case 'b':
+        case 'B':
+        {
+            unsigned int value = va_arg(args, unsigned int);
+            int bit = 31;
+            while (bit > 0 && !(value & (1u << bit))) bit--;
+            for (; bit >= 0; bit--) putchar((value & (1u << bit)) ? '1' : '0');
+            break;
+        }
+        case 't': putchar(va_arg(args, int) ? 'T' : 'F'); break;
+        case 'T': fputs(va_arg(args, int) ? "true" : "false", stdout); break;
+        case 'f':
+        case 'F':
+        case 'D': printf("%f", va_arg(args, double)); break;
+        default: putchar('%'); putchar(*format); break;
+        }
+    }
+    fflush(stdout);
+}
@@ -0,0 +1,45 @@
+/**
+ * @file ArduinoLog.h
+ * @brief host stand-in for thijse/ArduinoLog, prints to stdout
+ *
+ * Same levels and format specifiers as the library (%d %i %l %u %x %X %s %c %b %t %T %F %D),
+ * so the driver's log lines come out the way they do on the serial port.
+ */
+
+#ifndef HOST_ARDUINOLOG_H
+#define HOST_ARDUINOLOG_H
+
+#include <stdarg.h>
+#include "Arduino.h"
+
+#define LOG_LEVEL_SILENT 0
+#define LOG_LEVEL_FATAL 1
+#define LOG_LEVEL_ERROR 2
+#define LOG_LEVEL_WARNING 3
+#define LOG_LEVEL_INFO 4
+#define LOG_LEVEL_NOTICE 4
+#define LOG_LEVEL_TRACE 5
+#define LOG_LEVEL_VERBOSE 6
+
+class Logging
+{
+public:
+    void begin(int level, void * = nullptr, bool = true) { _level = level; }
+    void setLevel(int level) { _level = level; }
+    int getLevel() { return _level; }
+
+    void fatal(const char *format, ...);
+    void error(const char *format, ...);
+    void warning(const char *format, ...);
+    void notice(const char *format, ...);
+    void trace(const char *format, ...);
+    void verbose(const char *format, ...);
+
+private:
+    void print(int level, const char *format, va_list args);
+    int _level{LOG_LEVEL_WARNING};
+};
+
+extern Logging Log;
+
+#endif
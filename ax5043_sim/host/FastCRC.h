@@ -0,0 +1,27 @@
+/**
+ * @file FastCRC.h
+ * @brief host stand-in for FastCRC, only the x25 CRC that IL2P uses
+ */
+
+#ifndef HOST_FASTCRC_H
+#define HOST_FASTCRC_H
+
+#include <stdint.h>
+
+class FastCRC16
+{
+public:
+    // CRC-16/X-25: reflected 0x1021, init 0xFFFF, xorout 0xFFFF
+    uint16_t x25(const uint8_t *data, uint16_t datalen)
+    {
+        uint16_t crc = 0xFFFF;
+        while (datalen--)
+        {
+            crc ^= *data++;
+            for (int i = 0; i < 8; i++) crc = (crc & 1) ? (crc >> 1) ^ 0x8408 : (crc >> 1);
+        }
+        return ~crc;
+    }
+};
+
+#endif
@@ -0,0 +1,54 @@
+/**
+ * @file FlashStorage.h
+ * @brief host stand-in for FlashStorage, FlashClass over memory that behaves like the SAMD21's NOR flash
+ *
+ * Erase sets whole 256 byte rows to 0xFF, and a write can only clear bits, the way the NVM controller
+ * programs a page.  The region has to be writable memory here, not a const array.  erases counts rows
+ * erased at each row, for checking the wear.
+ */
+
+#ifndef HOST_FLASHSTORAGE_H
+#define HOST_FLASHSTORAGE_H
+
+#include <stdint.h>
+#include <string.h>
+#include <map>
+
+class FlashClass
+{
+public:
+    static const uint32_t ROW_SIZE = 256;
+
+    FlashClass(const void *flash_addr = NULL, uint32_t size = 0) {}
+
+    void write(const volatile void *flash_ptr, const void *data, uint32_t size)
+    {
+        volatile uint8_t *dst = (volatile uint8_t *)flash_ptr;
+        const uint8_t *src = (const uint8_t *)data;
+        size = (size + 3) & ~3u;  // whole words, like the page buffer
+        for (uint32_t i = 0; i < size; i++) dst[i] &= src[i];
+    }
+
+    void erase(const volatile void *flash_ptr, uint32_t size)
+    {
+        uintptr_t row = (uintptr_t)flash_ptr & ~(uintptr_t)(ROW_SIZE - 1);
+        for (; row < (uintptr_t)flash_ptr + size; row += ROW_SIZE)
+        {
+            memset((void *)row, 0xFF, ROW_SIZE);
+            erases()[row]++;
+        }
+    }
+
+    void read(const volatile void *flash_ptr, void *data, uint32_t size)
+    {
+        memcpy(data, (const void *)flash_ptr, size);
+    }
+
+    static std::map<uintptr_t, unsigned long> &erases()
+    {
+        static std::map<uintptr_t, unsigned long> counts;
+        return counts;
+    }
+};
+
+#endif
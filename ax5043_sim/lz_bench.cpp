@@ -0,0 +1,147 @@
+/**
+ * @file lz_bench.cpp
+ * @brief compression ratio and speed of the data frame LZ stage (silversat_radio/lz.h) on recorded traffic
+ *
+ * usage: lz_bench [capture ...]
+ *
+ * A capture is the raw bytes that went into (or came out of) Serial1, KISS frames and all, the way a serial logger or
+ * `cat /dev/ttyACM0 > capture.kiss` records them.  Each frame is unwrapped and put through lz_pack and lz_unpack the
+ * way the data processor and the receive handler do it, and checked byte for byte.  With no captures it makes up
+ * some traffic of each kind we expect from payload: telemetry lines, log lines, JSON, and random bytes (the case that
+ * should cost nothing).
+ *
+ * It prints, for each capture: frames, bytes before and after, the ratio, how many frames were left alone (not
+ * shorter), and how fast compress and decompress run on this machine.  The SAMD21 is somewhere around 50 times
+ * slower than a desktop at this sort of thing, so divide accordingly.
+ * Returns non-zero if any frame doesn't come back the same.
+ */
+
+#include <Arduino.h>
+#include <ArduinoLog.h>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "KISS.h"
+#include "constants.h"
+#include "lz.h"
+
+typedef std::vector<std::vector<uint8_t>> Frames;
+
+static int bad = 0;
+
+// KISS frames out of a capture, unwrapped, command byte first
+static Frames read_capture(const char *path)
+{
+    Frames frames;
+    FILE *file = fopen(path, "rb");
+    if (!file)
+    {
+        printf("can't open %s\r\n", path);
+        return frames;
+    }
+    std::vector<uint8_t> kiss;
+    int c;
+    while ((c = fgetc(file)) != EOF)
+    {
+        kiss.push_back(c);
+        if (c != constants::FEND) continue;
+        if (kiss.size() > 2 && kiss.size() <= 2 * LZ_MAX_INPUT + 2)
+        {
+            kiss.insert(kiss.begin(), constants::FEND);
+            std::vector<uint8_t> body(kiss.size());
+            int length = kiss_unwrap(kiss.data(), kiss.size(), body.data());
+            if (length > 0 && length <= LZ_MAX_INPUT && body[0] == 0x00)
+            {
+                body.resize(length);
+                frames.push_back(body);
+            }
+        }
+        kiss.clear();
+    }
+    fclose(file);
+    return frames;
+}
+
+// made up traffic, about mtu_size per frame
+static Frames sample(const char *kind, int count)
+{
+    Frames frames;
+    srand(1);
+    for (int n = 0; n < count; n++)
+    {
+        std::string text;
+        char line[128];
+        while (strcmp(kind, "random") && (text.size() < 200))
+        {
+            if (!strcmp(kind, "telemetry"))
+                snprintf(line, sizeof(line), "TLM,%d,%lu,batt=%d.%02d,temp=%d.%d,rssi=-%d,mode=NOMINAL\n", n,
+                         1760000000UL + n * 10 + text.size(), 7 + rand() % 2, rand() % 100, 15 + rand() % 10, rand() % 10, 90 + rand() % 20);
+            else if (!strcmp(kind, "log"))
+                snprintf(line, sizeof(line), "[%06d] INFO payload: image chunk %d of 512 written, crc ok\n", n * 13 + (int)text.size(), rand() % 512);
+            else if (!strcmp(kind, "json"))
+                snprintf(line, sizeof(line), "{\"t\":%d,\"lat\":%d.%04d,\"lon\":-%d.%04d,\"alt\":%d}", n, 40 + rand() % 10, rand() % 10000,
+                         70 + rand() % 10, rand() % 10000, 510000 + rand() % 1000);
+            text += line;
+        }
+        std::vector<uint8_t> body(1 + 200);
+        body[0] = 0x00;
+        for (int i = 0; i < 200; i++) body[1 + i] = strcmp(kind, "random") ? text[i] : rand();
+        frames.push_back(body);
+    }
+    return frames;
+}
+
+static void run(const char *name, const Frames &frames)
+{
+    if (frames.empty()) return;
+    long before = 0, after = 0;
+    int untouched = 0;
+    std::vector<std::vector<uint8_t>> packed;
+    using clock = std::chrono::steady_clock;
+
+    auto start = clock::now();
+    for (auto &frame : frames)
+    {
+        std::vector<uint8_t> copy(frame);
+        copy.resize(LZ_MAX_INPUT);
+        int length = lz_pack(copy.data(), frame.size());
+        copy.resize(length);
+        packed.push_back(copy);
+    }
+    double pack_us = std::chrono::duration<double, std::micro>(clock::now() - start).count();
+
+    std::vector<uint8_t> out(LZ_MAX_INPUT);
+    start = clock::now();
+    for (size_t i = 0; i < frames.size(); i++)
+    {
+        int length = packed[i].size();
+        if (packed[i][0] == constants::lz_code) length = lz_unpack(packed[i].data(), packed[i].size(), out.data(), out.size());
+        else memcpy(out.data(), packed[i].data(), length);
+        if (length != (int)frames[i].size() || memcmp(out.data(), frames[i].data(), length)) bad++;
+    }
+    double unpack_us = std::chrono::duration<double, std::micro>(clock::now() - start).count();
+
+    for (size_t i = 0; i < frames.size(); i++)
+    {
+        before += frames[i].size();
+        after += packed[i].size();
+        if (packed[i][0] != constants::lz_code) untouched++;
+    }
+    printf("%-12s %5zu frames %7ld -> %7ld bytes  ratio %.2f  %4d left alone  compress %6.1f MB/s  decompress %6.1f MB/s\r\n", name,
+           frames.size(), before, after, (double)before / after, untouched, before / pack_us, before / unpack_us);
+}
+
+int main(int argc, char **argv)
+{
+    Log.begin(LOG_LEVEL_WARNING);
+    if (argc > 1)
+        for (int i = 1; i < argc; i++) run(argv[i], read_capture(argv[i]));
+    else
+    {
+        const char *kinds[] = {"telemetry", "log", "json", "random"};
+        for (const char *kind : kinds) run(kind, sample(kind, 2000));
+    }
+    if (bad) printf("%d frames didn't come back the same\r\n", bad);
+    return bad ? 1 : 0;
+}
@@ -0,0 +1,707 @@
+/**
+ * @file sim_link.cpp
+ * @brief runs the radio driver on two simulated AX5043s and passes IL2P frames between them
+ *
+ * usage: sim_link [frames] [payload size] [-v] [-d] [-a] [-r [loss %]] [-e [loss %]] [-s]
+ *   -v  TRACE logging, and the deferred event log lines (decode with RadioTestInterface/eventlog.py)
+ *   -d  no DMA, every transfer goes through spi_transfer
+ *   -a  aggregation benchmark instead: goodput for [frames] ACK-sized data frames sent one IL2P frame each,
+ *       then packed into aggregates (aggregate.h), each as one transmit session
+ *   -r  ARQ test instead: [frames] data frames A to B with [loss %] of the frames lost each way (default 10), first
+ *       with no ARQ and then through arq.h, with B's acks going back to A.  Everything has to come out in order
+ *   -e  bulk transfer test instead: a made up file of [frames] frames of [payload size] bytes through erasure.h, A to B
+ *       with [loss %] of the packets lost (default 10).  B has to put the file back together byte for byte
+ *   -s  store and forward test instead: [frames] data frames go into flashqueue.h between passes, A resets, and then
+ *       they all have to come out at B in order.  Then it runs the log round a few times and prints the wear
+ *
+ * Radio A transmits, radio B receives, the same way the sketch does it: the frame is built like the
+ * data processor in loop() builds it, then ax_tx_packet on A and ax_rx_packet on B.  Every frame is
+ * checked byte for byte.  It prints what each frame cost in SPI traffic and (virtual) time, and the
+ * ax_hw SPI profile broken down by driver operation.
+ * Returns non-zero if any frame didn't make it.
+ */
+
+#include <Arduino.h>
+#include <ArduinoLog.h>
+
+#include "aggregate.h"
+#include "arq.h"
+#include "erasure.h"
+#include "flashqueue.h"
+#include "KISS.h"
+#include "ax.h"
+#include "ax_modes.h"
+#include "constants.h"
+#include "eventlog.h"
+#include "il2p.h"
+#include "il2p_rs.h"
+#include "il2p_crc.h"
+
+#include "ax5043_sim.h"
+
+// same defaults as Radio::begin
+static void setup_radio(ax_config &config, ax_modulation &modulation, void (*spi_transfer)(unsigned char *, uint8_t),
+                        void (*spi_transfer_async)(unsigned char *, uint16_t, void (*)(void)))
+{
+    memset(&config, 0, sizeof(ax_config));
+    memset(&modulation, 0, sizeof(ax_modulation));
+
+    config.synthesiser.vco_type = AX_VCO_INTERNAL;
+    config.synthesiser.A.frequency = constants::frequency;
+    config.synthesiser.B.frequency = constants::frequency;
+    config.clock_source = AX_CLOCK_SOURCE_TCXO;
+    config.f_xtal = 48000000;
+    config.transmit_power_limit = 1;
+    config.spi_transfer = spi_transfer;
+    config.spi_transfer_async = spi_transfer_async;
+    config.spi_async_threshold = constants::spi_dma_threshold;
+    config.pkt_store_flags = AX_PKT_STORE_RSSI | AX_PKT_STORE_RF_OFFSET;
+
+    modulation.modulation = AX_MODULATION_FSK;
+    modulation.encoding = AX_ENC_NRZ;
+    modulation.framing = AX_FRAMING_MODE_RAW_PATTERN_MATCH | AX_FRAMING_CRCMODE_OFF;
+    modulation.shaping = AX_MODCFGF_FREQSHAPE_GAUSSIAN_BT_0_5;
+    modulation.bitrate = 9600;
+    modulation.radiolab = 1;
+    modulation.il2p_enabled = 1;
+    modulation.power = constants::power;
+    modulation.parameters = {.fsk = {.modulation_index = 0.5}};
+
+    if (ax_init(&config) != AX_INIT_OK)
+    {
+        Log.error(F("ax_init failed\r\n"));
+        exit(2);
+    }
+    ax_default_params(&config, &modulation);
+    ax_set_performance_tuning(&config, &modulation);
+}
+
+// ax_hw's per-operation SPI counts (the same ones command 0x20 prints on the board)
+static void print_spi_profile(const char *title)
+{
+    const ax_hw_op_counts *counts = ax_hw_profile_counts();
+    if (!counts) return;
+
+    printf("%s spi profile (transfers, bytes, us):\r\n", title);
+    for (uint8_t op = 0; op < AX_HW_OP_COUNT; op++)
+    {
+        if (counts[op].transfers == 0) continue;
+        printf("  %-16s %8u %8u %8u\r\n", ax_hw_op_name(op), counts[op].transfers, counts[op].bytes, counts[op].time_us);
+    }
+    ax_hw_profile_reset();
+}
+
+// what the data processor in loop() does to a packet body (command code + payload) with il2p on
+static int build_il2p_frame(uint8_t *body, int body_length, uint8_t *frame)
+{
+    int payload_length = body_length - 1;
+    unsigned char header[13]{0xF7, 0xF0, 0x52, 0x78, 0x67, 0x77, 0x77, 0x30, 0x52, 0x38, 0x67, 0x77, 0x10};
+    for (int i = 2; i < 12; i++) header[i] |= ((payload_length >> (11 - i)) & 0x01) << 7;
+
+    int index = 0;
+    frame[index++] = body[0];
+    frame[index++] = 0xF1;
+    frame[index++] = 0x5E;
+    frame[index++] = 0x48;
+
+    il2p_scramble_block(header, frame + index, 13);
+    il2p_encode_rs(frame + index, 13, 2, frame + index + 13);
+    index += 15;
+
+    il2p_scramble_block(body + 1, frame + index, payload_length);
+    il2p_encode_rs(frame + index, payload_length, 16, frame + index + payload_length);
+    index += payload_length + 16;
+
+    IL2P_CRC il2p_crc;
+    uint32_t crc = il2p_crc.encode_crc(il2p_crc.calculate_AX25(body + 1, payload_length));
+    frame[index++] = crc >> 24;
+    frame[index++] = crc >> 16;
+    frame[index++] = crc >> 8;
+    frame[index++] = crc;
+
+    return index;
+}
+
+// streams frames back to back in one transmit session, the way the tx handler bursts them, and collects what B
+// receives.  It gives up on the rest half a second after the last frame is loaded (they were lost).  Returns the time
+// from the start of the first frame to the end of the last one received, or to giving up
+static unsigned long send_session(ax_config &config_a, ax_modulation &modulation_a, ax_config &config_b, ax_modulation &modulation_b,
+                                  uint8_t frames[][300], int *lengths, int count, uint8_t received[][256], int *received_lengths,
+                                  int &received_count)
+{
+    static ax_packet rx_pkt;
+    ax_tx_job job;
+    int next = 0;
+    bool loading = false;
+    unsigned long loaded = 0;
+    received_count = 0;
+    unsigned long start = micros();
+    while ((received_count < count) && (micros() - start < 10000000) && (loading || (next < count) || (micros() - loaded < 500000)))
+    {
+        if (!loading && (next < count))
+        {
+            ax_tx_packet_start(&job, &modulation_a, frames[next], lengths[next], next > 0);
+            next++;
+            loading = true;
+        }
+        if (loading && (ax_tx_packet_step(&config_a, &job) == AX_TX_STATE_DRAIN))
+        {
+            loading = false;
+            loaded = micros();
+        }
+        if ((ax_rx_packet(&config_b, &rx_pkt, &modulation_b) == 1) && (rx_pkt.length <= 256))
+        {
+            memcpy(received[received_count], rx_pkt.data, rx_pkt.length);
+            received_lengths[received_count++] = rx_pkt.length;
+        }
+    }
+    return micros() - start;
+}
+
+// TCP ACKs from tncattach (IP + TCP, then with timestamps) and the odd DNS query, command byte not included
+static const int ack_sizes[] = {40, 40, 52, 40, 52, 40, 64, 90};
+
+// goodput for a run of small data frames, one IL2P frame each and then aggregated.  Returns the number of frames that
+// didn't come out the other end byte for byte
+static int aggregation_benchmark(ax_config &config_a, ax_modulation &modulation_a, ax_config &config_b, ax_modulation &modulation_b,
+                                 int count)
+{
+    static uint8_t bodies[64][256];
+    static int body_lengths[64];
+    static uint8_t frames[64][300];
+    static int frame_lengths[64];
+    static uint8_t received[64][256];
+    static int received_lengths[64];
+    if (count > 64) count = 64;
+
+    srand(1);
+    int payload_bytes = 0;
+    for (int n = 0; n < count; n++)
+    {
+        body_lengths[n] = ack_sizes[n % (sizeof(ack_sizes) / sizeof(ack_sizes[0]))] + 1;
+        bodies[n][0] = 0x00; // data
+        for (int i = 1; i < body_lengths[n]; i++) bodies[n][i] = rand();
+        payload_bytes += body_lengths[n] - 1;
+    }
+    printf("aggregation benchmark: %d frames, %d payload bytes\r\n", count, payload_bytes);
+
+    int bad = 0;
+    for (int aggregated = 0; aggregated < 2; aggregated++)
+    {
+        // what goes on the air
+        int frame_count = 0;
+        int air_bytes = 0;
+        if (!aggregated)
+        {
+            for (int n = 0; n < count; n++) frame_lengths[frame_count++] = build_il2p_frame(bodies[n], body_lengths[n], frames[n]);
+        }
+        else
+        {
+            uint8_t aggregate[256];
+            int length = 0;
+            for (int n = 0; n <= count; n++)
+            {
+                if ((n == count) || !aggregate_fits(length, body_lengths[n]))
+                {
+                    frame_lengths[frame_count] = build_il2p_frame(aggregate, length, frames[frame_count]);
+                    frame_count++;
+                    length = 0;
+                }
+                if (n < count) length = aggregate_add(aggregate, length, bodies[n], body_lengths[n]);
+            }
+        }
+        for (int i = 0; i < frame_count; i++) air_bytes += frame_lengths[i];
+
+        int received_count;
+        unsigned long elapsed = send_session(config_a, modulation_a, config_b, modulation_b, frames, frame_lengths, frame_count,
+                                             received, received_lengths, received_count);
+
+        // compare what came out, taking the aggregates apart like the receive handler does
+        int matched = 0;
+        int n = 0;
+        for (int i = 0; i < received_count; i++)
+        {
+            if (received[i][0] != constants::aggregate_code)
+            {
+                if ((n < count) && (received_lengths[i] == body_lengths[n]) && !memcmp(received[i], bodies[n], body_lengths[n])) matched++;
+                n++;
+                continue;
+            }
+            const byte *frame;
+            int frame_length;
+            int offset = 0;
+            while ((frame_length = aggregate_next(received[i], received_lengths[i], offset, frame)) > 0)
+            {
+                if ((n < count) && (frame_length == body_lengths[n]) && !memcmp(frame, bodies[n], frame_length)) matched++;
+                n++;
+            }
+        }
+        bad += count - matched;
+        printf("  %-12s %3d IL2P frames, %5d bytes, %8lu us, %d of %d ok, goodput %lu bps\r\n", aggregated ? "aggregated:" : "one each:",
+               frame_count, air_bytes, elapsed, matched, count, (unsigned long)(payload_bytes * 8ULL * 1000000 / elapsed));
+    }
+    return bad;
+}
+
+// B's end of the ARQ test: what the receive handler does with a numbered frame (or the idle pass, with no frame), then
+// checks what comes out is the next frame.  Returns the number that came out
+static int arq_receive(LinkArq &arq, uint8_t *frame, int length, uint8_t bodies[][256], int *body_lengths, int count, int &expected,
+                       int &out_of_order)
+{
+    uint8_t held[ARQ_FRAME_MAX];
+    int written = 0;
+    int inner = frame ? arq.received(frame, length, millis()) : 0;
+    const uint8_t *out = frame + ARQ_HEADER;
+    if (inner == 0)
+    {
+        inner = arq.next(held);
+        out = held;
+    }
+    while (inner > 0)
+    {
+        int n = out[1] | (out[2] << 8);  // each frame has its number in it
+        if ((n < expected) || (n >= count) || (inner != body_lengths[n]) || memcmp(out, bodies[n], inner)) out_of_order++;
+        else
+        {
+            expected = n + 1;
+            written++;
+        }
+        inner = arq.next(held);
+        out = held;
+    }
+    return written;
+}
+
+// [count] data frames from A to B over a lossy link, sent once and then through ARQ (arq.h).  A sends a window's worth
+// in each transmit session, repeats first, then B sends its ack once it's been quiet for arq_ack_delay.  Returns
+// non-zero if ARQ didn't get them all there in order
+// a data frame longer than ARQ_FRAME_MAX, out of order so it would be held, has to be turned away and not overrun
+// anything.  It's CRC-valid as far as the receiver knows, IL2P takes frames this long.  true if it was
+static bool arq_oversize_test()
+{
+    static struct
+    {
+        LinkArq arq;
+        uint8_t after[64];  // what comes after it in memory, has to stay the same
+    } receiver;
+    static uint8_t frame[0x200];
+    memset(receiver.after, 0x5A, sizeof(receiver.after));
+
+    // seq 0 to sync up, then seq 2 with 1 missing
+    frame[0] = constants::arq_data_code;
+    frame[1] = 0;
+    frame[2] = 0;
+    frame[3] = 0;
+    frame[4] = ARQ_RESTART;
+    frame[5] = 0x00;
+    bool ok = receiver.arq.received(frame, ARQ_HEADER + 1, millis()) == 1;
+    frame[1] = 2;
+    memset(frame + ARQ_HEADER, 0xEE, sizeof(frame) - ARQ_HEADER);
+    for (uint8_t seq = 2; seq <= ARQ_WINDOW; seq++)  // every _held slot but 1's
+    {
+        frame[1] = seq;
+        ok &= receiver.arq.received(frame, sizeof(frame), millis()) == 0;
+    }
+    uint8_t out[0x200];
+    ok &= (receiver.arq.next(out) == 0) && (receiver.arq.rejected == ARQ_WINDOW - 1);
+    for (uint8_t i = 0; i < sizeof(receiver.after); i++) ok &= receiver.after[i] == 0x5A;
+    printf("  oversized frame out of order: %s, %lu rejected\r\n", ok ? "turned away" : "NOT TURNED AWAY", receiver.arq.rejected);
+    return ok;
+}
+
+static int arq_test(ax_config &config_a, ax_modulation &modulation_a, ax_config &config_b, ax_modulation &modulation_b,
+                    AX5043Sim &sim_a, AX5043Sim &sim_b, int count, int payload_size, int loss)
+{
+    static uint8_t bodies[256][256];
+    static int body_lengths[256];
+    static uint8_t body[256];
+    static uint8_t frames[ARQ_WINDOW][300];
+    static int frame_lengths[ARQ_WINDOW];
+    static uint8_t received[ARQ_WINDOW][256];
+    static int received_lengths[ARQ_WINDOW];
+    static LinkArq arq_a, arq_b;
+    if (count > 256) count = 256;
+    if (payload_size > 197) payload_size = 197;  // the sim puts a frame in B's FIFO all at once, so with the header it has to fit
+    if (payload_size < 2) payload_size = 2;
+
+    srand(1);
+    for (int n = 0; n < count; n++)
+    {
+        body_lengths[n] = payload_size + 1;
+        bodies[n][0] = 0x00; // data
+        bodies[n][1] = n;
+        bodies[n][2] = n >> 8;
+        for (int i = 3; i < body_lengths[n]; i++) bodies[n][i] = rand();
+    }
+    sim_a.link.loss_percent = loss;
+    sim_b.link.loss_percent = loss;
+    printf("arq test: %d frames of %d bytes, %d%% lost each way\r\n", count, payload_size, loss);
+
+    // sent once, in sessions of a window each
+    int arrived = 0;
+    unsigned long start = micros();
+    for (int next = 0; next < count;)
+    {
+        int n = 0;
+        for (; (n < ARQ_WINDOW) && (next < count); n++, next++) frame_lengths[n] = build_il2p_frame(bodies[next], body_lengths[next], frames[n]);
+        int received_count;
+        send_session(config_a, modulation_a, config_b, modulation_b, frames, frame_lengths, n, received, received_lengths, received_count);
+        arrived += received_count;
+    }
+    unsigned long elapsed = micros() - start;
+    printf("  no arq:  %3d of %d arrived, %8lu us\r\n", arrived, count, elapsed);
+
+    // through ARQ
+    int next = 0;
+    int delivered = 0;
+    int out_of_order = 0;
+    int expected = 0;
+    int sessions = 0;
+    int acks = 0;
+    start = micros();
+    while ((delivered < count) && (micros() - start < 300000000))
+    {
+        arq_a.service(millis());
+        int n = 0;
+        int length;
+        while ((n < ARQ_WINDOW) && ((length = arq_a.repeat(body, millis())) > 0))
+        {
+            if (!arq_a.resend(body, millis())) continue;  // acknowledged since it was queued
+            arq_a.transmitted();
+            frame_lengths[n] = build_il2p_frame(body, length, frames[n]);
+            n++;
+        }
+        while ((n < ARQ_WINDOW) && (next < count) && arq_a.room())
+        {
+            memcpy(body, bodies[next], body_lengths[next]);
+            length = arq_a.send(body, body_lengths[next], sizeof(body), millis());
+            arq_a.transmitted();
+            frame_lengths[n] = build_il2p_frame(body, length, frames[n]);
+            n++;
+            next++;
+        }
+        int received_count = 0;
+        if (n > 0)
+        {
+            send_session(config_a, modulation_a, config_b, modulation_b, frames, frame_lengths, n, received, received_lengths, received_count);
+            sessions++;
+        }
+        for (int i = 0; i < received_count; i++)
+        {
+            delivered += arq_receive(arq_b, received[i], received_lengths[i], bodies, body_lengths, count, expected, out_of_order);
+        }
+
+        // B's turn
+        delay(constants::arq_ack_delay);
+        arq_b.service(millis());
+        delivered += arq_receive(arq_b, NULL, 0, bodies, body_lengths, count, expected, out_of_order);  // given up on a gap
+        if (!arq_b.ackDue(millis())) continue;
+        length = arq_b.ack(body);
+        frame_lengths[0] = build_il2p_frame(body, length, frames[0]);
+        ax_rx_on(&config_a, &modulation_a);
+        ax_tx_on(&config_b, &modulation_b);
+        send_session(config_b, modulation_b, config_a, modulation_a, frames, frame_lengths, 1, received, received_lengths, received_count);
+        if (received_count > 0) arq_a.received(received[0], received_lengths[0], millis());
+        acks++;
+        ax_rx_on(&config_b, &modulation_b);
+        ax_tx_on(&config_a, &modulation_a);
+    }
+    elapsed = micros() - start;
+    printf("  arq:     %3d of %d delivered in order, %d out of order, %8lu us, %d sessions, %d acks, goodput %lu bps\r\n",
+           delivered, count, out_of_order, elapsed, sessions, acks, (unsigned long)(delivered * (payload_size - 2) * 8ULL * 1000000 / elapsed));
+    printf("  sent %lu, sent again %lu, given up %lu, skipped %lu, duplicates %lu\r\n", arq_a.sent, arq_a.repeated, arq_a.given_up,
+           arq_b.skipped, arq_b.duplicates);
+    return (delivered == count) && (out_of_order == 0) && arq_oversize_test() ? 0 : 1;
+}
+
+// a bulk transfer one way with packets lost, the way erasure_frame and write_erasure_frames in the sketch do it.
+// Returns non-zero if the file didn't come out the same
+static int erasure_test(ax_config &config_a, ax_modulation &modulation_a, ax_config &config_b, ax_modulation &modulation_b,
+                        AX5043Sim &sim_a, int count, int payload_size, int loss)
+{
+    static uint8_t file[65536];
+    static uint8_t out[65536];
+    static uint8_t packet[ERASURE_PACKET];
+    static uint8_t frames[ERASURE_K + ERASURE_R_MAX][300];
+    static int frame_lengths[ERASURE_K + ERASURE_R_MAX];
+    static uint8_t received[ERASURE_K + ERASURE_R_MAX][256];
+    static int received_lengths[ERASURE_K + ERASURE_R_MAX];
+    static uint8_t frame[ERASURE_SYMBOL + 1];
+    static ErasureEncoder encoder;
+    static ErasureDecoder decoder;
+    int size = count * payload_size;
+    if (size > (int)sizeof(file)) size = sizeof(file);
+
+    srand(1);
+    for (int i = 0; i < size; i++) file[i] = rand();
+    sim_a.link.loss_percent = loss;
+    printf("bulk transfer test: %d bytes in frames of %d, %d repair packets per %d, %d%% lost\r\n", size, payload_size,
+           constants::erasure_repair, ERASURE_K, loss);
+
+    // the file goes in as Serial1 frames, and the packets go out a block's worth per session
+    int sent = 0;
+    int out_length = 0;
+    int packets = 0;
+    int arrived = 0;
+    encoder.start(constants::erasure_repair);
+    unsigned long start = micros();
+    while (true)
+    {
+        int n = 0;
+        while ((n < ERASURE_K + ERASURE_R_MAX) && encoder.active())
+        {
+            int length = encoder.next(packet);
+            if (length > 0)
+            {
+                frame_lengths[n] = build_il2p_frame(packet, length, frames[n]);
+                n++;
+                continue;
+            }
+            if (sent == size)
+            {
+                encoder.stop();
+                continue;
+            }
+            // a frame from Serial1, or what the encoder didn't take of it last time
+            sent += encoder.write(file + sent, min(payload_size, size - sent));
+        }
+        if (n == 0) break;
+        int received_count;
+        send_session(config_a, modulation_a, config_b, modulation_b, frames, frame_lengths, n, received, received_lengths, received_count);
+        packets += n;
+        arrived += received_count;
+        for (int i = 0; i < received_count; i++)
+        {
+            decoder.received(received[i], received_lengths[i], millis());
+            int length;
+            while ((length = decoder.next(frame)) > 0)
+            {
+                if (out_length + length - 1 <= (int)sizeof(out)) memcpy(out + out_length, frame + 1, length - 1);
+                out_length += length - 1;
+            }
+        }
+    }
+    unsigned long elapsed = micros() - start;
+
+    // if the end of it was lost, it's over when nothing more comes
+    delay(constants::erasure_timeout);
+    decoder.service(millis());
+    int length;
+    while ((length = decoder.next(frame)) > 0)
+    {
+        if (out_length + length - 1 <= (int)sizeof(out)) memcpy(out + out_length, frame + 1, length - 1);
+        out_length += length - 1;
+    }
+
+    ErasureReport report;
+    bool finished = decoder.finished(report);
+    bool match = finished && (out_length == size) && !memcmp(out, file, size);
+    printf("  %d packets, %d arrived, %8lu us, %lu blocks, %lu recovered, %lu lost, margin %d lowest, %.1f average\r\n", packets,
+           arrived, elapsed, report.blocks, report.recovered, report.lost, report.margin_min,
+           report.blocks ? (double)report.margin_total / report.blocks : 0.0);
+    printf("  file %s, %d of %d bytes, goodput %lu bps\r\n", match ? "ok" : "DIFFERENT", out_length, size,
+           (unsigned long)(size * 8ULL * 1000000 / elapsed));
+    return match ? 0 : 1;
+}
+
+// frames from Serial1 stored between passes and sent when the other end's heard from (flashqueue.h)
+static int store_test(ax_config &config_a, ax_modulation &modulation_a, ax_config &config_b, ax_modulation &modulation_b,
+                      int count, int payload_size)
+{
+    alignas(256) static uint8_t region[FLASHQUEUE_SIZE];  // zeros, like it is after programming
+    static uint8_t frames[32][300];
+    static int frame_lengths[32];
+    static uint8_t received[32][256];
+    static int received_lengths[32];
+    uint8_t body[256];
+    uint8_t kiss[FLASHQUEUE_FRAME_MAX];
+    uint8_t unwrapped[FLASHQUEUE_FRAME_MAX];
+    if (payload_size > 197) payload_size = 197;  // the sim puts the whole frame in B's FIFO at once
+
+    // the body of frame n, the same every time it's asked for
+    auto make_body = [&](int n) {
+        srand(n + 1);
+        body[0] = 0x00;
+        for (int i = 1; i <= payload_size; i++) body[i] = rand();
+        return payload_size + 1;
+    };
+
+    printf("store and forward test: %d frames of %d bytes, %d KB of flash\r\n", count, payload_size, FLASHQUEUE_SIZE / 1024);
+    FlashQueue store(region);
+    store.begin();
+    while (store.prepare());
+    int stored = 0;
+    for (int n = 0; n < count; n++)
+    {
+        // into RAM, and out to flash a page at a time while the loop goes round
+        int length = kiss_encapsulate(body, make_body(n), kiss);
+        while (!store.append(kiss, length) && store.service(true));
+        if (store.frames() == stored) break;
+        stored++;
+    }
+    while (store.service(true));
+    printf("  between passes: %d stored, %ld bytes, %lu erases\r\n", stored, store.bytes(), store.erases);
+
+    // the pass starts, and halfway through the first session A resets
+    FlashQueue *sender = new FlashQueue(region);
+    sender->begin();
+    printf("  after a reset: %d still to go\r\n", sender->frames());
+    int expected = 0;
+    int delivered = 0;
+    int sessions = 0;
+    bool reset = false;
+    unsigned long start = micros();
+    while (!sender->empty() && (sessions < 1000))
+    {
+        // a session's worth, each one acknowledged in flash as it's handed to the radio
+        int n = 0;
+        unsigned long airtime = 0;
+        while (!sender->empty() && (n < 32) && (airtime < constants::tx_session_budget))
+        {
+            int length = sender->peek(kiss);
+            int body_length = kiss_unwrap(kiss, length, unwrapped);
+            frame_lengths[n] = build_il2p_frame(unwrapped, body_length, frames[n]);
+            airtime += frame_lengths[n] * 8000UL / modulation_a.bitrate;
+            sender->acknowledge();
+            sender->service(false);  // the sent mark, the next time round the loop
+            n++;
+            if (!reset && (n == 4))
+            {
+                delete sender;
+                sender = new FlashQueue(region);
+                sender->begin();
+                reset = true;
+            }
+        }
+        int received_count;
+        send_session(config_a, modulation_a, config_b, modulation_b, frames, frame_lengths, n, received, received_lengths, received_count);
+        sessions++;
+        for (int i = 0; i < received_count; i++)
+        {
+            int length = make_body(expected++);
+            if ((received_lengths[i] == length) && !memcmp(received[i], body, length)) delivered++;
+        }
+        expected += n - received_count;
+    }
+    unsigned long elapsed = micros() - start;
+    printf("  pass: %d of %d delivered in order, %d sessions, %8lu us, goodput %lu bps\r\n", delivered, stored, sessions, elapsed,
+           (unsigned long)(stored * payload_size * 8ULL * 1000000 / elapsed));
+    bool ok = (delivered == stored) && (stored > 0) && sender->empty();
+
+    // round the log a few more times, to see it wears evenly
+    int laps = 5;
+    long written = 0;
+    while (written < (long)laps * FLASHQUEUE_SIZE)
+    {
+        int length = kiss_encapsulate(body, make_body(written & 0xFF), kiss);
+        while (!sender->append(kiss, length))
+        {
+            if (sender->service(true)) continue;
+            if (sender->peekLength() == 0) break;
+            sender->peek(unwrapped);
+            sender->acknowledge();
+        }
+        written += length;
+    }
+    unsigned long least = ~0UL, most = 0;
+    for (int row = 0; row < FLASHQUEUE_SIZE; row += FlashClass::ROW_SIZE)
+    {
+        unsigned long erases = FlashClass::erases()[(uintptr_t)region + row];
+        least = min(least, erases);
+        most = max(most, erases);
+    }
+    while (sender->service(true));
+    printf("  longest stall: a page or a row each call, %lu us here (the board's flash is what counts)\r\n", sender->max_stall);
+    printf("  wear: %ld KB through it, every row erased %lu to %lu times\r\n", written / 1024, least, most);
+    delete sender;
+    return ok ? 0 : 1;
+}
+
+int main(int argc, char **argv)
+{
+    int frames = 20;
+    int payload_size = 100;
+    int level = LOG_LEVEL_WARNING;
+    bool dma = true;
+    bool benchmark = false;
+    int arq_loss = -1;
+    int erasure_loss = -1;
+    bool store = false;
+    int position = 0;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-v") == 0) level = LOG_LEVEL_TRACE;
+        else if (strcmp(argv[i], "-d") == 0) dma = false;
+        else if (strcmp(argv[i], "-a") == 0) benchmark = true;
+        else if (strcmp(argv[i], "-r") == 0) arq_loss = ((i + 1 < argc) && isdigit(argv[i + 1][0])) ? atoi(argv[++i]) : 10;
+        else if (strcmp(argv[i], "-e") == 0) erasure_loss = ((i + 1 < argc) && isdigit(argv[i + 1][0])) ? atoi(argv[++i]) : 10;
+        else if (strcmp(argv[i], "-s") == 0) store = true;
+        else if (position++ == 0) frames = atoi(argv[i]);
+        else payload_size = atoi(argv[i]);
+    }
+    if (payload_size < 1 || payload_size > 214) payload_size = 214; // + 40 bytes of il2p still fits the length byte
+    Log.begin(level);
+
+    il2p_init();
+
+    AX5043Sim sim_a, sim_b;
+    sim_a.connect(sim_b);
+    AX5043Sim::slot[0] = &sim_a;
+    AX5043Sim::slot[1] = &sim_b;
+
+    ax_config config_a, config_b;
+    ax_modulation modulation_a, modulation_b;
+    setup_radio(config_a, modulation_a, ax5043_sim_spi_transfer<0>, dma ? ax5043_sim_spi_transfer_async<0> : NULL);
+    setup_radio(config_b, modulation_b, ax5043_sim_spi_transfer<1>, dma ? ax5043_sim_spi_transfer_async<1> : NULL);
+
+    ax_rx_on(&config_b, &modulation_b);
+    ax_tx_on(&config_a, &modulation_a);
+    printf("bring up: %lu us, %u + %u spi transfers\r\n", micros(), sim_a.spi_transactions, sim_b.spi_transactions);
+    print_spi_profile("bring up");
+
+    if (benchmark) return aggregation_benchmark(config_a, modulation_a, config_b, modulation_b, frames) ? 1 : 0;
+    if (store) return store_test(config_a, modulation_a, config_b, modulation_b, frames, payload_size);
+    if (erasure_loss >= 0) return erasure_test(config_a, modulation_a, config_b, modulation_b, sim_a, frames, payload_size, erasure_loss);
+    if (arq_loss >= 0) return arq_test(config_a, modulation_a, config_b, modulation_b, sim_a, sim_b, frames, payload_size, arq_loss);
+
+    int good = 0;
+    srand(1);
+    for (int n = 0; n < frames; n++)
+    {
+        uint8_t body[256];
+        uint8_t frame[300];
+        body[0] = 0x00; // data
+        for (int i = 1; i <= payload_size; i++) body[i] = rand();
+        int frame_length = build_il2p_frame(body, payload_size + 1, frame);
+
+        uint32_t a_transactions = sim_a.spi_transactions, a_bytes = sim_a.spi_bytes;
+        uint32_t b_transactions = sim_b.spi_transactions, b_bytes = sim_b.spi_bytes;
+        unsigned long start = micros();
+
+        ax_tx_packet(&config_a, &modulation_a, frame, frame_length);
+
+        static ax_packet rx_pkt;
+        bool received = false;
+        while (!received && micros() - start < 2000000)
+        {
+            received = ax_rx_packet(&config_b, &rx_pkt, &modulation_b) == 1;
+        }
+
+        // drained between frames, the way the loop drains it when it's idle
+        char line[EVENT_LOG_LINE];
+        while (event_log.next(line))
+            if (level >= LOG_LEVEL_TRACE) fputs(line, stdout);
+
+        bool match = received && rx_pkt.length == payload_size + 1 && memcmp(rx_pkt.data, body, payload_size + 1) == 0;
+        if (match) good++;
+        printf("frame %d: %s, %lu us, tx %u transfers/%u bytes, rx %u transfers/%u bytes\r\n", n,
+               match ? "ok" : (received ? "CORRUPT" : "LOST"), micros() - start,
+               sim_a.spi_transactions - a_transactions, sim_a.spi_bytes - a_bytes,
+               sim_b.spi_transactions - b_transactions, sim_b.spi_bytes - b_bytes);
+    }
+
+    printf("%d of %d frames ok, sent %u, received %u, dropped %u\r\n", good, frames,
+           sim_a.frames_sent, sim_b.frames_received, sim_b.frames_dropped);
+    print_spi_profile("frames");
+    return good == frames ? 0 : 1;
+}
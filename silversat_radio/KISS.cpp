@@ -28,6 +28,8 @@
  */
 
 #include "KISS.h"
+#include "log_levels.h"
+#define LOG_MODULE_MAX LOG_MAX_PACKET
 
 // takes a pointer to the data (*in), the length (ilen), and a pointer to the processed output (*out)
 // returns length of encoded packet
@@ -77,7 +79,7 @@ int kiss_unwrap(byte *in, int ilen, byte *out)
     {
         /* Need at least the "type indicator" byte and constants::FEND. */
         /* Probably more. */
-        Log.error(F("KISS message less than minimum length.\r\n"));
+        LOG_ERROR(F("KISS message less than minimum length.\r\n"));
         return (0);
     }
 
@@ -87,7 +89,7 @@ int kiss_unwrap(byte *in, int ilen, byte *out)
     }
     else
     {
-        Log.error(F("KISS frame should end with constants::FEND.\r\n"));
+        LOG_ERROR(F("KISS frame should end with constants::FEND.\r\n"));
     }
 
     if (in[0] == constants::FEND)
@@ -104,7 +106,7 @@ int kiss_unwrap(byte *in, int ilen, byte *out)
 
         if (in[j] == constants::FEND)
         {
-            Log.error(F("KISS frame should not have constants::FEND in the middle.\r\n"));
+            LOG_ERROR(F("KISS frame should not have constants::FEND in the middle.\r\n"));
         }
 
         if (escaped_mode)
@@ -120,7 +122,7 @@ int kiss_unwrap(byte *in, int ilen, byte *out)
             }
             else
             {
-                Log.error(F("KISS protocol error.  Found 0x%02x after constants::FESC.\r\n"), in[j]);
+                LOG_ERROR(F("KISS protocol error.  Found 0x%02x after constants::FESC.\r\n"), in[j]);
             }
             escaped_mode = 0;
         }
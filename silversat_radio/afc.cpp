@@ -0,0 +1,50 @@
+/**
+* @file afc.cpp
+* @author Tom Conrad (tom@silversat.org)
+* @brief Automatic frequency correction from the RF offsets of received packets
+* @version 1.0.1
+* @date 2026-10-19
+
+afc.cpp - Automatic frequency correction from the RF offsets of received packets
+Created by Tom Conrad, October 19, 2026.
+Released into the public domain.
+
+*/
+
+#include "afc.h"
+#include "log_levels.h"
+#define LOG_MODULE_MAX LOG_MAX_RADIO
+
+bool FrequencyTracker::update(int32_t offset_hz)
+{
+  if (abs(offset_hz) > constants::afc_limit)
+  {
+    LOG_TRACE(F("afc: ignoring offset %l Hz\r\n"), offset_hz);
+    return false;
+  }
+
+  // single pole filter, the first one just sets it
+  if (_primed) _residual += (offset_hz - _residual) / constants::afc_filter;
+  else _residual = offset_hz;
+  _primed = true;
+
+  if (abs(_residual) > _max_residual) _max_residual = abs(_residual);
+  LOG_TRACE(F("afc: offset %l Hz, residual %l Hz\r\n"), offset_hz, _residual);
+
+  if (abs(_residual) < constants::afc_deadband) return false;
+
+  // move it all into the correction.  Later packets are measured against the new frequency, so take it out of the filter too
+  int32_t correction = constrain(_correction + _residual, -constants::afc_limit, constants::afc_limit);
+  _residual -= correction - _correction;
+  if (correction == _correction) return false;  //pinned at the limit
+  _correction = correction;
+  LOG_NOTICE(F("afc: correction now %l Hz\r\n"), _correction);
+  return true;
+}
+
+void FrequencyTracker::reset()
+{
+  _correction = 0;
+  _residual = 0;
+  _primed = false;
+}
@@ -0,0 +1,45 @@
+/**
+* @file afc.h
+* @author Tom Conrad (tom@silversat.org)
+* @brief Automatic frequency correction from the RF offsets of received packets
+* @version 1.0.1
+* @date 2026-10-19
+
+afc.h - Automatic frequency correction from the RF offsets of received packets
+Created by Tom Conrad, October 19, 2026.
+Released into the public domain.
+
+The AX5043 tracks the carrier within a packet and reports how far off it was (the RFFREQOFFS chunk).
+The ground only updates the doppler frequencies every so often, so between updates we drift off.  This closes
+the loop onboard: per-packet offsets are averaged, and once the average is outside the deadband the whole of it
+is moved into the correction.  Radio applies the correction with a quick synth adjust (no re-ranging).
+
+The measured offset is relative to the corrected frequency, so what's left in the filter after a correction is the
+residual error.  Offsets bigger than constants::afc_limit are thrown out, and the correction is limited to that too.
+*/
+
+#ifndef AFC_H
+#define AFC_H
+
+#include "Arduino.h"
+#include "constants.h"
+#include "ArduinoLog.h"
+
+class FrequencyTracker {
+public:
+  bool update(int32_t offset_hz);  //one packet's offset, true if the correction changed
+  void reset();
+
+  int32_t correction() { return _correction; }  //Hz, add to the receive frequency
+  int32_t residual() { return _residual; }      //filtered offset that's still there, Hz
+  int32_t max_residual() { return _max_residual; }
+  void clear_max_residual() { _max_residual = 0; }
+
+private:
+  int32_t _correction{0};
+  int32_t _residual{0};
+  int32_t _max_residual{0};
+  bool _primed{false};  //the first packet seeds the filter
+};
+
+#endif
@@ -0,0 +1,41 @@
+/**
+* @file aggregate.cpp
+* @author Tom Conrad (tom@silversat.org)
+* @brief Several small KISS frames in one IL2P frame
+* @version 1.0.1
+* @date 2026-10-19
+
+aggregate.cpp - Several small KISS frames in one IL2P frame
+Created by Tom Conrad, October 19, 2026.
+Released into the public domain.
+
+*/
+
+#include "aggregate.h"
+
+bool aggregate_fits(int length, int frame_length)
+{
+  if (length == 0) length = 1;  //the command byte
+  return (frame_length > 0) && (length + 1 + frame_length <= constants::aggregate_max);
+}
+
+int aggregate_add(byte *aggregate, int length, const byte *frame, int frame_length)
+{
+  if (!aggregate_fits(length, frame_length)) return 0;
+  if (length == 0) aggregate[length++] = constants::aggregate_code;
+  aggregate[length++] = frame_length;
+  memcpy(aggregate + length, frame, frame_length);
+  return length + frame_length;
+}
+
+int aggregate_next(const byte *aggregate, int length, int &offset, const byte *&frame)
+{
+  if (offset == 0) offset = 1;  //past the command byte
+  if (offset >= length) return 0;
+  int frame_length = aggregate[offset];
+  // the CRC passed, so this would be the other end's bug, but it's not going to run off the end of the packet
+  if ((frame_length == 0) || (offset + 1 + frame_length > length)) return -1;
+  frame = aggregate + offset + 1;
+  offset += 1 + frame_length;
+  return frame_length;
+}
@@ -0,0 +1,43 @@
+/**
+* @file aggregate.h
+* @author Tom Conrad (tom@silversat.org)
+* @brief Several small KISS frames in one IL2P frame
+* @version 1.0.1
+* @date 2026-10-19
+
+aggregate.h - Several small KISS frames in one IL2P frame
+Created by Tom Conrad, October 19, 2026.
+Released into the public domain.
+
+A TCP ACK from tncattach is about 44 bytes, and on its own it goes out with 15 header bytes, 16 parity bytes, 4 CRC
+bytes and the sync, and in its own session it's the preamble and a turnaround too.  When there's more than one frame
+waiting in the interactive queue (txqueue.h) they get packed into one IL2P frame instead:
+
+  constants::aggregate_code, then for each frame: its length (1 byte), its KISS command byte and its body
+
+The lengths are of the unwrapped frames, and the whole aggregate is at most constants::aggregate_max bytes, so a length
+always fits in a byte.  It's one IL2P payload, so it's protected by the same RS parity and CRC as any other frame and
+all the frames in it are either received or lost together.
+
+The receive side always takes them apart, so an end with constants::aggregate_frames turned off still understands
+one that has it on.  Only data frames (command byte 0x00, or compressed, see headercomp.h and lz.h) go
+in an aggregate, and they all go out on Serial1.
+*/
+
+#ifndef AGGREGATE_H
+#define AGGREGATE_H
+
+#include "Arduino.h"
+#include "constants.h"
+
+// true if a frame of frame_length bytes still fits in an aggregate that's length bytes so far (0 for not started)
+bool aggregate_fits(int length, int frame_length);
+
+// adds an unwrapped frame (command byte and body), returns the new length of the aggregate, 0 if it doesn't fit
+int aggregate_add(byte *aggregate, int length, const byte *frame, int frame_length);
+
+// the next frame in a received aggregate, starting from offset 0.  Returns its length and points frame at it,
+// 0 when there are no more, -1 if the lengths don't add up
+int aggregate_next(const byte *aggregate, int length, int &offset, const byte *&frame);
+
+#endif
@@ -0,0 +1,283 @@
+/**
+* @file arq.cpp
+* @author Tom Conrad (tom@silversat.org)
+* @brief Selective repeat ARQ between the two radios, for the data port
+* @version 1.0.1
+* @date 2026-10-19
+
+arq.cpp - Selective repeat ARQ between the two radios, for the data port
+Created by Tom Conrad, October 19, 2026.
+Released into the public domain.
+
+*/
+
+#include "arq.h"
+
+enum arq_state
+{
+  ARQ_FREE,
+  ARQ_SENT,  //waiting for an acknowledgment
+  ARQ_DUE,  //needs sending again
+  ARQ_QUEUED,  //handed out by repeat(), on its way
+  ARQ_DONE  //the other end has it (but not everything before it), or we gave up
+};
+
+bool LinkArq::room()
+{
+  return (uint8_t)(_next_seq - _base) < ARQ_WINDOW;
+}
+
+int LinkArq::send(byte *frame, int length, int size, unsigned long now_ms)
+{
+  if (!room() || (length + ARQ_HEADER > ARQ_FRAME_MAX) || (length + ARQ_HEADER > size)) return length;
+  memmove(frame + ARQ_HEADER, frame, length);
+  length += ARQ_HEADER;
+  frame[0] = constants::arq_data_code;
+  frame[1] = _next_seq;
+  Sent &entry = _sent[_next_seq % ARQ_WINDOW];
+  entry.retries = 0;
+  entry.length = length;
+  _last = _next_seq++;
+  _last_new = true;
+  stamp(frame, entry, now_ms);
+  memcpy(entry.frame, frame, length);
+  sent++;
+  return length;
+}
+
+bool LinkArq::resend(byte *frame, unsigned long now_ms)
+{
+  uint8_t seq = frame[1];
+  Sent &entry = _sent[seq % ARQ_WINDOW];
+  _last = seq;
+  _last_new = false;
+  // acknowledged or given up on since it was queued.  Its base would be newer than the frame, so it doesn't go
+  if ((uint8_t)(seq - _base) >= (uint8_t)(_next_seq - _base) || (entry.state == ARQ_FREE) || (entry.state == ARQ_DONE))
+  {
+    _last_valid = false;
+    return false;
+  }
+  stamp(frame, entry, now_ms);
+  return true;
+}
+
+void LinkArq::unsend()
+{
+  if (!_last_valid) return;
+  _last_valid = false;
+  if (_last_new)
+  {
+    _sent[_last % ARQ_WINDOW].state = ARQ_FREE;
+    _next_seq--;
+    sent--;
+  }
+  else if (_sent[_last % ARQ_WINDOW].state == ARQ_SENT) _sent[_last % ARQ_WINDOW].state = ARQ_QUEUED;  //it's back in the queue it came from
+}
+
+// the header as it is right now, and the copy's bookkeeping
+void LinkArq::stamp(byte *frame, Sent &entry, unsigned long now_ms)
+{
+  frame[2] = _base;
+  frame[3] = _expected;
+  frame[4] = bitmap() | (_restarted ? ARQ_RESTART : 0);
+  entry.state = ARQ_SENT;
+  entry.sent_ms = now_ms;
+  entry.order = ++_order;
+  _ack_owed = false;
+  _last_valid = true;
+}
+
+int LinkArq::repeat(byte *frame, unsigned long now_ms)
+{
+  for (uint8_t seq = _base; seq != _next_seq; seq++)
+  {
+    Sent &entry = _sent[seq % ARQ_WINDOW];
+    if (entry.state != ARQ_DUE) continue;
+    entry.state = ARQ_QUEUED;
+    entry.sent_ms = now_ms;
+    entry.retries++;
+    repeated++;
+    memcpy(frame, entry.frame, entry.length);
+    return entry.length;
+  }
+  return 0;
+}
+
+void LinkArq::service(unsigned long now_ms)
+{
+  for (uint8_t seq = _base; seq != _next_seq; seq++)
+  {
+    Sent &entry = _sent[seq % ARQ_WINDOW];
+    if (((entry.state != ARQ_SENT) && (entry.state != ARQ_QUEUED)) || (now_ms - entry.sent_ms < constants::arq_timeout)) continue;
+    if (entry.retries < constants::arq_retries) entry.state = ARQ_DUE;
+    else
+    {
+      entry.state = ARQ_DONE;
+      given_up++;
+    }
+  }
+  // given up from the bottom of the window, base tells the other end to stop waiting for them
+  while ((_base != _next_seq) && (_sent[_base % ARQ_WINDOW].state == ARQ_DONE)) _sent[_base++ % ARQ_WINDOW].state = ARQ_FREE;
+
+  // the sender must have given up on the gap
+  if ((_held_count > 0) && (now_ms - _gap_since >= constants::arq_gap_timeout))
+  {
+    for (uint8_t seq = _expected + 1; seq != (uint8_t)(_expected + ARQ_WINDOW); seq++)
+    {
+      Held &held = _held[seq % ARQ_WINDOW];
+      if (!held.held || (held.seq != seq)) continue;
+      _skip_to = seq;
+      break;
+    }
+  }
+}
+
+void LinkArq::acknowledged(uint8_t ack, uint8_t bits)
+{
+  unsigned long newest = 0;  //the last frame sent that the other end has, in send order
+  uint8_t outstanding = _next_seq - _base;
+  if ((uint8_t)(ack - _base) <= outstanding)
+  {
+    for (; _base != ack; _base++)
+    {
+      Sent &entry = _sent[_base % ARQ_WINDOW];
+      if ((entry.state != ARQ_FREE) && (entry.order > newest)) newest = entry.order;
+      entry.state = ARQ_FREE;
+      _restarted = false;
+    }
+  }
+  for (int bit = 0; bit < ARQ_WINDOW - 1; bit++)
+  {
+    uint8_t seq = ack + 1 + bit;
+    if (!(bits & (1 << bit)) || ((uint8_t)(seq - _base) >= (uint8_t)(_next_seq - _base))) continue;
+    Sent &entry = _sent[seq % ARQ_WINDOW];
+    if ((entry.state == ARQ_FREE) || (entry.state == ARQ_DONE)) continue;
+    if (entry.order > newest) newest = entry.order;
+    entry.state = ARQ_DONE;
+    _restarted = false;
+  }
+  // anything sent before one that got there, and didn't, was lost
+  for (uint8_t seq = _base; seq != _next_seq; seq++)
+  {
+    Sent &entry = _sent[seq % ARQ_WINDOW];
+    if ((entry.state == ARQ_SENT) && (entry.order < newest)) entry.state = ARQ_DUE;
+  }
+}
+
+int LinkArq::received(byte *frame, int length, unsigned long now_ms)
+{
+  if (frame[0] == constants::arq_ack_code)
+  {
+    if (length >= ARQ_ACK_LENGTH) acknowledged(frame[1], frame[2] & ~ARQ_RESTART);
+    return 0;
+  }
+  if (length <= ARQ_HEADER) return 0;
+  if (length > ARQ_FRAME_MAX)
+  {
+    rejected++;  //longer than we ever send, so not from one of us.  It wouldn't fit in _held
+    return 0;
+  }
+  uint8_t seq = frame[1];
+  uint8_t base = frame[2];
+  bool restart = frame[4] & ARQ_RESTART;
+  acknowledged(frame[3], frame[4] & ~ARQ_RESTART);
+  _ack_owed = true;
+  _last_rx = now_ms;
+
+  // the other end has reset, or we have, so its base is where we start.  Only once for each reset, the flag stays on
+  // until it hears from us
+  if (!_synced || (restart && !_peer_restarted))
+  {
+    for (int i = 0; i < ARQ_WINDOW; i++) _held[i].held = false;
+    _held_count = 0;
+    _expected = base;
+    _skip_to = base;
+    _synced = true;
+  }
+  _peer_restarted = restart;
+  uint8_t distance = seq - _expected;
+  if (ahead(base, _skip_to)) _skip_to = base;
+
+  if (distance >= ARQ_WINDOW)
+  {
+    duplicates++;  //we had it, the acknowledgment didn't make it back
+    return 0;
+  }
+  if ((distance == 0) && (_skip_to == _expected))
+  {
+    _expected++;
+    _skip_to = _expected;
+    return length - ARQ_HEADER;
+  }
+  Held &held = _held[seq % ARQ_WINDOW];
+  if (held.held && (held.seq == seq))
+  {
+    duplicates++;
+    return 0;
+  }
+  if (_held_count == 0) _gap_since = now_ms;
+  held.held = true;
+  held.seq = seq;
+  held.length = length - ARQ_HEADER;
+  memcpy(held.frame, frame + ARQ_HEADER, held.length);
+  _held_count++;
+  return 0;
+}
+
+int LinkArq::next(byte *frame)
+{
+  while (true)
+  {
+    Held &held = _held[_expected % ARQ_WINDOW];
+    if (held.held && (held.seq == _expected))
+    {
+      held.held = false;
+      _held_count--;
+      _expected++;
+      if (ahead(_expected, _skip_to)) _skip_to = _expected;
+      if (_held_count > 0) _gap_since = _last_rx;  //the next gap gets its own time
+      memcpy(frame, held.frame, held.length);
+      return held.length;
+    }
+    if (_skip_to == _expected) return 0;
+    _expected++;  //the sender gave up on this one
+    skipped++;
+  }
+}
+
+bool LinkArq::ackDue(unsigned long now_ms)
+{
+  if (!_ack_owed || (now_ms - _last_rx < constants::arq_ack_delay)) return false;
+  _ack_owed = false;  //it's queued, ack() fills in whatever it is by the time it goes
+  return true;
+}
+
+int LinkArq::ack(byte *frame)
+{
+  frame[0] = constants::arq_ack_code;
+  frame[1] = _expected;
+  frame[2] = bitmap();
+  return ARQ_ACK_LENGTH;
+}
+
+uint8_t LinkArq::bitmap()
+{
+  uint8_t bits = 0;
+  for (int bit = 0; bit < ARQ_WINDOW - 1; bit++)
+  {
+    uint8_t seq = _expected + 1 + bit;
+    Held &held = _held[seq % ARQ_WINDOW];
+    if (held.held && (held.seq == seq)) bits |= 1 << bit;
+  }
+  return bits;
+}
+
+void LinkArq::clearCounts()
+{
+  sent = 0;
+  repeated = 0;
+  given_up = 0;
+  skipped = 0;
+  duplicates = 0;
+  rejected = 0;
+}
@@ -0,0 +1,130 @@
+/**
+* @file arq.h
+* @author Tom Conrad (tom@silversat.org)
+* @brief Selective repeat ARQ between the two radios, for the data port
+* @version 1.0.1
+* @date 2026-10-19
+
+arq.h - Selective repeat ARQ between the two radios, for the data port
+Created by Tom Conrad, October 19, 2026.
+Released into the public domain.
+
+A frame lost on the air used to be found by TCP at the far end, after its retransmit timeout, which over a half duplex
+link with 2 second sessions is a long time.  Now the radios do it themselves, so a loss costs one round trip and TCP
+sees a clean pipe.
+
+Every frame from Serial1 (after compression and aggregation, it's whatever is about to be encoded) gets a header and a
+sequence number, and a copy is kept until the other end says it has it:
+
+  constants::arq_data_code, seq, base, ack, bitmap, then the frame (its command byte and body)
+
+base is the oldest frame we still have a copy of, so the other end knows it can stop waiting for anything before it.
+ack and bitmap are the other direction's acknowledgment, along for the ride: ack is the next frame we're waiting
+for, and bit n of bitmap is set if we already have frame ack + 1 + n.  That only takes 7 bits, and the top one
+(ARQ_RESTART) says this end has started numbering again since a reset.  When there's no data going back the
+acknowledgment goes on its own, queued ahead of everything else once the other end has been quiet for arq_ack_delay:
+
+  constants::arq_ack_code, ack, bitmap
+
+Up to ARQ_WINDOW frames can be waiting for acknowledgment, then new data waits.  A frame is sent again when a frame
+sent after it has been acknowledged and it hasn't (that's the one round trip), or after arq_timeout with nothing.
+After arq_retries it's given up on and TCP gets it.  One that's been queued to go again and still hasn't gone (dropped
+or preempted) after arq_timeout is due again, and that counts as a try, so the window can't stall on it.
+
+The receiving end holds frames that arrive ahead of a missing one and passes them on in order, since header
+compression (headercomp.h) has to see them in the order they were compressed.  If the gap is still there after
+arq_gap_timeout (the sender must have given up) it moves on.  A sender sets ARQ_RESTART on everything until one of
+its frames is acknowledged.  The first one with it set (and the first frame at all after our own reset) means start
+again from that frame's base.  Anything else that's behind is a duplicate, never a reason to go backwards, since
+what's passed on has to be new to header compression.  A frame queued to go again that's been acknowledged (or given
+up on) by the time it's encoded is dropped.
+
+RAM is two sets of ARQ_WINDOW frames, about 3.5 KB: the copies to send again, and the frames held for order.
+*/
+
+#ifndef ARQ_H
+#define ARQ_H
+
+#include "Arduino.h"
+#include "constants.h"
+
+#define ARQ_WINDOW 8  // 2 seconds of full frames at 9600, one session
+#define ARQ_HEADER 5
+#define ARQ_FRAME_MAX 215  // the most an IL2P frame takes, see aggregate_max.  A full tncattach frame is 205 with its command byte
+#define ARQ_ACK_LENGTH 3
+#define ARQ_RESTART 0x80  // in the bitmap byte, see above
+
+class LinkArq {
+public:
+  // sending
+  bool room();  //a new frame can go
+  int send(byte *frame, int length, int size, unsigned long now_ms);  //adds the header to a new frame in place and keeps a copy, returns the new length (the same if it can't)
+  bool resend(byte *frame, unsigned long now_ms);  //a frame from repeat() is about to be encoded, brings its acknowledgment up to date.  false if it's not needed any more, drop it
+  void unsend();  //the frame from the last send() or resend() isn't going after all (preempted)
+  void transmitted() { _last_valid = false; }  //it's gone to the radio, too late for unsend
+  int repeat(byte *frame, unsigned long now_ms);  //copies out the next frame that needs sending again, returns its length, 0 if none
+  void service(unsigned long now_ms);  //timeouts, call it every pass in receive
+
+  // receiving
+  int received(byte *frame, int length, unsigned long now_ms);  //a data or ack frame.  Returns the length of the frame after the header if it can go out now, 0 if not
+  int next(byte *frame);  //frames that were held and can go out now, in order.  Returns the length, 0 when there are no more
+  bool ackDue(unsigned long now_ms);  //an acknowledgment should go on its own, true once for each one owed
+  int ack(byte *frame);  //fills in an ack frame (3 bytes), the one queued is just a placeholder
+
+  bool arq(byte command) { return (command == constants::arq_data_code) || (command == constants::arq_ack_code); }
+
+  // counts for print stats
+  unsigned long sent{0};
+  unsigned long repeated{0};
+  unsigned long given_up{0};
+  unsigned long skipped{0};  //missing frames the receiving end stopped waiting for
+  unsigned long duplicates{0};
+  unsigned long rejected{0};  //data frames longer than ARQ_FRAME_MAX
+  void clearCounts();
+
+private:
+  struct Sent
+  {
+    uint8_t state;
+    uint8_t retries;
+    uint8_t length;
+    unsigned long sent_ms;  //or queued, by repeat()
+    unsigned long order;  //when it was last sent, in frames
+    byte frame[ARQ_FRAME_MAX];
+  };
+  struct Held
+  {
+    bool held;
+    uint8_t seq;
+    uint8_t length;
+    byte frame[ARQ_FRAME_MAX - ARQ_HEADER];
+  };
+
+  void stamp(byte *frame, Sent &entry, unsigned long now_ms);
+  void acknowledged(uint8_t ack, uint8_t bitmap);
+  uint8_t bitmap();
+  bool ahead(uint8_t seq, uint8_t from) { return (uint8_t)(seq - from) < 128; }  //seq is from or after it, mod 256
+
+  // sending
+  Sent _sent[ARQ_WINDOW]{};
+  uint8_t _next_seq{0};
+  uint8_t _base{0};
+  unsigned long _order{0};
+  uint8_t _last{0};  //the last frame stamped, for unsend
+  bool _last_new{false};
+  bool _last_valid{false};
+  bool _restarted{true};  //nothing we've sent has been acknowledged since the reset
+
+  // receiving
+  Held _held[ARQ_WINDOW]{};
+  int _held_count{0};
+  uint8_t _expected{0};
+  uint8_t _skip_to{0};  //the sender's base, or where the gap timeout says to go
+  bool _ack_owed{false};
+  unsigned long _last_rx{0};
+  unsigned long _gap_since{0};
+  bool _synced{false};  //had a frame from the other end since the reset
+  bool _peer_restarted{false};  //the last frame had ARQ_RESTART
+};
+
+#endif
@@ -29,6 +29,9 @@
  */
 
 #include "ax.h"
+#include "log_levels.h"
+#include "eventlog.h"
+#define LOG_MODULE_MAX LOG_MAX_AX
 // the following deal with a circular dependency
 // #include "ax_params.h"
 // #include "ax_hw.h"
@@ -96,56 +99,23 @@ void ax_fifo_tx_1k_zeros(ax_config *config)
 }
 
 /**
- * write tx data
+ * write the preamble (and sync word)
+ * continuation = true is used for the second and later frames of a burst.  The transmitter is
+ * still running, so the receiver is already bit synced and only a short inter-frame sync is sent
+ * (burst_sync_length preamble bytes, plus the sync word for IL2P) instead of the full preamble.
  */
-void ax_fifo_tx_data(ax_config *config, ax_modulation *mod,
-                     uint8_t *data, uint16_t length)
+static void ax_fifo_tx_preamble(ax_config *config, ax_modulation *mod, bool continuation)
 {
     uint8_t header[8];
-    uint16_t fifocount;
-    uint8_t chunk_length;
-    uint16_t rem_length;
-    uint8_t pkt_end = 0;
-    uint8_t pkt_max_chunk = 239;  //max size before splitting up chunks.  I changed it to 239 to account for flags byte
-
-    /* send remainder first */
-    chunk_length = length % pkt_max_chunk;  //if length = pkt_max_chunk -> 0
-    rem_length = length - chunk_length; 
-    Log.trace(F("chunk length = %d\r\n"), chunk_length);
-    Log.trace(F("rem length = %d\r\n"), rem_length);
-
-    if (length <= pkt_max_chunk)  //why not 240?, I changed that. tkc - 10/18/24
-    { /* all in one go */
-        pkt_end = AX_FIFO_TXDATA_PKTEND;
-    }
+    uint8_t preamble_length = continuation ? constants::burst_sync_length : constants::preamble_length;
 
-    fifocount = ax_hw_read_register_16(config, AX_REG_FIFOCOUNT);
-    Log.verbose("%X bytes in the FIFO\r\n", fifocount);
-
-    /* wait for enough space to contain both the preamble and chunk */
-    do
-    {
-        fifocount = ax_hw_read_register_16(config, AX_REG_FIFOCOUNT); // fifocount is current number of committed words.  So, free space is 256 - fifocount
-        Log.verbose("+");
-    } while (fifocount > (256 - (chunk_length + 17)));
-    Log.verbose("\r\n");
-
-    // where does 20 come from?  I'm still not sure why.  Chunk length is the amount of bytes over the 200.
-    // preamble takes 4 bytes
-    // sync bytes are another 7
-    // Add 4 more for data header assuming length byte is included.  15 total.  That's not 20...
-    // however a 240 byte chunk only leaves 15 bytes for everything else, so I'm guessing that's what limits it.
-    // you can write up to 240 bytes, but it needs to be broken into 200 + 40 chunks by the code.
-    // it does the smaller first so it clears out, once the preamble and framing is sent
-
-    /* write preamble */
     switch (mod->framing & 0xE)
     {
     case AX_FRAMING_MODE_HDLC:
         /* preamble */
         header[0] = AX_FIFO_CHUNK_REPEATDATA;                                         // three byte payload (hdr1,2,3)
         header[1] = AX_FIFO_TXDATA_UNENC | AX_FIFO_TXDATA_RAW | AX_FIFO_TXDATA_NOCRC; // see table 10 in programming manual
-        header[2] = constants::preamble_length;                                       // repeat count      was 9
+        header[2] = preamble_length;                                                  // repeat count      was 9
         if (mod->fec == 1)
         {
             header[3] = 0x7E; // FEC requires 0x7E preambles
@@ -161,7 +131,7 @@ void ax_fifo_tx_data(ax_config *config, ax_modulation *mod,
         /* preamble */
         header[0] = AX_FIFO_CHUNK_REPEATDATA;                                         // three byte payload (hdr1,2,3)
         header[1] = AX_FIFO_TXDATA_UNENC | AX_FIFO_TXDATA_RAW | AX_FIFO_TXDATA_NOCRC; // see table 10 in programming manual
-        header[2] = constants::preamble_length;                                                                // repeat count
+        header[2] = preamble_length;                                                  // repeat count
         header[3] = 0xAA;                                                             // data
         ax_hw_write_fifo(config, header, 4);
         
@@ -177,18 +147,29 @@ void ax_fifo_tx_data(ax_config *config, ax_modulation *mod,
         ax_hw_write_fifo(config, header, header[1] + 2);
         break;
     }
+}
+
+/**
+ * write the first data chunk, with the packet start flag (and the length byte if there is one)
+ */
+static void ax_fifo_tx_first_chunk(ax_config *config, ax_tx_job *job)
+{
+    ax_modulation *mod = job->mod;
+    uint8_t header[4];
+    uint8_t header_length;
+    uint8_t pkt_end = job->rem_length ? 0 : AX_FIFO_TXDATA_PKTEND;
+    uint8_t chunk_length = job->chunk_length;
 
-    /* write first data */
     if (((mod->framing & 0xE) == AX_FRAMING_MODE_HDLC) || /* hdlc */
         (mod->fixed_packet_length) ||                     /* or fixed length */
-        (length >= 255)                                   /* or can't include length byte anyhow */
+        (job->length >= 255)                              /* or can't include length byte anyhow */
     )
     {
         /* no length byte */
         header[0] = AX_FIFO_CHUNK_DATA;
         header[1] = 1 + chunk_length; /* incl flags */
         header[2] = AX_FIFO_TXDATA_PKTSTART | pkt_end;
-        ax_hw_write_fifo(config, header, 3);
+        header_length = 3;
     }
     else if (mod->il2p_enabled == 1)
     {
@@ -197,10 +178,10 @@ void ax_fifo_tx_data(ax_config *config, ax_modulation *mod,
         header[1] = 1 + chunk_length + 1; // incl flags
         header[2] = AX_FIFO_TXDATA_PKTSTART | pkt_end | AX_FIFO_TXDATA_NOCRC;  //the no CRC directive should be qualified to be only for il2p
         //  temp to see if this is messing up ninotnc (was here)
-        header[3] = length + 1; // incl length byte
-        ax_hw_write_fifo(config, header, 4);
+        header[3] = job->length + 1; // incl length byte
+        header_length = 4;
         
-        // ax_hw_write_fifo(config, header, 3);  //this line for il2p testing...delete when you want
+        // header_length = 3;  //this line for il2p testing...delete when you want
     }
     else 
     {
@@ -208,60 +189,135 @@ void ax_fifo_tx_data(ax_config *config, ax_modulation *mod,
         header[0] = AX_FIFO_CHUNK_DATA;   // 0xE1
         header[1] = 1 + chunk_length + 1; /* incl flags */
         header[2] = AX_FIFO_TXDATA_PKTSTART | pkt_end | AX_FIFO_TXDATA_NOCRC;
-        header[3] = length + 1; /* incl length byte */
-        ax_hw_write_fifo(config, header, 4);
+        header[3] = job->length + 1; /* incl length byte */
+        header_length = 4;
     }
-    /*
-    // not checking that there's enough room in the FIFO? well, I am now.
-    do
+    // header, data and commit in one go.  A long chunk goes out by DMA (if there is one) while we get on with things
+    ax_hw_write_fifo_commit(config, header, header_length, job->data, chunk_length);
+    LOG_TRACE("First data written to FIFO\r\n");
+    if (LOG_ON(LOG_LEVEL_VERBOSE)) for(int i=0; i<chunk_length; i++) LOG_VERBOSE("index: %i, data: %X\r\n", i, *(job->data+i));
+    job->data += chunk_length;
+}
+
+/**
+ * sets up a job to load a packet into the FIFO a step at a time, see ax_tx_packet_step.
+ * The packet has to stay put until the job gets to AX_TX_STATE_DRAIN.
+ * start_state is AX_TX_STATE_WAIT_SVMODEM straight after a power mode change, otherwise AX_TX_STATE_PREAMBLE
+ */
+void ax_tx_packet_start(ax_tx_job *job, ax_modulation *mod, uint8_t *packet, uint16_t length,
+                        bool continuation, uint8_t start_state)
+{
+    job->mod = mod;
+    job->data = packet;
+    job->length = length;
+    job->continuation = continuation;
+
+    /* send remainder first */
+    job->chunk_length = length % AX_TX_MAX_CHUNK;  //if length = AX_TX_MAX_CHUNK -> 0
+    job->rem_length = length - job->chunk_length;
+    LOG_TRACE(F("chunk length = %d\r\n"), job->chunk_length);
+    LOG_TRACE(F("rem length = %d\r\n"), job->rem_length);
+
+    job->state = start_state;
+}
+
+/**
+ * does whatever the job can do right now without waiting, and returns the state it's in
+ *   WAIT_SVMODEM: the modem supply isn't up yet (See 3.1.1)
+ *   PREAMBLE: waiting for room for the preamble and first chunk, then writes both
+ *   CHUNKS: one more chunk each time there's room for it
+ *   DRAIN: all of it is in the FIFO, nothing left to do here
+ * Each step is at most a couple of register reads and one FIFO burst, so it's fine to call it every pass of loop().
+ */
+uint8_t ax_tx_packet_step(ax_config *config, ax_tx_job *job)
+{
+    AX_HW_OP(AX_HW_OP_TX_PACKET);
+    uint8_t header[3];
+    uint16_t fifocount;
+    uint8_t pkt_end = 0;
+
+    switch (job->state)
     {
+    case AX_TX_STATE_WAIT_SVMODEM:
+        /* Ensure the SVMODEM bit (POWSTAT) is set high (See 3.1.1) */
+        if (!(ax_hw_read_register_8(config, AX_REG_POWSTAT) & AX_POWSTAT_SVMODEM)) break;
+
+        /* if the last frame already finished the transmitter is idle, and the receiver needs a full preamble again */
+        if (job->continuation && ((ax_RADIOSTATE(config) & 0x0F) == AX_RADIOSTATE_IDLE))
+        {
+            LOG_TRACE(F("burst ended before next frame, sending full preamble\r\n"));
+            job->continuation = false;
+        }
+        job->state = AX_TX_STATE_PREAMBLE;
+        /* no reason to wait for the next pass */
+        /* fall through */
+
+    case AX_TX_STATE_PREAMBLE:
+        /* wait for enough space to contain both the preamble and chunk */
+        // fifocount is current number of committed words.  So, free space is 256 - fifocount
         fifocount = ax_hw_read_register_16(config, AX_REG_FIFOCOUNT);
-        Log.verbose(".");
-
-    } while (fifocount > (256 - (chunk_length + 12)));
-    Log.verbose("\r\n");
-    */
-    ax_hw_write_fifo(config, data, (uint8_t)chunk_length);
-    Log.trace("First data written to FIFO\r\n");
-    for(int i=0; i<chunk_length; i++) Log.verbose("index: %i, data: %X\r\n", i, *(data+i));
-    data += chunk_length;
-    int chunk_start = chunk_length; //for debug, printing out later
-    ax_fifo_commit(config); /* commit */
+        LOG_VERBOSE("%X bytes in the FIFO\r\n", fifocount);
+        if (fifocount > (256 - (job->chunk_length + 17))) break;
+
+        // where does 20 come from?  I'm still not sure why.  Chunk length is the amount of bytes over the 200.
+        // preamble takes 4 bytes
+        // sync bytes are another 7
+        // Add 4 more for data header assuming length byte is included.  15 total.  That's not 20...
+        // however a 240 byte chunk only leaves 15 bytes for everything else, so I'm guessing that's what limits it.
+        // you can write up to 240 bytes, but it needs to be broken into 200 + 40 chunks by the code.
+        // it does the smaller first so it clears out, once the preamble and framing is sent
+        ax_fifo_tx_preamble(config, job->mod, job->continuation);
+        ax_fifo_tx_first_chunk(config, job);
+        job->state = job->rem_length ? AX_TX_STATE_CHUNKS : AX_TX_STATE_DRAIN;
+        break;
 
-    /* write subsequent data */
-    while (rem_length)
-    {
-        if (rem_length > pkt_max_chunk)
-        { /* send 200 bytes */
-            chunk_length = pkt_max_chunk;
-            rem_length -= pkt_max_chunk;
+    case AX_TX_STATE_CHUNKS:
+        /* write subsequent data */
+        if (job->rem_length > AX_TX_MAX_CHUNK)
+        { /* send a full chunk */
+            job->chunk_length = AX_TX_MAX_CHUNK;
         }
         else
         { /* finish off */
-            chunk_length = rem_length;  //only do this if rem_length < 200 (it fits into an 8-bit number)
-            rem_length = 0;
+            job->chunk_length = job->rem_length;  //only do this if rem_length < 239 (it fits into an 8-bit number)
             pkt_end = AX_FIFO_TXDATA_PKTEND;
         }
 
         /* wait for enough space for chunk */
-        do
-        {
-            fifocount = ax_hw_read_register_16(config, AX_REG_FIFOCOUNT);
-            Log.verbose("-");
-        } while (fifocount > (256 - (chunk_length + 10)));  //3 for the chunk overhead
-        Log.verbose("\r\n");
+        fifocount = ax_hw_read_register_16(config, AX_REG_FIFOCOUNT);
+        LOG_VERBOSE("%X bytes in the FIFO\r\n", fifocount);
+        if (fifocount > (256 - (job->chunk_length + 10))) break;  //3 for the chunk overhead
 
         /* write chunk */
         header[0] = AX_FIFO_CHUNK_DATA;
-        header[1] = chunk_length + 1; /* incl flags */
+        header[1] = job->chunk_length + 1; /* incl flags */
         header[2] = pkt_end | AX_FIFO_TXDATA_NOCRC;
-        ax_hw_write_fifo(config, header, 3);
-        ax_hw_write_fifo(config, data, (uint8_t)chunk_length);
-        Log.trace("Next data written to FIFO\r\n");
-        for(int i=0; i<chunk_length; i++) Log.verbose("index: %i, data: %X\r\n", rem_length + i, *(data+i));
-        data += chunk_length;
-        ax_fifo_commit(config); /* commit */
+        ax_hw_write_fifo_commit(config, header, 3, job->data, job->chunk_length);
+        job->rem_length -= job->chunk_length;
+        LOG_TRACE("Next data written to FIFO\r\n");
+        if (LOG_ON(LOG_LEVEL_VERBOSE)) for(int i=0; i<job->chunk_length; i++) LOG_VERBOSE("index: %i, data: %X\r\n", job->rem_length + i, *(job->data+i));
+        job->data += job->chunk_length;
+        if (job->rem_length == 0) job->state = AX_TX_STATE_DRAIN;
+        break;
+
+    default:
+        break;
     }
+    return job->state;
+}
+
+/**
+ * write tx data, waits until it's all in the FIFO.
+ * see ax_fifo_tx_preamble for continuation
+ */
+void ax_fifo_tx_data(ax_config *config, ax_modulation *mod,
+                     uint8_t *data, uint16_t length, bool continuation)
+{
+    ax_tx_job job;
+
+    ax_tx_packet_start(&job, mod, data, length, continuation, AX_TX_STATE_PREAMBLE);
+    while (ax_tx_packet_step(config, &job) != AX_TX_STATE_DRAIN)
+        ;
 }
 
 /**
@@ -273,7 +329,7 @@ uint16_t ax_fifo_rx_data(ax_config *config, ax_rx_chunk *chunk)
     uint32_t scratch;
 
     uint8_t fifostat = ax_hw_read_register_8(config, AX_REG_FIFOSTAT);
-    //if (fifostat != 0x21) Log.warning(F("fifostat: %X \r\n"), fifostat);
+    //if (fifostat != 0x21) LOG_WARNING(F("fifostat: %X \r\n"), fifostat);
     uint16_t fifocount = ax_hw_read_register_16(config, AX_REG_FIFOCOUNT);
     
     if (fifocount == 0)
@@ -282,14 +338,14 @@ uint16_t ax_fifo_rx_data(ax_config *config, ax_rx_chunk *chunk)
     }
 
     // check for fifo overruns, underruns, and full
-    if (fifostat & 0x08){Log.error(F("fifo over \r\n"));}
-    if (fifostat & 0x04){Log.error(F("fifo under \r\n"));}
-    if (fifostat & 0x02){Log.error(F("fifo full \r\n"));}
+    if (fifostat & 0x08){LOG_ERROR(F("fifo over \r\n"));}
+    if (fifostat & 0x04){LOG_ERROR(F("fifo under \r\n"));}
+    if (fifostat & 0x02){LOG_ERROR(F("fifo full \r\n"));}
 
-    Log.trace(F("got something. fifocount = %X\r\n"), fifocount); // was %d...tryin somethin ; looks like this variable is otherwise unused.  Repeating packet is size 226
+    LOG_TRACE(F("got something. fifocount = %X\r\n"), fifocount); // was %d...tryin somethin ; looks like this variable is otherwise unused.  Repeating packet is size 226
 
     chunk->chunk_t = ax_hw_read_register_8(config, AX_REG_FIFODATA);
-    Log.trace(F("chunk: %X \r\n"), chunk->chunk_t); // what kind of chunk did we receive?
+    LOG_TRACE(F("chunk: %X \r\n"), chunk->chunk_t); // what kind of chunk did we receive?
 
     switch (chunk->chunk_t)
     {
@@ -304,9 +360,9 @@ uint16_t ax_fifo_rx_data(ax_config *config, ax_rx_chunk *chunk)
                         chunk->chunk.data.data,
                         chunk->chunk.data.length + 1);
 
-        //for (int i=0; i< fifocount; i++) Log.verbose(F("fifo data %d: %X\r\n"), i, chunk->chunk.data.data[i]);
-        Log.verbose("fifocount: %X \r\n", fifocount);
-        Log.verbose("chunk.data.length: %X \r\n", chunk->chunk.data.length);
+        //for (int i=0; i< fifocount; i++) LOG_VERBOSE(F("fifo data %d: %X\r\n"), i, chunk->chunk.data.data[i]);
+        LOG_VERBOSE("fifocount: %X \r\n", fifocount);
+        LOG_VERBOSE("chunk.data.length: %X \r\n", chunk->chunk.data.length);
 
         return 3 + chunk->chunk.data.length;
         
@@ -370,7 +426,7 @@ void ax_wait_for_oscillator(ax_config *config)
         i++;
     }
 
-    Log.trace(F("osc stable in %d cycles\r\n"), i);
+    LOG_TRACE(F("osc stable in %d cycles\r\n"), i);
 }
 
 /**
@@ -446,7 +502,7 @@ void ax_set_modulation_parameters(ax_config *config, ax_modulation *mod)
     if ((mod->encoding & AX_ENC_INV) && mod->fec)
     {
         /* FEC doesn't play with inversion */
-        Log.warning(F("WARNING: Inversion is not supported in FEC! NOT INVERTING\r\n"));
+        LOG_WARNING(F("WARNING: Inversion is not supported in FEC! NOT INVERTING\r\n"));
         mod->encoding &= ~AX_ENC_INV; /* clear inv bit */
     }
     ax_hw_write_register_8(config, AX_REG_ENCODING, mod->encoding);
@@ -455,7 +511,7 @@ void ax_set_modulation_parameters(ax_config *config, ax_modulation *mod)
     if (mod->fec && ((mod->framing & 0xE) != AX_FRAMING_MODE_HDLC))
     {
         /* FEC needs HDLC framing */
-        Log.warning(F("WARNING: FEC needs HDLC! Forcing HDLC framing..\r\n"));
+        LOG_WARNING(F("WARNING: FEC needs HDLC! Forcing HDLC framing..\r\n"));
         mod->framing &= ~0xE;
         mod->framing |= AX_FRAMING_MODE_HDLC;
     }
@@ -504,12 +560,18 @@ uint32_t ax_set_freq_register(ax_config *config,
     uint32_t freq;
 
     /* we choose to always set the LSB to avoid spectral tones */
-    freq = (uint32_t)(((double)frequency * (1 << 23)) /
-                      (float)config->f_xtal);
+    // integer version of (uint32_t)(((double)frequency * (1 << 23)) / (float)config->f_xtal)
+    // the M0+ has no FPU, and this gets called on every doppler step.  It's bit-exact with the
+    // double version: frequency << 23 is exact in a double, so the two can only differ where the
+    // double quotient rounds up onto the next integer.  48 MHz is 2^10 x 46875, so the 2^10 divides
+    // out of the 2^23 cleanly and the quotient is frequency x 2^13 / 46875.  Its fraction is zero or
+    // at least 1/46875, far bigger than the double's rounding error (about 2^-26 in the UHF band).
+    // ax5043_sim/ax_test.cpp sweeps 420-450 MHz in 1 Hz steps and times it.
+    freq = (uint32_t)(((uint64_t)frequency << 23) / config->f_xtal);
     freq = (freq << 1) | 1;
     ax_hw_write_register_32(config, reg, freq);
 
-    Log.trace(F("freq %d = %X\r\n"), (int)frequency, (unsigned int)freq);
+    LOG_TRACE(F("freq %d = %X\r\n"), (int)frequency, (unsigned int)freq);
 
     return freq;
 }
@@ -575,12 +637,9 @@ ax_synthesiser_parameters synth_receive = {
 };
 
 /**
- * 5.10 set synthesiser parameters
+ * 5.10 PLLVCODIV value for a synthesiser
  */
-void ax_set_synthesiser_parameters(ax_config *config,
-                                   ax_synthesiser_parameters *params,
-                                   ax_synthesiser *synth,
-                                   enum ax_vco_type vco_type)
+static uint8_t ax_synthesiser_vcodiv(ax_synthesiser *synth, enum ax_vco_type vco_type)
 {
     /* rfdiv */
     uint8_t vco_parameters =
@@ -604,6 +663,19 @@ void ax_set_synthesiser_parameters(ax_config *config,
     // right now just setting it to the value we're using for 48 MHz TCXO
     vco_parameters |= AX_PLLVCODIV_DIVIDE_2;
 
+    return vco_parameters;
+}
+
+/**
+ * 5.10 set synthesiser parameters
+ */
+void ax_set_synthesiser_parameters(ax_config *config,
+                                   ax_synthesiser_parameters *params,
+                                   ax_synthesiser *synth,
+                                   enum ax_vco_type vco_type)
+{
+    uint8_t vco_parameters = ax_synthesiser_vcodiv(synth, vco_type);
+
     /* set registers */
     ax_hw_write_register_8(config, AX_REG_PLLLOOP, params->loop);
     ax_hw_write_register_8(config, AX_REG_PLLCPI, params->charge_pump_current);
@@ -668,7 +740,7 @@ void ax_set_afsk_rx_parameters(ax_config *config, ax_modulation *mod)
                           0.5);
     ax_hw_write_register_16(config, AX_REG_AFSKMARK, afskmark);
 
-    Log.trace(F("afskmark (rx) %d = %X\r\n"), mark, afskmark);
+    LOG_TRACE(F("afskmark (rx) %d = %X\r\n"), mark, afskmark);
 
     /* Space */
     afskspace = (uint16_t)((((float)space * (1 << 16) *
@@ -677,7 +749,7 @@ void ax_set_afsk_rx_parameters(ax_config *config, ax_modulation *mod)
                            0.5);
     ax_hw_write_register_16(config, AX_REG_AFSKSPACE, afskspace);
 
-    Log.trace(F("afskspace (rx) %d = %X\r\n"), space, afskspace);
+    LOG_TRACE(F("afskspace (rx) %d = %X\r\n"), space, afskspace);
 
     /* Detector Bandwidth */
     ax_hw_write_register_16(config, AX_REG_AFSKCTRL, mod->par.afskshift);
@@ -691,7 +763,7 @@ void ax_set_rx_parameters(ax_config *config, ax_modulation *mod)
     /* IF Frequency */
     ax_hw_write_register_16(config, AX_REG_IFFREQ, mod->par.iffreq);
 
-    Log.trace(F("WRITE IFFREQ %d\r\n"), (int)mod->par.iffreq);
+    LOG_TRACE(F("WRITE IFFREQ %d\r\n"), (int)mod->par.iffreq);
 
     /* Decimation */
     ax_hw_write_register_8(config, AX_REG_DECIMATION, mod->par.decimation);
@@ -815,7 +887,7 @@ void ax_set_afsk_tx_parameters(ax_config *config, ax_modulation *mod)
                           0.5);
     ax_hw_write_register_16(config, AX_REG_AFSKMARK, afskmark);
 
-    Log.trace(F("afskmark (tx) %d = %X\r\n"), mark, afskmark);
+    LOG_TRACE(F("afskmark (tx) %d = %X\r\n"), mark, afskmark);
 
     /* Space */
     afskspace = (uint16_t)((((float)space * (1 << 18)) /
@@ -823,7 +895,7 @@ void ax_set_afsk_tx_parameters(ax_config *config, ax_modulation *mod)
                            0.5);
     ax_hw_write_register_16(config, AX_REG_AFSKSPACE, afskspace);
 
-    Log.trace(F("afskspace (tx) %d = %X\r\n"), space, afskspace);
+    LOG_TRACE(F("afskspace (tx) %d = %X\r\n"), space, afskspace);
 }
 
 /**
@@ -849,22 +921,22 @@ uint8_t ax_modcfga_tx_parameters_tx_path(enum ax_transmit_path path)
 #ifdef _AX_TX_SE
         return AX_MODCFGA_TXSE;
 #else
-        //Log.trace(F("Single ended transmit path NOT set!\r\n"));
-        //Log.trace(F("Check this is okay on your hardware, and define _AX_TX_SE to enable.\r\n"));
-        //Log.trace(F("Setting differential transmit path instead...\r\n"));
+        //LOG_TRACE(F("Single ended transmit path NOT set!\r\n"));
+        //LOG_TRACE(F("Check this is okay on your hardware, and define _AX_TX_SE to enable.\r\n"));
+        //LOG_TRACE(F("Setting differential transmit path instead...\r\n"));
         return AX_MODCFGA_TXDIFF;
 #endif
     case AX_TRANSMIT_PATH_DIFF:
 #ifdef _AX_TX_DIFF
         return AX_MODCFGA_TXDIFF;
 #else
-        Log.trace(F("Differential transmit path NOT set!\r\n"));
-        Log.trace(F("Check this is okay on your hardware, and define _AX_TX_DIFF to enable.\r\n"));
-        Log.trace(F("Setting single ended transmit path instead...\r\n"));
+        LOG_TRACE(F("Differential transmit path NOT set!\r\n"));
+        LOG_TRACE(F("Check this is okay on your hardware, and define _AX_TX_DIFF to enable.\r\n"));
+        LOG_TRACE(F("Setting single ended transmit path instead...\r\n"));
         return AX_MODCFGA_TXSE;
 #endif
     default:
-        Log.error(F("Unknown transmit path!\r\n"));
+        LOG_ERROR(F("Unknown transmit path!\r\n"));
 #ifdef _AX_TX_DIFF
         return AX_MODCFGA_TXDIFF;
 #else
@@ -926,7 +998,7 @@ void ax_set_tx_parameters(ax_config *config, ax_modulation *mod)
         break;
     }
     ax_hw_write_register_24(config, AX_REG_FSKDEV, fskdev);
-    Log.trace(F("fskdev %d = %X\r\n"), (int)deviation, (unsigned int)fskdev);
+    LOG_TRACE(F("fskdev %d = %X\r\n"), (int)deviation, (unsigned int)fskdev);
 
     /* TX bitrate. We assume bitrate < f_xtal */
     txrate = (uint32_t)((((float)mod->bitrate * (1 << 24)) /
@@ -934,12 +1006,12 @@ void ax_set_tx_parameters(ax_config *config, ax_modulation *mod)
                         0.5);
     ax_hw_write_register_24(config, AX_REG_TXRATE, txrate);
 
-    Log.trace(F("bitrate %d = %X\r\n"), (int)mod->bitrate, (unsigned int)txrate);
+    LOG_TRACE(F("bitrate %d = %X\r\n"), (int)mod->bitrate, (unsigned int)txrate);
 
     /* check bitrate for asynchronous wire mode */
     if (1 && mod->bitrate >= config->f_xtal / 32)
     {
-        Log.warning(F("for asynchronous wire mode, bitrate must be less than f_xtal/32\r\n"));
+        LOG_WARNING(F("for asynchronous wire mode, bitrate must be less than f_xtal/32\r\n"));
     }
 
     /* TX power */
@@ -953,10 +1025,10 @@ void ax_set_tx_parameters(ax_config *config, ax_modulation *mod)
     }
     pwr = (uint16_t)((p * (1 << 12)) + 0.5);
     pwr = (pwr > 0xFFF) ? 0xFFF : pwr; /* max 0xFFF */
-    Log.trace(F("power value: %X\r\n"), pwr);
+    LOG_TRACE(F("power value: %X\r\n"), pwr);
     ax_hw_write_register_16(config, AX_REG_TXPWRCOEFFB, pwr);
 
-    Log.trace(F("power %f = %X\r\n"), mod->power, pwr);
+    LOG_TRACE(F("power %f = %X\r\n"), mod->power, pwr);
 }
 
 /**
@@ -977,7 +1049,7 @@ void ax_set_pll_parameters(ax_config *config)
     config->f_pllrng = config->f_xtal / (1 << (8 + pllrngclk_div));
     /* NOTE: config->f_pllrng should be less than 1/10 of the loop filter b/w */
     /* 8kHz is fine, as minimum loop filter b/w is 100kHz */
-    Log.trace(F("Ranging clock f_pllrng %d Hz\r\n"), (int)config->f_pllrng);
+    LOG_TRACE(F("Ranging clock f_pllrng %d Hz\r\n"), (int)config->f_pllrng);
 }
 
 /**
@@ -1010,7 +1082,7 @@ void ax_set_xtal_parameters(ax_config *config)
         }
         else
         {
-            Log.trace(F("xtal load capacitance %d not supported\r\n"),
+            LOG_TRACE(F("xtal load capacitance %d not supported\r\n"),
                          config->load_capacitance);
             xtalcap = 0;
         }
@@ -1346,6 +1418,7 @@ void ax_set_performance_tuning(ax_config *config, ax_modulation *mod)
 void ax_set_registers(ax_config *config, ax_modulation *mod,
                       ax_wakeup_config *wakeup_config)
 {
+    AX_HW_OP(AX_HW_OP_SET_REGISTERS);
     // MODULATION, ENCODING, FRAMING, FEC
     ax_set_modulation_parameters(config, mod);
 
@@ -1405,6 +1478,7 @@ void ax_set_registers(ax_config *config, ax_modulation *mod,
  */
 void ax_set_registers_tx(ax_config *config, ax_modulation *mod)
 {
+    AX_HW_OP(AX_HW_OP_SET_REGISTERS);
     ax_set_synthesiser_parameters(config,
                                   &synth_transmit,
                                   &config->synthesiser.A,
@@ -1425,6 +1499,7 @@ void ax_set_registers_tx(ax_config *config, ax_modulation *mod)
  */
 void ax_set_registers_rx(ax_config *config, ax_modulation *mod)
 {
+    AX_HW_OP(AX_HW_OP_SET_REGISTERS);
     ax_set_synthesiser_parameters(config,
                                   &synth_receive,
                                   &config->synthesiser.B,
@@ -1440,22 +1515,209 @@ void ax_set_registers_rx(ax_config *config, ax_modulation *mod)
     ax_hw_write_register_8(config, 0xF18, 0x02); /* ?? */
 }
 
+/**
+ * precompute the tx/rx turnaround delta
+ *
+ * ax_set_registers writes the same values for both directions, so once the chip
+ * has been fully configured only the registers that ax_set_registers_tx and
+ * ax_set_registers_rx set differently need to change on a turnaround.
+ * Called at the end of ax_tx_on/ax_rx_on; invalidated by ax_init, ax_default_params
+ * and vco ranging, which all leave the registers in some other state.
+ */
+void ax_prepare_turnaround(ax_config *config, ax_modulation *mod)
+{
+    ax_turnaround_image *image = &config->turnaround;
+    image->valid = 0;
+    image->count = 0;
+
+    /* AFSK sets mark/space per direction, just use the full path */
+    if ((mod->modulation & 0xf) == AX_MODULATION_AFSK)
+    {
+        return;
+    }
+
+    uint8_t tx_vcodiv = ax_synthesiser_vcodiv(&config->synthesiser.A, config->synthesiser.vco_type);
+    uint8_t rx_vcodiv = ax_synthesiser_vcodiv(&config->synthesiser.B, config->synthesiser.vco_type);
+
+    /* same order as ax_set_synthesiser_parameters and ax_set_registers_tx/rx.  A register
+       added to either of those has to go in here too, ax5043_sim/ax_test.cpp checks that
+       the turnarounds leave the chip the same as the full setups */
+    const uint16_t regs[] = {AX_REG_PLLLOOP, AX_REG_PLLCPI, AX_REG_PLLVCODIV, 0xF34, 0xF00, 0xF18};
+    const uint8_t tx[] = {synth_transmit.loop, synth_transmit.charge_pump_current, tx_vcodiv,
+                          (uint8_t)((tx_vcodiv & AX_PLLVCODIV_RF_DIVIDER_DIV_TWO) ? 0x28 : 0x08), 0x0F, 0x06};
+    const uint8_t rx[] = {synth_receive.loop, synth_receive.charge_pump_current, rx_vcodiv,
+                          (uint8_t)((rx_vcodiv & AX_PLLVCODIV_RF_DIVIDER_DIV_TWO) ? 0x28 : 0x08), 0x0F, 0x02};
+
+    for (uint8_t i = 0; i < sizeof(regs) / sizeof(regs[0]); i++)
+    {
+        if (tx[i] != rx[i])
+        {
+            image->reg[image->count] = regs[i];
+            image->tx_value[image->count] = tx[i];
+            image->rx_value[image->count] = rx[i];
+            image->count++;
+        }
+    }
+
+    image->valid = 1;
+    LOG_TRACE(F("turnaround delta: %d registers\r\n"), image->count);
+}
+
+/**
+ * write the tx (tx = true) or rx half of the turnaround delta
+ */
+static void ax_apply_turnaround(ax_config *config, bool tx)
+{
+    ax_turnaround_image *image = &config->turnaround;
+
+    for (uint8_t i = 0; i < image->count; i++)
+    {
+        ax_hw_write_register_8(config, image->reg[i],
+                               tx ? image->tx_value[i] : image->rx_value[i]);
+    }
+}
+
 /**
  * VCO FUNCTIONS ------------------------------------------
  */
 
+/**
+ * finds a cached ranging result that covers frequency, NULL if there isn't one
+ */
+static ax_vco_cache_entry *ax_vco_cache_lookup(ax_vco_cache *cache, uint32_t frequency)
+{
+    if (cache->is_cache_set != 0x56)
+    {
+        return NULL;
+    }
+
+    for (uint8_t i = 0; i < AX_VCO_CACHE_ENTRIES; i++)
+    {
+        ax_vco_cache_entry *entry = &cache->entry[i];
+        if (entry->frequency == 0)
+        {
+            continue;
+        }
+
+        int32_t delta_f = entry->frequency - frequency;
+        uint32_t abs_delta_f = (delta_f < 0) ? -delta_f : delta_f; /* abs */
+        if (abs_delta_f <= (entry->frequency / 256))
+        {
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * adds (or updates) the ranging result for synth
+ */
+static void ax_vco_cache_store(ax_vco_cache *cache, ax_synthesiser *synth)
+{
+    if (cache->is_cache_set != 0x56)
+    {
+        memset(cache, 0, sizeof(ax_vco_cache));
+        cache->is_cache_set = 0x56;
+    }
+
+    ax_vco_cache_entry *entry = ax_vco_cache_lookup(cache, synth->frequency);
+    if (entry == NULL)
+    {
+        /* oldest entry goes */
+        entry = &cache->entry[cache->next];
+        cache->next = (cache->next + 1) % AX_VCO_CACHE_ENTRIES;
+    }
+    else if ((entry->vco_range == synth->vco_range) && (entry->rfdiv == synth->rfdiv))
+    {
+        return; /* nothing new */
+    }
+
+    entry->frequency = synth->frequency;
+    entry->rfdiv = synth->rfdiv;
+    entry->vco_range = synth->vco_range;
+    cache->dirty = 1;
+    LOG_TRACE(F("cached vco range %X for %d Hz\r\n"), entry->vco_range, (int)entry->frequency);
+}
+
+/**
+ * forget all cached ranging results, e.g. when the PLL won't lock with them
+ */
+void ax_vco_cache_clear(ax_config *config)
+{
+    memset(&config->vco_cache, 0, sizeof(ax_vco_cache));
+    config->vco_cache.dirty = 1;
+}
+
+/**
+ * true if the PLL locks on the VCOR that's in pllranging.  The synthesiser is run (SYNTHRX) on that register set for
+ * up to AX_VCO_LOCK_TIMEOUT us, then the power mode and frequency select go back how they were
+ */
+static uint8_t ax_vco_locks(ax_config *config, uint16_t pllranging)
+{
+    uint8_t pwrmode = config->pwrmode;
+    uint8_t loop = ax_hw_read_register_8(config, AX_REG_PLLLOOP);
+    uint8_t loopboost = ax_hw_read_register_8(config, AX_REG_PLLLOOPBOOST);
+    uint8_t freqsel = (pllranging == AX_REG_PLLRANGINGB) ? AX_PLLLOOP_FREQSEL_B : AX_PLLLOOP_FREQSEL_A;
+
+    ax_hw_write_register_8(config, AX_REG_PLLLOOP, (loop & 0x7F) | freqsel);
+    ax_hw_write_register_8(config, AX_REG_PLLLOOPBOOST, (loopboost & 0x7F) | freqsel);
+    ax_set_pwrmode(config, AX_PWRMODE_SYNTHRX);
+
+    uint8_t locked;
+    unsigned long start = micros();
+    do
+    {
+        locked = ax_hw_read_register_8(config, pllranging) & AX_PLLRANGING_PLL_LOCK;
+    } while (!locked && (micros() - start < AX_VCO_LOCK_TIMEOUT));
+
+    ax_set_pwrmode(config, pwrmode);
+    ax_hw_write_register_8(config, AX_REG_PLLLOOP, loop);
+    ax_hw_write_register_8(config, AX_REG_PLLLOOPBOOST, loopboost);
+    return locked;
+}
+
 /**
  * Performs a ranging operation
  *
  * updates values in synth structure
+ * if there's a cached result for this frequency it's loaded instead of ranging
  */
 enum ax_vco_ranging_result ax_do_vco_ranging(ax_config *config,
                                              uint16_t pllranging,
                                              ax_synthesiser *synth,
                                              enum ax_vco_type vco_type)
 {
+    AX_HW_OP(AX_HW_OP_VCO_RANGING);
     uint8_t r;
 
+    /* ranging leaves the synthesiser registers in the ranging state */
+    config->turnaround.valid = 0;
+
+    /* already ranged this band? just load VCOR */
+    ax_vco_cache_entry *cached = ax_vco_cache_lookup(&config->vco_cache, synth->frequency);
+    if (cached)
+    {
+        synth->rfdiv = (enum ax_rfdiv)cached->rfdiv;
+        synth->vco_range = cached->vco_range;
+        ax_set_synthesiser_parameters(config, &synth_ranging, synth, vco_type);
+        ax_hw_write_register_8(config, pllranging, synth->vco_range); /* manual VCOR, no RNGSTART */
+
+        if (ax_vco_locks(config, pllranging))
+        {
+            synth->vco_range_known = 1;
+            synth->frequency_when_last_ranged = cached->frequency;
+            LOG_TRACE(F("using cached vco range %X\r\n"), synth->vco_range);
+            return AX_VCO_RANGING_SUCCESS;
+        }
+
+        /* the chip's drifted (temperature, ageing) since it was cached, forget it and range */
+        LOG_WARNING(F("cached vco range %X didn't lock, ranging\r\n"), synth->vco_range);
+        cached->frequency = 0;
+        config->vco_cache.dirty = 1;
+        synth->vco_range_known = 0;
+        synth->rfdiv = AX_RFDIV_UKNOWN;
+    }
+
     /* set vco range (VCOR) to 8 if unknown */
     synth->vco_range = (synth->vco_range_known == 0) ? 8 : synth->vco_range;
 
@@ -1482,16 +1744,17 @@ enum ax_vco_ranging_result ax_do_vco_ranging(ax_config *config,
     if (r & AX_PLLRANGING_RNGERR)
     {
         /* ranging error */
-        Log.error(F("Ranging error!\r\n"));
+        LOG_ERROR(F("Ranging error!\r\n"));
         return AX_VCO_RANGING_FAILED;
     }
 
-    Log.trace(F("Ranging done r = %X\r\n"), r);
+    LOG_TRACE(F("Ranging done r = %X\r\n"), r);
 
     /* Update vco_range */
     synth->vco_range = r & 0xF;
     synth->vco_range_known = 1;
     synth->frequency_when_last_ranged = synth->frequency;
+    ax_vco_cache_store(&config->vco_cache, synth);
 
     return AX_VCO_RANGING_SUCCESS;
 }
@@ -1503,9 +1766,28 @@ enum ax_vco_ranging_result ax_do_vco_ranging(ax_config *config,
  */
 enum ax_vco_ranging_result ax_vco_ranging(ax_config *config)
 {
+    AX_HW_OP(AX_HW_OP_VCO_RANGING);
     enum ax_vco_ranging_result resultA, resultB;
 
-    Log.trace(F("starting vco ranging...\r\n"));
+    LOG_TRACE(F("starting vco ranging...\r\n"));
+
+    /* both bands have been ranged before, no need to power up for ranging */
+    if (ax_vco_cache_lookup(&config->vco_cache, config->synthesiser.A.frequency) &&
+        ax_vco_cache_lookup(&config->vco_cache, config->synthesiser.B.frequency))
+    {
+        ax_set_synthesiser_frequencies(config);
+        ax_hw_write_register_8(config, AX_REG_PLLVCOI,
+                               AX_PLLVCOI_ENABLE_MANUAL | 27);
+        resultA = ax_do_vco_ranging(config, AX_REG_PLLRANGINGA,
+                                    &config->synthesiser.A, config->synthesiser.vco_type);
+        resultB = ax_do_vco_ranging(config, AX_REG_PLLRANGINGB,
+                                    &config->synthesiser.B, config->synthesiser.vco_type);
+        if ((resultA == AX_VCO_RANGING_SUCCESS) && (resultB == AX_VCO_RANGING_SUCCESS))
+        {
+            return AX_VCO_RANGING_SUCCESS;
+        }
+        /* a cached one didn't lock and ranging it there didn't work either, do it all from STANDBY */
+    }
 
     /* Enable TCXO if used */
     if (config->tcxo_enable)
@@ -1565,6 +1847,7 @@ enum ax_vco_ranging_result ax_vco_ranging(ax_config *config)
 void ax_default_params(ax_config *config, ax_modulation *mod)
 {
     ax_populate_params(config, mod, &mod->par);
+    config->turnaround.valid = 0; /* registers need a full rewrite */
 }
 
 /**
@@ -1574,6 +1857,7 @@ void ax_default_params(ax_config *config, ax_modulation *mod)
  */
 int ax_adjust_frequency_A(ax_config *config, uint32_t frequency)
 {
+    AX_HW_OP(AX_HW_OP_ADJUST_FREQUENCY);
     uint8_t radiostate;
     int32_t delta_f;
     uint32_t abs_delta_f;
@@ -1586,7 +1870,7 @@ int ax_adjust_frequency_A(ax_config *config, uint32_t frequency)
         /* can't do anything in deepsleep */
         // this should cause a reset from the external watchdog.
         // TODO:  look into storing failure modes in a non-volatile variable (log)
-        Log.error(F("in deep sleep for some reason\r\n"));
+        LOG_ERROR(F("in deep sleep for some reason\r\n"));
         while (1)
             ;
         return AX_INIT_PORT_FAILED;
@@ -1598,7 +1882,7 @@ int ax_adjust_frequency_A(ax_config *config, uint32_t frequency)
         // if so, change power state to STANDBY
         //won't go into standby unless the fifo is clear
         ax_fifo_clear(config);
-        Log.trace(F("changing to STANDBY (A)\r\n"));
+        LOG_TRACE(F("changing to STANDBY (A)\r\n"));
         ax_set_pwrmode(config, AX_PWRMODE_STANDBY);
         while (ax_hw_read_register_8(config, AX_REG_POWSTAT) & AX_POWSTAT_SVMODEM);
     }
@@ -1611,7 +1895,7 @@ int ax_adjust_frequency_A(ax_config *config, uint32_t frequency)
         do
         {
             radiostate = ax_hw_read_register_8(config, AX_REG_RADIOSTATE) & 0xF;
-            Log.trace(F("waiting on radiostate A FULLTX: %X\r\n"), radiostate);
+            LOG_TRACE(F("waiting on radiostate A FULLTX: %X\r\n"), radiostate);
             delay(1);
         } while (radiostate != AX_RADIOSTATE_IDLE);
     }
@@ -1620,13 +1904,13 @@ int ax_adjust_frequency_A(ax_config *config, uint32_t frequency)
         do
         {
             radiostate = ax_hw_read_register_8(config, AX_REG_RADIOSTATE) & 0xF;
-            Log.trace(F("waiting on radiostate A FULLRX: %X\r\n"), radiostate);
+            LOG_TRACE(F("waiting on radiostate A FULLRX: %X\r\n"), radiostate);
             delay(1);
         } while (radiostate != AX_RADIOSTATE_RX_PREAMBLE_1);
     }
     else
     {
-        Log.warning("We're in a weird power state\r\n");
+        LOG_WARNING("We're in a weird power state\r\n");
     }
 
     /* set new frequency */
@@ -1640,7 +1924,7 @@ int ax_adjust_frequency_A(ax_config *config, uint32_t frequency)
     if (abs_delta_f > (synth->frequency_when_last_ranged / 256))
     {
         /* Need to re-range VCO */
-        Log.trace(F("need to re-range the VCO\r\n"));
+        LOG_TRACE(F("need to re-range the VCO\r\n"));
 
         /* clear assumptions about frequency */
         synth->rfdiv = AX_RFDIV_UKNOWN;
@@ -1649,11 +1933,11 @@ int ax_adjust_frequency_A(ax_config *config, uint32_t frequency)
         // everything up to here only applied to VCO A
         // before ranging, we need to set the synth frequencies
         // this is done in ax_vco_ranging.
-        Log.trace(F("frequency check: %i\r\n"), config->synthesiser.A.frequency);
+        LOG_TRACE(F("frequency check: %i\r\n"), config->synthesiser.A.frequency);
         /* re-range both VCOs */
         if (ax_vco_ranging(config) != AX_VCO_RANGING_SUCCESS)
         {
-            Log.error(F("ranging failed\r\n"));
+            LOG_ERROR(F("ranging failed\r\n"));
             // TODO: create a log entry
             return AX_INIT_VCO_RANGING_FAILED;
         }
@@ -1662,7 +1946,7 @@ int ax_adjust_frequency_A(ax_config *config, uint32_t frequency)
     else
     {
         /* no need to re-range */
-        Log.trace(F("no need it says, check the next command!\r\n"));
+        LOG_TRACE(F("no need it says, check the next command!\r\n"));
         ax_set_synthesiser_frequencies(config);
     }
 
@@ -1672,7 +1956,7 @@ int ax_adjust_frequency_A(ax_config *config, uint32_t frequency)
     if (ax_hw_read_register_8(config, AX_REG_PINFUNCDATA) == 0x84)
     {
         // if so, change power state to FULLTX
-        Log.trace(F("returning to FULLTX\r\n"));
+        LOG_TRACE(F("returning to FULLTX\r\n"));
         ax_set_pwrmode(config, AX_PWRMODE_FULLTX);
     }
 
@@ -1689,6 +1973,7 @@ int ax_adjust_frequency_A(ax_config *config, uint32_t frequency)
  */
 int ax_adjust_frequency_B(ax_config *config, uint32_t frequency)
 {
+    AX_HW_OP(AX_HW_OP_ADJUST_FREQUENCY);
     uint8_t radiostate;
     int32_t delta_f;
     uint32_t abs_delta_f;
@@ -1700,7 +1985,7 @@ int ax_adjust_frequency_B(ax_config *config, uint32_t frequency)
     {
         /* can't do anything in deepsleep */
         // TODO:  look into storing failure modes in a non-volatile variable (log)
-        Log.warning(F("in deep sleep for some reason\r\n"));
+        LOG_WARNING(F("in deep sleep for some reason\r\n"));
         while (1)
             ;
         return AX_INIT_PORT_FAILED;
@@ -1710,7 +1995,7 @@ int ax_adjust_frequency_B(ax_config *config, uint32_t frequency)
     if (ax_hw_read_register_8(config, AX_REG_PINFUNCDATA) == 0x84)
     {
         ax_fifo_clear(config);
-        Log.trace(F("changing to STANDBY (B)\r\n"));
+        LOG_TRACE(F("changing to STANDBY (B)\r\n"));
         ax_set_pwrmode(config, AX_PWRMODE_STANDBY);
         while (ax_hw_read_register_8(config, AX_REG_POWSTAT) & AX_POWSTAT_SVMODEM);
     }
@@ -1721,7 +2006,7 @@ int ax_adjust_frequency_B(ax_config *config, uint32_t frequency)
         do
         {
             radiostate = ax_hw_read_register_8(config, AX_REG_RADIOSTATE) & 0xF;
-            Log.trace(F("waiting on radiostate B FULLTX\r\n"));
+            LOG_TRACE(F("waiting on radiostate B FULLTX\r\n"));
             delay(1);
         } while (radiostate != AX_RADIOSTATE_IDLE);
     }
@@ -1730,13 +2015,13 @@ int ax_adjust_frequency_B(ax_config *config, uint32_t frequency)
         do
         {
             radiostate = ax_hw_read_register_8(config, AX_REG_RADIOSTATE) & 0xF;
-            Log.trace(F("waiting on radiostate B FULLRX: %X\r\n"), radiostate);
+            LOG_TRACE(F("waiting on radiostate B FULLRX: %X\r\n"), radiostate);
             delay(1);
         } while (radiostate != AX_RADIOSTATE_RX_PREAMBLE_1);
     }
     else
     {
-        Log.warning("We're in a weird power state\r\n");
+        LOG_WARNING("We're in a weird power state\r\n");
     }
 
     /* set new frequency */
@@ -1755,12 +2040,12 @@ int ax_adjust_frequency_B(ax_config *config, uint32_t frequency)
         synth->rfdiv = AX_RFDIV_UKNOWN;
         synth->vco_range_known = 0;
 
-        Log.trace(F("frequency check: %i\r\n"), config->synthesiser.B.frequency);
+        LOG_TRACE(F("frequency check: %i\r\n"), config->synthesiser.B.frequency);
 
         /* re-range both VCOs */
         if (ax_vco_ranging(config) != AX_VCO_RANGING_SUCCESS)
         {
-            Log.error(F("ranging failed\r\n"));
+            LOG_ERROR(F("ranging failed\r\n"));
             return AX_INIT_VCO_RANGING_FAILED;
         }
         // ax_vco_ranging leaves the chip in POWERDOWN, with VCO B selected
@@ -1768,7 +2053,7 @@ int ax_adjust_frequency_B(ax_config *config, uint32_t frequency)
     else
     {
         /* no need to re-range */
-        Log.trace(F("no need it says, check the next command!\r\n"));
+        LOG_TRACE(F("no need it says, check the next command!\r\n"));
         ax_set_synthesiser_frequencies(config);
     }
 
@@ -1787,6 +2072,7 @@ int ax_adjust_frequency_B(ax_config *config, uint32_t frequency)
  */
 int ax_force_quick_adjust_frequency_A(ax_config *config, uint32_t frequency)
 {
+    AX_HW_OP(AX_HW_OP_ADJUST_FREQUENCY);
     ax_synthesiser *synth = &config->synthesiser.A;
 
     /* set new frequency */
@@ -1807,6 +2093,7 @@ int ax_force_quick_adjust_frequency_A(ax_config *config, uint32_t frequency)
  */
 int ax_force_quick_adjust_frequency_B(ax_config *config, uint32_t frequency)
 {
+    AX_HW_OP(AX_HW_OP_ADJUST_FREQUENCY);
     ax_synthesiser *synth = &config->synthesiser.B;
 
     /* set new frequency */
@@ -1823,15 +2110,16 @@ int ax_force_quick_adjust_frequency_B(ax_config *config, uint32_t frequency)
  */
 void ax_tx_on(ax_config *config, ax_modulation *mod)
 {
+    AX_HW_OP(AX_HW_OP_TX_ON);
     if (mod->par.is_params_set != 0x51)
     {
-        Log.error(F("mod->par must be set first! call ax_default_params...\r\n"));
+        LOG_ERROR(F("mod->par must be set first! call ax_default_params...\r\n"));
         // TODO:  look into storing failure modes in a non-volatile variable (log)
         while (1)
             ;
     }
 
-    Log.trace(F("going for transmit...\r\n"));
+    LOG_TRACE(F("going for transmit...\r\n"));
 
     /* Registers */
     ax_set_registers(config, mod, NULL);
@@ -1847,15 +2135,15 @@ void ax_tx_on(ax_config *config, ax_modulation *mod)
     ax_fifo_clear(config);
 
     //the next two are to satisfy the errata
-    Log.trace("going into standby (TX)\r\n");
+    LOG_TRACE("going into standby (TX)\r\n");
     ax_set_pwrmode(config, AX_PWRMODE_STANDBY);
     while (ax_hw_read_register_8(config, AX_REG_POWSTAT) & AX_POWSTAT_SVMODEM);
     
-    Log.trace("powering up fifo (TX)\r\n");
+    LOG_TRACE("powering up fifo (TX)\r\n");
     ax_set_pwrmode(config, AX_PWRMODE_FIFOON);
 
     /* Place chip in FULLTX mode */
-    Log.trace("going into FULLTX (TX)\r\n");
+    LOG_TRACE("going into FULLTX (TX)\r\n");
     ax_set_pwrmode(config, AX_PWRMODE_FULLTX);
 
     /* Wait for oscillator to start running  */
@@ -1869,29 +2157,64 @@ void ax_tx_on(ax_config *config, ax_modulation *mod)
     {
         config->tcxo_disable();
     }
+
+    ax_prepare_turnaround(config, mod);
 }
 
 /**
- * Loads packet into the FIFO for transmission
+ * Switch from FULLRX to FULLTX, only rewriting the turnaround delta
+ *
+ * falls back to ax_tx_on if the delta isn't valid (first switch after init,
+ * a modulation change or vco ranging)
+ */
+void ax_tx_turnaround(ax_config *config, ax_modulation *mod)
+{
+    AX_HW_OP(AX_HW_OP_TURNAROUND);
+    if (!config->turnaround.valid)
+    {
+        LOG_TRACE(F("no turnaround delta, full tx setup\r\n"));
+        ax_tx_on(config, mod);
+        return;
+    }
+
+    ax_apply_turnaround(config, true);
+
+    /* Clear FIFO */
+    ax_fifo_clear(config);
+
+    // the errata still requires going through standby and fifoon
+    ax_set_pwrmode(config, AX_PWRMODE_STANDBY);
+    while (ax_hw_read_register_8(config, AX_REG_POWSTAT) & AX_POWSTAT_SVMODEM);
+    ax_set_pwrmode(config, AX_PWRMODE_FIFOON);
+    ax_set_pwrmode(config, AX_PWRMODE_FULLTX);
+
+    /* Wait for oscillator to start running  */
+    ax_wait_for_oscillator(config);
+}
+
+/**
+ * Loads packet into the FIFO for transmission, and waits until it's all in there
+ * set continuation to append the packet to a burst that is still on the air (short inter-frame sync)
+ * ax_tx_packet_start/ax_tx_packet_step do the same thing without waiting
  */
 void ax_tx_packet(ax_config *config, ax_modulation *mod,
-                  uint8_t *packet, uint16_t length)
+                  uint8_t *packet, uint16_t length, bool continuation)
 {
+    AX_HW_OP(AX_HW_OP_TX_PACKET);
     if (config->pwrmode != AX_PWRMODE_FULLTX)
     {
-        Log.error(F("PWRMODE must be FULLTX before writing to FIFO!\r\n"));
+        LOG_ERROR(F("PWRMODE must be FULLTX before writing to FIFO!\r\n"));
         return;
     }
 
-    /* Ensure the SVMODEM bit (POWSTAT) is set high (See 3.1.1) */
+    /* Write preamble and packet to the FIFO, once SVMODEM is set */
     // failure causes a reset
-    while (!(ax_hw_read_register_8(config, AX_REG_POWSTAT) & AX_POWSTAT_SVMODEM))
+    ax_tx_job job;
+    ax_tx_packet_start(&job, mod, packet, length, continuation, AX_TX_STATE_WAIT_SVMODEM);
+    while (ax_tx_packet_step(config, &job) != AX_TX_STATE_DRAIN)
         ;
 
-    /* Write preamble and packet to the FIFO */
-    ax_fifo_tx_data(config, mod, packet, length);
-
-    Log.trace(F("packet written to FIFO!\r\n"));
+    LOG_TRACE(F("packet written to FIFO!\r\n"));
 }
 
 /**
@@ -1903,7 +2226,7 @@ void ax_tx_beacon(ax_config *config,
 {
     if (config->pwrmode != AX_PWRMODE_FULLTX)
     {
-        Log.error(F("PWRMODE must be FULLTX before writing to FIFO!\r\n"));
+        LOG_ERROR(F("PWRMODE must be FULLTX before writing to FIFO!\r\n"));
         return;
     }
 
@@ -1913,14 +2236,14 @@ void ax_tx_beacon(ax_config *config,
 
     /* let's set the packet to read out MSB first */
     uint8_t address_config = ax_hw_read_register_8(config, AX_REG_PKTADDRCFG);
-    Log.trace(F("address config: %d\r\n"), address_config);
+    LOG_TRACE(F("address config: %d\r\n"), address_config);
     ax_hw_write_register_8(config, AX_REG_PKTADDRCFG, address_config | 0x80);
 
     /* Write packet to the FIFO */
     ax_fifo_tx_beacon(config, packet, length);
 
-    Log.trace(F("address config: %d\r\n"), address_config | 0x80);
-    Log.trace(F("beacon written to FIFO!\r\n"));
+    LOG_TRACE(F("address config: %d\r\n"), address_config | 0x80);
+    LOG_TRACE(F("beacon written to FIFO!\r\n"));
 
     // now wait for transmit
     while (ax_RADIOSTATE(config) != AX_RADIOSTATE_TX)
@@ -1928,7 +2251,7 @@ void ax_tx_beacon(ax_config *config,
 
     /* now that it's been committed (transmitting) we can undo the MSB change */
     ax_hw_write_register_8(config, AX_REG_PKTADDRCFG, address_config);
-    Log.trace(F("address config: %d\r\n"), address_config);
+    LOG_TRACE(F("address config: %d\r\n"), address_config);
 }
 
 /**
@@ -1939,7 +2262,7 @@ void ax_tx_1k_zeros(ax_config *config)
 {
     if (config->pwrmode != AX_PWRMODE_FULLTX)
     {
-        Log.error(F("PWRMODE must be FULLTX before writing to FIFO!\r\n"));
+        LOG_ERROR(F("PWRMODE must be FULLTX before writing to FIFO!\r\n"));
         return;
     }
 
@@ -1955,9 +2278,10 @@ void ax_tx_1k_zeros(ax_config *config)
  */
 void ax_rx_on(ax_config *config, ax_modulation *mod)
 {
+    AX_HW_OP(AX_HW_OP_RX_ON);
     if (mod->par.is_params_set != 0x51)
     {
-        Log.error(F("mod->par must be set first! call ax_default_params...\r\n"));
+        LOG_ERROR(F("mod->par must be set first! call ax_default_params...\r\n"));
         // causes a reset
         while (1)
             ;
@@ -1969,15 +2293,15 @@ void ax_rx_on(ax_config *config, ax_modulation *mod)
 
     ax_fifo_clear(config);
 
-    Log.trace("going into standby (RX)\r\n");
+    LOG_TRACE("going into standby (RX)\r\n");
     //need to check the powerstat register to verify it really went into standby
     ax_set_pwrmode(config, AX_PWRMODE_STANDBY);
     //while (ax_hw_read_register_8(config, AX_REG_POWSTAT) & AX_POWSTAT_SVMODEM != 0);
     
-    Log.trace("powering up FIFO (RX)\r\n");
+    LOG_TRACE("powering up FIFO (RX)\r\n");
     ax_set_pwrmode(config, AX_PWRMODE_FIFOON);
 
-    Log.trace("going into FULLRX\r\n");
+    LOG_TRACE("going into FULLRX\r\n");
     /* Place chip in FULLRX mode */
     ax_set_pwrmode(config, AX_PWRMODE_FULLRX);
 
@@ -1995,6 +2319,50 @@ void ax_rx_on(ax_config *config, ax_modulation *mod)
 
     /* Tune Baseband - Experimental */
     // ax_hw_write_register_8(config, AX_REG_BBTUNE, 0x10);
+
+    ax_prepare_turnaround(config, mod);
+}
+
+/**
+ * Switch from FULLTX to FULLRX, only rewriting the turnaround delta
+ *
+ * falls back to ax_rx_on if the delta isn't valid
+ */
+void ax_rx_turnaround(ax_config *config, ax_modulation *mod)
+{
+    AX_HW_OP(AX_HW_OP_TURNAROUND);
+    if (!config->turnaround.valid)
+    {
+        LOG_TRACE(F("no turnaround delta, full rx setup\r\n"));
+        ax_rx_on(config, mod);
+        return;
+    }
+
+    ax_fifo_clear(config);
+
+    ax_set_pwrmode(config, AX_PWRMODE_STANDBY);
+    ax_set_pwrmode(config, AX_PWRMODE_FIFOON);
+    ax_set_pwrmode(config, AX_PWRMODE_FULLRX);
+
+    ax_apply_turnaround(config, false); /* same point in the sequence as ax_set_registers_rx */
+    ax_SET_SYNTH_B(config);
+
+    /* Clear FIFO */
+    ax_fifo_clear(config);
+}
+
+/**
+ * Switch the receiver to another modulation
+ *
+ * no reset and no re-ranging (the synths don't move), so this is quick as long as
+ * mod->par was populated beforehand.  Nothing is computed here, it's just the
+ * register writes.
+ */
+void ax_rx_switch(ax_config *config, ax_modulation *mod)
+{
+    ax_set_pwrmode(config, AX_PWRMODE_STANDBY); /* not while it's demodulating */
+    config->turnaround.valid = 0;
+    ax_rx_on(config, mod);
 }
 
 /**
@@ -2005,7 +2373,7 @@ void ax_rx_wor(ax_config *config, ax_modulation *mod,
 {
     if (mod->par.is_params_set != 0x51)
     {
-        Log.error(F("mod->par must be set first! call ax_default_params...\r\n"));
+        LOG_ERROR(F("mod->par must be set first! call ax_default_params...\r\n"));
         // causes a reset on Silversat board
         while (1)
             ;
@@ -2038,6 +2406,7 @@ void ax_rx_wor(ax_config *config, ax_modulation *mod,
  */
 int ax_rx_packet(ax_config *config, ax_packet *rx_pkt, ax_modulation *modulation)
 {
+    AX_HW_OP(AX_HW_OP_RX_PACKET);
     ax_rx_chunk rx_chunk;
     uint16_t pkt_wr_index = 0;
     uint16_t length;
@@ -2052,9 +2421,9 @@ int ax_rx_packet(ax_config *config, ax_packet *rx_pkt, ax_modulation *modulation
     while (1)
     {
         //  let's see what states show up as we go along
-        // Log.trace(F("radio state: %X\r\n"), ax_hw_read_register_8(config, AX_REG_RADIOSTATE) & 0xF);
-        // Log.trace(F("TRK P %d\r\n"), ax_hw_read_register_16(config, AX_REG_TRKPHASE));
-        // Log.trace(F("TRK F %d\r\n"), ax_hw_read_register_24(config, AX_REG_TRKRFFREQ));
+        // LOG_TRACE(F("radio state: %X\r\n"), ax_hw_read_register_8(config, AX_REG_RADIOSTATE) & 0xF);
+        // LOG_TRACE(F("TRK P %d\r\n"), ax_hw_read_register_16(config, AX_REG_TRKPHASE));
+        // LOG_TRACE(F("TRK F %d\r\n"), ax_hw_read_register_24(config, AX_REG_TRKRFFREQ));
 
         /* Check if FIFO is not empty */
         if (ax_fifo_rx_data(config, &rx_chunk))
@@ -2066,15 +2435,15 @@ int ax_rx_packet(ax_config *config, ax_packet *rx_pkt, ax_modulation *modulation
                 {
                     length = rx_chunk.chunk.data.length; //there's the first mystery byte (always 0xC8..should be flags, but isn't)
 
-                    Log.trace(F("flags %X\r\n"), rx_chunk.chunk.data.flags);
-                    Log.trace(F("length %d\r\n"), length);
-                    Log.trace(F("pkt write index %d\r\n"), pkt_wr_index);
+                    LOG_TRACE(F("flags %X\r\n"), rx_chunk.chunk.data.flags);
+                    LOG_TRACE(F("length %d\r\n"), length);
+                    LOG_TRACE(F("pkt write index %d\r\n"), pkt_wr_index);
 
                     /* print byte-by-byte */
                     /*        
                     for (int i = 0; i < length+1; i++)
                     {
-                        Log.verbose(F("data %d: %X\r\n"), i,
+                        LOG_VERBOSE(F("data %d: %X\r\n"), i,
                                     rx_chunk.chunk.data.data[i]);
                     }
                     */
@@ -2082,7 +2451,7 @@ int ax_rx_packet(ax_config *config, ax_packet *rx_pkt, ax_modulation *modulation
                     // if pkt_start is not set and pkt_end flag is set and pkt_write_index = 0, then it's bad
                     // that is, it's signalling that it's the end, but it hasn't started.
                     if (!(rx_chunk.chunk.data.flags & AX_FIFO_RXDATA_PKTSTART) && (pkt_wr_index == 0)){
-                        Log.trace(F("end flag set and write index  = 0\r\n"));
+                        LOG_TRACE(F("end flag set and write index  = 0\r\n"));
                         return 0;                            
                     }
 
@@ -2090,7 +2459,7 @@ int ax_rx_packet(ax_config *config, ax_packet *rx_pkt, ax_modulation *modulation
                     if ((rx_chunk.chunk.data.flags & AX_FIFO_RXDATA_ABORT) || (rx_chunk.chunk.data.flags & AX_FIFO_RXDATA_SIZEFAIL)) 
                     { // checks if the abort, sizefail, addrfail and residue flags are set
                         // this is a bad packet, discard
-                        Log.trace(F("bad packet, no cookie!\r\n"));
+                        LOG_TRACE(F("bad packet, no cookie!\r\n"));
                         // return 0;
                         return 0;
                     }
@@ -2098,7 +2467,7 @@ int ax_rx_packet(ax_config *config, ax_packet *rx_pkt, ax_modulation *modulation
                     /* if the current chunk would overflow packet data buffer, discard */
                     if ((pkt_wr_index + length) > AX_PACKET_MAX_DATA_LENGTH)
                     {
-                        Log.error(F("overflow\r\n"));
+                        LOG_ERROR(F("overflow\r\n"));
                         return 0;
                     }
 
@@ -2127,16 +2496,17 @@ int ax_rx_packet(ax_config *config, ax_packet *rx_pkt, ax_modulation *modulation
                         /*
                         for (int i = 0; i < rx_pkt->length; i++)
                         {
-                        Log.trace(F("data %d: %C %c\r\n"), i,
+                        LOG_TRACE(F("data %d: %C %c\r\n"), i,
                                     rx_pkt->data[i],
                                     rx_pkt->data[i]);
                         }
 
                         if (0)
                         {
-                        Log.trace(F("FEC FEC FEC %X\r\n"), ax_hw_read_register_8(config, AX_REG_FECSTATUS));
+                        LOG_TRACE(F("FEC FEC FEC %X\r\n"), ax_hw_read_register_8(config, AX_REG_FECSTATUS));
                         }
                         */
+                        rx_pkt->drained = micros();
                         pkt_parts |= 0x80;
                     }
                     
@@ -2144,21 +2514,21 @@ int ax_rx_packet(ax_config *config, ax_packet *rx_pkt, ax_modulation *modulation
                 }
 
                 case AX_FIFO_CHUNK_RSSI:
-                    Log.notice(F("rssi %d dBm\r\n"), rx_chunk.chunk.rssi);
+                    event_log.add(EV_RSSI, rx_chunk.chunk.rssi);  // deferred, we're in the middle of receiving
 
                     rx_pkt->rssi = rx_chunk.chunk.rssi;
                     pkt_parts |= AX_PKT_STORE_RSSI;
                     break;
 
                 case AX_FIFO_CHUNK_RFFREQOFFS:
-                    Log.notice(F("rf offset %d Hz\r\n"), (int)rx_chunk.chunk.rffreqoffs);
+                    event_log.add(EV_RF_OFFSET, rx_chunk.chunk.rffreqoffs);
                     rx_pkt->rffreqoffs = rx_chunk.chunk.rffreqoffs;
                     pkt_parts |= AX_PKT_STORE_RF_OFFSET;
                     break;
 
                 case AX_FIFO_CHUNK_FREQOFFS:
                     offset = rx_chunk.chunk.freqoffs * 2000;
-                    Log.notice(F("freq offset %f\r\n"), offset / (1 << 16));
+                    LOG_NOTICE(F("freq offset %f\r\n"), offset / (1 << 16));
 
                     /* todo add data to back */
                     pkt_parts |= AX_PKT_STORE_FREQUENCY_OFFSET;
@@ -2166,45 +2536,45 @@ int ax_rx_packet(ax_config *config, ax_packet *rx_pkt, ax_modulation *modulation
 
                 case AX_FIFO_CHUNK_DATARATE:
                     /* todo process datarate */
-                    Log.notice(F("datarate TODO\r\n"));
+                    LOG_NOTICE(F("datarate TODO\r\n"));
                     pkt_parts |= AX_PKT_STORE_DATARATE_OFFSET;
                     break;
                 default:
 
-                    Log.error(F("some other chunk type %X\r\n"), rx_chunk.chunk_t);
+                    LOG_ERROR(F("some other chunk type %X\r\n"), rx_chunk.chunk_t);
                     break;
                 }
             if (pkt_parts == pkt_parts_list)
             {
                 /* we have all the parts for a packet */
-                Log.trace(F("We have all the parts!\r\n"));
+                LOG_TRACE(F("We have all the parts!\r\n"));
                 //PROCESS HERE
                 /* print byte-by-byte */
-                for (int i = 0; i < rx_pkt->length; i++) Log.verbose(F("data %d: %X\r\n"), i, rx_pkt->data[i]);
+                if (LOG_ON(LOG_LEVEL_VERBOSE)) for (int i = 0; i < rx_pkt->length; i++) LOG_VERBOSE(F("data %d: %X\r\n"), i, rx_pkt->data[i]);
 
                 ax_fifo_clear(config);  //clear the fifo...i want to make sure there's nothing left in it.
-                Log.trace(F("FIFO cleared\r\n"));
+                LOG_TRACE(F("FIFO cleared\r\n"));
 
                 if (modulation->il2p_enabled)
                 {
                     //we should now have the length byte (1), command code(1), il2p framing(3), il2p header(13), header parity(2), payload(0), payload parity(16), crc(4)
-                    Log.trace(F("rx_pkt length %i\r\n"), rx_pkt->length);  //total length incl len byte, cmd, etc...
+                    LOG_TRACE(F("rx_pkt length %i\r\n"), rx_pkt->length);  //total length incl len byte, cmd, etc...
                     if (rx_pkt->length < 40)
                     {
-                        Log.notice(F("packet too short: <40\r\n"));
+                        LOG_NOTICE(F("packet too short: <40\r\n"));
                         return 0;
                     }
                     //grab the command code
-                    Log.trace(F("the command code is: %X\r\n"), rx_pkt->data[1]);  //it's after the length byte
+                    LOG_TRACE(F("the command code is: %X\r\n"), rx_pkt->data[1]);  //it's after the length byte
                     unsigned char command_code = rx_pkt->data[1];
-                    Log.trace(F("the three sync bytes are: %X, %X, %X\r\n"), rx_pkt->data[2], rx_pkt->data[3], rx_pkt->data[4]);
+                    LOG_TRACE(F("the three sync bytes are: %X, %X, %X\r\n"), rx_pkt->data[2], rx_pkt->data[3], rx_pkt->data[4]);
 
                     //check CRC - it should be the last four bytes
                     uint32_t received_crc = *(rx_pkt->data+rx_pkt->length-4)<<24 | //example length: = 228, grab bytes 224, 225, 226, 227
                                           *(rx_pkt->data+rx_pkt->length-3)<<16 | 
                                           *(rx_pkt->data+rx_pkt->length-2)<<8 | 
                                           *(rx_pkt->data+rx_pkt->length-1);
-                    Log.verbose(F("received crc: %X\r\n"),received_crc);
+                    LOG_VERBOSE(F("received crc: %X\r\n"),received_crc);
                     //if (!il2p_CRC.verify(rx_pkt->data + 5, rx_pkt->length-5-4, received_crc)) return 0;
 
                     IL2P_CRC il2p_crc_2;
@@ -2214,11 +2584,11 @@ int ax_rx_packet(ax_config *config, ax_packet *rx_pkt, ax_modulation *modulation
                     const int il2p_header_parity_length = 2;
 
 
-                    Log.verbose(F("pkt start byte: %X\r\n"), *(rx_pkt->data+length_framing));  //5=len + cmd + 3 x frame
-                    Log.verbose(F("pkt end byte: %X\r\n"), *(rx_pkt->data+ rx_pkt->length - length_framing)); //example length = 228, grab byte 223
-                    Log.verbose(F("length-10: %d \r\n"), rx_pkt->length-10);
-                    //if (!(il2p_crc_2.verify(rx_pkt->data + length_framing, rx_pkt->length-length_framing-length_crc-1, received_crc))) Log.verbose(F("BAD CRC!\r\n"));
-                    //else Log.verbose(F("SUCCESS!!!\r\n")); 
+                    LOG_VERBOSE(F("pkt start byte: %X\r\n"), *(rx_pkt->data+length_framing));  //5=len + cmd + 3 x frame
+                    LOG_VERBOSE(F("pkt end byte: %X\r\n"), *(rx_pkt->data+ rx_pkt->length - length_framing)); //example length = 228, grab byte 223
+                    LOG_VERBOSE(F("length-10: %d \r\n"), rx_pkt->length-10);
+                    //if (!(il2p_crc_2.verify(rx_pkt->data + length_framing, rx_pkt->length-length_framing-length_crc-1, received_crc))) LOG_VERBOSE(F("BAD CRC!\r\n"));
+                    //else LOG_VERBOSE(F("SUCCESS!!!\r\n")); 
                     uint16_t extracted_crc = il2p_crc_2.extract_crc(received_crc);
 
                     // Process IL2P header
@@ -2226,29 +2596,29 @@ int ax_rx_packet(ax_config *config, ax_packet *rx_pkt, ax_modulation *modulation
                     unsigned char descrambled_header[13];
                     
                     int decode_success_header = il2p_decode_rs(rx_pkt->data + length_framing, il2p_header_length, il2p_header_parity_length, decoded_header);  //header starts in byte 5
-                    Log.trace(F("HEADER decode success = %i\r\n"), decode_success_header);
+                    LOG_TRACE(F("HEADER decode success = %i\r\n"), decode_success_header);
                     if (decode_success_header < 0)
                     {
-                        Log.error(F("IL2P HEADER could not be recovered\r\n"));
+                        LOG_ERROR(F("IL2P HEADER could not be recovered\r\n"));
                         //return 0; //the header can't be recovered...returning would truncate the loop.  we want to see if the data is good
                     }
                     if (decode_success_header == 0 || decode_success_header == 1)
                     {
-                        Log.trace(F("descrambling header\r\n"));
+                        LOG_TRACE(F("descrambling header\r\n"));
                         il2p_descramble_block(decoded_header, descrambled_header, il2p_header_length);
                         //so now we have the header back (theoretically)
                         //could add a compare here and break if it doesn't match
                         //for now, just output it
-                        Log.trace(F("Received HEADER block\r\n"));
-                        for (int i=0; i<13; i++) Log.trace(F("%X, "),descrambled_header[i]);
-                        Log.trace(F("\r\n"));
+                        LOG_TRACE(F("Received HEADER block\r\n"));
+                        if (LOG_ON(LOG_LEVEL_TRACE)) for (int i=0; i<13; i++) LOG_TRACE(F("%X, "),descrambled_header[i]);
+                        LOG_TRACE(F("\r\n"));
                     }
 
                     //Process IL2P data
                     unsigned char decoded_data[255];  //not optimizing array size here
                     unsigned char descrambled_data[255];
 
-                    Log.verbose(F("first byte: %X\r\n"), *(rx_pkt->data + length_framing+il2p_header_length+il2p_header_parity_length+4));
+                    LOG_VERBOSE(F("first byte: %X\r\n"), *(rx_pkt->data + length_framing+il2p_header_length+il2p_header_parity_length+4));
                     //final data size should be length-15 (for header) - 16 (for parity bytes) - 1 (for cmd); 
                     //starting location is offset by header, length and cmd
                     //int decode_success_data = il2p_decode_rs(rx_chunk.chunk.data.data + 17 + 4, rx_pkt->length- 32 - 4 - 4, 16, decoded_data); //now 4 more for the CRC
@@ -2257,44 +2627,46 @@ int ax_rx_packet(ax_config *config, ax_packet *rx_pkt, ax_modulation *modulation
                     int data_size = rx_pkt->length - fixed_length;
                     if (data_size < 0) 
                     {
-                        Log.notice(F("data_size too short: < 0\r\n"));  //this is just a check
+                        LOG_NOTICE(F("data_size too short: < 0\r\n"));  //this is just a check
                         return 0;
                     }
-                    Log.notice(F("DATA size as received: %X\r\n"), data_size);
                     int decode_success_data = il2p_decode_rs(rx_pkt->data + length_framing + il2p_header_length + il2p_header_parity_length, data_size, data_parity, decoded_data); //now 4 more for the CRC
                     
-                    Log.notice(F("DATA decode success = %i\r\n"), decode_success_data);
+                    event_log.add(EV_DATA_DECODE, data_size, decode_success_data);
                     if (decode_success_data < 0)
                     {
-                        Log.error(F("IL2P DATA could not be recovered\r\n"));
+                        LOG_ERROR(F("IL2P DATA could not be recovered\r\n"));
+                        rx_pkt->bad_packets++;
                         return 0; //the header can't be recovered
                     }
 
                     if (decode_success_data >= 0 && decode_success_data <=8)
                     {
-                        Log.trace(F("descrambling data\r\n"));
+                        LOG_TRACE(F("descrambling data\r\n"));
                         il2p_descramble_block(decoded_data, descrambled_data, data_size);
                         // the il2p header isn't needed to calculate the CRC.  It's calculated using the fixed AX.25 one.
                         uint16_t ax25_crc = il2p_crc_2.calculate_AX25(descrambled_data, data_size);
-                        Log.trace("AX25 CRC (RX) = %X\r\n", ax25_crc);
+                        LOG_TRACE("AX25 CRC (RX) = %X\r\n", ax25_crc);
                         if (ax25_crc == extracted_crc) 
                         {
-                            Log.notice("Success! CRC matches\r\n");
+                            event_log.add(EV_CRC_OK);
                         }
                         else
                         {
-                            Log.notice("BAD CRC!\r\n");
+                            event_log.add(EV_CRC_BAD);
+                            rx_pkt->bad_packets++;
                             return 0; //if the crc doesn't match we want to drop the packet.
                         }
 
-                        Log.verbose(F("Received DATA block\r\n"));
-                        //for (int i=0; i< rx_pkt->length-40; i++) Log.verbose(F("%i: %X\r\n"), i, descrambled_data[i]);
-                        Log.verbose(F("\r\n"));
+                        LOG_VERBOSE(F("Received DATA block\r\n"));
+                        //for (int i=0; i< rx_pkt->length-40; i++) LOG_VERBOSE(F("%i: %X\r\n"), i, descrambled_data[i]);
+                        LOG_VERBOSE(F("\r\n"));
+                        rx_pkt->rs_corrections = decode_success_data;
                         rx_pkt->data[0] = command_code;  //gotta put the command code back
                         
                         for (int i = 0; i< data_size; i++) rx_pkt->data[i+1] = descrambled_data[i]; 
                         rx_pkt->length -= (fixed_length - 1);  //one less for the cmd byte
-                        Log.notice(F("final packet length: %i\r\n"), rx_pkt->length);
+                        event_log.add(EV_PACKET_LENGTH, rx_pkt->length);
                     }
                 }
                 return 1;
@@ -2332,7 +2704,7 @@ void ax_off(ax_config *config)
 
     ax_set_pwrmode(config, AX_PWRMODE_POWERDOWN);
 
-    Log.trace(F("ax_off complete!\r\n"));
+    LOG_TRACE(F("ax_off complete!\r\n"));
 }
 
 /**
@@ -2398,6 +2770,7 @@ void ax_set_tx_path(ax_config *config, enum ax_transmit_path path)
  */
 int ax_init(ax_config *config)
 {
+    AX_HW_OP(AX_HW_OP_INIT);
     /* must set spi_transfer */
     if (!config->spi_transfer)
     {
@@ -2406,21 +2779,21 @@ int ax_init(ax_config *config)
 
     /* Scratch */
     uint8_t scratch = ax_scratch(config);
-    Log.notice(F("Scratch %X\r\n"), scratch);
+    LOG_NOTICE(F("Scratch %X\r\n"), scratch);
 
     if (scratch != AX_SCRATCH)
     {
-        Log.error(F("Bad scratch value\r\n")); 
+        LOG_ERROR(F("Bad scratch value\r\n")); 
         return AX_INIT_BAD_SCRATCH;
     }
 
     /* Revision */
     uint8_t silicon_revision = ax_silicon_revision(config);
-    Log.notice(F("Silicon Revision %X\r\n"), silicon_revision);
+    LOG_NOTICE(F("Silicon Revision %X\r\n"), silicon_revision);
 
     if (silicon_revision != AX_SILICONREVISION)
     {
-        Log.error(F("Bad Silicon Revision value.\r\n"));
+        LOG_ERROR(F("Bad Silicon Revision value.\r\n"));
 
         return AX_INIT_BAD_REVISION;
     }
@@ -2429,6 +2802,7 @@ int ax_init(ax_config *config)
 
     /* Set RST bit (PWRMODE) */
     ax_hw_write_register_8(config, AX_REG_PWRMODE, AX_PWRMODE_RST);
+    config->turnaround.valid = 0;
 
     /* Set the PWRMODE register to POWERDOWN, also clears RST bit */
     ax_set_pwrmode(config, AX_PWRMODE_POWERDOWN);
@@ -2465,9 +2839,9 @@ void ax_fifo_tx_beacon(ax_config *config,
     /* debugging */
     // uint8_t fifostat = ax_hw_read_register_8(config, AX_REG_FIFOCOUNT);
     // uint16_t fifofree = ax_hw_read_register_16(config, AX_REG_FIFOFREE);
-    // Log.trace(F("fifo status (txbeacon): %X\r\n"), fifostat);
-    // Log.trace(F("fifo count (txbeacon): %X\r\n"), fifocount);
-    // Log.trace(F("fifo free (txbeacon): %X\r\n"), fifofree);
+    // LOG_TRACE(F("fifo status (txbeacon): %X\r\n"), fifostat);
+    // LOG_TRACE(F("fifo count (txbeacon): %X\r\n"), fifocount);
+    // LOG_TRACE(F("fifo free (txbeacon): %X\r\n"), fifofree);
 
     /* write chunk */
     header[0] = AX_FIFO_CHUNK_DATA;
@@ -2476,9 +2850,9 @@ void ax_fifo_tx_beacon(ax_config *config,
     ax_hw_write_fifo(config, header, 3);
     ax_hw_write_fifo(config, data, (uint8_t)length);
 
-    // Log.trace(F("fifo status (txbeacon): %X\r\n"), fifostat);
-    // Log.trace(F("fifo count (txbeacon): %X\r\n"), fifocount);
-    // Log.trace(F("fifo free (txbeacon): %X\r\n"), fifofree);
+    // LOG_TRACE(F("fifo status (txbeacon): %X\r\n"), fifostat);
+    // LOG_TRACE(F("fifo count (txbeacon): %X\r\n"), fifocount);
+    // LOG_TRACE(F("fifo free (txbeacon): %X\r\n"), fifofree);
 
     ax_fifo_commit(config); /* commit */
 }
@@ -2562,7 +2936,7 @@ uint16_t ax_MODIFY_TX_POWER(ax_config *config, float new_power)
     ax_hw_write_register_16(config, AX_REG_TXPWRCOEFFB, pwr);
     // current_mod->power = new_power;  // modify the structure
 
-    Log.trace(F("power %f = %X\r\n"), new_power, pwr);
+    LOG_TRACE(F("power %f = %X\r\n"), new_power, pwr);
     return ax_hw_read_register_16(config, AX_REG_TXPWRCOEFFB);
 }
 
@@ -2573,13 +2947,13 @@ uint16_t ax_MODIFY_FEC(ax_config *config, ax_modulation *current_mod, bool FEC)
     {
         current_mod->fec = 0; // FSK
         current_mod->bitrate = 9600;
-        Log.trace(F("FEC off; bitrate is 9600\r\n"));
+        LOG_TRACE(F("FEC off; bitrate is 9600\r\n"));
     }
     else
     {
         current_mod->fec = 1;
         current_mod->bitrate = 19200;
-        Log.trace(F("FEC on; bitrate now 19200\r\n"));
+        LOG_TRACE(F("FEC on; bitrate now 19200\r\n"));
     }
 
     return current_mod->fec;
@@ -2605,10 +2979,10 @@ uint16_t ax_MODIFY_SHAPING(ax_config *config, ax_modulation *current_mod, uint8_
     }
     else
     {
-        Log.error(F("ERROR: Shaping index out of bounds\r\n"));
+        LOG_ERROR(F("ERROR: Shaping index out of bounds\r\n"));
     }
 
-    Log.trace(F("new shaping configured\r\n"));
+    LOG_TRACE(F("new shaping configured\r\n"));
     return current_mod->shaping;
 }
 
@@ -94,6 +94,9 @@ typedef struct ax_packet
     uint16_t length;
     int16_t rssi;
     int32_t rffreqoffs;
+    uint8_t rs_corrections; /* symbols the IL2P data decode had to fix */
+    uint16_t bad_packets;   /* running count of IL2P packets dropped for RS or CRC failures */
+    unsigned long drained;  /* micros() when the end of the packet came out of the FIFO */
 } ax_packet;
 
 /**
@@ -117,6 +120,33 @@ enum ax_vco_ranging_result
     AX_VCO_RANGING_FAILED,
 };
 
+/**
+ * non-blocking transmit.  A packet goes into the FIFO through these states, see ax_tx_packet_step.
+ * TURNAROUND is for the caller, ax doesn't use it.
+ */
+enum ax_tx_state
+{
+    AX_TX_STATE_IDLE = 0,
+    AX_TX_STATE_WAIT_SVMODEM, /* waiting for the modem supply after the change to FULLTX */
+    AX_TX_STATE_PREAMBLE,     /* waiting for room for the preamble and first chunk */
+    AX_TX_STATE_CHUNKS,       /* the rest, a chunk at a time as the transmitter makes room */
+    AX_TX_STATE_DRAIN,        /* all in the FIFO, the transmitter is emptying it */
+    AX_TX_STATE_TURNAROUND,   /* back to receive once the transmitter is idle */
+};
+
+#define AX_TX_MAX_CHUNK 239 /* max size before splitting up chunks, 240 less the flags byte */
+
+typedef struct ax_tx_job
+{
+    uint8_t state;         /* ax_tx_state */
+    ax_modulation *mod;
+    uint8_t *data;         /* next byte to go in the FIFO */
+    uint16_t length;       /* whole packet */
+    uint16_t rem_length;   /* not written yet, after the first chunk */
+    uint8_t chunk_length;  /* current chunk */
+    bool continuation;
+} ax_tx_job;
+
 /**
  * FUNCTION PROTOTYPES ---------------------------------------------------------
  */
@@ -153,9 +183,11 @@ void ax_set_digital_to_analog_converter(ax_config *config);
 void ax_set_registers(ax_config *config, ax_modulation *mod, ax_wakeup_config *wakeup_config);
 void ax_set_registers_tx(ax_config *config, ax_modulation *mod);
 void ax_set_registers_rx(ax_config *config, ax_modulation *mod);
+void ax_prepare_turnaround(ax_config *config, ax_modulation *mod);
 // vco functions
 enum ax_vco_ranging_result ax_do_vco_ranging(ax_config *config, uint16_t pllranging, ax_synthesiser *synth, enum ax_vco_type vco_type);
 enum ax_vco_ranging_result ax_vco_ranging(ax_config *config);
+void ax_vco_cache_clear(ax_config *config);
 
 /* tweakable parameters */
 void ax_default_params(ax_config *config, ax_modulation *mod);
@@ -168,21 +200,27 @@ int ax_force_quick_adjust_frequency_B(ax_config *config, uint32_t frequency);
 
 /* transmit */
 void ax_tx_on(ax_config *config, ax_modulation *mod);
+void ax_tx_turnaround(ax_config *config, ax_modulation *mod);
 void ax_tx_packet(ax_config *config, ax_modulation *mod,
-                  uint8_t *packet, uint16_t length);
+                  uint8_t *packet, uint16_t length, bool continuation = false);
 void ax_tx_beacon(ax_config *config,
                   uint8_t *packet, uint16_t length);
 void ax_tx_1k_zeros(ax_config *config);
 void ax_fifo_tx_beacon(ax_config *config,
                        uint8_t *data, uint16_t length);
 void ax_fifo_tx_data(ax_config *config, ax_modulation *mod,
-                     uint8_t *data, uint16_t length);
+                     uint8_t *data, uint16_t length, bool continuation = false);
+void ax_tx_packet_start(ax_tx_job *job, ax_modulation *mod, uint8_t *packet, uint16_t length,
+                        bool continuation, uint8_t start_state = AX_TX_STATE_WAIT_SVMODEM);
+uint8_t ax_tx_packet_step(ax_config *config, ax_tx_job *job);
 
 /* FIFO */
 void ax_fifo_clear(ax_config *config);
 
 /* receive */
 void ax_rx_on(ax_config *config, ax_modulation *mod);
+void ax_rx_turnaround(ax_config *config, ax_modulation *mod);
+void ax_rx_switch(ax_config *config, ax_modulation *mod);
 void ax_rx_wor(ax_config *config, ax_modulation *mod,
                ax_wakeup_config *wakeup_config);
 int ax_rx_packet(ax_config *config, ax_packet *rx_pkt, ax_modulation *modulation);
@@ -29,10 +29,112 @@
  */
 
 #include "ax_hw.h"
+#include "ax_reg_values.h"
+#include <ArduinoLog.h>
 
 /* Current status */
 uint16_t status = 0;
 
+#ifdef AX_HW_PROFILE
+uint8_t ax_hw_current_op = AX_HW_OP_OTHER;
+static ax_hw_op_counts op_counts[AX_HW_OP_COUNT];
+static ax_hw_trace_entry trace[AX_HW_TRACE_LENGTH];
+static uint32_t trace_index = 0; /* total transfers traced, wraps the ring */
+#endif
+
+/* async (DMA) transfers.  There's only ever one outstanding, and everything else waits for it to finish */
+static volatile bool async_pending = false;
+static ax_config *async_config;
+static unsigned char async_buffer[0x100 + 4]; /* a whole FIFO worth plus the address and a chunk header */
+static unsigned char async_commit[2];
+
+#ifdef AX_HW_PROFILE
+/* the address has to be decoded before the transfer, because the status comes back over it */
+static ax_hw_trace_entry *ax_hw_trace_start(unsigned char *data, uint16_t length)
+{
+    ax_hw_trace_entry *entry = &trace[trace_index++ & (AX_HW_TRACE_LENGTH - 1)];
+    if ((data[0] & 0x70) == 0x70)
+    { /* long access */
+        entry->reg = ((data[0] & 0x0F) << 8) | data[1];
+    }
+    else
+    {
+        entry->reg = data[0] & 0x7F;
+    }
+    entry->length = length > 0xFF ? 0xFF : length;
+    entry->op_write = (ax_hw_current_op << 1) | ((data[0] & 0x80) ? 1 : 0);
+    entry->time_us = micros();
+    return entry;
+}
+
+static void ax_hw_trace_end(ax_hw_trace_entry *entry, uint16_t length)
+{
+    ax_hw_op_counts *counts = &op_counts[ax_hw_current_op];
+    counts->transfers++;
+    counts->bytes += length;
+    counts->time_us += micros() - entry->time_us;
+}
+#endif
+
+/**
+ * waits for an async transfer to finish
+ */
+void ax_hw_wait(void)
+{
+    while (async_pending)
+        ;
+}
+
+/**
+ * every transfer goes through here so it can be profiled
+ */
+static void ax_hw_transfer(ax_config *config, unsigned char *data, uint8_t length)
+{
+    ax_hw_wait();
+#ifdef AX_HW_PROFILE
+    ax_hw_trace_entry *entry = ax_hw_trace_start(data, length);
+    config->spi_transfer(data, length);
+    ax_hw_trace_end(entry, length);
+#else
+    config->spi_transfer(data, length);
+#endif
+}
+
+static void ax_hw_async_done(void)
+{
+    async_pending = false;
+}
+
+/* chained from the end of a FIFO write, so this runs in the interrupt */
+static void ax_hw_async_commit(void)
+{
+    async_commit[0] = ((AX_REG_FIFOSTAT & 0x7F) | 0x80);
+    async_commit[1] = AX_FIFOCMD_COMMIT;
+    async_config->spi_transfer_async(async_commit, 2, ax_hw_async_done);
+}
+
+/**
+ * starts an async transfer.  The profile only sees the time it takes to get it going, which is the point.
+ */
+static void ax_hw_transfer_async(ax_config *config, unsigned char *data, uint16_t length, void (*done)(void))
+{
+    ax_hw_wait();
+    async_pending = true;
+    async_config = config;
+#ifdef AX_HW_PROFILE
+    ax_hw_trace_entry *entry = ax_hw_trace_start(data, length);
+    config->spi_transfer_async(data, length, done);
+    ax_hw_trace_end(entry, length);
+#else
+    config->spi_transfer_async(data, length, done);
+#endif
+}
+
+static bool ax_hw_use_async(ax_config *config, uint16_t length)
+{
+    return config->spi_transfer_async && config->spi_async_threshold && length >= config->spi_async_threshold;
+}
+
 /**
  * Reads register, and fully updates status. 8 bit
  *
@@ -45,7 +147,7 @@ uint8_t ax_hw_read_register_long_8(ax_config *config, uint16_t reg)
     data[0] = ((reg >> 8) | 0x70);
     data[1] = (reg & 0xFF);
     data[2] = 0xFF;
-    config->spi_transfer(data, 3);
+    ax_hw_transfer(config, data, 3);
 
     status = ((uint16_t)data[0] << 8) & data[1];
 
@@ -69,7 +171,7 @@ uint8_t ax_hw_read_register_8(ax_config *config, uint16_t reg)
 
         data[0] = (reg & 0x7F);
         data[1] = 0xFF;
-        config->spi_transfer(data, 2);
+        ax_hw_transfer(config, data, 2);
 
         status &= 0xFF;
         status |= ((uint16_t)data[0] << 8);
@@ -90,7 +192,7 @@ uint16_t ax_hw_write_register_long_8(ax_config *config, uint16_t reg, uint8_t va
     data[0] = ((reg >> 8) | 0xF0);
     data[1] = (reg & 0xFF);
     data[2] = value;
-    config->spi_transfer(data, 3);
+    ax_hw_transfer(config, data, 3);
 
     status = ((uint16_t)data[0] << 8) & data[1];
 
@@ -114,7 +216,7 @@ uint16_t ax_hw_write_register_8(ax_config *config, uint16_t reg, uint8_t value)
 
         data[0] = ((reg & 0x7F) | 0x80);
         data[1] = value;
-        config->spi_transfer(data, 2);
+        ax_hw_transfer(config, data, 2);
 
         status &= 0xFF;
         status |= ((uint16_t)data[0] << 8);
@@ -138,7 +240,7 @@ uint16_t ax_hw_write_register_long_32(ax_config *config, uint16_t reg, uint32_t
     data[3] = (value >> 16);
     data[4] = (value >> 8);
     data[5] = (value >> 0);
-    config->spi_transfer(data, 6);
+    ax_hw_transfer(config, data, 6);
 
     status = ((uint16_t)data[0] << 8) & data[1];
 
@@ -166,7 +268,7 @@ uint16_t ax_hw_write_register_32(ax_config *config, uint16_t reg, uint32_t value
         data[3] = (value >> 8);
         data[4] = (value >> 0);
 
-        config->spi_transfer(data, 5);
+        ax_hw_transfer(config, data, 5);
 
         status &= 0xFF;
         status |= ((uint16_t)data[0] << 8);
@@ -191,7 +293,7 @@ uint16_t ax_hw_read_register_long_bytes(ax_config *config, uint16_t reg,
     data[0] = ((reg >> 8) | 0x70);
     data[1] = (reg & 0xFF);
     memset(data + 2, 0xFF, bytes);
-    config->spi_transfer(data, 2 + bytes);
+    ax_hw_transfer(config, data, 2 + bytes);
 
     status = ((uint16_t)data[0] << 8) & data[1];
 
@@ -218,7 +320,7 @@ uint16_t ax_hw_read_register_bytes(ax_config *config, uint16_t reg,
 
         data[0] = (reg & 0x7F);
         memset(data + 1, 0xFF, bytes);
-        config->spi_transfer(data, 1 + bytes);
+        ax_hw_transfer(config, data, 1 + bytes);
 
         status &= 0xFF;
         status |= ((uint16_t)data[0] << 8);
@@ -281,18 +383,29 @@ uint32_t ax_hw_read_register_32(ax_config *config, uint16_t reg)
 
 /**
  * Writes buffer to fifo. First byte of buffer is discarded.
+ * Long writes go by DMA if there is one, and this returns before they're done.  The status is from the last
+ * finished transfer in that case.
  *
  * Returns status
  */
 uint16_t ax_hw_write_fifo(ax_config *config, uint8_t *buffer, uint16_t length)
 {
+    if (ax_hw_use_async(config, length + 1))
+    {
+        ax_hw_wait(); /* the buffer might still be going out */
+        async_buffer[0] = ((AX_REG_FIFODATA & 0x7F) | 0x80);
+        memcpy(async_buffer + 1, buffer, length);
+        ax_hw_transfer_async(config, async_buffer, length + 1, ax_hw_async_done);
+        return status;
+    }
+
     uint8_t data[0x100];
 
     /* write (short access) */
     data[0] = ((AX_REG_FIFODATA & 0x7F) | 0x80);
     memcpy(data + 1, buffer, length);
 
-    config->spi_transfer(data, length + 1);
+    ax_hw_transfer(config, data, length + 1);
 
     status &= 0xFF;
     status |= ((uint16_t)data[0] << 8);
@@ -300,6 +413,49 @@ uint16_t ax_hw_write_fifo(ax_config *config, uint8_t *buffer, uint16_t length)
     return status;
 }
 
+/**
+ * Writes a chunk header and its data to the fifo in one transfer, then commits it.  With DMA the commit
+ * is chained on the end of the write, so the whole thing goes out while the caller gets on with the next chunk.
+ *
+ * Returns status
+ */
+uint16_t ax_hw_write_fifo_commit(ax_config *config, uint8_t *header, uint8_t header_length,
+                                 uint8_t *buffer, uint16_t length)
+{
+    uint16_t total = 1 + header_length + length;
+
+    if (ax_hw_use_async(config, total))
+    {
+        ax_hw_wait();
+        async_buffer[0] = ((AX_REG_FIFODATA & 0x7F) | 0x80);
+        memcpy(async_buffer + 1, header, header_length);
+        memcpy(async_buffer + 1 + header_length, buffer, length);
+        ax_hw_transfer_async(config, async_buffer, total, ax_hw_async_commit);
+#ifdef AX_HW_PROFILE
+        /* the commit goes from the interrupt, count it here */
+        ax_hw_trace_entry *entry = ax_hw_trace_start(async_commit, 2);
+        entry->reg = AX_REG_FIFOSTAT;
+        entry->op_write |= 1;
+        ax_hw_trace_end(entry, 2);
+#endif
+        return status;
+    }
+
+    uint8_t data[0x100 + 4];
+
+    /* write (short access) */
+    data[0] = ((AX_REG_FIFODATA & 0x7F) | 0x80);
+    memcpy(data + 1, header, header_length);
+    memcpy(data + 1 + header_length, buffer, length);
+
+    ax_hw_transfer(config, data, total);
+
+    status &= 0xFF;
+    status |= ((uint16_t)data[0] << 8);
+
+    return ax_hw_write_register_8(config, AX_REG_FIFOSTAT, AX_FIFOCMD_COMMIT);
+}
+
 /**
  * Reads buffer from fifo. First byte of returned buffer is top byte of status
  *
@@ -310,7 +466,15 @@ uint16_t ax_hw_read_fifo(ax_config *config, uint8_t *buffer, uint16_t length)
     /* read (short access) */
     buffer[0] = (AX_REG_FIFODATA & 0x7F);
 
-    config->spi_transfer(buffer, length);
+    if (ax_hw_use_async(config, length))
+    { /* nothing else to do while it comes in, but the DMA is quicker than a byte at a time */
+        ax_hw_transfer_async(config, buffer, length, ax_hw_async_done);
+        ax_hw_wait();
+    }
+    else
+    {
+        ax_hw_transfer(config, buffer, length);
+    }
 
     status &= 0xFF;
     status |= ((uint16_t)buffer[0] << 8);
@@ -333,3 +497,75 @@ uint16_t ax_hw_poll_status(void)
 {
     return 0;
 }
+
+/**
+ * SPI profile
+ */
+void ax_hw_profile_reset(void)
+{
+#ifdef AX_HW_PROFILE
+    memset(op_counts, 0, sizeof(op_counts));
+    trace_index = 0;
+#endif
+}
+
+const ax_hw_op_counts *ax_hw_profile_counts(void)
+{
+#ifdef AX_HW_PROFILE
+    return op_counts;
+#else
+    return NULL;
+#endif
+}
+
+const char *ax_hw_op_name(uint8_t op)
+{
+    static const char *names[AX_HW_OP_COUNT] = {
+        "other", "init", "set_registers", "vco_ranging", "adjust_frequency",
+        "tx_on", "rx_on", "turnaround", "tx_packet", "rx_packet", "status"};
+
+    return (op < AX_HW_OP_COUNT) ? names[op] : "?";
+}
+
+uint8_t ax_hw_trace_length(void)
+{
+#ifdef AX_HW_PROFILE
+    return (trace_index < AX_HW_TRACE_LENGTH) ? trace_index : AX_HW_TRACE_LENGTH;
+#else
+    return 0;
+#endif
+}
+
+const ax_hw_trace_entry *ax_hw_trace_get(uint8_t n)
+{
+#ifdef AX_HW_PROFILE
+    uint32_t first = trace_index - ax_hw_trace_length();
+    return &trace[(first + n) & (AX_HW_TRACE_LENGTH - 1)];
+#else
+    return NULL;
+#endif
+}
+
+void ax_hw_profile_print(uint8_t trace_entries)
+{
+#ifdef AX_HW_PROFILE
+    Log.notice(F("SPI profile (transfers, bytes, us):\r\n"));
+    for (uint8_t op = 0; op < AX_HW_OP_COUNT; op++)
+    {
+        if (op_counts[op].transfers == 0) continue;
+        Log.notice(F("%s: %l, %l, %l\r\n"), ax_hw_op_name(op), op_counts[op].transfers, op_counts[op].bytes, op_counts[op].time_us);
+    }
+
+    uint8_t length = ax_hw_trace_length();
+    if (trace_entries > length) trace_entries = length;
+    Log.notice(F("last %i transfers (time, op, R/W, register, length):\r\n"), trace_entries);
+    for (uint8_t n = length - trace_entries; n < length; n++)
+    {
+        const ax_hw_trace_entry *entry = ax_hw_trace_get(n);
+        Log.notice(F("%l %s %c %X %i\r\n"), entry->time_us, ax_hw_op_name(entry->op_write >> 1),
+                   (entry->op_write & 1) ? 'W' : 'R', entry->reg, entry->length);
+    }
+#else
+    Log.notice(F("SPI profiling is compiled out (AX_HW_PROFILE)\r\n"));
+#endif
+}
@@ -59,8 +59,75 @@ uint32_t ax_hw_read_register_32(ax_config *config, uint16_t reg);
 
 uint16_t ax_hw_write_fifo(ax_config *config, uint8_t *buffer, uint16_t length);
 uint16_t ax_hw_read_fifo(ax_config *config, uint8_t *buffer, uint16_t length);
+uint16_t ax_hw_write_fifo_commit(ax_config *config, uint8_t *header, uint8_t header_length,
+                                 uint8_t *buffer, uint16_t length);
+void ax_hw_wait(void); /* waits for an outstanding async (DMA) transfer */
 
 uint16_t ax_hw_status(void);
 uint16_t ax_hw_poll_status(void);
 
+/**
+ * SPI profiling.  Every transfer is counted against the driver operation that's running when it's
+ * issued, and the last AX_HW_TRACE_LENGTH transfers are kept in a ring (register, direction, length, time).
+ * Comment out AX_HW_PROFILE to take it out completely.
+ */
+#define AX_HW_PROFILE
+
+enum ax_hw_op
+{
+    AX_HW_OP_OTHER = 0,
+    AX_HW_OP_INIT,
+    AX_HW_OP_SET_REGISTERS,
+    AX_HW_OP_VCO_RANGING,
+    AX_HW_OP_ADJUST_FREQUENCY,
+    AX_HW_OP_TX_ON,
+    AX_HW_OP_RX_ON,
+    AX_HW_OP_TURNAROUND,
+    AX_HW_OP_TX_PACKET,
+    AX_HW_OP_RX_PACKET,
+    AX_HW_OP_STATUS,
+    AX_HW_OP_COUNT,
+};
+
+typedef struct ax_hw_op_counts
+{
+    uint32_t transfers;
+    uint32_t bytes;
+    uint32_t time_us; /* time spent in spi_transfer */
+} ax_hw_op_counts;
+
+#define AX_HW_TRACE_LENGTH 32 /* power of two */
+typedef struct ax_hw_trace_entry
+{
+    uint32_t time_us; /* micros() at the start of the transfer */
+    uint16_t reg;
+    uint8_t length;   /* whole transfer, including the address byte(s) */
+    uint8_t op_write; /* ax_hw_op << 1 | 1 for a write */
+} ax_hw_trace_entry;
+
+#ifdef AX_HW_PROFILE
+extern uint8_t ax_hw_current_op;
+
+/* sets the operation for the rest of the enclosing scope, and puts the previous one back on the way out */
+class ax_hw_op_scope
+{
+public:
+    ax_hw_op_scope(uint8_t op) : _previous(ax_hw_current_op) { ax_hw_current_op = op; }
+    ~ax_hw_op_scope() { ax_hw_current_op = _previous; }
+
+private:
+    uint8_t _previous;
+};
+#define AX_HW_OP(op) ax_hw_op_scope _ax_hw_op_scope(op)
+#else
+#define AX_HW_OP(op)
+#endif
+
+void ax_hw_profile_reset(void);
+const ax_hw_op_counts *ax_hw_profile_counts(void); /* indexed by ax_hw_op */
+const char *ax_hw_op_name(uint8_t op);
+uint8_t ax_hw_trace_length(void);
+const ax_hw_trace_entry *ax_hw_trace_get(uint8_t n); /* 0 is the oldest */
+void ax_hw_profile_print(uint8_t trace_entries);     /* prints the counts and the last trace_entries transfers */
+
 #endif /* AX_HW_H */
@@ -576,9 +576,9 @@ void ax_param_performace_tuning(ax_config *config, ax_modulation *mod,
 }
 
 /**
- * populates ax_params structure
+ * computes the ax_params structure from scratch (float math)
  */
-void ax_populate_params(ax_config *config, ax_modulation *mod, ax_params *par)
+static void ax_compute_params(ax_config *config, ax_modulation *mod, ax_params *par)
 {
     /* Modulation index for FSK modes */
     switch (mod->modulation & 0xf)
@@ -630,3 +630,80 @@ void ax_populate_params(ax_config *config, ax_modulation *mod, ax_params *par)
 
     par->is_params_set = 0x51; /* yes, parameters are now set */
 }
+
+/**
+ * parameter sets that have already been computed
+ *
+ * The modes in ax_modes.cpp are fixed at compile time, so the params only
+ * change when the inputs below do.  After a mode has been loaded once,
+ * switching back to it (beacon -> data, modify_mode) is a table lookup.
+ */
+#define AX_PARAMS_CACHE_ENTRIES 4
+
+typedef struct ax_params_key
+{
+    uint32_t f_xtal;
+    uint8_t f_xtaldiv;
+    uint8_t modulation;
+    uint8_t fec;
+    uint8_t radiolab;
+    uint8_t continuous;
+    uint32_t bitrate;
+    uint8_t parameters[sizeof(((ax_modulation *)0)->parameters)];
+    uint32_t max_delta_carrier; /* before it's defaulted */
+} ax_params_key;
+
+typedef struct ax_params_cache_entry
+{
+    ax_params_key key;
+    uint32_t max_delta_carrier; /* after it's defaulted */
+    ax_params par;
+} ax_params_cache_entry;
+
+static ax_params_cache_entry ax_params_cache[AX_PARAMS_CACHE_ENTRIES];
+static uint8_t ax_params_cache_next = 0;
+
+static void ax_params_make_key(ax_config *config, ax_modulation *mod, ax_params_key *key)
+{
+    memset(key, 0, sizeof(ax_params_key)); /* padding too, the keys get memcmp'd */
+    key->f_xtal = config->f_xtal;
+    key->f_xtaldiv = config->f_xtaldiv;
+    key->modulation = mod->modulation;
+    key->fec = mod->fec;
+    key->radiolab = mod->radiolab;
+    key->continuous = mod->continuous;
+    key->bitrate = mod->bitrate;
+    memcpy(key->parameters, &mod->parameters, sizeof(key->parameters));
+    key->max_delta_carrier = mod->max_delta_carrier;
+}
+
+/**
+ * populates ax_params structure
+ */
+void ax_populate_params(ax_config *config, ax_modulation *mod, ax_params *par)
+{
+    ax_params_key key;
+    ax_params_make_key(config, mod, &key);
+
+    for (uint8_t i = 0; i < AX_PARAMS_CACHE_ENTRIES; i++)
+    {
+        ax_params_cache_entry *entry = &ax_params_cache[i];
+        if ((entry->par.is_params_set == 0x51) &&
+            (memcmp(&entry->key, &key, sizeof(ax_params_key)) == 0))
+        {
+            Log.trace(F("using cached params\r\n"));
+            mod->max_delta_carrier = entry->max_delta_carrier;
+            memcpy(par, &entry->par, sizeof(ax_params));
+            return;
+        }
+    }
+
+    ax_compute_params(config, mod, par);
+
+    /* oldest entry goes */
+    ax_params_cache_entry *entry = &ax_params_cache[ax_params_cache_next];
+    ax_params_cache_next = (ax_params_cache_next + 1) % AX_PARAMS_CACHE_ENTRIES;
+    memcpy(&entry->key, &key, sizeof(ax_params_key));
+    entry->max_delta_carrier = mod->max_delta_carrier;
+    memcpy(&entry->par, par, sizeof(ax_params));
+}
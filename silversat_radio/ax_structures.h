@@ -201,6 +201,43 @@ typedef struct ax_synthesiser
     uint8_t vco_range;       /* determined by autoranging */
 } ax_synthesiser;
 
+/**
+ * Cache of VCO ranging results.  An entry is good for any frequency within
+ * f/256 of the frequency it was ranged at, the same window ax_adjust_frequency
+ * uses to decide whether to re-range.  Kept in flash by the Radio class.  An
+ * entry that doesn't lock when it's loaded is dropped and that band is ranged.
+ */
+#define AX_VCO_CACHE_ENTRIES 8
+#define AX_VCO_LOCK_TIMEOUT 500 /* us for the PLL to lock on a cached VCOR before it's ranged again */
+typedef struct ax_vco_cache_entry
+{
+    uint32_t frequency; /* frequency when ranged, 0 if unused */
+    uint8_t rfdiv;      /* enum ax_rfdiv */
+    uint8_t vco_range;  /* VCOR */
+} ax_vco_cache_entry;
+
+typedef struct ax_vco_cache
+{
+    uint8_t is_cache_set; /* 0x56 when the table is valid */
+    uint8_t next;         /* next slot to replace */
+    uint8_t dirty;        /* changed since it was last saved */
+    ax_vco_cache_entry entry[AX_VCO_CACHE_ENTRIES];
+} ax_vco_cache;
+
+/**
+ * Register delta for a fast tx/rx turnaround.  Only the registers whose tx and
+ * rx values differ for the current modulation are kept (see ax_prepare_turnaround).
+ */
+#define AX_TURNAROUND_MAX_REGS 8
+typedef struct ax_turnaround_image
+{
+    uint16_t reg[AX_TURNAROUND_MAX_REGS];
+    uint8_t tx_value[AX_TURNAROUND_MAX_REGS];
+    uint8_t rx_value[AX_TURNAROUND_MAX_REGS];
+    uint8_t count;
+    uint8_t valid; /* 0 forces the full ax_tx_on/ax_rx_on path */
+} ax_turnaround_image;
+
 /**
  * configuration
  */
@@ -231,6 +268,10 @@ typedef struct ax_config
 
     /* spi transfer */
     void (*spi_transfer)(unsigned char *, uint8_t);
+    /* optional non-blocking transfer for FIFO bursts.  It must call done (it can be from an interrupt) when the */
+    /* transfer is over.  NULL, and everything goes through spi_transfer */
+    void (*spi_transfer_async)(unsigned char *, uint16_t, void (*done)(void));
+    uint16_t spi_async_threshold; /* transfers at least this long use spi_transfer_async */
 
     /* receive */
     uint8_t pkt_store_flags;  /* PKTSTOREFLAGS */
@@ -248,6 +289,12 @@ typedef struct ax_config
     /* pll vco */
     uint32_t f_pllrng;
 
+    /* vco ranging results */
+    ax_vco_cache vco_cache;
+
+    /* tx/rx turnaround */
+    ax_turnaround_image turnaround;
+
 } ax_config;
 
 #endif
\ No newline at end of file
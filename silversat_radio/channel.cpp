@@ -0,0 +1,73 @@
+/**
+* @file channel.cpp
+* @author Tom Conrad (tom@silversat.org)
+* @brief Background RSSI sampling and noise floor tracking for clear channel assessment
+* @version 1.0.1
+* @date 2026-10-19
+
+channel.cpp - Background RSSI sampling and noise floor tracking for clear channel assessment
+Created by Tom Conrad, October 19, 2026.
+Released into the public domain.
+
+*/
+
+#include "channel.h"
+
+void NoiseFloor::sample(uint8_t rssi, unsigned long now_ms)
+{
+  if (!_sampled) _block_start = now_ms;
+  _last_sample = now_ms;
+  _sampled = true;
+
+  // the clear decision is a max hold over the last few, like the old 5 readings but spread out
+  int recent = constrain(constants::cca_recent, 1, CCA_RECENT_MAX);
+  _recent[_recent_next] = rssi;
+  _recent_next = (_recent_next + 1) % recent;
+  if (_recent_count < recent) _recent_count++;
+  _recent_max = 0;
+  for (int i = 0; i < _recent_count; i++) if (_recent[i] > _recent_max) _recent_max = _recent[i];
+
+  if (_block_count < CCA_BLOCK_SAMPLES) _block[_block_count++] = rssi;
+  if (now_ms - _block_start >= constants::cca_floor_period) endBlock();
+}
+
+// once a block, so sorting it is fine
+void NoiseFloor::endBlock()
+{
+  for (int i = 1; i < _block_count; i++)
+  {
+    uint8_t value = _block[i];
+    int j = i - 1;
+    for (; (j >= 0) && (_block[j] > value); j--) _block[j + 1] = _block[j];
+    _block[j + 1] = value;
+  }
+
+  int blocks = constrain(constants::cca_floor_blocks, 1, CCA_FLOOR_BLOCKS_MAX);
+  _floors[_floors_next] = _block[(_block_count * constants::cca_floor_percentile) / 100];
+  _floors_next = (_floors_next + 1) % blocks;
+  if (_floors_count < blocks) _floors_count++;
+
+  _floor = 255;
+  for (int i = 0; i < _floors_count; i++) if (_floors[i] < _floor) _floor = _floors[i];
+
+  _block_count = 0;
+  _block_start = _last_sample;
+}
+
+uint8_t NoiseFloor::threshold(uint8_t ceiling)
+{
+  if (_floor < 0) return ceiling;
+  return min(_floor + constants::cca_margin, (int)ceiling);
+}
+
+void NoiseFloor::reset()
+{
+  _block_count = 0;
+  _floors_count = 0;
+  _floors_next = 0;
+  _floor = -1;
+  _recent_count = 0;
+  _recent_next = 0;
+  _recent_max = 0;
+  _sampled = false;
+}
@@ -0,0 +1,69 @@
+/**
+* @file channel.h
+* @author Tom Conrad (tom@silversat.org)
+* @brief Background RSSI sampling and noise floor tracking for clear channel assessment
+* @version 1.0.1
+* @date 2026-10-19
+
+channel.h - Background RSSI sampling and noise floor tracking for clear channel assessment
+Created by Tom Conrad, October 19, 2026.
+Released into the public domain.
+
+assess_channel used to take 5 RSSI readings 500 us apart on every idle pass (2.5 ms of nothing) and compare the
+biggest to a fixed threshold out of flash.  Now the loop takes one reading every constants::cca_sample_interval ms
+while it's in receive, and "is it clear" is just a compare against what's already been sampled.
+
+The readings are grouped into blocks of constants::cca_floor_period ms.  At the end of a block its low percentile
+(constants::cca_floor_percentile) is kept, and the noise floor is the lowest of the last constants::cca_floor_blocks
+of those.  Packets and other people's transmissions are the top of each block, so they don't move the floor, but
+interference that stays up for the whole window does.  The channel is clear when the last few readings
+(constants::cca_recent) are all within constants::cca_margin of the floor.
+
+The threshold from flash (command 0x1F) is now a ceiling: the channel is never called clear above it, however high
+the floor gets.  Until the first block is done it's the only threshold, same as before.  RSSI is the raw register
+byte, compared the way the old code did it.
+*/
+
+#ifndef CHANNEL_H
+#define CHANNEL_H
+
+#include "Arduino.h"
+#include "constants.h"
+
+#define CCA_BLOCK_SAMPLES 64     // readings kept per block, cca_floor_period / cca_sample_interval should fit
+#define CCA_FLOOR_BLOCKS_MAX 16  // most blocks the floor is taken over
+#define CCA_RECENT_MAX 8         // most recent readings the clear decision looks at
+
+class NoiseFloor {
+public:
+  bool due(unsigned long now_ms) { return !_sampled || (now_ms - _last_sample >= constants::cca_sample_interval); }
+  void sample(uint8_t rssi, unsigned long now_ms);
+  void reset();  //after anything that moves the receiver (frequency, mode)
+
+  bool clear(uint8_t ceiling) { return _sampled && (_recent_max <= threshold(ceiling)); }
+  uint8_t threshold(uint8_t ceiling);
+  int floor() { return _floor; }  //-1 until the first block is done
+  uint8_t recent() { return _recent_max; }
+
+private:
+  void endBlock();
+
+  uint8_t _block[CCA_BLOCK_SAMPLES];
+  int _block_count{0};
+  unsigned long _block_start{0};
+
+  uint8_t _floors[CCA_FLOOR_BLOCKS_MAX];  //low percentile of each block
+  int _floors_count{0};
+  int _floors_next{0};
+  int _floor{-1};
+
+  uint8_t _recent[CCA_RECENT_MAX];
+  int _recent_count{0};
+  int _recent_next{0};
+  uint8_t _recent_max{0};
+
+  unsigned long _last_sample{0};
+  bool _sampled{false};
+};
+
+#endif
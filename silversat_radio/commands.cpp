@@ -23,6 +23,7 @@
  my original thought was that this was only needed for a halt, so it wasn't a big deal if we just trashed the last data packet
  HOWEVER, there's the question of doppler correction, which would be done by ground sending periodic frequency change commands.  they have to be processed in the context of a continuing data transfer, and it would be bad to trash packets.  So we gotta sync.
  I *think* the way to handle it is to ONLY process commands if the top of the databuff is 0xC0 or empty.  (check both).  It would effectively delay command processing, but only if data is coming in at the same time.  (net effect..none here, it gets taken care of in the main code, and HAS been implemented)
+ UPDATE: commands and responses for the other end now go in their own relay queue (txqueue.h), which only ever holds whole frames, so there's nothing to sync with.  They also go out ahead of the data.
  
  note: commands have variable amounts of data, but these are generally some fixed amount per command. More generically, the data we receive after the first C0 and command code, and the last C0 is the length of the data in the command.
 
@@ -31,7 +32,7 @@
 #include "commands.h"
 
 
-void Command::processcommand(CircularBuffer<byte, DATABUFFSIZE> &databuffer, Packet &commandpacket, 
+void Command::processcommand(CircularBuffer<byte, DATABUFFSIZE> &databuffer, CircularBuffer<byte, PRIORITYBUFFSIZE> &relaybuffer, Packet &commandpacket, 
     ExternalWatchdog &watchdog, Efuse &efuse, Radio &radio, bool fault, int operating_frequency, FlashStorageClass<byte> &clear_threshold, 
     byte clearthreshold, bool board_reset, Stats &stats)
 {
@@ -163,7 +164,7 @@ void Command::processcommand(CircularBuffer<byte, DATABUFFSIZE> &databuffer, Pac
         else
         {
             sendACK(commandpacket.commandcode);
-            transmit_callsign(databuffer);
+            transmit_callsign(relaybuffer);
         }
         // no response
         break;
@@ -299,7 +300,7 @@ void Command::processcommand(CircularBuffer<byte, DATABUFFSIZE> &databuffer, Pac
         else
         {
             sendACK(commandpacket.commandcode);
-            print_stats(stats, databuffer);
+            print_stats(stats, databuffer, radio);
         }
         break;
     }
@@ -320,6 +321,50 @@ void Command::processcommand(CircularBuffer<byte, DATABUFFSIZE> &databuffer, Pac
         break;
     }
 
+    case 0x20: // print SPI profile
+    {
+        if (commandpacket.packetlength != 3)
+        {
+            sendNACK(commandpacket.commandcode);
+        }
+        else
+        {
+            sendACK(commandpacket.commandcode);
+            print_spi_profile();
+        }
+        break;
+    }
+
+    case 0x22: // print latency histograms
+    {
+        if (commandpacket.packetlength != 3)
+        {
+            sendNACK(commandpacket.commandcode);
+        }
+        else
+        {
+            sendACK(commandpacket.commandcode);
+            stats.latency.print();
+        }
+        break;
+    }
+
+    case 0x21: // doppler schedule (no body cancels it)
+    {
+        sendACK(commandpacket.commandcode);
+        if (commandpacket.packetlength == 3)
+        {
+            radio.stopDoppler();
+            response = "cancelled";
+            sendResponse(commandpacket.commandcode, response);
+        }
+        else if (doppler_schedule(commandpacket, radio, response))
+        {
+            sendResponse(commandpacket.commandcode, response);
+        }
+        break;
+    }
+
     default:
     {
         sendNACK(commandpacket.commandcode);
@@ -490,6 +535,7 @@ int Command::modify_frequency(Packet &commandpacket, Radio &radio, int operating
     }
     else
     {
+        radio.stopDoppler(false);
         Log.notice(F("setting new transmit frequency\r\n"));
         radio.setTransmitFrequency(new_frequency);
         Log.notice(F("setting new receive frequency\r\n"));
@@ -544,6 +590,7 @@ bool Command::doppler_frequencies(Packet &commandpacket, Radio &radio, String &r
     }
     else
     {
+        radio.stopDoppler(false);  // the ground is doing it by hand again
         radio.setTransmitFrequency(transmit_frequency);
         radio.setReceiveFrequency(receive_frequency);
         
@@ -552,16 +599,29 @@ bool Command::doppler_frequencies(Packet &commandpacket, Radio &radio, String &r
     }
 }
 
-void Command::transmit_callsign(CircularBuffer<byte, DATABUFFSIZE> &databuffer)
+// the table is described in doppler.h.  Times are from now.
+bool Command::doppler_schedule(Packet &commandpacket, Radio &radio, String &response)
+{
+    if (!radio.startDoppler((char *)commandpacket.packetbody))
+    {
+        Log.error(F("bad doppler schedule\r\n"));
+        sendNACK(commandpacket.commandcode);
+        return false;
+    }
+    response = String(radio.doppler.points()) + " points, " + String(radio.doppler.duration()) + " s";
+    return true;
+}
+
+void Command::transmit_callsign(CircularBuffer<byte, PRIORITYBUFFSIZE> &relaybuffer)
 {
     // act on command
-    databuffer.push(constants::FEND);
-    databuffer.push(0xAA);
+    relaybuffer.push(constants::FEND);
+    relaybuffer.push(0xAA);
     for (unsigned int i = 0; i < sizeof(constants::callsign) - 1; i++)
     {
-        databuffer.push(constants::callsign[i]);
+        relaybuffer.push(constants::callsign[i]);
     }
-    databuffer.push(constants::FEND);
+    relaybuffer.push(constants::FEND);
     //il2p_testing();
 }
 
@@ -858,7 +918,7 @@ byte Command::modify_CCA_threshold(Packet &commandpacket, Radio &radio, FlashSto
     return (byte)new_threshold;
 }
 
-void Command::print_stats(Stats &stats, CircularBuffer<byte, DATABUFFSIZE> &databuffer)
+void Command::print_stats(Stats &stats, CircularBuffer<byte, DATABUFFSIZE> &databuffer, Radio &radio)
 {
     Log.notice(F("Execution Times: \r\n"));
     Log.notice(F("max loop time: %lu \r\n"), stats.max_loop_time);
@@ -866,6 +926,8 @@ void Command::print_stats(Stats &stats, CircularBuffer<byte, DATABUFFSIZE> &data
     Log.notice(F("max data processor execution time: %lu \r\n"), stats.max_data_processor_execution_time);
     Log.notice(F("max transmit handler execution time: %lu \r\n"), stats.max_transmit_handler_execution_time);
     Log.notice(F("max receive handler execution time: %lu \r\n"), stats.max_receive_handler_execution_time);
+    Log.notice(F("max tx turnaround time: %lu \r\n"), stats.max_tx_turnaround_time);
+    Log.notice(F("max rx turnaround time: %lu \r\n"), stats.max_rx_turnaround_time);
     Log.notice(F("\r\nBuffer Status: \r\n"));
     Log.notice(F("max S0 tx buffer load: %i\r\n"), stats.max_buffer_load_s0);
     Log.notice(F("max S1 tx buffer load: %i\r\n"), stats.max_buffer_load_s1);
@@ -874,6 +936,22 @@ void Command::print_stats(Stats &stats, CircularBuffer<byte, DATABUFFSIZE> &data
     Log.notice(F("max cmdbuffer load: %i\r\n"), stats.max_commandbuffer_load);
     Log.notice(F("max txbuffer load: %i\r\n"), stats.max_txbuffer_load);
     Log.notice(F("min freememory: %i\r\n"), stats.free_mem_minimum);
+    Log.notice(F("stack headroom: %i\r\n"), stats.stack_headroom);
+    Log.notice(F("frames sent (control, relay, repeat, interactive, bulk, store): %l, %l, %l, %l, %l, %l\r\n"), stats.tx_frames[TXQ_CONTROL],
+        stats.tx_frames[TXQ_RELAY], stats.tx_frames[TXQ_REPEAT], stats.tx_frames[TXQ_INTERACTIVE], stats.tx_frames[TXQ_BULK], stats.tx_frames[TXQ_STORE]);
+    Log.notice(F("aggregates sent: %l, carrying %l frames\r\n"), stats.aggregates, stats.aggregated_frames);
+    Log.notice(F("header compression: %l frames, %l bytes saved, %l dropped\r\n"), stats.hc_compressed, stats.hc_saved, stats.hc_dropped);
+    Log.notice(F("payload compression: %l frames, %l bytes saved, %l dropped\r\n"), stats.lz_frames, stats.lz_saved, stats.lz_dropped);
+    Log.notice(F("arq: %l frames sent, %l sent again, %l given up, %l skipped, %l duplicates, %l rejected\r\n"), radio.arq.sent,
+        radio.arq.repeated, radio.arq.given_up, radio.arq.skipped, radio.arq.duplicates, radio.arq.rejected);
+    Log.notice(F("bulk transfer packets sent: %l\r\n"), stats.erasure_packets);
+    if (stats.erasure_report.blocks > 0)
+    {
+        Log.notice(F("last bulk transfer received: %l blocks, %l recovered, %l lost, margin %i lowest, %l total\r\n"), stats.erasure_report.blocks,
+            stats.erasure_report.recovered, stats.erasure_report.lost, stats.erasure_report.margin_min, stats.erasure_report.margin_total);
+    }
+    Log.notice(F("store and forward: %l frames stored, %l didn't fit, %i waiting, %l block erases, %l us longest stall\r\n"),
+        stats.store_frames, stats.store_full, stats.store_waiting, stats.store_erases, stats.store_max_stall);
 
     //reset the variables
     stats.max_loop_time = 0;
@@ -881,11 +959,34 @@ void Command::print_stats(Stats &stats, CircularBuffer<byte, DATABUFFSIZE> &data
     stats.max_data_processor_execution_time = 0;
     stats.max_transmit_handler_execution_time = 0;
     stats.max_receive_handler_execution_time = 0;
+    stats.max_tx_turnaround_time = 0;
+    stats.max_rx_turnaround_time = 0;
     stats.max_buffer_load_s0 = 0;
     stats.max_buffer_load_s1 = 0;
     stats.max_databuffer_load = 0;
     stats.max_commandbuffer_load = 0;
     stats.max_txbuffer_load = 0;
     stats.free_mem_minimum = 32000; 
+    for (int i = 0; i < TXQ_COUNT; i++) stats.tx_frames[i] = 0;
+    stats.aggregates = 0;
+    stats.aggregated_frames = 0;
+    stats.hc_compressed = 0;
+    stats.hc_saved = 0;
+    stats.hc_dropped = 0;
+    stats.lz_frames = 0;
+    stats.lz_saved = 0;
+    stats.lz_dropped = 0;
+    radio.arq.clearCounts();
+    stats.erasure_packets = 0;
+    stats.store_frames = 0;
+    stats.store_full = 0;
+
+}
 
-}
\ No newline at end of file
+// SPI transfers per driver operation since the last time, and the most recent transfers.  Like print_stats it's
+// on the debug port and it starts over afterwards.
+void Command::print_spi_profile()
+{
+    ax_hw_profile_print(AX_HW_TRACE_LENGTH);
+    ax_hw_profile_reset();
+}
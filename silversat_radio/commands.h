@@ -26,7 +26,7 @@ extern char *__brkval;
 #endif
 
 #ifndef DATABUFFSIZE
-#define DATABUFFSIZE 8192 // 32 packets at max packet size.  Need to watch for an overflow on this one!!!
+#define DATABUFFSIZE 4096 // 16 packets at max packet size.  Past half full they go to the flash store (flashqueue.h)
 #endif
 
 #include "beacon.h"
@@ -57,7 +57,7 @@ extern char *__brkval;
 class Command
 {
 public:
-    void processcommand(CircularBuffer<byte, DATABUFFSIZE> &databuffer, Packet &commandpacket,
+    void processcommand(CircularBuffer<byte, DATABUFFSIZE> &databuffer, CircularBuffer<byte, PRIORITYBUFFSIZE> &relaybuffer, Packet &commandpacket,
         ExternalWatchdog &watchdog, Efuse &efuse, Radio &radio, bool fault, int operating_frequency,
         FlashStorageClass<byte> &clear_threshold, 
         byte clearthreshold, bool board_reset, Stats &stats);
@@ -81,7 +81,8 @@ private:
     // &watchdog is needed if the command may cause long enough of a delay to trip the watchdog.  e.g. beacons
     // &radio is needed if you want to query or change the radio state
     // &response is the String that holds the response.  Only some commands have a response.
-    // &databuffer is needed if you want to push a packet across the RF link (e.g. send callsign)
+    // &databuffer is the bulk data queue (reset clears it, print_stats reports it)
+    // &relaybuffer is needed if you want to push a packet across the RF link (e.g. send callsign), it goes ahead of the data (txqueue.h)
     // &efuse is the efuse class instance, needed to make queries of current and status
     // &operating_frequency is the current default operating frequency stored in the internal flash of the SAMD21
     // &clear_threshold is the current default clear channel assessment threshold
@@ -93,7 +94,8 @@ private:
     int modify_frequency(Packet &commandpacket, Radio &radio, int operating_frequency);
     bool modify_mode(Packet &commandpacket, Radio &radio);
     bool doppler_frequencies(Packet &commandpacket, Radio &radio, String &response);
-    void transmit_callsign(CircularBuffer<byte, DATABUFFSIZE> &databuffer);
+    bool doppler_schedule(Packet &commandpacket, Radio &radio, String &response);
+    void transmit_callsign(CircularBuffer<byte, PRIORITYBUFFSIZE> &relaybuffer);
     // reset_5V() is handled in the efuse class
     void transmitCW(Packet &commandpacket, Radio &radio, ExternalWatchdog &watchdog);
     int background_rssi(Packet &commandpacket, Radio &radio, ExternalWatchdog &watchdog);
@@ -105,7 +107,8 @@ private:
     //void toggle_frequency(Radio &radio);
     char background_S_level(Radio &radio);
     byte modify_CCA_threshold(Packet &commandpacket, Radio &radio, FlashStorageClass<byte> &clear_threshold);
-    void print_stats(Stats &stats, CircularBuffer<byte, DATABUFFSIZE> &databuffer);
+    void print_stats(Stats &stats, CircularBuffer<byte, DATABUFFSIZE> &databuffer, Radio &radio);
+    void print_spi_profile();
 };
 
 #endif
\ No newline at end of file
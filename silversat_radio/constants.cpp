@@ -40,6 +40,62 @@ namespace constants
     extern const float power{0.5};
     extern const uint32_t max_delta_carrier{3000};
     extern const byte preamble_length{16};
+    extern const byte burst_sync_length{2};
+    extern const unsigned long tx_session_budget{2000};  //8 full frames at 9600, 4 at 4800
+    extern const unsigned long tx_session_hold{20};  //a byte at 9600 baud is about 1 ms
+    extern const uint32_t spi_clock{8000000};
+    extern const uint16_t spi_dma_threshold{32};
+    extern const bool afc_enabled{true};
+    extern const bool afc_track_tx{false};
+    extern const int afc_filter{4};
+    extern const int32_t afc_deadband{200};
+    extern const int32_t afc_limit{12000};  //a bit more than the doppler at 437 MHz from LEO
+    extern const unsigned long doppler_interval{500};  //the most the doppler changes in 500 ms is about 100 Hz
+    extern const bool rate_adaptive{false};  //until the margins have been checked on a pass
+    extern const byte rate_control_code{0xAC};
+    extern const int rate_window{8};
+    extern const int rate_down_failures{2};
+    extern const int rate_down_corrections{5};
+    extern const int rate_down_margin{8};  //what -112 and -100 dBm were meant to be over a -120 dBm floor
+    extern const int rate_up_corrections{1};
+    extern const int rate_up_margin{20};
+    extern const unsigned long rate_holdoff{30000};
+    extern const unsigned long rate_reply_timeout{3000};
+    extern const int rate_retries{3};
+    extern const unsigned long rate_silence_timeout{60000};  //has to be longer than the gaps between commands on a pass
+    extern const unsigned long cca_sample_interval{20};
+    extern const unsigned long cca_floor_period{1000};  //50 readings, fits in CCA_BLOCK_SAMPLES
+    extern const int cca_floor_percentile{20};
+    extern const int cca_floor_blocks{10};  //10 seconds
+    extern const int cca_margin{8};
+    extern const byte csma_persistence{63};  //0.25
+    extern const byte csma_slot_time{10};  //100 ms, a bit more than a turnaround
+    extern const int interactive_frame_max{100};  //a TCP ACK through tncattach is 44 bytes before KISS
+    extern const int tx_starvation_frames{4};
+    extern const bool aggregate_frames{true};
+    extern const byte aggregate_code{0xAD};
+    extern const int aggregate_max{210};  //+ 5 of ARQ header is 215, 214 payload bytes + 39 of IL2P is 253
+    extern const bool header_compression{true};
+    extern const byte hc_uncompressed_code{0xAE};
+    extern const byte hc_compressed_code{0xAF};
+    extern const int hc_refresh{32};
+    extern const bool payload_compression{true};
+    extern const byte lz_code{0xB0};
+    extern const int lz_min{32};  //a compressed TCP ACK is about 10 bytes
+    extern const bool arq_enabled{true};
+    extern const byte arq_data_code{0xB1};
+    extern const byte arq_ack_code{0xB2};
+    extern const unsigned long arq_timeout{4000};  //a 2 second session each way
+    extern const int arq_retries{4};
+    extern const unsigned long arq_ack_delay{100};  //the sender's burst is over by then
+    extern const unsigned long arq_gap_timeout{30000};  //longer than the sender takes to give up, 5 tries 4 seconds apart
+    extern const byte erasure_code{0xB3};
+    extern const int erasure_repair{4};
+    extern const unsigned long erasure_timeout{10000};
+    extern const bool store_forward{true};
+    extern const unsigned long store_link_timeout{60000};  //longer than the gaps between commands on a pass, like rate_silence_timeout
+    extern const unsigned long store_idle{100};  //about 100 character times at 9600, a sender that's between bursts
+    extern const int cca_recent{3};  //60 ms, a bit more than the old 5 x 500 us but it doesn't cost anything
     extern const String version{"1.14"};
     extern const int PTT_delay{250};
     extern const int PTT_duration{20*1000}; //delay in milliseconds
@@ -21,6 +21,62 @@
  * power = the power fraction expressed as a percentage of maximum power.  remember that the max power for single ended is half of the power for differential.
  * max_delta_carrier = range for the AFC loop, usually based on oscillator tolerance, in Hz
  * preamble_length = number of preamble bytes to send
+ * burst_sync_length = number of preamble bytes sent between frames of a transmit burst (the transmitter is still keyed, so the receiver stays bit synced)
+ * tx_session_budget = most airtime (ms) one transmit session gets before dropping back to receive, so a bulk transfer can't hold the channel.  Frames are counted as they're queued, from the bitrate and their length
+ * tx_session_hold = stay in transmit while a frame is still coming in on Serial1 and the last byte came in less than this many ms ago
+ * spi_clock = AX5043 SPI clock in Hz.  The chip allows 10 MHz, and the SERCOM can only divide 48 MHz by even numbers, so 8 MHz is as fast as it goes
+ * spi_dma_threshold = SPI transfers at least this long (FIFO bursts) are done by DMA, anything shorter isn't worth setting up the DMA for
+ * afc_enabled = track the RF offset of received packets and pull the synthesizers onto it (see afc.h)
+ * afc_track_tx = apply the same correction (in ppm) to the transmit synth.  Only right if the offset is our own reference, not doppler the ground already took out
+ * afc_filter = per-packet offsets are averaged over about this many packets
+ * afc_deadband = filtered offsets smaller than this (Hz) are left alone
+ * afc_limit = the most the tracker will move either synth from where it was set (Hz).  Bigger offsets are thrown out as bad measurements
+ * doppler_interval = how often (ms) the doppler schedule moves the synths, between packets
+ * rate_adaptive = let the two ends agree on 4800 or 9600 IL2P from how the link is doing (see ratecontrol.h)
+ * rate_control_code = KISS command byte of the rate control frames between the two radios
+ * rate_window = number of received packets the rate decision is made over (at most 16)
+ * rate_down_failures = packets in the window lost to RS or CRC failures that send us down
+ * rate_down_corrections = average RS symbol corrections per packet that send us down (the data block can fix 8)
+ * rate_down_margin = average packet RSSI over the noise floor (RSSI register counts, 1 dB) below which we go down
+ * rate_up_corrections = a full window with no failures, at most this many corrections per packet, and...
+ * rate_up_margin = ...at least this average margin over the noise floor lets us go up.  It's well above rate_down_margin so we don't flap
+ * rate_holdoff = ms after a switch (or a refused request) before asking again
+ * rate_reply_timeout = ms to wait for the peer to answer a request before sending it again
+ * rate_retries = times a request is sent before giving up
+ * rate_silence_timeout = ms above 4800 with nothing decoded before we drop back to 4800 on our own
+ * cca_sample_interval = ms between background RSSI readings in receive (see channel.h)
+ * cca_floor_period = ms of readings per block, the low percentile of each block goes into the noise floor
+ * cca_floor_percentile = which percentile of a block counts as its noise
+ * cca_floor_blocks = the noise floor is the lowest of this many blocks (at most 16)
+ * cca_margin = how far above the noise floor (RSSI register units, 1 dB) still counts as clear.  clear_threshold is the ceiling
+ * cca_recent = the last this many readings all have to be under the threshold (at most 8)
+ * csma_persistence = KISS P, the chance of going in a slot once the channel is clear is (P+1)/256 (see csma.h)
+ * csma_slot_time = KISS SlotTime, 10 ms units.  The host can change both, and TXDELAY (tx_delay), with KISS parameter frames
+ * interactive_frame_max = Serial1 frames up to this many bytes (KISS encoded) go in the interactive queue, ahead of bulk data (see txqueue.h)
+ * tx_starvation_frames = a queue that's been passed over this many frames in a row goes next, whatever its priority
+ * aggregate_frames = pack small frames from the interactive queue into one IL2P frame (see aggregate.h).  Receiving them is always on
+ * aggregate_code = KISS command byte of an aggregate frame
+ * aggregate_max = most bytes in an aggregate, command byte included.  The ARQ header and IL2P overhead still have to fit the FIFO length byte
+ * header_compression = send the TCP/IP headers of data frames as changes from the last frame in the same connection (see headercomp.h).  Receiving them is always on
+ * hc_uncompressed_code = KISS command byte of a data frame with its headers whole, that sets up a connection at the other end
+ * hc_compressed_code = KISS command byte of a data frame with compressed headers
+ * hc_refresh = a connection's headers go whole at least every this many frames, in case the other end lost track without noticing
+ * payload_compression = LZ compress each data frame before it's encoded, when that makes it shorter (see lz.h).  Receiving them is always on
+ * lz_code = KISS command byte of a compressed data frame
+ * lz_min = frames shorter than this aren't worth trying
+ * arq_enabled = number the frames from Serial1 and send the lost ones again ourselves (see arq.h).  Both ends have to have it on
+ * arq_data_code = KISS command byte of a numbered frame
+ * arq_ack_code = KISS command byte of an acknowledgment on its own
+ * arq_timeout = ms before a frame nobody has acknowledged gets sent again
+ * arq_retries = times a frame gets sent again before it's given up on
+ * arq_ack_delay = ms of quiet after the last numbered frame before an acknowledgment goes on its own
+ * arq_gap_timeout = ms the receiving end waits for a missing frame before giving up on it and passing on what's behind it
+ * erasure_code = KISS command byte of a bulk transfer packet, and of the frames on Serial1 that start and stop one (see erasure.h)
+ * erasure_repair = repair packets per block of ERASURE_K when the start frame doesn't say.  4 gets a block through 20% loss
+ * erasure_timeout = ms with nothing for the block that's coming in before the receiving end writes out what it has
+ * store_forward = data frames from Serial1 go into flash while the other end can't hear us, and out when it can (see flashqueue.h)
+ * store_link_timeout = ms since anything was heard from the other end before the pass is over, as far as the store is concerned
+ * store_idle = ms Serial1 has to be quiet before a flash row gets erased for the store (the processor stops for up to 6 ms)
  * version = The software version of this code.  I have arbitrarilly decided that the version at CDR was 1.0.  Working up from there.
  */
 
@@ -46,6 +102,62 @@ namespace constants
     extern const float power;
     extern const uint32_t max_delta_carrier;
     extern const byte preamble_length;
+    extern const byte burst_sync_length;
+    extern const unsigned long tx_session_budget;
+    extern const unsigned long tx_session_hold;
+    extern const uint32_t spi_clock;
+    extern const uint16_t spi_dma_threshold;
+    extern const bool afc_enabled;
+    extern const bool afc_track_tx;
+    extern const int afc_filter;
+    extern const int32_t afc_deadband;
+    extern const int32_t afc_limit;
+    extern const unsigned long doppler_interval;
+    extern const bool rate_adaptive;
+    extern const byte rate_control_code;
+    extern const int rate_window;
+    extern const int rate_down_failures;
+    extern const int rate_down_corrections;
+    extern const int rate_down_margin;
+    extern const int rate_up_corrections;
+    extern const int rate_up_margin;
+    extern const unsigned long rate_holdoff;
+    extern const unsigned long rate_reply_timeout;
+    extern const int rate_retries;
+    extern const unsigned long rate_silence_timeout;
+    extern const unsigned long cca_sample_interval;
+    extern const unsigned long cca_floor_period;
+    extern const int cca_floor_percentile;
+    extern const int cca_floor_blocks;
+    extern const int cca_margin;
+    extern const int cca_recent;
+    extern const byte csma_persistence;
+    extern const byte csma_slot_time;
+    extern const int interactive_frame_max;
+    extern const int tx_starvation_frames;
+    extern const bool aggregate_frames;
+    extern const byte aggregate_code;
+    extern const int aggregate_max;
+    extern const bool header_compression;
+    extern const byte hc_uncompressed_code;
+    extern const byte hc_compressed_code;
+    extern const int hc_refresh;
+    extern const bool payload_compression;
+    extern const byte lz_code;
+    extern const int lz_min;
+    extern const bool arq_enabled;
+    extern const byte arq_data_code;
+    extern const byte arq_ack_code;
+    extern const unsigned long arq_timeout;
+    extern const int arq_retries;
+    extern const unsigned long arq_ack_delay;
+    extern const unsigned long arq_gap_timeout;
+    extern const byte erasure_code;
+    extern const int erasure_repair;
+    extern const unsigned long erasure_timeout;
+    extern const bool store_forward;
+    extern const unsigned long store_link_timeout;
+    extern const unsigned long store_idle;
     extern const String version;
     extern const int PTT_delay;
     extern const int PTT_duration; //delay in milliseconss
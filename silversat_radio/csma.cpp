@@ -0,0 +1,50 @@
+/**
+* @file csma.cpp
+* @author Tom Conrad (tom@silversat.org)
+* @brief p-persistent CSMA, with the KISS TXDELAY, P and SlotTime parameters
+* @version 1.0.1
+* @date 2026-10-19
+
+csma.cpp - p-persistent CSMA, with the KISS TXDELAY, P and SlotTime parameters
+Created by Tom Conrad, October 19, 2026.
+Released into the public domain.
+
+*/
+
+#include "csma.h"
+#include "log_levels.h"
+#define LOG_MODULE_MAX LOG_MAX_RADIO
+
+bool ChannelAccess::parameter(byte command, byte value)
+{
+  switch (command)
+  {
+    case KISS_TXDELAY:
+      _txdelay = value;
+      LOG_NOTICE(F("csma: TXDELAY %d0 ms\r\n"), value);
+      return true;
+    case KISS_PERSISTENCE:
+      _persistence = value;
+      LOG_NOTICE(F("csma: P %d\r\n"), value);
+      return true;
+    case KISS_SLOTTIME:
+      _slottime = value;
+      LOG_NOTICE(F("csma: SlotTime %d0 ms\r\n"), value);
+      return true;
+  }
+  return false;
+}
+
+bool ChannelAccess::persist(unsigned long now_us)
+{
+  if (_deferred && (now_us - _slot_start < _slottime * 10000UL)) return false;
+  // P = 255 always goes
+  if (random(256) <= _persistence)
+  {
+    _deferred = false;
+    return true;
+  }
+  _deferred = true;
+  _slot_start = now_us;
+  return false;
+}
@@ -0,0 +1,56 @@
+/**
+* @file csma.h
+* @author Tom Conrad (tom@silversat.org)
+* @brief p-persistent CSMA, with the KISS TXDELAY, P and SlotTime parameters
+* @version 1.0.1
+* @date 2026-10-19
+
+csma.h - p-persistent CSMA, with the KISS TXDELAY, P and SlotTime parameters
+Created by Tom Conrad, October 19, 2026.
+Released into the public domain.
+
+We used to key up as soon as the channel had been clear for tx_delay.  Both ends have the same tx_delay, so when the
+other end finishes and both have something queued, both go at the same moment and a pair of 255 byte frames is lost.
+This is the usual KISS TNC channel access instead:
+
+  wait until the channel has been clear for TXDELAY (after the last thing we heard or sent)
+  then once per slot: go with probability (P+1)/256, otherwise wait for the next slot and look again
+
+The host sets the parameters with the standard KISS frames on Serial1 (the data port), the same way it would for any
+TNC.  Each is one byte after the command byte:
+
+  0x01 TXDELAY   10 ms units.  Here it's the clear time before keying up, since the preamble is handled by the radio
+  0x02 P         persistence, 0 to 255
+  0x03 SlotTime  10 ms units
+
+They don't go over the air and aren't saved, tncattach sends them when it starts.  Defaults are constants::tx_delay,
+csma_persistence and csma_slot_time.  Only the channel clear decision is here, Radio and the loop still decide when
+there's something to send.
+*/
+
+#ifndef CSMA_H
+#define CSMA_H
+
+#include "Arduino.h"
+#include "constants.h"
+#include "ArduinoLog.h"
+
+#define KISS_TXDELAY 0x01
+#define KISS_PERSISTENCE 0x02
+#define KISS_SLOTTIME 0x03
+
+class ChannelAccess {
+public:
+  bool parameter(byte command, byte value);  //a KISS parameter frame, false if it isn't one of ours
+  unsigned long txDelay() { return _txdelay * 10000UL; }  //us
+  bool persist(unsigned long now_us);  //the channel is clear, true if this is our slot
+
+private:
+  byte _txdelay{(byte)min(constants::tx_delay / 10000UL, 255UL)};
+  byte _persistence{constants::csma_persistence};
+  byte _slottime{constants::csma_slot_time};
+  bool _deferred{false};  //lost the draw, waiting out the slot
+  unsigned long _slot_start{0};
+};
+
+#endif
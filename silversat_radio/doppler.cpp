@@ -0,0 +1,110 @@
+/**
+* @file doppler.cpp
+* @author Tom Conrad (tom@silversat.org)
+* @brief Time-tagged doppler schedule, run onboard for a whole pass
+* @version 1.0.1
+* @date 2026-10-19
+
+doppler.cpp - Time-tagged doppler schedule, run onboard for a whole pass
+Created by Tom Conrad, October 19, 2026.
+Released into the public domain.
+
+*/
+
+#include "doppler.h"
+#include "log_levels.h"
+#define LOG_MODULE_MAX LOG_MAX_RADIO
+
+bool DopplerSchedule::load(const char *body, unsigned long now_ms)
+{
+  Point points[DOPPLER_MAX_POINTS];
+  int count = 0;
+  char *end;
+
+  long tx_base = strtol(body, &end, 10);
+  if (end == body) return false;
+  body = end;
+  long rx_base = strtol(body, &end, 10);
+  if (end == body) return false;
+  body = end;
+
+  if ((tx_base < 400000000 || tx_base > 525000000) || (rx_base < 400000000 || rx_base > 525000000)) return false;
+
+  while (*body != 0)
+  {
+    while (*body == ' ' || *body == ';') body++;
+    if (*body == 0) break;
+    if (count == DOPPLER_MAX_POINTS) return false;
+
+    long fields[3];
+    for (int i = 0; i < 3; i++)
+    {
+      if (i > 0)
+      {
+        if (*body != ',') return false;
+        body++;
+      }
+      fields[i] = strtol(body, &end, 10);
+      if (end == body) return false;
+      body = end;
+    }
+    // times have to go forwards, and the offsets are doppler, not a new frequency
+    if (fields[0] < 0 || fields[0] > 65535) return false;
+    if (count > 0 && fields[0] <= points[count - 1].time) return false;
+    if (abs(fields[1]) > 100000 || abs(fields[2]) > 100000) return false;
+
+    points[count].time = fields[0];
+    points[count].tx_offset = fields[1];
+    points[count].rx_offset = fields[2];
+    count++;
+  }
+  if (count == 0) return false;
+
+  memcpy(_points, points, sizeof(Point) * count);
+  _count = count;
+  _tx_base = tx_base;
+  _rx_base = rx_base;
+  _start = now_ms;
+  LOG_NOTICE(F("doppler schedule: %d points over %l seconds\r\n"), _count, duration());
+  return true;
+}
+
+bool DopplerSchedule::active(unsigned long now_ms)
+{
+  return (_count > 0) && ((now_ms - _start) <= (unsigned long)_points[_count - 1].time * 1000);
+}
+
+bool DopplerSchedule::frequencies(unsigned long now_ms, int &tx_frequency, int &rx_frequency)
+{
+  if (_count == 0) return false;
+  unsigned long elapsed = now_ms - _start;
+  if (elapsed < (unsigned long)_points[0].time * 1000) return false;
+
+  // find the segment we're in, past the end just holds the last point
+  int i = 0;
+  while ((i < _count - 1) && (elapsed >= (unsigned long)_points[i + 1].time * 1000)) i++;
+  int32_t tx_offset = _points[i].tx_offset;
+  int32_t rx_offset = _points[i].rx_offset;
+  if (i < _count - 1)
+  {
+    int32_t into = elapsed - (unsigned long)_points[i].time * 1000;   //ms
+    int32_t span = (int32_t)(_points[i + 1].time - _points[i].time) * 1000;
+    tx_offset += (int64_t)(_points[i + 1].tx_offset - _points[i].tx_offset) * into / span;
+    rx_offset += (int64_t)(_points[i + 1].rx_offset - _points[i].rx_offset) * into / span;
+  }
+  tx_frequency = _tx_base + tx_offset;
+  rx_frequency = _rx_base + rx_offset;
+  return true;
+}
+
+void DopplerSchedule::first(int &tx_frequency, int &rx_frequency)
+{
+  tx_frequency = _tx_base + _points[0].tx_offset;
+  rx_frequency = _rx_base + _points[0].rx_offset;
+}
+
+unsigned long DopplerSchedule::duration()
+{
+  if (_count == 0) return 0;
+  return _points[_count - 1].time - _points[0].time;
+}
@@ -0,0 +1,57 @@
+/**
+* @file doppler.h
+* @author Tom Conrad (tom@silversat.org)
+* @brief Time-tagged doppler schedule, run onboard for a whole pass
+* @version 1.0.1
+* @date 2026-10-19
+
+doppler.h - Time-tagged doppler schedule, run onboard for a whole pass
+Created by Tom Conrad, October 19, 2026.
+Released into the public domain.
+
+The doppler command (0x0D) only sets one pair of frequencies, so the ground has to keep sending them all pass
+over the 19200 baud command link.  This takes the whole pass in one command (0x21) as a table of points:
+
+  <tx base Hz> <rx base Hz> <t>,<tx offset>,<rx offset>;<t>,<tx offset>,<rx offset>;...
+
+t is seconds after the command is received, and the offsets are Hz from the base (signed).  Between points the
+frequencies are interpolated.  Radio::startDoppler sets the first point's frequencies straight away, through the
+same ranging the doppler command uses, and Radio::serviceDoppler applies the rest.  After the last point the
+frequencies go back to what they were before the schedule, and it's cleared.
+*/
+
+#ifndef DOPPLER_H
+#define DOPPLER_H
+
+#include "Arduino.h"
+#include "ArduinoLog.h"
+
+#define DOPPLER_MAX_POINTS 20  // a command body is at most 254 characters, so this is already more than fits with big offsets
+
+class DopplerSchedule {
+public:
+  bool load(const char *body, unsigned long now_ms);  //false (and the old schedule is kept) if it doesn't parse
+  void cancel() { _count = 0; }
+
+  bool active(unsigned long now_ms);  //loaded and not past the last point
+  bool frequencies(unsigned long now_ms, int &tx_frequency, int &rx_frequency);  //false before the first point
+  void first(int &tx_frequency, int &rx_frequency);  //the first point's
+  int points() { return _count; }
+  unsigned long duration();  //seconds from the first point to the last
+
+private:
+  struct Point
+  {
+    uint16_t time;  //seconds after load
+    int32_t tx_offset;
+    int32_t rx_offset;
+  };
+
+  Point _points[DOPPLER_MAX_POINTS];
+  int _count{0};
+  int32_t _tx_base{0};
+  int32_t _rx_base{0};
+  unsigned long _start{0};  //millis() at load
+};
+
+#endif
@@ -0,0 +1,465 @@
+/**
+* @file erasure.cpp
+* @author Tom Conrad (tom@silversat.org)
+* @brief Erasure coded bulk transfers, for one way downlinks like the SSDV images
+* @version 1.0.1
+* @date 2026-10-19
+
+erasure.cpp - Erasure coded bulk transfers, for one way downlinks like the SSDV images
+Created by Tom Conrad, October 19, 2026.
+Released into the public domain.
+
+*/
+
+#include "erasure.h"
+
+#define ERASURE_FREE 0xFF
+
+// GF(256) with the IL2P polynomial, tables made the first time they're needed
+static byte gf_exp[255];
+static byte gf_log[256];
+static bool gf_ready{false};
+
+static void gf_init()
+{
+  if (gf_ready) return;
+  int x = 1;
+  for (int i = 0; i < 255; i++)
+  {
+    gf_exp[i] = x;
+    gf_log[x] = i;
+    x <<= 1;
+    if (x & 0x100) x ^= 0x11D;
+  }
+  gf_ready = true;
+}
+
+static byte gf_inverse(byte a)
+{
+  return gf_exp[(255 - gf_log[a]) % 255];
+}
+
+// the Cauchy matrix, 1 / (x_n + y_i) with x_n = ERASURE_K + n and y_i = i
+static byte coefficient(int repair, int symbol)
+{
+  return gf_inverse((ERASURE_K + repair) ^ symbol);
+}
+
+// dst += c * src.  No divide on the M0, so the exponent wraps by subtracting
+static void gf_add_scaled(byte *dst, const byte *src, byte c, int length)
+{
+  if (c == 0) return;
+  int log_c = gf_log[c];
+  for (int i = 0; i < length; i++)
+  {
+    if (src[i] == 0) continue;
+    int e = gf_log[src[i]] + log_c;
+    if (e >= 255) e -= 255;
+    dst[i] ^= gf_exp[e];
+  }
+}
+
+static void gf_scale(byte *dst, byte c, int length)
+{
+  int log_c = gf_log[c];
+  for (int i = 0; i < length; i++)
+  {
+    if (dst[i] == 0) continue;
+    int e = gf_log[dst[i]] + log_c;
+    if (e >= 255) e -= 255;
+    dst[i] = gf_exp[e];
+  }
+}
+
+void ErasureEncoder::start(int repair)
+{
+  gf_init();
+  if (repair < 0) repair = 0;
+  if (repair > ERASURE_R_MAX) repair = ERASURE_R_MAX;
+  _active = true;
+  _transfer++;
+  _block = 0;
+  _repair = repair;
+  _repair_next = _repair;
+  _index = 0;
+  _fill = 0;
+  _full = false;
+  _source_ready = false;
+  _k = 0;
+  _final = false;
+  memset(_sums, 0, sizeof(_sums));
+  blocks = 0;
+  repairs = 0;
+}
+
+void ErasureEncoder::stop()
+{
+  if (!_active) return;
+  if (_full || (_fill > 0)) endBlock(true);
+  else _active = false;  //nothing in it at all
+}
+
+int ErasureEncoder::write(const byte *data, int length)
+{
+  if (!_active || _source_ready || (_repair_next < _repair)) return 0;
+  // more data, so the waiting symbol isn't the last one
+  if (_full)
+  {
+    if (_index == ERASURE_K - 1) endBlock(false);
+    else _source_ready = true;
+    return 0;
+  }
+  int take = min(length, ERASURE_SYMBOL - _fill);
+  memcpy(_symbol + _fill, data, take);
+  _fill += take;
+  _full = (_fill == ERASURE_SYMBOL);
+  return take;
+}
+
+void ErasureEncoder::endBlock(bool final)
+{
+  _k = _index + 1;
+  _tail = _fill;
+  _final = final;
+  _source_ready = true;
+}
+
+void ErasureEncoder::header(byte *packet, int index)
+{
+  packet[0] = constants::erasure_code;
+  packet[1] = _transfer;
+  packet[2] = _block >> 8;
+  packet[3] = _block;
+  packet[4] = index;
+  packet[5] = _k;
+  packet[6] = _tail;
+  packet[7] = (_repair << 1) | _final;
+}
+
+int ErasureEncoder::next(byte *packet)
+{
+  if (_source_ready)
+  {
+    memset(_symbol + _fill, 0, ERASURE_SYMBOL - _fill);  // the last one's padded, the repair sums need all of it
+    header(packet, _index);
+    memcpy(packet + ERASURE_HEADER, _symbol, ERASURE_SYMBOL);
+    for (int n = 0; n < _repair; n++) gf_add_scaled(_sums[n], _symbol, coefficient(n, _index), ERASURE_SYMBOL);
+    _source_ready = false;
+    _full = false;
+    _fill = 0;
+    if (_k == 0) _index++;
+    else _repair_next = 0;  // the block's done, its repair packets are next
+  }
+  else if (_repair_next < _repair)
+  {
+    header(packet, ERASURE_K + _repair_next);
+    memcpy(packet + ERASURE_HEADER, _sums[_repair_next], ERASURE_SYMBOL);
+    _repair_next++;
+    repairs++;
+  }
+  else return 0;
+
+  if ((_k != 0) && (_repair_next == _repair))
+  {
+    // on to the next block
+    blocks++;
+    _block++;
+    _index = 0;
+    _k = 0;
+    memset(_sums, 0, sizeof(_sums));
+    if (_final) _active = false;
+  }
+  return ERASURE_PACKET;
+}
+
+void ErasureDecoder::received(const byte *packet, int length, unsigned long now_ms)
+{
+  if ((length < ERASURE_PACKET) || (packet[0] != constants::erasure_code)) return;
+  gf_init();
+  // the caller's meant to empty next() first, but just in case
+  if (_draining)
+  {
+    if (!_parked) park(packet);
+    return;
+  }
+  accept(packet, now_ms);
+}
+
+void ErasureDecoder::park(const byte *packet)
+{
+  memcpy(_park, packet, ERASURE_PACKET);
+  _parked = true;
+}
+
+void ErasureDecoder::accept(const byte *packet, unsigned long now_ms)
+{
+  uint8_t transfer = packet[1];
+  uint16_t block = (packet[2] << 8) | packet[3];
+  int index = packet[4];
+  int k = packet[5];
+
+  // a new transfer.  One from before this one is late and gets dropped
+  if (!_started || ((transfer != report.transfer) && ((uint8_t)(transfer - report.transfer) < 128)))
+  {
+    if (_open)
+    {
+      park(packet);
+      endBlock();
+      return;
+    }
+    if (_counting) endCount();
+    if (_started && !_reported) endTransfer();  // it went quiet and never finished
+    _started = true;
+    _done = false;
+    _reported = false;
+    _block_next = 0;
+    report = {};
+    report.transfer = transfer;
+    report.margin_min = ERASURE_K + ERASURE_R_MAX;
+  }
+  else if (transfer != report.transfer) return;
+  if (index >= ERASURE_K + ERASURE_R_MAX) return;
+
+  // the rest of a block that's already been written out, they only count for the margin
+  if (!_open && _counting && (block == _block))
+  {
+    _seen |= 1UL << index;
+    _last_rx = now_ms;
+    if (index == _last_index) endCount();
+    return;
+  }
+  if (_done) return;
+
+  if (!_open)
+  {
+    if (block < _block_next) return;
+    if (_counting) endCount();
+    // none of the ones in between got here at all
+    long skipped = block - _block_next;
+    if (skipped > 0)
+    {
+      report.blocks += skipped;
+      report.lost += skipped;
+      report.margin_total -= skipped * ERASURE_K;
+      report.margin_min = -ERASURE_K;
+    }
+    _open = true;
+    _block = block;
+    _k = 0;
+    _tail = ERASURE_SYMBOL;
+    _final = false;
+    _seen = 0;
+    memset(_holder, ERASURE_FREE, sizeof(_holder));
+  }
+  else if (block != _block)
+  {
+    if (block < _block) return;
+    // the next one's started, so that's all there is of this one
+    park(packet);
+    endBlock();
+    return;
+  }
+  _last_rx = now_ms;
+
+  if ((k > ERASURE_K) || (_seen & (1UL << index))) return;
+  _seen |= 1UL << index;
+  int repair = packet[7] >> 1;
+  _last_index = (repair > 0) ? ERASURE_K + min(repair, ERASURE_R_MAX) - 1 : ERASURE_K - 1;
+  if (k != 0)
+  {
+    _k = k;
+    _tail = (packet[6] > 0) && (packet[6] <= ERASURE_SYMBOL) ? packet[6] : ERASURE_SYMBOL;
+    _final = packet[7] & 0x01;
+    if (repair == 0) _last_index = k - 1;
+  }
+
+  const byte *symbol = packet + ERASURE_HEADER;
+  if (index < ERASURE_K)
+  {
+    // a repair packet in its slot moves over, if there's somewhere for it
+    if (_holder[index] != ERASURE_FREE)
+    {
+      for (int slot = ERASURE_K - 1; slot >= 0; slot--)
+      {
+        if ((slot == index) || (_holder[slot] != ERASURE_FREE)) continue;
+        memcpy(_slots[slot], _slots[index], ERASURE_SYMBOL);
+        _holder[slot] = _holder[index];
+        break;
+      }
+    }
+    memcpy(_slots[index], symbol, ERASURE_SYMBOL);
+    _holder[index] = index;
+  }
+  else
+  {
+    // the symbols fill the low slots, so repair packets start at the top
+    int slot = ERASURE_K - 1;
+    while ((slot >= 0) && (_holder[slot] != ERASURE_FREE)) slot--;
+    if (slot >= 0)  // it's full otherwise, so it's got everything anyway
+    {
+      memcpy(_slots[slot], symbol, ERASURE_SYMBOL);
+      _holder[slot] = index;
+    }
+  }
+  if ((_k != 0) && (useful() >= _k)) endBlock();
+  if (_counting && (index == _last_index)) endCount();
+}
+
+// packets that count towards the block, the symbols in it and the repair packets
+int ErasureDecoder::useful()
+{
+  int count = 0;
+  for (int slot = 0; slot < ERASURE_K; slot++)
+  {
+    if ((_holder[slot] != ERASURE_FREE) && ((_holder[slot] < _k) || (_holder[slot] >= ERASURE_K))) count++;
+  }
+  return count;
+}
+
+// it goes out on Serial1 now, but the packets still coming for it count for the margin until the last one's due
+void ErasureDecoder::endBlock()
+{
+  if (_k == 0) _k = ERASURE_K;  // it never said, so it wasn't the last one (or the end of it was lost)
+  int missing = 0;
+  for (int index = 0; index < _k; index++) missing += (_holder[index] != index);
+  report.blocks++;
+  if (missing > 0)
+  {
+    if (decode()) report.recovered++;
+    else report.lost++;
+  }
+  _open = false;
+  _counting = true;
+  _draining = true;
+  _out = 0;
+  _block_next = _block + 1;
+  if (_final) _done = true;
+}
+
+void ErasureDecoder::endCount()
+{
+  int received = 0;
+  for (int index = 0; index < ERASURE_K + ERASURE_R_MAX; index++) received += (_seen >> index) & 1;
+  int margin = received - _k;
+  report.margin_total += margin;
+  if (margin < report.margin_min) report.margin_min = margin;
+  _counting = false;
+  if (_final) endTransfer();
+}
+
+void ErasureDecoder::endTransfer()
+{
+  _ended = report;
+  _finished = true;
+  _reported = true;
+}
+
+// fills in the missing symbols from the repair packets.  Take what the symbols that did come contribute off the repair
+// packets, which leaves a set of equations in just the missing ones.  Any square piece of a Cauchy matrix can be
+// inverted, and so can every leading piece of that, so Gauss-Jordan doesn't need to pivot
+bool ErasureDecoder::decode()
+{
+  int missing[ERASURE_R_MAX];
+  int rows[ERASURE_R_MAX];  // the slot each equation's in
+  int repair[ERASURE_R_MAX];
+  int count = 0;
+  for (int index = 0; index < _k; index++)
+  {
+    if (_holder[index] == index) continue;
+    if (count == ERASURE_R_MAX) return false;
+    missing[count++] = index;
+  }
+  int equations = 0;
+  for (int slot = 0; (slot < ERASURE_K) && (equations < count); slot++)
+  {
+    if ((_holder[slot] == ERASURE_FREE) || (_holder[slot] < ERASURE_K)) continue;
+    rows[equations] = slot;
+    repair[equations++] = _holder[slot] - ERASURE_K;
+  }
+  if (equations < count) return false;
+
+  byte matrix[ERASURE_R_MAX][ERASURE_R_MAX];
+  for (int row = 0; row < count; row++)
+  {
+    for (int index = 0; index < _k; index++)
+    {
+      if (_holder[index] == index) gf_add_scaled(_slots[rows[row]], _slots[index], coefficient(repair[row], index), ERASURE_SYMBOL);
+    }
+    for (int column = 0; column < count; column++) matrix[row][column] = coefficient(repair[row], missing[column]);
+  }
+
+  for (int pivot = 0; pivot < count; pivot++)
+  {
+    byte scale = gf_inverse(matrix[pivot][pivot]);
+    gf_scale(matrix[pivot], scale, count);
+    gf_scale(_slots[rows[pivot]], scale, ERASURE_SYMBOL);
+    for (int row = 0; row < count; row++)
+    {
+      byte factor = matrix[row][pivot];
+      if ((row == pivot) || (factor == 0)) continue;
+      gf_add_scaled(matrix[row], matrix[pivot], factor, count);
+      gf_add_scaled(_slots[rows[row]], _slots[rows[pivot]], factor, ERASURE_SYMBOL);
+    }
+  }
+
+  // each one into its own slot
+  for (int row = 0; row < count; row++)
+  {
+    int target = missing[row];
+    if (rows[row] != target)
+    {
+      for (int i = 0; i < ERASURE_SYMBOL; i++)
+      {
+        byte swap = _slots[target][i];
+        _slots[target][i] = _slots[rows[row]][i];
+        _slots[rows[row]][i] = swap;
+      }
+      for (int other = row + 1; other < count; other++)
+      {
+        if (rows[other] == target) rows[other] = rows[row];
+      }
+      _holder[rows[row]] = _holder[target];
+    }
+    _holder[target] = target;
+  }
+  return true;
+}
+
+int ErasureDecoder::next(byte *frame)
+{
+  while (_draining)
+  {
+    while (_out < _k)
+    {
+      int index = _out++;
+      if (_holder[index] != index) continue;  // lost
+      int length = (index == _k - 1) ? _tail : ERASURE_SYMBOL;
+      frame[0] = 0x00;
+      memcpy(frame + 1, _slots[index], length);
+      return length + 1;
+    }
+    _draining = false;
+    if (_parked)
+    {
+      _parked = false;
+      accept(_park, _last_rx);
+    }
+  }
+  return 0;
+}
+
+void ErasureDecoder::service(unsigned long now_ms)
+{
+  if ((!_open && !_counting) || _draining || (now_ms - _last_rx < constants::erasure_timeout)) return;
+  if (_open) endBlock();
+  if (_counting) endCount();
+  if (!_reported) endTransfer();  // it might pick up again, but this is what there is for now
+}
+
+bool ErasureDecoder::finished(ErasureReport &ended)
+{
+  if (!_finished) return false;
+  _finished = false;
+  ended = _ended;
+  return true;
+}
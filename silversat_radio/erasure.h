@@ -0,0 +1,133 @@
+/**
+* @file erasure.h
+* @author Tom Conrad (tom@silversat.org)
+* @brief Erasure coded bulk transfers, for one way downlinks like the SSDV images
+* @version 1.0.1
+* @date 2026-10-19
+
+erasure.h - Erasure coded bulk transfers, for one way downlinks like the SSDV images
+Created by Tom Conrad, October 19, 2026.
+Released into the public domain.
+
+Sending a file down with nobody able to ask for the lost frames again (gnuradio/ssdv_test.py) loses whatever the link
+loses.  A bulk transfer adds repair packets instead, so the other end can fill in the lost ones on its own.
+
+The payload starts one with a KISS frame on Serial1 with command byte constants::erasure_code and 'S' (and optionally
+the number of repair packets per block, constants::erasure_repair if not), sends the file as ordinary data frames, and
+ends it with constants::erasure_code and 'E'.  The frames can be any size, the bytes get cut into ERASURE_SYMBOL byte
+symbols, and every ERASURE_K symbols are a block.  Each symbol goes out as it is (the code is systematic), then the
+repair packets for the block:
+
+  constants::erasure_code, transfer, block (2 bytes), index, k, tail, repair packets per block << 1 | final,
+  then ERASURE_SYMBOL bytes
+
+index is the symbol, 0 to k - 1, or ERASURE_K + n for repair packet n.  k (how many symbols are in the block), tail (how
+many bytes of the last one are used) and final (the transfer ends with this block) are only known when the block ends,
+so they're 0 in the symbols before that.
+
+The code is Reed-Solomon over packets: repair packet n is the sum over the symbols i of symbol i times 1 / (x_n + y_i)
+in GF(256), a Cauchy matrix, so any k of the packets in a block are enough to get all of it back.  The repair packets
+are added up as the symbols go by, so the encoder only needs the symbol being filled and the repair sums, about 1.8 KB.
+
+The receiving end keeps one block, ERASURE_K symbols (3 KB), and writes it to Serial1 as data frames of a symbol each
+once it has k packets, or the next block starts, or nothing has come for constants::erasure_timeout.  If it didn't
+get enough it writes the symbols it has.  The margin is how many packets it got over what it needed, per block, counted
+up to the block's last repair packet.  The lowest and the total for a transfer go in the log at the end of it, and in
+print stats (negative means blocks were lost).
+*/
+
+#ifndef ERASURE_H
+#define ERASURE_H
+
+#include "Arduino.h"
+#include "constants.h"
+
+#define ERASURE_SYMBOL 195  // ssdv_test.py's packet size.  203 bytes with the header and command byte, less than a full tncattach frame
+#define ERASURE_K 16  // symbols in a block, 3 KB to hold one on the receiving end
+#define ERASURE_R_MAX 8  // most repair packets per block, half the block
+#define ERASURE_HEADER 8
+#define ERASURE_PACKET (ERASURE_HEADER + ERASURE_SYMBOL)
+
+class ErasureEncoder {
+public:
+  void start(int repair);  //a new transfer with this many repair packets per block
+  void stop();  //the last block goes out with whatever there is
+  bool active() { return _active; }
+  int write(const byte *data, int length);  //returns how much it took.  It stops at the end of each symbol until next() has had everything
+  int next(byte *packet);  //the next packet to send, ERASURE_PACKET bytes with the command byte, 0 if none
+
+  unsigned long blocks{0};  //sent in this transfer
+  unsigned long repairs{0};
+
+private:
+  void endBlock(bool final);
+  void header(byte *packet, int index);
+
+  bool _active{false};
+  uint8_t _transfer{0};
+  uint16_t _block{0};
+  int _repair{0};  //per block, this transfer
+  int _index{0};  //the symbol being filled
+  int _fill{0};
+  bool _full{false};  //_symbol is waiting to go, once more data shows up or it's stopped
+  bool _source_ready{false};
+  int _repair_next{ERASURE_R_MAX};  //the next repair packet to go, _repair when there are none
+  uint8_t _k{0};  //the block's size and tail, once it's ended
+  uint8_t _tail{0};
+  bool _final{false};
+  byte _symbol[ERASURE_SYMBOL];
+  byte _sums[ERASURE_R_MAX][ERASURE_SYMBOL];
+};
+
+struct ErasureReport
+{
+  uint8_t transfer;
+  unsigned long blocks;
+  unsigned long recovered;  //blocks with lost symbols that got filled in
+  unsigned long lost;  //blocks that didn't get enough
+  int margin_min;  //packets over what was needed, for the worst block
+  long margin_total;  //for the average
+};
+
+class ErasureDecoder {
+public:
+  void received(const byte *packet, int length, unsigned long now_ms);
+  int next(byte *frame);  //data frames (command byte 0x00) for Serial1, in order.  Returns the length, 0 when there are no more
+  void service(unsigned long now_ms);  //ends a block nothing has come for in erasure_timeout
+  bool finished(ErasureReport &ended);  //a transfer just ended (or went quiet), true once
+
+  ErasureReport report{};  //the transfer so far
+
+private:
+  void accept(const byte *packet, unsigned long now_ms);
+  void endBlock();
+  void endCount();
+  bool decode();
+  void endTransfer();
+  int useful();
+  void park(const byte *packet);
+
+  bool _open{false};  //a block is coming in
+  bool _draining{false};  //it's ended and next() is writing it out
+  bool _started{false};
+  bool _done{false};  //the final block's been written, anything else for this transfer is late
+  bool _counting{false};  //the block's been written, but there are still packets on the way for it
+  bool _reported{false};
+  bool _finished{false};
+  ErasureReport _ended{};
+  uint16_t _block{0};
+  uint16_t _block_next{0};  //blocks before this one are over
+  uint8_t _k{0};  //0 until a packet says
+  uint8_t _tail{ERASURE_SYMBOL};
+  bool _final{false};
+  uint32_t _seen{0};  //bit per packet index, for the margin
+  int _last_index{ERASURE_K - 1};  //the block's last packet, once it's here the margin is known
+  int _out{0};  //the next symbol for next()
+  unsigned long _last_rx{0};
+  uint8_t _holder[ERASURE_K];  //which packet is in each slot.  Symbol i goes in slot i, repair packets in any slot that's free
+  byte _slots[ERASURE_K][ERASURE_SYMBOL];
+  bool _parked{false};  //the first packet of the next block, while this one is written out
+  byte _park[ERASURE_PACKET];
+};
+
+#endif
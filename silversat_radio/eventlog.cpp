@@ -0,0 +1,56 @@
+/**
+* @file eventlog.cpp
+* @author Tom Conrad (tom@silversat.org)
+* @brief Deferred binary log for the transmit and receive paths
+* @version 1.0.1
+* @date 2026-10-19
+
+eventlog.cpp - Deferred binary log for the transmit and receive paths
+Created by Tom Conrad, October 19, 2026.
+Released into the public domain.
+
+*/
+
+#include "eventlog.h"
+
+EventLog event_log;
+
+void EventLog::store(event_id id, uint8_t count, int32_t a, int32_t b)
+{
+  if (_count == EVENT_LOG_SIZE)
+  {
+    _dropped++;
+    _lost++;
+    return;
+  }
+  Record &record = _ring[(_head + _count) % EVENT_LOG_SIZE];
+  record.time = micros();
+  record.id = id;
+  record.count = count;
+  record.args[0] = a;
+  record.args[1] = b;
+  _count++;
+}
+
+bool EventLog::next(char *line)
+{
+  // the drop count goes out first, it's about records that would have come after these but it's easy to read that way
+  if (_dropped)
+  {
+    snprintf(line, EVENT_LOG_LINE, "~%X %lX %X\r\n", (unsigned int)EV_DROPPED, (unsigned long)micros(), (unsigned int)_dropped);
+    _dropped = 0;
+    return true;
+  }
+  if (_count == 0) return false;
+
+  Record &record = _ring[_head];
+  int length = snprintf(line, EVENT_LOG_LINE, "~%X %lX", (unsigned int)record.id, (unsigned long)record.time);
+  for (int i = 0; i < record.count; i++)
+  {
+    length += snprintf(line + length, EVENT_LOG_LINE - length, " %lX", (unsigned long)(uint32_t)record.args[i]);
+  }
+  snprintf(line + length, EVENT_LOG_LINE - length, "\r\n");
+  _head = (_head + 1) % EVENT_LOG_SIZE;
+  _count--;
+  return true;
+}
@@ -0,0 +1,82 @@
+/**
+* @file eventlog.h
+* @author Tom Conrad (tom@silversat.org)
+* @brief Deferred binary log for the transmit and receive paths
+* @version 1.0.1
+* @date 2026-10-19
+
+eventlog.h - Deferred binary log for the transmit and receive paths
+Created by Tom Conrad, October 19, 2026.
+Released into the public domain.
+
+A Log.notice in the middle of a turnaround formats the whole line and pushes it out the debug port right there, and
+at 57600 that's milliseconds.  event_log.add() just stores the message number, micros() and up to two numbers in a
+RAM ring (a few microseconds).  The loop drains the ring to Serial when it has nothing better to do, one line per
+record, and only as much as fits in the serial buffer without waiting.  A drained record looks like
+
+  ~<id> <micros> <arg> <arg>      (all hex)
+
+and RadioTestInterface/eventlog.py turns it back into text using the table below, so the table is the only copy of
+the format strings.  Add new messages at the end so old captures still decode.  Formats take %d %i %u %x %X only.
+
+When the ring is full new records are dropped and counted, and an EV_DROPPED record goes out with the count.
+Only call add() from the loop, not from interrupts.
+*/
+
+#ifndef EVENTLOG_H
+#define EVENTLOG_H
+
+#include "Arduino.h"
+
+#define EVENT_LOG_SIZE 32        // records, 16 bytes each
+#define EVENT_LOG_LINE 36        // buffer for one drained line, it's at most 32 with the \r\n
+
+#define EVENT_LOG_MESSAGES(X) \
+  X(EV_DROPPED,        "eventlog: %u records dropped") \
+  X(EV_TRANSMIT,       "transmitting packet") \
+  X(EV_BURST,          "streaming packet into burst") \
+  X(EV_FULL_TX,        "State changed to FULL_TX, delay %u") \
+  X(EV_FULL_RX,        "State changed to FULL_RX, frames in session: %i") \
+  X(EV_RECEIVED,       "got a packet! length %i") \
+  X(EV_RSSI,           "rssi %d dBm") \
+  X(EV_RF_OFFSET,      "rf offset %d Hz") \
+  X(EV_DATA_DECODE,    "DATA size as received: %X, decode success = %i") \
+  X(EV_CRC_OK,         "Success! CRC matches") \
+  X(EV_CRC_BAD,        "BAD CRC!") \
+  X(EV_PACKET_LENGTH,  "final packet length: %i")
+
+#define EVENT_LOG_ENUM(id, format) id,
+enum event_id : uint8_t { EVENT_LOG_MESSAGES(EVENT_LOG_ENUM) EV_COUNT };
+#undef EVENT_LOG_ENUM
+
+class EventLog {
+public:
+  void add(event_id id) { store(id, 0, 0, 0); }
+  void add(event_id id, int32_t a) { store(id, 1, a, 0); }
+  void add(event_id id, int32_t a, int32_t b) { store(id, 2, a, b); }
+
+  bool next(char *line);  //takes the oldest record out as a line (EVENT_LOG_LINE long), false if there's nothing
+  int pending() { return _count + (_dropped ? 1 : 0); }
+  uint16_t lost() { return _lost; }  //dropped since boot
+
+private:
+  void store(event_id id, uint8_t count, int32_t a, int32_t b);
+
+  struct Record
+  {
+    uint32_t time;
+    int32_t args[2];
+    uint8_t id;
+    uint8_t count;
+  };
+
+  Record _ring[EVENT_LOG_SIZE];
+  uint8_t _head{0};    //oldest
+  uint8_t _count{0};
+  uint16_t _dropped{0};  //not reported yet
+  uint16_t _lost{0};
+};
+
+extern EventLog event_log;
+
+#endif
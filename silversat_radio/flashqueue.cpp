@@ -0,0 +1,346 @@
+/**
+* @file flashqueue.cpp
+* @author Tom Conrad (tom@silversat.org)
+* @brief Store and forward queue in the SAMD21's flash, for Serial1 data between passes
+* @version 1.0.1
+* @date 2026-10-19
+
+flashqueue.cpp - Store and forward queue in the SAMD21's flash, for Serial1 data between passes
+Created by Tom Conrad, October 19, 2026.
+Released into the public domain.
+
+*/
+
+#include "flashqueue.h"
+
+#define FLASHQUEUE_MAGIC 0x53465131  // "1QFS" in memory
+#define FLASHQUEUE_MARKER 0x5A
+#define FLASHQUEUE_HEADER 8  // block and record headers are both 2 words
+#define FLASHQUEUE_ERASED 0xFFFFFFFF
+
+static int padded(int length)
+{
+  return (length + 3) & ~3;
+}
+
+static byte checksum(const byte *frame, int length)
+{
+  byte sum = length;
+  for (int i = 0; i < length; i++) sum += frame[i];
+  return sum;
+}
+
+uint32_t FlashQueue::word(int block, int offset)
+{
+  return *(const volatile uint32_t *)(_region + block * FLASHQUEUE_BLOCK + offset);
+}
+
+// -1 is where nothing's been written yet, -2 is something that isn't a whole frame.  Either way it's the end of the block
+int FlashQueue::recordLength(int block, int offset)
+{
+  if (offset + FLASHQUEUE_HEADER > FLASHQUEUE_BLOCK) return -1;
+  uint32_t header = word(block, offset);
+  if (header == FLASHQUEUE_ERASED) return -1;
+  int length = header & 0xFFFF;
+  if (((header >> 24) != FLASHQUEUE_MARKER) || (length == 0) || (length > FLASHQUEUE_FRAME_MAX) ||
+      (offset + FLASHQUEUE_HEADER + padded(length) > FLASHQUEUE_BLOCK)) return -2;
+  byte sum = length;
+  const volatile byte *frame = _region + block * FLASHQUEUE_BLOCK + offset + FLASHQUEUE_HEADER;
+  for (int i = 0; i < length; i++) sum += frame[i];
+  return (sum == ((header >> 16) & 0xFF)) ? length : -2;
+}
+
+void FlashQueue::begin()
+{
+  // the newest block is the tail
+  _tail_block = -1;
+  for (int block = 0; block < FLASHQUEUE_BLOCKS; block++)
+  {
+    if (word(block, 0) != FLASHQUEUE_MAGIC) continue;
+    uint32_t sequence = word(block, 4);
+    if ((_tail_block < 0) || ((int32_t)(sequence - _sequence) > 0))
+    {
+      _tail_block = block;
+      _sequence = sequence;
+    }
+  }
+  _frames = 0;
+  _bytes = 0;
+  _acks = 0;
+  _tail_closed = true;
+  _staged = 0;
+  _staged_frames = 0;
+  _written = 0;
+  _erase_block = -1;
+
+  // the blocks were opened round in order, so from the one after the tail is oldest first
+  bool found = false;
+  for (int i = 1; (_tail_block >= 0) && (i <= FLASHQUEUE_BLOCKS); i++)
+  {
+    int block = (_tail_block + i) % FLASHQUEUE_BLOCKS;
+    if (word(block, 0) != FLASHQUEUE_MAGIC) continue;
+    int offset = FLASHQUEUE_HEADER;
+    int length;
+    while ((length = recordLength(block, offset)) > 0)
+    {
+      if (word(block, offset + 4) == FLASHQUEUE_ERASED)
+      {
+        if (!found)
+        {
+          _head_block = block;
+          _head = offset;
+          found = true;
+        }
+        _frames++;
+        _bytes += length;
+      }
+      offset += FLASHQUEUE_HEADER + padded(length);
+    }
+    if (block == _tail_block)
+    {
+      _tail = offset;
+      _tail_closed = (length == -2);
+    }
+  }
+  if (!found)
+  {
+    _head_block = max(_tail_block, 0);
+    _head = _tail;
+  }
+
+  // which of the free ones are ready to open
+  for (int block = 0; block < FLASHQUEUE_BLOCKS; block++)
+  {
+    bool blank = isFree(block);
+    for (int offset = 0; blank && (offset < FLASHQUEUE_BLOCK); offset += 4) blank = (word(block, offset) == FLASHQUEUE_ERASED);
+    setErased(block, blank);
+  }
+}
+
+// the blocks after the tail, up to the oldest one with something still to go or a mark still to write
+bool FlashQueue::isFree(int block)
+{
+  if (_tail_block < 0) return true;
+  if (block == _tail_block) return false;
+  if ((_frames == 0) && (_acks == 0)) return true;
+  int oldest = (_acks > 0) ? _ack_block : _head_block;
+  if (oldest == _tail_block) return true;
+  return (block - _tail_block + FLASHQUEUE_BLOCKS) % FLASHQUEUE_BLOCKS < (oldest - _tail_block + FLASHQUEUE_BLOCKS) % FLASHQUEUE_BLOCKS;
+}
+
+void FlashQueue::setErased(int block, bool erased)
+{
+  if (erased) _erased[block / 32] |= 1UL << (block % 32);
+  else _erased[block / 32] &= ~(1UL << (block % 32));
+}
+
+// one row of the first free block round from the tail that isn't erased yet
+bool FlashQueue::eraseRow(bool quiet)
+{
+  if (!quiet) return false;
+  if ((_erase_block < 0) || !isFree(_erase_block))
+  {
+    _erase_block = -1;
+    for (int i = 1; (i <= FLASHQUEUE_BLOCKS) && (_erase_block < 0); i++)
+    {
+      int block = (max(_tail_block, 0) + i) % FLASHQUEUE_BLOCKS;
+      if (isFree(block) && !isErased(block)) _erase_block = block;
+    }
+    if (_erase_block < 0) return false;
+    _erase_row = 0;
+  }
+  _flash.erase(_region + _erase_block * FLASHQUEUE_BLOCK + _erase_row * FLASHQUEUE_ROW, FLASHQUEUE_ROW);
+  if (++_erase_row * FLASHQUEUE_ROW == FLASHQUEUE_BLOCK)
+  {
+    setErased(_erase_block, true);
+    erases++;
+    _erase_block = -1;
+  }
+  return true;
+}
+
+bool FlashQueue::prepare()
+{
+  return eraseRow(true);
+}
+
+// the next block round, once it's been erased.  Writing its header is this call's page
+bool FlashQueue::openBlock()
+{
+  int block = (_tail_block + 1) % FLASHQUEUE_BLOCKS;
+  if (!isFree(block) || !isErased(block)) return false;
+  uint32_t header[2]{FLASHQUEUE_MAGIC, _sequence + 1};
+  _flash.write(_region + block * FLASHQUEUE_BLOCK, header, sizeof(header));
+  setErased(block, false);
+  _sequence++;
+  _tail_block = block;
+  _tail = FLASHQUEUE_HEADER;
+  _tail_closed = (word(block, 0) != FLASHQUEUE_MAGIC);  //it didn't take, the frame tries the one after
+  if (_frames == 0)
+  {
+    _head_block = _tail_block;
+    _head = _tail;
+  }
+  return true;
+}
+
+bool FlashQueue::append(const byte *frame, int length)
+{
+  if ((length <= 0) || (length > FLASHQUEUE_FRAME_MAX) || (_staged + 2 + length > FLASHQUEUE_STAGE)) return false;
+  _stage[_staged] = length;
+  _stage[_staged + 1] = length >> 8;
+  memcpy(_stage + _staged + 2, frame, length);
+  _staged += 2 + length;
+  _staged_frames++;
+  return true;
+}
+
+// the next piece of the first staged frame's record, up to the end of the page it's in (the library's writes don't
+// cross pages).  true once the whole record's in
+bool FlashQueue::writePage()
+{
+  int length = _stage[0] | (_stage[1] << 8);
+  const byte *frame = _stage + 2;
+  int size = FLASHQUEUE_HEADER + padded(length);
+  uint32_t header[2]{((uint32_t)FLASHQUEUE_MARKER << 24) | ((uint32_t)checksum(frame, length) << 16) | length, FLASHQUEUE_ERASED};
+  int offset = _tail + _written;
+  int count = min(size - _written, FLASHQUEUE_PAGE - (offset % FLASHQUEUE_PAGE));
+  byte page[FLASHQUEUE_PAGE];
+  for (int i = 0; i < count; i++)
+  {
+    int at = _written + i - FLASHQUEUE_HEADER;
+    if (at < 0) page[i] = ((byte *)header)[_written + i];
+    else page[i] = (at < length) ? frame[at] : 0xFF;
+  }
+  _flash.write(_region + _tail_block * FLASHQUEUE_BLOCK + offset, page, count);
+  _written += count;
+  return _written == size;
+}
+
+bool FlashQueue::service(bool quiet)
+{
+  unsigned long start = micros();
+  if (!step(quiet)) return false;
+  unsigned long stall = micros() - start;
+  if (stall > max_stall) max_stall = stall;
+  return true;
+}
+
+// at most one page or one row
+bool FlashQueue::step(bool quiet)
+{
+  // the sent marks first, so a reset doesn't send them again
+  if (_acks > 0)
+  {
+    uint32_t sent{0};
+    _flash.write(_region + _ack_block * FLASHQUEUE_BLOCK + _ack + 4, &sent, sizeof(sent));
+    if (--_acks > 0)
+    {
+      int hops = 0;
+      do nextRecord(_ack_block, _ack);
+      while ((word(_ack_block, _ack + 4) != FLASHQUEUE_ERASED) && (++hops < FLASHQUEUE_SIZE / FLASHQUEUE_HEADER));
+    }
+    return true;
+  }
+
+  if (_staged_frames > 0)
+  {
+    int length = _stage[0] | (_stage[1] << 8);
+    if ((_written == 0) && (_tail_closed || (_tail + FLASHQUEUE_HEADER + padded(length) > FLASHQUEUE_BLOCK)))
+    {
+      if (openBlock()) return true;
+      return eraseRow(quiet);  //full, or the next block's not ready
+    }
+    if (!writePage()) return true;
+    _written = 0;
+    if (recordLength(_tail_block, _tail) != length)
+    {
+      _tail_closed = true;  //a worn out word or something, the block's done with and the frame goes in the next one
+      return true;
+    }
+    if (_frames == 0)
+    {
+      _head_block = _tail_block;
+      _head = _tail;
+    }
+    _tail += FLASHQUEUE_HEADER + padded(length);
+    _frames++;
+    _bytes += length;
+    _staged -= 2 + length;
+    _staged_frames--;
+    memmove(_stage, _stage + 2 + length, _staged);
+    return true;
+  }
+
+  return eraseRow(quiet);
+}
+
+int FlashQueue::peekLength()
+{
+  if (_frames == 0) return 0;
+  int length = recordLength(_head_block, _head);
+  return (length > 0) ? length : 0;
+}
+
+int FlashQueue::peek(byte *frame)
+{
+  int length = peekLength();
+  _flash.read(_region + _head_block * FLASHQUEUE_BLOCK + _head + FLASHQUEUE_HEADER, frame, length);
+  return length;
+}
+
+void FlashQueue::acknowledge()
+{
+  int length = peekLength();
+  if (length == 0) return;
+  if (_acks++ == 0)
+  {
+    _ack_block = _head_block;
+    _ack = _head;
+  }
+  _frames--;
+  _bytes -= length;
+  advanceHead();
+}
+
+// past the record there, and on to the next block if that was the last one in it
+void FlashQueue::nextRecord(int &block, int &offset)
+{
+  int length = recordLength(block, offset);
+  if (length > 0)
+  {
+    offset += FLASHQUEUE_HEADER + padded(length);
+    if (recordLength(block, offset) > 0) return;
+  }
+  for (int i = 1; i <= FLASHQUEUE_BLOCKS; i++)
+  {
+    block = (block + 1) % FLASHQUEUE_BLOCKS;
+    offset = FLASHQUEUE_HEADER;
+    if ((word(block, 0) == FLASHQUEUE_MAGIC) && (recordLength(block, offset) > 0)) return;
+  }
+}
+
+// on to the next frame that hasn't gone
+void FlashQueue::advanceHead()
+{
+  if (_frames == 0)
+  {
+    _head_block = _tail_block;
+    _head = _tail;
+    return;
+  }
+  // a mark that's waiting counts as sent.  Going all the way round means the count's wrong, which a reset would fix, and so does this
+  int hops = 0;
+  do
+  {
+    nextRecord(_head_block, _head);
+    if (++hops > FLASHQUEUE_SIZE / FLASHQUEUE_HEADER)
+    {
+      _frames = 0;
+      _bytes = 0;
+      _head_block = _tail_block;
+      _head = _tail;
+      return;
+    }
+  } while (word(_head_block, _head + 4) != FLASHQUEUE_ERASED);
+}
@@ -0,0 +1,118 @@
+/**
+* @file flashqueue.h
+* @author Tom Conrad (tom@silversat.org)
+* @brief Store and forward queue in the SAMD21's flash, for Serial1 data between passes
+* @version 1.0.1
+* @date 2026-10-19
+
+flashqueue.h - Store and forward queue in the SAMD21's flash, for Serial1 data between passes
+Created by Tom Conrad, October 19, 2026.
+Released into the public domain.
+
+Between passes there's nobody to send to, and the payload's data could only sit in the 8 KB databuffer (or go out to
+nobody).  Now data frames from Serial1 go in here while the other end hasn't been heard from for
+constants::store_link_timeout, and behind anything already in here so they stay in order.  Once it's heard from again
+(any frame at all, a relay command is enough) this is the lowest priority transmit queue (TXQ_STORE in txqueue.h) and
+it goes out as fast as the sessions allow.  A frame stays in flash until it's been handed to the radio, so a reset
+in the middle of a pass only loses the one on the air (and resends the last few, if their sent marks were still
+waiting to be written).
+
+It's a log in FLASHQUEUE_SIZE bytes of the program flash, the same FlashStorage library the clear threshold and the
+VCO cache use.  The flash erases in 256 byte rows and writes 4 byte words that can only go from 1s to 0s, so:
+
+  FLASHQUEUE_BLOCK byte blocks (4 rows), used round in order.  Each one starts with a magic word and a sequence number
+  that goes up by one for every block opened, so the order's known after a reset.
+
+  frames are appended one after the other in the newest block: a header word (marker, checksum, length), a status word
+  that's all 1s until the frame's sent and then gets written to 0, and the frame padded out to a word.
+
+  a block gets erased only when the log has come round to it and everything in it has gone, so every block gets the
+  same wear, once per FLASHQUEUE_SIZE bytes stored.  At the rated 25k cycles that's 1.6 GB.
+
+The processor stops while the flash is busy, interrupts and all, since it runs out of the same flash.  The datasheet's
+worst cases are 2.5 ms to write a page and 6 ms to erase a row.  The SERCOM only holds 3 characters (two in its
+buffer and one coming in), 3.1 ms at 9600, so nothing can be written or erased in line with Serial1:
+
+  append() only copies the frame into FLASHQUEUE_STAGE bytes of RAM.
+
+  service() runs once a loop, right after Serial1's been emptied, and does at most one thing.  It writes one 64 byte
+  page (a piece of a frame, a block header or a sent mark), which is inside the 3.1 ms.  Or it erases one row, but
+  only once Serial1 has been quiet for constants::store_idle, so a sender's between bursts.  The free blocks get erased
+  ahead like that, and a block is only opened once it's been erased, so the log never waits on an erase.
+
+  setup() erases whatever the last run left, before Serial1 is started.
+
+max_stall is the longest service() has held the processor up, measured with micros() on the board (print stats).
+
+A frame that was being written when the power went has a bad checksum, and that block takes nothing more.
+Reprogramming the board clears it (the region is zeros after programming, and gets erased as it's used).
+*/
+
+#ifndef FLASHQUEUE_H
+#define FLASHQUEUE_H
+
+#include "Arduino.h"
+#include <FlashStorage.h>
+
+#define FLASHQUEUE_SIZE 65536  // of the 256 KB, the sketch has the rest.  About a minute of airtime at 9600
+#define FLASHQUEUE_BLOCK 1024  // erased together, the biggest frame has to fit in one with its headers
+#define FLASHQUEUE_BLOCKS (FLASHQUEUE_SIZE / FLASHQUEUE_BLOCK)
+#define FLASHQUEUE_ROW 256  // what the flash erases
+#define FLASHQUEUE_PAGE 64  // and what it writes
+#define FLASHQUEUE_FRAME_MAX 512  // KISS encoded, the same as kisspacket
+#define FLASHQUEUE_STAGE 768  // RAM for frames on their way into flash, the biggest one and then some
+
+class FlashQueue {
+public:
+  FlashQueue(const volatile byte *region) : _region(region) {}  //FLASHQUEUE_SIZE bytes, 256 byte aligned
+
+  void begin();  //finds what's still to go after a reset
+  bool prepare();  //erases a row of what the last run left, false once it's all done.  For setup(), before Serial1 starts
+  bool append(const byte *frame, int length);  //into RAM.  false if there's no room there or the frame's too long
+  bool service(bool quiet);  //one page written, or if quiet, one row erased.  false if there was nothing to do
+  int peek(byte *frame);  //the oldest frame in flash that hasn't gone yet, returns its length, 0 if there isn't one
+  int peekLength();
+  void acknowledge();  //the peeked frame's been sent, it's done with.  The mark goes in flash from service()
+  bool empty() { return (_frames == 0) && (_staged == 0); }
+  int frames() { return _frames + _staged_frames; }
+  long bytes() { return _bytes + _staged - 2 * _staged_frames; }
+
+  unsigned long erases{0};  //blocks erased since the reset, for the wear
+  unsigned long max_stall{0};  //us, the longest one service() call held the processor up
+
+private:
+  bool step(bool quiet);
+  int recordLength(int block, int offset);  //frame length of a good record there, -1 for the end of the block
+  uint32_t word(int block, int offset);
+  void nextRecord(int &block, int &offset);
+  void advanceHead();
+  bool isFree(int block);
+  bool isErased(int block) { return _erased[block / 32] & (1UL << (block % 32)); }
+  void setErased(int block, bool erased);
+  bool eraseRow(bool quiet);
+  bool openBlock();
+  bool writePage();
+
+  const volatile byte *_region;
+  FlashClass _flash;
+  int _head_block{0};  //the oldest frame that's still to go
+  int _head{0};
+  int _ack_block{0};  //the oldest one that's gone, with its mark still to write
+  int _ack{0};
+  int _acks{0};  //marks still to write
+  int _tail_block{-1};  //where the next one goes, -1 before anything's been written
+  int _tail{0};
+  bool _tail_closed{true};  //the tail block takes nothing more
+  uint32_t _sequence{0};  //of the tail block
+  int _frames{0};
+  long _bytes{0};
+  uint32_t _erased[(FLASHQUEUE_BLOCKS + 31) / 32]{};  //free blocks that are all 1s, ready to open
+  int _erase_block{-1};  //part way through erasing this one
+  int _erase_row{0};
+  byte _stage[FLASHQUEUE_STAGE];  //each frame is 2 bytes of length, then the frame
+  int _staged{0};  //bytes used in _stage
+  int _staged_frames{0};
+  int _written{0};  //bytes of the first staged frame's record that are in flash
+};
+
+#endif
@@ -0,0 +1,335 @@
+/**
+* @file headercomp.cpp
+* @author Tom Conrad (tom@silversat.org)
+* @brief TCP/IP header compression for the data frames from tncattach
+* @version 1.0.1
+* @date 2026-10-19
+
+headercomp.cpp - TCP/IP header compression for the data frames from tncattach
+Created by Tom Conrad, October 19, 2026.
+Released into the public domain.
+
+*/
+
+#include "headercomp.h"
+
+// the bits in changes
+#define HC_WINDOW 0x01
+#define HC_ACK 0x02
+#define HC_SEQ 0x04
+#define HC_IPID 0x08
+#define HC_TIMESTAMP 0x10  //both TSval and TSecr follow
+#define HC_PUSH 0x20  //the PSH flag itself, not a field
+
+// where things are in the IP header, and the TCP header that follows it
+#define IP_TOS 1
+#define IP_LENGTH 2
+#define IP_ID 4
+#define IP_FRAGMENT 6
+#define IP_TTL 8
+#define IP_PROTOCOL 9
+#define IP_CHECKSUM 10
+#define IP_SOURCE 12
+#define TCP_SEQ 4
+#define TCP_ACK 8
+#define TCP_OFFSET 12
+#define TCP_FLAGS 13
+#define TCP_WINDOW 14
+#define TCP_CHECKSUM 16
+#define TCP_URGENT 18
+#define TCP_OPTIONS 20
+
+#define TCP_PSH 0x08
+#define TCP_ACK_FLAG 0x10
+#define TCP_NOT_COMPRESSED 0x27  //URG, RST, SYN, FIN
+
+static uint16_t get16(const byte *p) { return (p[0] << 8) | p[1]; }
+static uint32_t get32(const byte *p) { return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | (p[2] << 8) | p[3]; }
+static void put16(byte *p, uint16_t value) { p[0] = value >> 8; p[1] = value; }
+static void put32(byte *p, uint32_t value) { put16(p, value >> 16); put16(p + 2, value); }
+
+static int put_delta(byte *out, uint32_t delta)
+{
+  if ((delta > 0) && (delta < 256))
+  {
+    out[0] = delta;
+    return 1;
+  }
+  out[0] = 0;
+  put16(out + 1, delta);
+  return 3;
+}
+
+// 0 if it runs off the end
+static int get_delta(const byte *in, int left, uint32_t &delta)
+{
+  if (left < 1) return 0;
+  if (in[0] != 0)
+  {
+    delta = in[0];
+    return 1;
+  }
+  if (left < 3) return 0;
+  delta = get16(in + 1);
+  return 3;
+}
+
+// the usual ones complement sum, not folded yet
+static uint32_t sum(const byte *data, int length, uint32_t total)
+{
+  for (int i = 0; i + 1 < length; i += 2) total += get16(data + i);
+  if (length & 1) total += data[length - 1] << 8;
+  return total;
+}
+
+static uint16_t fold(uint32_t total)
+{
+  while (total >> 16) total = (total & 0xFFFF) + (total >> 16);
+  return ~total;
+}
+
+// a data frame (command byte first) that's TCP over IPv4 we can do something with.  Fills in the header length (not
+// counting the command byte) and how much of that is tncattach's
+static bool parse(const byte *frame, int length, int &header_length, int &prefix)
+{
+  prefix = 0;
+  if ((length >= 5) && (frame[1] == 0) && (frame[2] == 0) && (frame[3] == 0x08) && (frame[4] == 0x00)) prefix = 4;  //tun flags, IPv4
+  const byte *ip = frame + 1 + prefix;
+  int ip_length = length - 1 - prefix;
+  if (ip_length < 40) return false;
+  if ((ip[0] != 0x45) || (ip[IP_PROTOCOL] != 6)) return false;  //no IP options, TCP
+  if ((ip[IP_FRAGMENT] & 0x3F) || ip[IP_FRAGMENT + 1]) return false;
+  if (get16(ip + IP_LENGTH) != ip_length) return false;
+  int tcp_length = (ip[20 + TCP_OFFSET] >> 4) * 4;
+  if ((tcp_length < 20) || (20 + tcp_length > ip_length)) return false;
+  header_length = prefix + 20 + tcp_length;
+  return true;
+}
+
+// same connection: tncattach's bytes, addresses and ports
+static bool same_flow(const HcFlow &flow, const byte *header, int prefix)
+{
+  return flow.valid && (flow.prefix == prefix) && !memcmp(flow.header, header, prefix) &&
+         !memcmp(flow.header + prefix + IP_SOURCE, header + prefix + IP_SOURCE, 8) &&
+         !memcmp(flow.header + prefix + 20, header + prefix + 20, 4);
+}
+
+// Linux puts NOP, NOP, timestamp first in the options of every segment
+static bool has_timestamp(const byte *tcp, int tcp_length)
+{
+  return (tcp_length >= TCP_OPTIONS + 12) && (tcp[TCP_OPTIONS] == 1) && (tcp[TCP_OPTIONS + 1] == 1) &&
+         (tcp[TCP_OPTIONS + 2] == 8) && (tcp[TCP_OPTIONS + 3] == 10);
+}
+
+// the changes from the last header in the flow, in the compressed frame's format.  Returns how many bytes, 0 if it
+// can't be done that way
+static int encode_changes(const HcFlow &flow, const byte *header, byte *out)
+{
+  const byte *ip = header + flow.prefix;
+  const byte *tcp = ip + 20;
+  const byte *last_ip = flow.header + flow.prefix;
+  const byte *last_tcp = last_ip + 20;
+  int tcp_length = flow.length - flow.prefix - 20;
+
+  // the things that aren't supposed to change
+  if ((ip[IP_TOS] != last_ip[IP_TOS]) || (ip[IP_TTL] != last_ip[IP_TTL]) || memcmp(ip + IP_FRAGMENT, last_ip + IP_FRAGMENT, 2)) return 0;
+  if ((tcp[TCP_FLAGS] & TCP_NOT_COMPRESSED) || !(tcp[TCP_FLAGS] & TCP_ACK_FLAG)) return 0;
+  if ((tcp[TCP_FLAGS] | TCP_PSH) != (last_tcp[TCP_FLAGS] | TCP_PSH)) return 0;
+  if (memcmp(tcp + TCP_URGENT, last_tcp + TCP_URGENT, 2)) return 0;
+  bool timestamp = has_timestamp(tcp, tcp_length) && has_timestamp(last_tcp, tcp_length);
+  int same_from = timestamp ? TCP_OPTIONS + 12 : TCP_OPTIONS;
+  if (memcmp(tcp + same_from, last_tcp + same_from, tcp_length - same_from)) return 0;
+
+  byte changes = 0;
+  int index = 1;
+  if (tcp[TCP_FLAGS] & TCP_PSH) changes |= HC_PUSH;
+  uint32_t window = (uint16_t)(get16(tcp + TCP_WINDOW) - get16(last_tcp + TCP_WINDOW));
+  if (window)
+  {
+    changes |= HC_WINDOW;
+    index += put_delta(out + index, window);
+  }
+  // the sequence numbers only go forwards, and not by much.  Backwards is a retransmission, which goes whole
+  uint32_t ack = get32(tcp + TCP_ACK) - get32(last_tcp + TCP_ACK);
+  if (ack > 0xFFFF) return 0;
+  if (ack)
+  {
+    changes |= HC_ACK;
+    index += put_delta(out + index, ack);
+  }
+  uint32_t seq = get32(tcp + TCP_SEQ) - get32(last_tcp + TCP_SEQ);
+  if (seq > 0xFFFF) return 0;
+  if (seq)
+  {
+    changes |= HC_SEQ;
+    index += put_delta(out + index, seq);
+  }
+  uint32_t ipid = (uint16_t)(get16(ip + IP_ID) - get16(last_ip + IP_ID));
+  if (ipid != 1)
+  {
+    changes |= HC_IPID;
+    index += put_delta(out + index, ipid);
+  }
+  if (timestamp)
+  {
+    uint32_t tsval = get32(tcp + TCP_OPTIONS + 4) - get32(last_tcp + TCP_OPTIONS + 4);
+    uint32_t tsecr = get32(tcp + TCP_OPTIONS + 8) - get32(last_tcp + TCP_OPTIONS + 8);
+    if ((tsval > 0xFFFF) || (tsecr > 0xFFFF)) return 0;
+    if (tsval || tsecr)
+    {
+      changes |= HC_TIMESTAMP;
+      index += put_delta(out + index, tsval);
+      index += put_delta(out + index, tsecr);
+    }
+  }
+  out[0] = changes;
+  return index;
+}
+
+int HeaderCompressor::compress(byte *frame, int length, int size)
+{
+  int header_length, prefix;
+  if ((frame[0] != 0x00) || !parse(frame, length, header_length, prefix)) return length;
+  const byte *header = frame + 1;
+  _frames++;
+
+  // which connection, or the one that's been quiet the longest
+  int slot = -1;
+  int oldest = 0;
+  for (int i = 0; (i < HC_FLOWS) && (slot < 0); i++)
+  {
+    if (same_flow(_tx[i], header, prefix)) slot = i;
+    else if (!_tx[i].valid || (_tx[oldest].valid && (_tx[i].used < _tx[oldest].used))) oldest = i;
+  }
+
+  byte changes[1 + 6 * 3];
+  int changes_length = 0;
+  if ((slot >= 0) && (_tx[slot].length == header_length) && (_tx[slot].since_refresh < constants::hc_refresh))
+    changes_length = encode_changes(_tx[slot], header, changes);
+  if (slot < 0) slot = oldest;
+  HcFlow &flow = _tx[slot];
+  byte checksum[2];
+  memcpy(checksum, header + prefix + 20 + TCP_CHECKSUM, 2);
+  int payload_length = length - 1 - header_length;
+
+  // the headers whole, this frame is what the other end works from now
+  if (changes_length == 0)
+  {
+    if (length + 1 > size) return length;
+    memmove(frame + 2, frame + 1, length - 1);
+    frame[0] = constants::hc_uncompressed_code;
+    frame[1] = slot;
+    memcpy(flow.header, frame + 2, header_length);
+    flow.valid = true;
+    flow.length = header_length;
+    flow.prefix = prefix;
+    flow.since_refresh = 0;
+    flow.used = _frames;
+    return length + 1;
+  }
+
+  memcpy(flow.header, header, header_length);
+  flow.since_refresh++;
+  flow.used = _frames;
+  frame[0] = constants::hc_compressed_code;
+  frame[1] = slot;
+  memcpy(frame + 2, changes, changes_length);
+  memcpy(frame + 2 + changes_length, checksum, 2);
+  memmove(frame + 4 + changes_length, frame + 1 + header_length, payload_length);
+  return 4 + changes_length + payload_length;
+}
+
+int HeaderCompressor::decompress(const byte *frame, int length, byte *out, int size)
+{
+  if ((length < 2) || (frame[1] >= HC_FLOWS)) return 0;
+  HcFlow &flow = _rx[frame[1]];
+
+  if (frame[0] == constants::hc_uncompressed_code)
+  {
+    // a data frame again, once the slot is out of the way
+    int header_length, prefix;
+    if (length - 1 > size) return 0;
+    out[0] = 0x00;
+    memcpy(out + 1, frame + 2, length - 2);
+    if (!parse(out, length - 1, header_length, prefix)) return 0;
+    memcpy(flow.header, out + 1, header_length);
+    flow.valid = true;
+    flow.toss = false;
+    flow.length = header_length;
+    flow.prefix = prefix;
+    return length - 1;
+  }
+
+  if ((length < 3) || !flow.valid || flow.toss) return 0;  //not even a change mask
+  byte header[HC_HEADER_MAX];
+  memcpy(header, flow.header, flow.length);
+  byte *ip = header + flow.prefix;
+  byte *tcp = ip + 20;
+  byte changes = frame[2];
+  int index = 3;
+  uint32_t delta;
+  int used;
+
+  if (changes & HC_WINDOW)
+  {
+    if (!(used = get_delta(frame + index, length - index, delta))) return 0;
+    put16(tcp + TCP_WINDOW, get16(tcp + TCP_WINDOW) + delta);
+    index += used;
+  }
+  if (changes & HC_ACK)
+  {
+    if (!(used = get_delta(frame + index, length - index, delta))) return 0;
+    put32(tcp + TCP_ACK, get32(tcp + TCP_ACK) + delta);
+    index += used;
+  }
+  if (changes & HC_SEQ)
+  {
+    if (!(used = get_delta(frame + index, length - index, delta))) return 0;
+    put32(tcp + TCP_SEQ, get32(tcp + TCP_SEQ) + delta);
+    index += used;
+  }
+  delta = 1;
+  if ((changes & HC_IPID) && !(used = get_delta(frame + index, length - index, delta))) return 0;
+  if (changes & HC_IPID) index += used;
+  put16(ip + IP_ID, get16(ip + IP_ID) + delta);
+  if (changes & HC_TIMESTAMP)
+  {
+    if (!(used = get_delta(frame + index, length - index, delta))) return 0;
+    put32(tcp + TCP_OPTIONS + 4, get32(tcp + TCP_OPTIONS + 4) + delta);
+    index += used;
+    if (!(used = get_delta(frame + index, length - index, delta))) return 0;
+    put32(tcp + TCP_OPTIONS + 8, get32(tcp + TCP_OPTIONS + 8) + delta);
+    index += used;
+  }
+  tcp[TCP_FLAGS] = (changes & HC_PUSH) ? (tcp[TCP_FLAGS] | TCP_PSH) : (tcp[TCP_FLAGS] & ~TCP_PSH);
+  if (length - index < 2) return 0;
+  memcpy(tcp + TCP_CHECKSUM, frame + index, 2);
+  index += 2;
+
+  int payload_length = length - index;
+  int ip_length = flow.length - flow.prefix + payload_length;
+  if (1 + flow.length + payload_length > size) return 0;
+  put16(ip + IP_LENGTH, ip_length);
+  put16(ip + IP_CHECKSUM, 0);
+  put16(ip + IP_CHECKSUM, fold(sum(ip, 20, 0)));
+
+  out[0] = 0x00;
+  memcpy(out + 1, header, flow.length);
+  memcpy(out + 1 + flow.length, frame + index, payload_length);
+
+  // if anything got lost the TCP checksum won't add up (pseudo header: addresses, protocol, TCP length)
+  int tcp_length = ip_length - 20;
+  uint32_t total = sum(ip + IP_SOURCE, 8, 6 + tcp_length);
+  if (fold(sum(out + 1 + flow.prefix + 20, tcp_length, total)) != 0)
+  {
+    flow.toss = true;
+    return 0;
+  }
+  memcpy(flow.header, header, flow.length);
+  return 1 + flow.length + payload_length;
+}
+
+void HeaderCompressor::forget()
+{
+  for (int i = 0; i < HC_FLOWS; i++) _tx[i].valid = false;
+}
@@ -0,0 +1,85 @@
+/**
+* @file headercomp.h
+* @author Tom Conrad (tom@silversat.org)
+* @brief TCP/IP header compression for the data frames from tncattach
+* @version 1.0.1
+* @date 2026-10-19
+
+headercomp.h - TCP/IP header compression for the data frames from tncattach
+Created by Tom Conrad, October 19, 2026.
+Released into the public domain.
+
+Every TCP segment from tncattach carries its 4 bytes (the tun flags and ethertype), a 20 byte IPv4 header and a 20 byte
+TCP header, 32 with the timestamps Linux puts on everything.  That's more than a TCP ACK's worth of header on every
+frame, and almost all of it is the same as the last frame in the same connection.  This is Van Jacobson's scheme
+(RFC 1144) with the timestamps handled the ROHC way, as deltas, so it still works on a Linux connection:
+
+Both ends keep a table of HC_FLOWS connections, the headers of the last frame in each.  The first frame of a
+connection (and any frame that can't be described as a change from the last one) goes out with its headers whole:
+
+  constants::hc_uncompressed_code, slot, then the frame as it came in (no command byte)
+
+and the other end copies its headers into that slot.  After that the frames in that connection go out as
+
+  constants::hc_compressed_code, slot, changes, TCP checksum (2 bytes), the changed fields, the TCP payload
+
+changes says which fields are there, each a difference from the last frame: 1 to 255 is one byte, anything else is a 0
+and two bytes.  The IP ID is assumed to go up by one.  The IP length and checksum are worked out again on the other
+side, and the TCP checksum goes across as it was.
+
+Frames that aren't plain TCP over IPv4 (no IP options, no fragments) go out as they are, and so do SYN, FIN, RST and
+URG segments.  A sequence number going backwards (a retransmission) always goes out whole, and so does every
+constants::hc_refresh'th frame in a connection.
+
+There's no way to tell the sender a frame was lost, so the receiving end checks the TCP checksum of everything it
+puts back together.  When one doesn't add up the connection stops until the next whole frame.  The lost frame gets
+retransmitted by TCP, and that comes across whole, so it sorts itself out (that's RFC 1144 too).
+
+The decompressor has to see the frames in the order they were compressed, so with ARQ on (arq.h) only frames that
+are going to be numbered get compressed.  One too long for ARQ_FRAME_MAX goes as it is.
+*/
+
+#ifndef HEADERCOMP_H
+#define HEADERCOMP_H
+
+#include "Arduino.h"
+#include "constants.h"
+
+#ifndef HC_FLOWS
+#define HC_FLOWS 4  // connections each way.  It's a handful of ssh and http sessions on a pass
+#endif
+#define HC_HEADER_MAX 84  // tncattach's 4 + IP 20 + TCP with the most options, 60
+
+struct HcFlow
+{
+  bool valid;
+  bool toss;  //receive side: lost track, compressed frames get dropped until a whole one comes in
+  uint8_t length;  //of header[]
+  uint8_t prefix;  //tncattach's bytes in front of the IP header, 0 or 4
+  uint8_t since_refresh;
+  unsigned long used;  //for replacing the least recently used one
+  byte header[HC_HEADER_MAX];  //the headers of the last frame, with no command byte
+};
+
+class HeaderCompressor {
+public:
+  // compresses a data frame (command byte and body) in place if it can.  size is how big the buffer is, since a frame
+  // with the headers whole is a byte longer.  Returns the new length, the same as length if nothing changed
+  int compress(byte *frame, int length, int size);
+
+  // puts a frame back together, out is a data frame (command byte 0x00).  Returns its length, 0 if it has to be
+  // dropped.  out needs length + HC_HEADER_MAX bytes
+  int decompress(const byte *frame, int length, byte *out, int size);
+
+  // a frame that was compressed isn't going to be sent after all, so the other end won't know what it's a change from
+  void forget();
+
+  bool compressed(byte command) { return (command == constants::hc_uncompressed_code) || (command == constants::hc_compressed_code); }
+
+private:
+  HcFlow _tx[HC_FLOWS]{};
+  HcFlow _rx[HC_FLOWS]{};
+  unsigned long _frames{0};  //the clock for least recently used
+};
+
+#endif
@@ -14,6 +14,8 @@ Released into the public domain.
 */
 
 #include "il2p_crc.h"
+#include "log_levels.h"
+#define LOG_MODULE_MAX LOG_MAX_IL2P
 
 IL2P_CRC::IL2P_CRC()
 {
@@ -64,8 +66,8 @@ uint16_t IL2P_CRC::calculate_AX25(uint8_t *buf, int buf_length)
   uint8_t newbuff[216]; //create new buffer and add the ax25 header
   for (int i=0; i<16; i++) newbuff[i] = ax25_header[i];
   for (int i=0; i<buf_length; i++) newbuff[i+16] = buf[i];
-  //for (int i = 0; i < buf_length+16; i++)  Log.notice("%X, ", newbuff[i]);
-  //Log.notice("\r\n");
+  //for (int i = 0; i < buf_length+16; i++)  LOG_NOTICE("%X, ", newbuff[i]);
+  //LOG_NOTICE("\r\n");
   uint16_t crc = CRC16.x25(newbuff, buf_length+16);
   return crc;
 }
@@ -85,10 +87,10 @@ bool IL2P_CRC::verify(uint8_t *buf, int buf_length, uint32_t received_crc)
   uint16_t new_crc = (corrected_fourth_byte&0x0F)<<12 | (corrected_third_byte&0x0F)<<8 | (corrected_second_byte&0x0F)<<4 | (corrected_first_byte)&0x0F;
 
   //Serial.print("new_crc: ");Serial.println(new_crc, BIN);
-  Log.verbose(F("Rcvd Tx CRC: %X\r\n"), new_crc);
+  LOG_VERBOSE(F("Rcvd Tx CRC: %X\r\n"), new_crc);
 
   m_crc = CRC16.x25(buf, buf_length);
-  //Log.notice(F("Rx CRC: %X\r\n"), m_crc);
+  //LOG_NOTICE(F("Rx CRC: %X\r\n"), m_crc);
 
   if (new_crc == m_crc) return true;
 
@@ -111,7 +113,7 @@ uint16_t IL2P_CRC::extract_crc(uint32_t received_crc)
   uint16_t new_crc = (corrected_fourth_byte&0x0F)<<12 | (corrected_third_byte&0x0F)<<8 | (corrected_second_byte&0x0F)<<4 | (corrected_first_byte)&0x0F;
 
   //Serial.print("new_crc: ");Serial.println(new_crc, BIN);
-  Log.verbose(F("Rcvd Tx CRC: %X\r\n"), new_crc);
+  LOG_VERBOSE(F("Rcvd Tx CRC: %X\r\n"), new_crc);
 
   return new_crc;
 }
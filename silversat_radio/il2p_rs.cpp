@@ -20,6 +20,8 @@
 #include <Arduino.h>
 #include <ArduinoLog.h>
 #include "il2p_rs.h"
+#include "log_levels.h"
+#define LOG_MODULE_MAX LOG_MAX_IL2P
 
 /* Reed-Solomon codec control block */
 struct RS {
@@ -106,7 +108,7 @@ RS* init_rs_char(unsigned int symsize, unsigned int gfpoly, unsigned int fcr, un
     rs = (RS *)calloc(1,sizeof(RS));
     if (rs == nullptr) 
     {
-        Log.fatal(F("FATAL ERROR: Out of memory.\r\n"));
+        LOG_FATAL(F("FATAL ERROR: Out of memory.\r\n"));
         delay(3000);  //trigger the watchdog
     }
     rs->mm = symsize;
@@ -115,14 +117,14 @@ RS* init_rs_char(unsigned int symsize, unsigned int gfpoly, unsigned int fcr, un
     rs->alpha_to = (DTYPE *)calloc((rs->nn+1),sizeof(DTYPE));
     if(rs->alpha_to == nullptr)
     {
-        Log.fatal(F("FATAL ERROR: Out of memory.\r\n"));
+        LOG_FATAL(F("FATAL ERROR: Out of memory.\r\n"));
         delay(3000);  //trigger the watchdog
     }
     
     rs->index_of = (DTYPE *)calloc((rs->nn+1),sizeof(DTYPE));
     if(rs->index_of == nullptr)
     {
-        Log.fatal(F("FATAL ERROR: Out of memory.\r\n"));
+        LOG_FATAL(F("FATAL ERROR: Out of memory.\r\n"));
         delay(3000);  //trigger the watchdog
     }
 
@@ -154,7 +156,7 @@ RS* init_rs_char(unsigned int symsize, unsigned int gfpoly, unsigned int fcr, un
     rs->genpoly = (DTYPE *)calloc((nroots+1),sizeof(DTYPE));
     if(rs->genpoly == nullptr)
     {
-        Log.fatal(F("FATAL ERROR: Out of memory.\r\n"));
+        LOG_FATAL(F("FATAL ERROR: Out of memory.\r\n"));
         delay(3000);  //trigger the watchdog
     }
     rs->fcr = fcr;
@@ -221,11 +223,11 @@ RS* il2p_find_rs(int nparity)
 	{
 	    if (tab[n].nroots == nparity) 
 		{
-	        Log.verbose(F("found tab: %i\r\n"), n);
+	        LOG_VERBOSE(F("found tab: %i\r\n"), n);
             return (tab[n].rs);
 	    }
 	}
-	Log.error("IL2P INTERNAL ERROR: il2p_find_rs: control block not found for nparity = %d.\r\n", nparity);
+	LOG_ERROR("IL2P INTERNAL ERROR: il2p_find_rs: control block not found for nparity = %d.\r\n", nparity);
 	return (tab[0].rs);
 }
 
@@ -289,7 +291,7 @@ int il2p_decode_rs (unsigned char *rec_block, int data_size, int num_parity, uns
 	memset (rs_block, 0, sizeof(rs_block) - n);
 	memcpy (rs_block + sizeof(rs_block) - n, rec_block, n);
 
-	Log.verbose("==============================  il2p_decode_rs  ==============================\r\n");
+	LOG_VERBOSE("==============================  il2p_decode_rs  ==============================\r\n");
 
 	int derrlocs[64];	// Half would probably be OK.
 
@@ -309,7 +311,7 @@ int il2p_decode_rs (unsigned char *rec_block, int data_size, int num_parity, uns
 	    }
 	}
 
-	Log.verbose("==============================  il2p_decode_rs  returns %d  ==============================\r\n", derrors);
+	LOG_VERBOSE("==============================  il2p_decode_rs  returns %d  ==============================\r\n", derrors);
 	
 	return (derrors);
 }
@@ -319,11 +321,11 @@ void encode_rs_char(RS *rs, DTYPE *data, DTYPE *bb)
 {
     int i, j;
     DTYPE feedback;
-    Log.verbose(F("starting encoder \r\n"));
+    LOG_VERBOSE(F("starting encoder \r\n"));
     memset(bb,0,NROOTS*sizeof(DTYPE)); // clear out the FEC data area
-    Log.verbose(F("bb = %X\r\n"), *bb);
-    Log.verbose(F("NROOTS = %X\r\n"), rs->nroots);
-    Log.verbose(F("NN = %X\r\n"), rs->nn);
+    LOG_VERBOSE(F("bb = %X\r\n"), *bb);
+    LOG_VERBOSE(F("NROOTS = %X\r\n"), rs->nroots);
+    LOG_VERBOSE(F("NN = %X\r\n"), rs->nn);
     for(i=0;i<NN-NROOTS;i++){
         feedback = INDEX_OF[data[i] ^ bb[0]];
         if(feedback != A0){      /* feedback term is non-zero */
@@ -337,7 +339,7 @@ void encode_rs_char(RS *rs, DTYPE *data, DTYPE *bb)
         else
         bb[NROOTS-1] = 0;
     }
-    Log.verbose(F("encoding complete \r\n"));
+    LOG_VERBOSE(F("encoding complete \r\n"));
 }
 
 //-----------------------------------------------------------------------
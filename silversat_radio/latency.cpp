@@ -0,0 +1,179 @@
+/**
+* @file latency.cpp
+* @author Tom Conrad (tom@silversat.org)
+* @brief Per-frame latency through each stage of the transmit and receive paths
+* @version 1.0.1
+* @date 2026-10-19
+
+latency.cpp - Per-frame latency through each stage of the transmit and receive paths
+Created by Tom Conrad, October 19, 2026.
+Released into the public domain.
+
+*/
+
+#include "latency.h"
+#include "constants.h"
+
+static const char *const latency_names[LAT_COUNT] = {
+  "tx serial", "tx queued", "tx wait", "tx load", "tx air", "tx total",
+  "rx air", "rx decode", "rx out", "rx total"};
+
+// 0 is "don't know", so a stage that actually lands on micros() == 0 gets moved by a microsecond
+static unsigned long stamp()
+{
+  unsigned long now = micros();
+  return now ? now : 1;
+}
+
+void LatencyTracer::add(latency_interval interval, unsigned long from, unsigned long to)
+{
+  if (from == 0 || to == 0) return;
+  uint32_t elapsed = to - from;
+  int bucket = 0;
+  while ((bucket < LATENCY_BUCKETS - 1) && (elapsed >> (bucket + 1))) bucket++;
+
+  LatencyHistogram &histogram = _histogram[interval];
+  if (histogram.count[bucket] < 0xFFFF) histogram.count[bucket]++;
+  histogram.samples++;
+  histogram.total += elapsed;
+  if (elapsed > histogram.max) histogram.max = elapsed;
+}
+
+// a frame starts at the first byte after a FEND and is complete at the next FEND.  buffered is where that FEND is
+// in the databuffer, which is what processbuff will say the frame length is once everything in front of it is gone.
+void LatencyTracer::serialByte(byte data, int buffered)
+{
+  if (data != constants::FEND)
+  {
+    if (!_open) _open_time = stamp();
+    _open = true;
+    return;
+  }
+  if (!_open) return;  //back to back FENDs
+  _open = false;
+  if (_queued_count[TXQ_BULK] == LATENCY_QUEUED_FRAMES) return;  //these just don't get traced
+  _queued[TXQ_BULK][_queued_count[TXQ_BULK]++] = {_open_time, stamp(), buffered};
+}
+
+void LatencyTracer::moved(int queue, int frame_end, int buffered)
+{
+  if ((_queued_count[TXQ_BULK] == 0) || (_queued[TXQ_BULK][_queued_count[TXQ_BULK] - 1].end != frame_end)) return;
+  Queued entry = _queued[TXQ_BULK][--_queued_count[TXQ_BULK]];
+  if (_queued_count[queue] == LATENCY_QUEUED_FRAMES) return;
+  entry.end = buffered;
+  _queued[queue][_queued_count[queue]++] = entry;
+}
+
+void LatencyTracer::shifted(int queue, int count, int remaining)
+{
+  int kept = 0;
+  for (int i = 0; i < _queued_count[queue]; i++)
+  {
+    Queued entry = _queued[queue][i];
+    entry.end -= count;
+    // gone off the front, or past the end, which means the queue got cleared (reset command)
+    if (entry.end <= 0 || entry.end > remaining) continue;
+    _queued[queue][kept++] = entry;
+  }
+  _queued_count[queue] = kept;
+}
+
+void LatencyTracer::frameTaken(int queue, int length, int remaining)
+{
+  _encoding = {};
+  // anything ending before this one was junk that ended on its opening FEND
+  for (int i = 0; (i < _queued_count[queue]) && (_queued[queue][i].end <= length); i++)
+  {
+    if (_queued[queue][i].end != length) continue;
+    _encoding.ingress = _queued[queue][i].ingress;
+    _encoding.complete = _queued[queue][i].complete;
+  }
+  shifted(queue, length, remaining);
+}
+
+void LatencyTracer::encoded()
+{
+  _encoding.encoded = stamp();
+  add(LAT_TX_SERIAL, _encoding.ingress, _encoding.complete);
+  add(LAT_TX_QUEUED, _encoding.complete, _encoding.encoded);
+}
+
+void LatencyTracer::started()
+{
+  _loading = _encoding;
+  _loading.started = stamp();
+  _is_loading = true;
+  _encoding = {};
+  add(LAT_TX_WAIT, _loading.encoded, _loading.started);
+}
+
+void LatencyTracer::committed()
+{
+  if (!_is_loading) return;
+  _is_loading = false;
+  _loading.committed = stamp();
+  add(LAT_TX_LOAD, _loading.started, _loading.committed);
+  if (_on_air_count < LATENCY_BURST_FRAMES) _on_air[_on_air_count++] = _loading;
+}
+
+void LatencyTracer::sessionDone()
+{
+  unsigned long done = stamp();
+  for (int i = 0; i < _on_air_count; i++)
+  {
+    add(LAT_TX_AIR, _on_air[i].committed, done);
+    add(LAT_TX_TOTAL, _on_air[i].ingress, done);
+  }
+  _on_air_count = 0;
+}
+
+void LatencyTracer::receiving(bool in_packet)
+{
+  if (in_packet && !_in_packet) _rx_sync = stamp();
+  _in_packet = in_packet;
+}
+
+void LatencyTracer::decoded(unsigned long drained)
+{
+  // the sync stamp goes with this packet, whether or not it ends up on a serial port (rate control doesn't)
+  _rx_packet_sync = _rx_sync;
+  _rx_sync = 0;
+  _in_packet = false;  //so the next pass in RX is the next packet's sync, back to back packets never leave RX
+  _rx_decoded = stamp();
+  add(LAT_RX_AIR, _rx_packet_sync, drained);
+  add(LAT_RX_DECODE, drained, _rx_decoded);
+}
+
+void LatencyTracer::written()
+{
+  unsigned long done = stamp();
+  add(LAT_RX_OUT, _rx_decoded, done);
+  add(LAT_RX_TOTAL, _rx_packet_sync, done);
+  _rx_decoded = 0;
+}
+
+void LatencyTracer::print()
+{
+  Log.notice(F("latency (us), bucket n is 2^n and up\r\n"));
+  for (int i = 0; i < LAT_COUNT; i++)
+  {
+    LatencyHistogram &histogram = _histogram[i];
+    if (histogram.samples == 0)
+    {
+      Log.notice(F("%s: none\r\n"), latency_names[i]);
+      continue;
+    }
+    Log.notice(F("%s: n %l, mean %l, max %l\r\n"), latency_names[i], histogram.samples,
+      (uint32_t)(histogram.total / histogram.samples), histogram.max);
+    for (int bucket = 0; bucket < LATENCY_BUCKETS; bucket++)
+    {
+      if (histogram.count[bucket]) Log.notice(F("  %d: %d\r\n"), bucket, histogram.count[bucket]);
+    }
+  }
+  clear();
+}
+
+void LatencyTracer::clear()
+{
+  for (int i = 0; i < LAT_COUNT; i++) _histogram[i] = {};
+}
@@ -0,0 +1,121 @@
+/**
+* @file latency.h
+* @author Tom Conrad (tom@silversat.org)
+* @brief Per-frame latency through each stage of the transmit and receive paths
+* @version 1.0.1
+* @date 2026-10-19
+
+latency.h - Per-frame latency through each stage of the transmit and receive paths
+Created by Tom Conrad, October 19, 2026.
+Released into the public domain.
+
+Stats only keeps the worst execution time of each handler, which doesn't say where a frame actually waits.  This
+timestamps each frame at every stage and keeps a histogram of the time between stages.  Only frames that came in on
+Serial1 have the first two.
+
+Transmit: first byte in on Serial1, KISS frame complete (the closing FEND), IL2P encoded (out of the databuffer and
+into the txbuffer), handed to the radio (after CCA and turnaround), all of it in the FIFO, and the end of the transmit
+session it went out in.  Frames in a burst all finish with the session, so the last interval is an upper bound for
+the early ones.  Frames that didn't come in on Serial1 (commands for the other end, rate control) only get the
+stages from encoded on, and so does one that was put back on its queue for something more important.
+
+Receive: sync detected (the loop sees RADIOSTATE go to RX), out of the FIFO, decoded, and written to the serial port.
+The sync stamp is only as good as the loop time while receiving.
+
+Buckets are powers of two in microseconds.  Command 0x22 prints them on the debug port and starts over.
+*/
+
+#ifndef LATENCY_H
+#define LATENCY_H
+
+#include "Arduino.h"
+#include "ArduinoLog.h"
+#include "txqueue.h"
+
+#define LATENCY_BUCKETS 22        // bucket i is [2^i, 2^(i+1)) us, the last one is everything from 2 s up
+#define LATENCY_QUEUED_FRAMES 16  // complete frames waiting in each transmit queue that we have ingress times for
+#define LATENCY_BURST_FRAMES 16   // frames on the air in one session, more than that just aren't timed
+
+enum latency_interval
+{
+  LAT_TX_SERIAL,    // first byte -> frame complete
+  LAT_TX_QUEUED,    // frame complete -> encoded (waiting in the databuffer)
+  LAT_TX_WAIT,      // encoded -> handed to the radio (txbuffer, CCA, turnaround)
+  LAT_TX_LOAD,      // handed to the radio -> all in the FIFO
+  LAT_TX_AIR,       // all in the FIFO -> session over
+  LAT_TX_TOTAL,     // first byte -> session over
+  LAT_RX_AIR,       // sync -> out of the FIFO
+  LAT_RX_DECODE,    // out of the FIFO -> decoded
+  LAT_RX_OUT,       // decoded -> written to the serial port
+  LAT_RX_TOTAL,     // sync -> written
+  LAT_COUNT
+};
+
+struct LatencyHistogram
+{
+  uint16_t count[LATENCY_BUCKETS];
+  uint32_t samples;
+  uint32_t max;
+  uint64_t total;  //for the mean
+};
+
+class LatencyTracer {
+public:
+  // transmit, in the order a frame sees them
+  // frames are found by where they end in their queue (txqueue.h), Serial1 frames start out in TXQ_BULK
+  void serialByte(byte data, int buffered);  //every byte from Serial1 as it goes into the databuffer, buffered is the databuffer size after
+  void moved(int queue, int frame_end, int buffered);  //the frame that just completed (at frame_end) went off the end of the databuffer onto another queue
+  void shifted(int queue, int count, int remaining);  //bytes taken off the front of a queue that weren't a frame (processbuff skipping junk), negative for put back
+  void frameTaken(int queue, int length, int remaining);  //the data processor took a frame off a queue
+  void encoded();
+  void started();  //radio.transmit
+  void committed();  //transmitStep says it's all in the FIFO
+  void sessionDone();  //back in receive
+
+  // receive
+  void receiving(bool in_packet);  //RADIOSTATE is RX, called every idle pass
+  void decoded(unsigned long drained);  //drained is micros() when ax_rx_packet read the end of the packet
+  void written();
+
+  void print();  //on the debug port, then clears
+  void clear();
+
+private:
+  void add(latency_interval interval, unsigned long from, unsigned long to);
+
+  struct TxTrace
+  {
+    unsigned long ingress;   //0 if we don't know
+    unsigned long complete;
+    unsigned long encoded;
+    unsigned long started;
+    unsigned long committed;
+  };
+
+  struct Queued
+  {
+    unsigned long ingress;
+    unsigned long complete;
+    int end;  //bytes from the front of the queue to the end of the frame
+  };
+
+  LatencyHistogram _histogram[LAT_COUNT]{};
+
+  bool _open{false};  //in the middle of a frame on Serial1
+  unsigned long _open_time{0};
+  Queued _queued[TXQ_COUNT][LATENCY_QUEUED_FRAMES];
+  int _queued_count[TXQ_COUNT]{};
+
+  TxTrace _encoding{};  //in the txbuffer
+  TxTrace _loading{};   //going into the FIFO
+  bool _is_loading{false};
+  TxTrace _on_air[LATENCY_BURST_FRAMES];
+  int _on_air_count{0};
+
+  bool _in_packet{false};
+  unsigned long _rx_sync{0};
+  unsigned long _rx_packet_sync{0};  //the sync stamp of the packet being written out
+  unsigned long _rx_decoded{0};
+};
+
+#endif
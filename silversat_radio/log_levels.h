@@ -0,0 +1,58 @@
+/**
+* @file log_levels.h
+* @author Tom Conrad (tom@silversat.org)
+* @brief Compile-time log ceilings, one per module
+* @version 1.0.1
+* @date 2026-10-19
+
+log_levels.h - Compile-time log ceilings, one per module
+Created by Tom Conrad, October 19, 2026.
+Released into the public domain.
+
+The runtime level (Log.begin in setup) only stops the printing.  Everything else still happens: the arguments get
+evaluated, the format string gets walked, loops that only exist to dump bytes still run, and every string is in
+flash.  In the driver and packet paths that's a lot of loop time at NOTICE for nothing.
+
+A module that uses these picks its ceiling after its includes,
+
+  #define LOG_MODULE_MAX LOG_MAX_AX
+
+and logs with LOG_TRACE(...) etc. instead of Log.trace(...).  Anything above the ceiling is an if (0), so the compiler
+throws it out, arguments and all (it still gets type checked, and a variable only used for logging doesn't warn).
+Work that's only done for logging goes inside if (LOG_ON(LOG_LEVEL_VERBOSE)).
+
+To debug a module, raise its ceiling here AND the runtime level.  Raising only the runtime level gets you nothing more
+from a module that's compiled out.  They're #ifndef'd so a build can also set them with -D (build.extra_flags).
+*/
+
+#ifndef LOG_LEVELS_H
+#define LOG_LEVELS_H
+
+#include <ArduinoLog.h>
+
+#ifndef LOG_MAX_AX
+#define LOG_MAX_AX      LOG_LEVEL_NOTICE  // ax.cpp, the FIFO and packet paths
+#endif
+#ifndef LOG_MAX_IL2P
+#define LOG_MAX_IL2P    LOG_LEVEL_NOTICE  // il2p_rs.cpp, il2p_crc.cpp
+#endif
+#ifndef LOG_MAX_PACKET
+#define LOG_MAX_PACKET  LOG_LEVEL_NOTICE  // packet.cpp, KISS.cpp
+#endif
+#ifndef LOG_MAX_RADIO
+#define LOG_MAX_RADIO   LOG_LEVEL_NOTICE  // radio.cpp
+#endif
+#ifndef LOG_MAX_MAIN
+#define LOG_MAX_MAIN    LOG_LEVEL_NOTICE  // silversat_radio.ino, the loop
+#endif
+
+#define LOG_ON(level) (LOG_MODULE_MAX >= (level))
+
+#define LOG_FATAL(...)   do { if (LOG_ON(LOG_LEVEL_FATAL)) Log.fatal(__VA_ARGS__); } while (0)
+#define LOG_ERROR(...)   do { if (LOG_ON(LOG_LEVEL_ERROR)) Log.error(__VA_ARGS__); } while (0)
+#define LOG_WARNING(...) do { if (LOG_ON(LOG_LEVEL_WARNING)) Log.warning(__VA_ARGS__); } while (0)
+#define LOG_NOTICE(...)  do { if (LOG_ON(LOG_LEVEL_NOTICE)) Log.notice(__VA_ARGS__); } while (0)
+#define LOG_TRACE(...)   do { if (LOG_ON(LOG_LEVEL_TRACE)) Log.trace(__VA_ARGS__); } while (0)
+#define LOG_VERBOSE(...) do { if (LOG_ON(LOG_LEVEL_VERBOSE)) Log.verbose(__VA_ARGS__); } while (0)
+
+#endif
@@ -0,0 +1,131 @@
+/**
+* @file lz.cpp
+* @author Tom Conrad (tom@silversat.org)
+* @brief Small LZ77 (LZSS) compression for the data frames
+* @version 1.0.1
+* @date 2026-10-19
+
+lz.cpp - Small LZ77 (LZSS) compression for the data frames
+Created by Tom Conrad, October 19, 2026.
+Released into the public domain.
+
+*/
+
+#include "lz.h"
+
+static uint8_t hash3(const byte *p)
+{
+  return ((p[0] << 4) ^ (p[1] << 2) ^ p[2]) & (LZ_HASH_SIZE - 1);
+}
+
+int lz_compress(const byte *in, int length, byte *out, int size)
+{
+  if (length > LZ_MAX_INPUT) return 0;
+  uint8_t head[LZ_HASH_SIZE];  //the last position with each hash, 0xFF for none
+  uint8_t prev[LZ_MAX_INPUT];  //and the one before that with the same hash
+  memset(head, 0xFF, sizeof(head));
+
+  int index = 0;
+  int flags = 0;
+  int bit = 8;
+  int i = 0;
+  while (i < length)
+  {
+    if (bit == 8)
+    {
+      if (index >= size) return 0;
+      flags = index;
+      out[index++] = 0;
+      bit = 0;
+    }
+
+    // the longest match in the chain.  It can run on past i, the decoder copies a byte at a time
+    int best = 0;
+    int distance = 0;
+    if (i + LZ_MIN_MATCH <= length)
+    {
+      int longest = min(length - i, LZ_MAX_MATCH);
+      int candidate = head[hash3(in + i)];
+      for (int chain = 0; (chain < LZ_CHAIN) && (candidate != 0xFF) && (best < longest); chain++)
+      {
+        int n = 0;
+        while ((n < longest) && (in[candidate + n] == in[i + n])) n++;
+        if (n > best)
+        {
+          best = n;
+          distance = i - candidate;
+        }
+        candidate = prev[candidate];
+      }
+    }
+
+    int step = 1;
+    if (best >= LZ_MIN_MATCH)
+    {
+      if (index + 2 > size) return 0;
+      out[flags] |= 1 << bit;
+      out[index++] = distance - 1;
+      out[index++] = best - LZ_MIN_MATCH;
+      step = best;
+    }
+    else
+    {
+      if (index >= size) return 0;
+      out[index++] = in[i];
+    }
+    bit++;
+
+    // everything we went past goes in the table
+    for (int j = 0; j < step; j++, i++)
+    {
+      if (i + LZ_MIN_MATCH > length) continue;
+      uint8_t hash = hash3(in + i);
+      prev[i] = head[hash];
+      head[hash] = i;
+    }
+  }
+  return index;
+}
+
+int lz_decompress(const byte *in, int length, byte *out, int size)
+{
+  int i = 0;
+  int index = 0;
+  while (i < length)
+  {
+    byte flags = in[i++];
+    for (int bit = 0; (bit < 8) && (i < length); bit++)
+    {
+      if (!(flags & (1 << bit)))
+      {
+        if (index >= size) return -1;
+        out[index++] = in[i++];
+        continue;
+      }
+      if (i + 2 > length) return -1;
+      int distance = in[i++] + 1;
+      int n = in[i++] + LZ_MIN_MATCH;
+      if ((distance > index) || (index + n > size)) return -1;
+      for (int k = 0; k < n; k++, index++) out[index] = out[index - distance];
+    }
+  }
+  return index;
+}
+
+int lz_pack(byte *frame, int length)
+{
+  if ((length < constants::lz_min) || (length > LZ_MAX_INPUT)) return length;
+  byte packed[LZ_MAX_INPUT];
+  int packed_length = lz_compress(frame, length, packed, length - 2);  //has to save at least a byte, after the code
+  if (packed_length == 0) return length;
+  frame[0] = constants::lz_code;
+  memcpy(frame + 1, packed, packed_length);
+  return packed_length + 1;
+}
+
+int lz_unpack(const byte *frame, int length, byte *out, int size)
+{
+  if ((length < 2) || (frame[0] != constants::lz_code)) return 0;
+  int unpacked = lz_decompress(frame + 1, length - 1, out, size);
+  return (unpacked > 0) ? unpacked : 0;
+}
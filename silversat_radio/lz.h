@@ -0,0 +1,53 @@
+/**
+* @file lz.h
+* @author Tom Conrad (tom@silversat.org)
+* @brief Small LZ77 (LZSS) compression for the data frames
+* @version 1.0.1
+* @date 2026-10-19
+
+lz.h - Small LZ77 (LZSS) compression for the data frames
+Created by Tom Conrad, October 19, 2026.
+Released into the public domain.
+
+Telemetry, logs and text from the payload are mostly repeats of themselves, and the data processor used to send
+them as they came.  Each data frame is now compressed on its own before it's scrambled and encoded, if that makes it
+shorter.  Only the frame itself is the dictionary.  Frames get lost, so nothing can depend on an earlier one, and a
+255 byte window is all a frame has anyway, so an offset and a length each fit in a byte.
+
+The stream is a flag byte and then eight items, the next flag byte and eight more, and so on.  A 0 bit in the flag
+byte (lowest bit first) is a literal byte, a 1 is a match: how far back (1 to 255, sent as one less) and how long (3 to
+258, sent as three less).
+
+A compressed frame goes out as constants::lz_code, then the stream of the whole frame, command byte included, so
+the other end gets back exactly what went in (a data frame, or one with compressed headers, see headercomp.h).  If it
+doesn't come out shorter the frame goes as it was, so random or already compressed data costs nothing but the time.
+
+It's all on the stack: 320 bytes of hash table and chains to compress, nothing to decompress.
+*/
+
+#ifndef LZ_H
+#define LZ_H
+
+#include "Arduino.h"
+#include "constants.h"
+
+#define LZ_MAX_INPUT 255  // positions have to fit in a byte
+#define LZ_MIN_MATCH 3
+#define LZ_MAX_MATCH (255 + LZ_MIN_MATCH)
+#define LZ_HASH_SIZE 64
+#define LZ_CHAIN 16  // matches looked at for each position, more is slower and barely smaller
+
+// compresses length bytes into out, returns the compressed length, 0 if it doesn't fit in size bytes
+int lz_compress(const byte *in, int length, byte *out, int size);
+
+// returns the decompressed length, -1 if the stream doesn't make sense or won't fit in size bytes
+int lz_decompress(const byte *in, int length, byte *out, int size);
+
+// a data frame (command byte first) compressed in place if it's at least constants::lz_min bytes and it comes out
+// shorter.  Returns the new length, the same as length if nothing changed
+int lz_pack(byte *frame, int length);
+
+// a frame starting with constants::lz_code back to what it was.  Returns its length, 0 if it's bad
+int lz_unpack(const byte *frame, int length, byte *out, int size);
+
+#endif
@@ -12,6 +12,8 @@ Released into the public domain.
 */
 
 #include "packet.h"
+#include "log_levels.h"
+#define LOG_MODULE_MAX LOG_MAX_PACKET
 
 Packet::Packet()
 {
@@ -26,7 +28,7 @@ int Packet::extractParams()
   size_t start_position = 0, end_position;
   String token;
   String packetstring = (char *)packetbody;
-  while ((end_position = packetstring.indexOf(" ", start_position)) != -1)
+  while ((end_position = packetstring.indexOf(" ", start_position)) != -1 && numparams < 3)  //leaves room for the last one
   {
     token = packetstring.substring(start_position, end_position);
     start_position = end_position + 1;
@@ -39,56 +41,64 @@ int Packet::extractParams()
     numparams++;
   }
 
-  Log.trace(F("packet body: %s\r\n"), packetstring.c_str());
-  Log.trace(F("command code: %X\r\n"), commandcode);
-  Log.trace(F("numparams: %d\r\n"), numparams);
-  Log.trace(F("parameters: "));
+  LOG_TRACE(F("packet body: %s\r\n"), packetstring.c_str());
+  LOG_TRACE(F("command code: %X\r\n"), commandcode);
+  LOG_TRACE(F("numparams: %d\r\n"), numparams);
+  LOG_TRACE(F("parameters: "));
 
-  for(int i=0; i<numparams; i++) Log.trace("%d \r\n", parameters[i].c_str());
-  Log.trace("\r\n");
+  if (LOG_ON(LOG_LEVEL_TRACE)) for(int i=0; i<numparams; i++) LOG_TRACE("%d \r\n", parameters[i].c_str());
+  LOG_TRACE("\r\n");
   return numparams; 
 }
 
 
-bool Packet::processcmdbuff(CircularBuffer<byte, CMDBUFFSIZE> &cmdbuffer, CircularBuffer<byte, DATABUFFSIZE> &databuffer)
+bool Packet::processcmdbuff(CircularBuffer<byte, CMDBUFFSIZE> &cmdbuffer, CircularBuffer<byte, PRIORITYBUFFSIZE> &relaybuffer)
 {
     // first remove the seal... 0xC0
     cmdbuffer.shift();
     // and then grab the command code
     commandcode = cmdbuffer.shift();
-    Log.trace(F("command code is: %X\r\n"), commandcode);
+    LOG_TRACE(F("command code is: %X\r\n"), commandcode);
 
     // if (packet.commandcode == 0xAA || packet.commandcode == 0x00) {
     if (commandcode == 0xAA)
     {
-        // nothing to see here, it's not for me...forward to the other end, so copy this over to the tx buffer
-        databuffer.push(constants::FEND);
+        // nothing to see here, it's not for me...forward to the other end, so copy this over to the relay queue (txqueue.h)
+        relaybuffer.push(constants::FEND);
         // so for commands or responses bound for the other side, I'm adding a new command code back on to indicate where it's going.
-        databuffer.push(0xAA);
+        relaybuffer.push(0xAA);
         // you're starting at the second byte of the total packet
         // noInterrupts();  //turn off interrupts until this is done.  This is to avoid writing to the buffer until all the packet is shifted out.
         for (int i = 2; i < packetlength; i++)
         {
-            // shift it out of cmdbuffer and push it into databuffer, don't need to push a final 0xC0 because it's still part of the packet
-            databuffer.push(cmdbuffer.shift());
+            // shift it out of cmdbuffer and push it into relaybuffer, don't need to push a final 0xC0 because it's still part of the packet
+            relaybuffer.push(cmdbuffer.shift());
         }
         // interrupts();
-        Log.trace(F("packetlength = %i\r\n"), packetlength);           // the size of the packet
-        Log.trace(F("databuffer length = %i\r\n"), databuffer.size()); // the size that was pushed into the databuffer
+        LOG_TRACE(F("packetlength = %i\r\n"), packetlength);           // the size of the packet
+        LOG_TRACE(F("relaybuffer length = %i\r\n"), relaybuffer.size()); // the size that was pushed into the relaybuffer
         return false;
     }
     else
     {
         // it's possibly a local command
-        Log.trace(F("packet length: %i\r\n"), packetlength);
+        LOG_TRACE(F("packet length: %i\r\n"), packetlength);
+        bool too_long = (packetlength - 3) >= (int)sizeof(packetbody);
         for (int i = 2; i < (packetlength - 1); i++) // in this case we don't want the last C0
         {
-          packetbody[i - 2] = cmdbuffer.shift();
+          byte body_byte = cmdbuffer.shift();
+          if (!too_long) packetbody[i - 2] = body_byte;
         }
-        packetbody[packetlength-3] = 0; // put a null in the next byte...if the command has no body (length =3), then it puts a null in the first byte
+        if (too_long)
+        {
+          // it doesn't fit, so drop the body rather than act on part of it.  the command will NACK
+          LOG_ERROR(F("command body too long: %i\r\n"), packetlength);
+          packetbody[0] = 0;
+        }
+        else packetbody[packetlength-3] = 0; // put a null in the next byte...if the command has no body (length =3), then it puts a null in the first byte
         cmdbuffer.shift();                    // remove the last C0 from the buffer
 
-        //Log.notice("command body: %s\r\n", packetbody);
+        //LOG_NOTICE("command body: %s\r\n", packetbody);
         if (packetlength > 3) extractParams(); //extract the parameters from the command body
 
         return true;
@@ -20,13 +20,14 @@ Released into the public domain.
 #include "Arduino.h"
 #include "ax.h"
 #include "CircularBuffer.h"
+#include "txqueue.h"
 
 #ifndef CMDBUFFSIZE
 #define CMDBUFFSIZE 512 // 4 packets at max packet size...but probably a lot more because commands are short
 #endif
 
 #ifndef DATABUFFSIZE
-#define DATABUFFSIZE 8192 // 32 packets at max packet size.  Need to watch for an overflow on this one!!!
+#define DATABUFFSIZE 4096 // 16 packets at max packet size.  Past half full they go to the flash store (flashqueue.h)
 #endif
 
 //this is the basic packet class.  I want to add derived classes for commands, data and il2p packets.
@@ -45,10 +46,10 @@ class Packet
     int numparams {0};
 
     int extractParams();
-    bool processcmdbuff(CircularBuffer<byte, CMDBUFFSIZE> &cmdbuffer, CircularBuffer<byte, DATABUFFSIZE> &databuffer);
+    bool processcmdbuff(CircularBuffer<byte, CMDBUFFSIZE> &cmdbuffer, CircularBuffer<byte, PRIORITYBUFFSIZE> &relaybuffer);
 
   private:
-    int m_sent; //have I been sent?  this is for a future connected mode layer
+    int m_sent; //have I been sent?  not used, the connected mode layer ended up below this, on the frames as they're encoded (arq.h)
 
 };
 
@@ -12,6 +12,8 @@ Released into the public domain.
 */
 
 #include "radio.h"
+#include "log_levels.h"
+#define LOG_MODULE_MAX LOG_MAX_RADIO
 
 Radio::Radio(int TX_RX_pin, int RX_TX_pin, int PAENABLE_pin, int SYSCLK_pin, int AX5043_DCLK_pin, int AX5043_DATA_pin, int PIN_LED_TX_pin, int IRQ_pin)
 {
@@ -33,7 +35,9 @@ Radio::Radio(int TX_RX_pin, int RX_TX_pin, int PAENABLE_pin, int SYSCLK_pin, int
 // this sets the mode for all the pins and their initial conditions.  It populates the config and modulation structure.
 // and then sets it into receive mode.
 void Radio::begin(void (*spi_transfer)(unsigned char *, uint8_t), 
-    int operating_frequency, FlashStorageClass<byte> &clear_threshold)
+    int operating_frequency, FlashStorageClass<byte> &clear_threshold,
+    FlashStorageClass<ax_vco_cache> &vco_cache,
+    void (*spi_transfer_async)(unsigned char *, uint16_t, void (*)(void)))
 {
     pinMode(_pin_TX_RX, OUTPUT);       // TX/ RX-bar
     pinMode(_pin_RX_TX, OUTPUT);       // RX/ TX-bar
@@ -76,6 +80,8 @@ void Radio::begin(void (*spi_transfer)(unsigned char *, uint8_t),
 
     /* SPI transfer */
     config.spi_transfer = spi_transfer; // define the SPI handler
+    config.spi_transfer_async = spi_transfer_async; // FIFO bursts by DMA, if there is one
+    config.spi_async_threshold = constants::spi_dma_threshold;
 
     /* receive */
     config.pkt_store_flags = AX_PKT_STORE_RSSI | AX_PKT_STORE_RF_OFFSET;  //search on "AX_PKT_STORE" for other options, only data rate offset is implemented
@@ -117,14 +123,20 @@ void Radio::begin(void (*spi_transfer)(unsigned char *, uint8_t),
     /* Set the PWRMODE register to POWERDOWN, also clears RST bit */
     //ax_set_pwrmode(&config, AX_PWRMODE_POWERDOWN);
 
+    // ranging results from previous boots, so ax_init doesn't have to range again.  Flash is all zeros after programming.
+    _vco_cache_storage = &vco_cache;
+    config.vco_cache = vco_cache.read();
+    if (config.vco_cache.is_cache_set != 0x56) memset(&config.vco_cache, 0, sizeof(ax_vco_cache));
+    config.vco_cache.dirty = 0;
+
     int radio_start = ax_init(&config);
     while (radio_start != AX_INIT_OK)
     {
-        if (radio_start == AX_INIT_BAD_REVISION) Log.error("Bad Revision \r\n");
-        if (radio_start == AX_INIT_BAD_SCRATCH)  Log.error("Bad Scratch \r\n");
-        if (radio_start == AX_INIT_PORT_FAILED)  Log.error("Port Failure \r\n");
-        if (radio_start == AX_INIT_SET_SPI)  Log.error("SPI not set \r\n");
-        if (radio_start == AX_INIT_VCO_RANGING_FAILED) Log.error("VCO Ranging Failure \r\n");
+        if (radio_start == AX_INIT_BAD_REVISION) LOG_ERROR("Bad Revision \r\n");
+        if (radio_start == AX_INIT_BAD_SCRATCH)  LOG_ERROR("Bad Scratch \r\n");
+        if (radio_start == AX_INIT_PORT_FAILED)  LOG_ERROR("Port Failure \r\n");
+        if (radio_start == AX_INIT_SET_SPI)  LOG_ERROR("SPI not set \r\n");
+        if (radio_start == AX_INIT_VCO_RANGING_FAILED) LOG_ERROR("VCO Ranging Failure \r\n");
         
         //something is wrong, do a reset
         /* Set RST bit (PWRMODE) */
@@ -135,6 +147,11 @@ void Radio::begin(void (*spi_transfer)(unsigned char *, uint8_t),
     
     }; // this does a reset, so needs to be first
 
+    // the rates the link can switch between get their parameters worked out now, once
+    _rate_modulation[RATE_4800] = gmsk_modulation_il2p_4800;
+    _rate_modulation[RATE_9600] = gmsk_modulation_il2p;
+    for (int i = 0; i < RATE_COUNT; i++) ax_default_params(&config, &_rate_modulation[i]);
+
     // load the RF parameters for the current config
     ax_default_params(&config, &modulation); // ax_modes.c for RF parameters
     // I noticed this was never getting called, so trying it.  tkc 8/12/24
@@ -149,41 +166,45 @@ void Radio::begin(void (*spi_transfer)(unsigned char *, uint8_t),
 
 
     // parrot back what we set
-    Log.verbose(F("config variable values:\r\n"));
-    Log.verbose(F("tcxo frequency: %d\r\n"), int(config.f_xtal));
-    Log.verbose(F("synthesizer A frequency: %d\r\n"), int(config.synthesiser.A.frequency));
-    Log.verbose(F("synthesizer B frequency: %d\r\n"), int(config.synthesiser.B.frequency));
-    Log.verbose(F("status: %X\r\n"), ax_hw_status());
+    LOG_VERBOSE(F("config variable values:\r\n"));
+    LOG_VERBOSE(F("tcxo frequency: %d\r\n"), int(config.f_xtal));
+    LOG_VERBOSE(F("synthesizer A frequency: %d\r\n"), int(config.synthesiser.A.frequency));
+    LOG_VERBOSE(F("synthesizer B frequency: %d\r\n"), int(config.synthesiser.B.frequency));
+    LOG_VERBOSE(F("status: %X\r\n"), ax_hw_status());
 
     // set the IRQ for the radio control
     ax_SET_IRQMRADIOCTRL(&config);
 
     // turn on the receiver
     ax_rx_on(&config, &modulation);
-    Log.trace(F("current selected synth for Tx: %X\r\n"), ax_hw_read_register_8(&config, AX_REG_PLLLOOP));
+    LOG_TRACE(F("current selected synth for Tx: %X\r\n"), ax_hw_read_register_8(&config, AX_REG_PLLLOOP));
 
     // on a watchdog reset, the PLL may not be locked.  Re-range until it locks.
     int pll_lock = ax_hw_read_register_8(&config, AX_REG_PLLRANGINGA) & 0x40;
     while (pll_lock != 0x40)
     {
+       ax_vco_cache_clear(&config);  // the cached ranges didn't lock (or are stale), so really range
        setTransmitFrequency(constants::frequency);
        setReceiveFrequency(constants::frequency);
        pll_lock = ax_hw_read_register_8(&config, AX_REG_PLLRANGINGA) & 0x40;
-       Log.notice("PLL lock result: %X\r\n", pll_lock);
+       LOG_NOTICE("PLL lock result: %X\r\n", pll_lock);
     }
 
+    rate_control.begin(modeRate(), millis());
+
     // for RF debugging
     //  printRegisters(config);
     _CCA_threshold = clear_threshold.read();
+    saveVCOCache();
 }
 
 // setTransmit configures the radio for transmit..go figure
 void Radio::setTransmit()
 {
-    //Log.verbose("enabling interrupts\r\n");
+    //LOG_VERBOSE("enabling interrupts\r\n");
     //interrupts();
     ax_SET_SYNTH_A(&config);
-    Log.trace(F("current selected synth for Tx: %X\r\n"), ax_hw_read_register_8(&config, AX_REG_PLLLOOP));
+    LOG_TRACE(F("current selected synth for Tx: %X\r\n"), ax_hw_read_register_8(&config, AX_REG_PLLLOOP));
     ax_force_quick_adjust_frequency_A(&config, config.synthesiser.A.frequency); // doppler compensation
     //ax_set_pwrmode(&config, 0x05);  // see errata   now in ax_tx_on and ax_rx_on
     //ax_set_pwrmode(&config, 0x07);  // see errata
@@ -191,65 +212,189 @@ void Radio::setTransmit()
     digitalWrite(_pin_RX_TX, LOW);
     //digitalWrite(_pin_PAENABLE, HIGH); // enable the PA BEFORE turning on the transmitter
     //delayMicroseconds(constants::pa_delay);
-    ax_tx_on(&config, &modulation);         // turn on the radio in full tx mode
+    ax_tx_turnaround(&config, &modulation); // turn on the radio in full tx mode, only rewriting what differs from rx
     ax_SET_SYNTH_A(&config);  //I think that the quick adjust is changing us to synth B
     //digitalWrite(_pin_TX_LED, HIGH); 
-    Log.verbose(F("PLLLOOP register: %X\r\n"), ax_hw_read_register_8(&config, AX_REG_PLLLOOP));
-    Log.verbose(F("getSynth: %i\r\n"), getSynth());
-    if (getSynth() != 0) Log.error(F("LOOK! incorrect synth selected\r\n"));
+    LOG_VERBOSE(F("PLLLOOP register: %X\r\n"), ax_hw_read_register_8(&config, AX_REG_PLLLOOP));
+    LOG_VERBOSE(F("getSynth: %i\r\n"), getSynth());
+    if (getSynth() != 0) LOG_ERROR(F("LOOK! incorrect synth selected\r\n"));
     // ax_set_pinfunc_data(&config, 7);
 }
 
 // setReceive configures the radio for receive..go figure
 void Radio::setReceive()
 {
-    //Log.verbose("disabling interrupts\r\n");
+    //LOG_VERBOSE("disabling interrupts\r\n");
     //noInterrupts();
     // ax_set_pinfunc_data(&config, 2);
     digitalWrite(_pin_PAENABLE, LOW);       // cut the power to the PA
     digitalWrite(_pin_TX_LED, LOW);
-    Log.trace(F("current selected synth for Rx: %X\r\n"), ax_hw_read_register_8(&config, AX_REG_PLLLOOP));
+    LOG_TRACE(F("current selected synth for Rx: %X\r\n"), ax_hw_read_register_8(&config, AX_REG_PLLLOOP));
     ax_force_quick_adjust_frequency_B(&config, config.synthesiser.B.frequency); // doppler compensation
     // go into full_RX mode -- does this cause a re-range of the synthesizer?
     delayMicroseconds(constants::pa_delay); // wait for it to turn off
     digitalWrite(_pin_TX_RX, LOW);          // set the TR state to receive
     digitalWrite(_pin_RX_TX, HIGH);
-    Log.trace(F("turning on receiver\r\n"));
-    ax_rx_on(&config, &modulation);
+    LOG_TRACE(F("turning on receiver\r\n"));
+    ax_rx_turnaround(&config, &modulation); // only rewrites what differs from tx
     ax_SET_SYNTH_B(&config);
-    Log.verbose(F("PLLLOOP register: %X\r\n"), ax_hw_read_register_8(&config, AX_REG_PLLLOOP));
-    Log.verbose(F("getSynth: %i\r\n"), getSynth());
-    if (getSynth() != 1) Log.error(F("LOOK! incorrect synth selected\r\n"));
+    LOG_VERBOSE(F("PLLLOOP register: %X\r\n"), ax_hw_read_register_8(&config, AX_REG_PLLLOOP));
+    LOG_VERBOSE(F("getSynth: %i\r\n"), getSynth());
+    if (getSynth() != 1) LOG_ERROR(F("LOOK! incorrect synth selected\r\n"));
 }
 
 //set the radio transmitter frequency
 int Radio::setTransmitFrequency(int frequency)
 {
+    _tx_frequency = frequency;
+    if (constants::afc_enabled && constants::afc_track_tx) frequency += txCorrection();
     config.synthesiser.A.frequency = frequency;
     int adjust_result = ax_adjust_frequency_A(&config, frequency);
     ax_SET_SYNTH_A(&config);     
-    if (getSynth() != 0) Log.error(F("LOOK! incorrect synth selected\r\n"));
+    saveVCOCache();
+    if (getSynth() != 0) LOG_ERROR(F("LOOK! incorrect synth selected\r\n"));
     return adjust_result;
 }
 
 //set the radio receive frequency
 int Radio::setReceiveFrequency(int frequency)
 {
+    _rx_frequency = frequency;
+    if (constants::afc_enabled) frequency += afc.correction();
     config.synthesiser.B.frequency = frequency;
     int adjust_result = ax_adjust_frequency_B(&config, frequency);
     ax_SET_SYNTH_B(&config);
-    if (getSynth() != 1) Log.error(F("LOOK! incorrect synth selected\r\n"));
+    saveVCOCache();
+    if (getSynth() != 1) LOG_ERROR(F("LOOK! incorrect synth selected\r\n"));
     return adjust_result;
 }
 
+// only writes when ranging found something new, flash has limited write cycles
+void Radio::saveVCOCache()
+{
+    if (_vco_cache_storage == nullptr || !config.vco_cache.dirty) return;
+    config.vco_cache.dirty = 0;
+    _vco_cache_storage->write(config.vco_cache);
+    LOG_TRACE(F("vco cache saved\r\n"));
+}
+
+// these are the frequencies we were told to use, the synths are on these plus the afc correction
 int Radio::getTransmitFrequency()
 {
-    return config.synthesiser.A.frequency;
+    return _tx_frequency;
 }
 
 int Radio::getReceiveFrequency()
 {
-    return config.synthesiser.B.frequency;
+    return _rx_frequency;
+}
+
+// closes the loop on the RF offset of each received packet (see afc.h).  The receive synth moves right away,
+// the transmit synth (if it's tracking) at the next setTransmit.
+void Radio::trackFrequency(int32_t rffreqoffs)
+{
+    if (!constants::afc_enabled) return;
+
+    // RFFREQOFFS is in the same units as FREQA/FREQB, f_xtal/2^24
+    int32_t offset_hz = (int32_t)(((int64_t)rffreqoffs * config.f_xtal) >> 24);
+    if (!afc.update(offset_hz)) return;
+
+    ax_force_quick_adjust_frequency_B(&config, _rx_frequency + afc.correction());
+    if (constants::afc_track_tx) config.synthesiser.A.frequency = _tx_frequency + txCorrection();
+}
+
+// the quick adjusts in serviceDoppler don't re-range the VCOs, so they're ranged here for the first point, the same way
+// the doppler command (0x0D) does it.  The offsets are limited to 100 kHz, well inside what one VCOR value covers.
+bool Radio::startDoppler(const char *body)
+{
+    bool running = (doppler.points() > 0);
+    if (!doppler.load(body, millis())) return false;
+    if (!running)
+    {
+        _nominal_tx_frequency = _tx_frequency;
+        _nominal_rx_frequency = _rx_frequency;
+    }
+    int tx_frequency, rx_frequency;
+    doppler.first(tx_frequency, rx_frequency);
+    if ((setTransmitFrequency(tx_frequency) != AX_INIT_OK) || (setReceiveFrequency(rx_frequency) != AX_INIT_OK))
+    {
+        LOG_ERROR(F("doppler schedule won't range\r\n"));
+        stopDoppler();
+        return false;
+    }
+    _doppler_update = millis();
+    return true;
+}
+
+void Radio::stopDoppler(bool restore)
+{
+    doppler.cancel();
+    if (!restore || (_nominal_tx_frequency == 0))
+    {
+        _nominal_tx_frequency = 0;
+        return;
+    }
+    setTransmitFrequency(_nominal_tx_frequency);
+    setReceiveFrequency(_nominal_rx_frequency);
+    _nominal_tx_frequency = 0;
+    _nominal_rx_frequency = 0;
+    LOG_NOTICE(F("doppler schedule over, back to tx %d, rx %d\r\n"), _tx_frequency, _rx_frequency);
+}
+
+// the receive synth moves right away with a quick adjust (no re-ranging), and the transmit frequency goes in at the
+// next setTransmit.  That's why this has to be between packets in receive.
+void Radio::serviceDoppler()
+{
+    if (doppler.points() == 0) return;
+    if (millis() - _doppler_update < constants::doppler_interval) return;
+    if (radioBusy() != 0) return;  //in the middle of a packet, next pass
+    _doppler_update = millis();
+    if (!doppler.active(millis()))
+    {
+        stopDoppler();
+        return;
+    }
+
+    int tx_frequency, rx_frequency;
+    if (!doppler.frequencies(millis(), tx_frequency, rx_frequency)) return;
+    if ((tx_frequency == _tx_frequency) && (rx_frequency == _rx_frequency)) return;
+
+    _tx_frequency = tx_frequency;
+    _rx_frequency = rx_frequency;
+    config.synthesiser.A.frequency = _tx_frequency + ((constants::afc_enabled && constants::afc_track_tx) ? txCorrection() : 0);
+    ax_force_quick_adjust_frequency_B(&config, _rx_frequency + (constants::afc_enabled ? afc.correction() : 0));
+    LOG_TRACE(F("doppler: tx %d, rx %d\r\n"), _tx_frequency, _rx_frequency);
+}
+
+// switching rates the way dataMode does it (reset, ranging, params) takes long enough to lose packets.  The params
+// for both rates are already in _rate_modulation, and the synths stay where they are, so it's just the registers.
+void Radio::setRate(int index)
+{
+    if (index < 0 || index >= RATE_COUNT) return;
+    float power = modulation.power;  //keep whatever power was commanded
+    modulation = _rate_modulation[index];
+    modulation.power = power;
+    unsigned long switch_start = micros();
+    ax_rx_switch(&config, &modulation);
+    rate_control.begin(index, millis());
+    noise_floor.reset();  //different bandwidth, different noise
+    LOG_NOTICE(F("rate: now %d bps, switch took %u us\r\n"), modulation.bitrate, micros() - switch_start);
+}
+
+int Radio::modeRate()
+{
+    for (int i = 0; i < RATE_COUNT; i++)
+    {
+        if ((modulation.bitrate == _rate_modulation[i].bitrate) && (modulation.il2p_enabled == _rate_modulation[i].il2p_enabled) &&
+            (modulation.framing == _rate_modulation[i].framing)) return i;
+    }
+    return -1;
+}
+
+// the same correction in ppm
+int32_t Radio::txCorrection()
+{
+    return (int32_t)((int64_t)afc.correction() * _tx_frequency / _rx_frequency);
 }
 
 /* beacon mode is entered by putting the AX5043 in Wire mode and setting the modulation for ASK.
@@ -283,11 +428,11 @@ void Radio::beaconMode()
     digitalWrite(_pin_TX_RX, HIGH);
     digitalWrite(_pin_RX_TX, LOW);
 
-    Log.trace(F("config variable values:\r\n"));
-    Log.verbose(F("tcxo frequency: %d\r\n"), uint(config.f_xtal));
-    Log.trace(F("synthesizer A frequency: %d\r\n"), uint(config.synthesiser.A.frequency));
-    Log.trace(F("synthesizer B frequency: %d\r\n"), uint(config.synthesiser.B.frequency));
-    Log.verbose(F("status: %X\r\n"), ax_hw_status());
+    LOG_TRACE(F("config variable values:\r\n"));
+    LOG_VERBOSE(F("tcxo frequency: %d\r\n"), uint(config.f_xtal));
+    LOG_TRACE(F("synthesizer A frequency: %d\r\n"), uint(config.synthesiser.A.frequency));
+    LOG_TRACE(F("synthesizer B frequency: %d\r\n"), uint(config.synthesiser.B.frequency));
+    LOG_VERBOSE(F("status: %X\r\n"), ax_hw_status());
     ax_SET_SYNTH_A(&config); // make sure we're using SYNTH A
     ax_tx_on(&config, &ask_modulation);
 }
@@ -312,16 +457,19 @@ void Radio::dataMode()
 
     ax_off(&config); // turn the radio off
     while (ax_init(&config) != AX_INIT_OK); // this does a reset, so probably needs to be first, this hopefully takes us out of wire mode too
-    Log.trace(F("radio init\r\n"));
+    LOG_TRACE(F("radio init\r\n"));
     // load the RF parameters
     ax_default_params(&config, &modulation); // ax_modes.c for RF parameters
-    Log.trace(F("default params loaded\r\n"));
+    LOG_TRACE(F("default params loaded\r\n"));
 
     ax_rx_on(&config, &modulation);
-    Log.trace(F("current selected synth for Tx: %X\r\n"), ax_hw_read_register_8(&config, AX_REG_PLLLOOP));
-    Log.trace(F("receiver on\r\n"));
-    Log.verbose(F("status: %X\r\n"), ax_hw_status());
-    Log.notice(F("i'm done and back to receive\r\n"));
+    saveVCOCache();
+    noise_floor.reset();
+    rate_control.begin(modeRate(), millis());  //a mode command (or anything else through here) starts the rate over
+    LOG_TRACE(F("current selected synth for Tx: %X\r\n"), ax_hw_read_register_8(&config, AX_REG_PLLLOOP));
+    LOG_TRACE(F("receiver on\r\n"));
+    LOG_VERBOSE(F("status: %X\r\n"), ax_hw_status());
+    LOG_NOTICE(F("i'm done and back to receive\r\n"));
 }
 
 /* cW mode is entered by putting the AX5043 in Wire mode and setting the modulation for ASK.
@@ -347,7 +495,7 @@ void Radio::cwMode(uint32_t duration, ExternalWatchdog &watchdog)
     // this keeps beacon at full power
     ask_modulation.power = modulation.power;
 
-    Log.notice(F("ask power: %f\r\n"), ask_modulation.power); // check to make sure it was modified...but maybe it wasn't?
+    LOG_NOTICE(F("ask power: %f\r\n"), ask_modulation.power); // check to make sure it was modified...but maybe it wasn't?
 
     ax_default_params(&config, &ask_modulation); // load the RF parameters
 
@@ -363,7 +511,7 @@ void Radio::cwMode(uint32_t duration, ExternalWatchdog &watchdog)
     ax_tx_on(&config, &ask_modulation); // turn on the transmitter
 
     // start transmitting
-    Log.notice(F("output CW for %d seconds\r\n"), duration);
+    LOG_NOTICE(F("output CW for %d seconds\r\n"), duration);
     digitalWrite(_pin_TX_LED, HIGH);
     digitalWrite(_pin_PAENABLE, HIGH);
     // delay(PAdelay); //let the pa bias stabilize
@@ -380,7 +528,7 @@ void Radio::cwMode(uint32_t duration, ExternalWatchdog &watchdog)
     digitalWrite(_pin_RX_TX, HIGH);
     digitalWrite(_pin_AX5043_DATA, LOW); //set the data to low (stops transmitting for ASK)
     digitalWrite(_pin_TX_LED, LOW); //turn off the transmit LED
-    Log.notice(F("done\r\n"));
+    LOG_NOTICE(F("done\r\n"));
 
     // drop out of wire mode
     _func = 2;
@@ -389,52 +537,58 @@ void Radio::cwMode(uint32_t duration, ExternalWatchdog &watchdog)
     // now put it back the way you found it.
     while (ax_init(&config) != AX_INIT_OK);  // do a reset
     ax_default_params(&config, &modulation); // ax_modes.c for RF parameters
-    Log.trace(F("default params loaded\r\n"));
+    LOG_TRACE(F("default params loaded\r\n"));
     ax_rx_on(&config, &modulation);
-    Log.notice(F("receiver on\r\n"));
-    Log.trace(F("current selected synth for Tx: %X\r\n"), ax_hw_read_register_8(&config, AX_REG_PLLLOOP));
+    LOG_NOTICE(F("receiver on\r\n"));
+    LOG_TRACE(F("current selected synth for Tx: %X\r\n"), ax_hw_read_register_8(&config, AX_REG_PLLLOOP));
 }
 
 size_t Radio::reportstatus(String &response, Efuse &efuse, bool fault)
 {
     // create temperature sensor instance, only needed here
     Generic_LM75_10Bit tempsense(0x4B);
-    //Log.verbose("response: %s\r\n", response);
+    //LOG_VERBOSE("response: %s\r\n", response);
     response = "Freq A:" + String(config.synthesiser.A.frequency, DEC);
-    //Log.verbose("response: %s\r\n", response);
+    //LOG_VERBOSE("response: %s\r\n", response);
     response += "; Freq B:" + String(config.synthesiser.B.frequency, DEC);
-    //Log.verbose("response: %s\r\n", response);
+    //LOG_VERBOSE("response: %s\r\n", response);
     response += "; Ver:" + String(constants::version);
-    //Log.verbose("response: %s\r\n", response);
+    //LOG_VERBOSE("response: %s\r\n", response);
     //response += "; Status:" + String(ax_hw_status(), HEX); // ax_hw_status is the FIFO status from the last transaction
     #ifdef SILVERSAT
         float patemp = tempsense.readTemperatureC();
-        Log.verbose("response: %s\r\n", response);
+        LOG_VERBOSE("response: %s\r\n", response);
         response += "; Temp:" + String(patemp, 1);
-        //Log.verbose("response: %s\r\n", response);
+        //LOG_VERBOSE("response: %s\r\n", response);
         //response += "; Overcurrent:" + String(fault);
-        //Log.verbose("response: %s\r\n", response);
+        //LOG_VERBOSE("response: %s\r\n", response);
         //response += "; 5V Current:" + String(efuse.measure_current(), DEC);
         //to get 5V current, just send command twice, max is reset.
-        //Log.verbose("response: %s\r\n", response);
+        //LOG_VERBOSE("response: %s\r\n", response);
         response += "; MaxCur: " + String(efuse.get_max_current());
-        //Log.verbose("response: %s\r\n", response);
+        //LOG_VERBOSE("response: %s\r\n", response);
     #endif
     //response += "; Shape:" + String(modulation.shaping, HEX);
-    //Log.verbose("response: %s\r\n", response);
+    //LOG_VERBOSE("response: %s\r\n", response);
     //response += "; FEC:" + String(modulation.fec, HEX);
     response += "; Rate:"+ String(modulation.bitrate);
-    //Log.verbose("response: %s\r\n", response);
+    response += "; RateSw:" + String(rate_control.switches());  //adaptive rate switches since boot
+    //LOG_VERBOSE("response: %s\r\n", response);
     response += "; il2p:" + String(modulation.il2p_enabled);
-    //Log.verbose("response: %s\r\n", response);
+    //LOG_VERBOSE("response: %s\r\n", response);
     //response += "; framing:" + String(modulation.framing & 0x0E);
-    //Log.verbose("response: %s\r\n", response);
+    //LOG_VERBOSE("response: %s\r\n", response);
     response += "; CCA:" + String(_CCA_threshold);
-    //Log.verbose("response: %s\r\n", response);
+    response += "; Floor:" + String(noise_floor.floor());  //-1 until there's a block of readings
+    //LOG_VERBOSE("response: %s\r\n", response);
     //response += "; Bitrate:" + String(modulation.bitrate, DEC);
-    //Log.verbose("response: %s\r\n", response);
+    //LOG_VERBOSE("response: %s\r\n", response);
     response += "; Pwr%:" + String(modulation.power, 3);
-    //Log.verbose("response: %s\r\n", response);
+    //LOG_VERBOSE("response: %s\r\n", response);
+    response += "; AFC:" + String(afc.correction());
+    response += "; Resid:" + String(afc.max_residual());  //worst since the last status
+
+    afc.clear_max_residual();
 
     efuse.clear_max_current();
     return response.length();
@@ -468,6 +622,7 @@ void Radio::key(int chips, Efuse &efuse)
 
 int Radio::radioBusy()
 {
+  AX_HW_OP(AX_HW_OP_STATUS);
   uint8_t current_state = ax_hw_read_register_8(&config, AX_REG_PWRMODE) & 0xF;
   uint8_t radiostate = ax_RADIOSTATE(&config) & 0x0F;
 
@@ -489,34 +644,112 @@ int Radio::radioBusy()
   }
   else 
   {
-    Log.notice("we're not in FULLTX or FULLRX\r\n");
+    LOG_NOTICE("we're not in FULLTX or FULLRX\r\n");
     return 3;
   }
 }
 
+bool Radio::receiving()
+{
+  AX_HW_OP(AX_HW_OP_STATUS);
+  return (ax_RADIOSTATE(&config) & 0x0F) == AX_RADIOSTATE_RX;
+}
+
 uint8_t Radio::rssi()
 {
+    AX_HW_OP(AX_HW_OP_STATUS);
     uint8_t rssi = ax_RSSI(&config);
     return rssi;
 }
 
-void Radio::transmit(byte* txqueue, int txbufflen)
+// transmit used to sit in ax_tx_packet until the last chunk was in the FIFO, which for a two chunk frame is most of
+// the time it takes to send the first one.  Now it's a state machine: WAIT_SVMODEM -> PREAMBLE -> CHUNKS -> DRAIN -> TURNAROUND
+// transmit starts it, transmitStep moves it along once per pass of loop(), and finishTransmit does the drain and turnaround.
+void Radio::transmit(byte* txqueue, int txbufflen, bool continuation)
 {
     digitalWrite(_pin_TX_LED, HIGH);
+
+    if (txbufflen > (int)sizeof(_tx_packet)) txbufflen = sizeof(_tx_packet);
+    memcpy(_tx_packet, txqueue, txbufflen);
+    ax_tx_packet_start(&_tx_job, &modulation, _tx_packet, txbufflen, continuation);
+    transmitStep();  //a frame that fits in the FIFO is all in there after this
+}
+
+bool Radio::transmitStep()
+{
+    uint8_t previous = _tx_job.state;
+    if ((previous == AX_TX_STATE_IDLE) || (previous >= AX_TX_STATE_DRAIN)) return false;
+
+    if (config.pwrmode != AX_PWRMODE_FULLTX)
+    {
+        LOG_ERROR(F("PWRMODE must be FULLTX before writing to FIFO!\r\n"));
+        _tx_job.state = AX_TX_STATE_IDLE;
+        return false;
+    }
+
+    uint8_t state = ax_tx_packet_step(&config, &_tx_job);
+    //the PA goes on once the preamble is committed.  this instruction order is experimental!
+    if ((previous <= AX_TX_STATE_PREAMBLE) && (state > AX_TX_STATE_PREAMBLE)) digitalWrite(_pin_PAENABLE, HIGH);
+    if (state == AX_TX_STATE_DRAIN) LOG_TRACE(F("packet written to FIFO!\r\n"));
+    return state < AX_TX_STATE_DRAIN;
+}
+
+bool Radio::finishTransmit()
+{
+    if ((_tx_job.state != AX_TX_STATE_IDLE) && (_tx_job.state < AX_TX_STATE_DRAIN)) return false;  //still loading
     
-    ax_tx_packet(&config, &modulation, txqueue, txbufflen);
-    digitalWrite(_pin_PAENABLE, HIGH);  //this instruction order is experimental!
+    //radio busy will only show idle as long as it's in FULLTX
+    _tx_job.state = AX_TX_STATE_DRAIN;
+    if (radioBusy() == 1) return false;  //the last frame is still going out, try again next pass
+
+    _tx_job.state = AX_TX_STATE_TURNAROUND;
+    LOG_NOTICE("current power state: %X\r\n", get_power_state());
+    setReceive();
+    _tx_job.state = AX_TX_STATE_IDLE;
+    return true;
 }
 
+// a frame can be streamed into the current burst if we're still transmitting the last one and there's
+// room in the FIFO for its first chunk.  Checking the room first keeps the frame from sitting in PREAMBLE.
+bool Radio::burstReady(int txbufflen)
+{
+    AX_HW_OP(AX_HW_OP_STATUS);
+    if (get_power_state() != AX_PWRMODE_FULLTX) return false;
+    if ((_tx_job.state != AX_TX_STATE_IDLE) && (_tx_job.state < AX_TX_STATE_DRAIN)) return false;  //last one isn't all in yet
+    if ((ax_RADIOSTATE(&config) & 0x0F) == AX_RADIOSTATE_IDLE) return false;
+
+    int first_chunk = txbufflen % AX_TX_MAX_CHUNK;  //matches the chunking in ax_tx_packet_step
+    return ax_FIFOFREE(&config) >= (first_chunk + 17);
+}
+
+// preamble (or the short burst sync), the frame, and a few bytes of sync word and flags.  FEC doubles it
+unsigned long Radio::airtime(int txbufflen, bool continuation)
+{
+    if (modulation.bitrate == 0) return 0;
+    uint32_t bits = (txbufflen + (continuation ? constants::burst_sync_length : constants::preamble_length) + 4) * 8;
+    if (modulation.fec) bits *= 2;
+    return (bits * 1000 + modulation.bitrate - 1) / modulation.bitrate;
+}
+
+// also feeds the rate controller: every decoded packet, and every one the decoder gave up on
 bool Radio::receive()
 {
-    if (ax_rx_packet(&config, &rx_pkt, &modulation) == 1) return true;
-    else return false;
+    bool received = (ax_rx_packet(&config, &rx_pkt, &modulation) == 1);
+    while (_bad_packets != rx_pkt.bad_packets)
+    {
+        _bad_packets++;
+        rate_control.failed();
+    }
+    if (!received) return false;
+    // the packet's RSSI is the same register byte the noise floor is made of (ratecontrol.h)
+    int noise = noise_floor.floor();
+    rate_control.received((noise < 0) ? RATE_NO_MARGIN : (rx_pkt.rssi & 0xFF) - noise, rx_pkt.rs_corrections, millis());
+    return received;
 }
 
 void Radio::clear_Radio_FIFO()
 {
-    Log.trace(F("clearing the AX5043 FIFO\r\n")); // may be unnecessary...may have unintended consequences?
+    LOG_TRACE(F("clearing the AX5043 FIFO\r\n")); // may be unnecessary...may have unintended consequences?
     //TODO: perhaps create a radio.reset function?  there is a procedure for it.
     ax_fifo_clear(&config);
 }
@@ -524,20 +757,20 @@ void Radio::clear_Radio_FIFO()
 void Radio::setSynthA()  //directly set the Tx synth to be active
 {
     ax_SET_SYNTH_A(&config);
-    Log.notice(F("Synth A set\r\n"));
+    LOG_NOTICE(F("Synth A set\r\n"));
 } 
 
 void Radio::setSynthB()  //directly set the Rx synth to be active
 {
     ax_SET_SYNTH_B(&config);
-    Log.notice(F("Synth B set\r\n"));
+    LOG_NOTICE(F("Synth B set\r\n"));
 }
 
 uint8_t Radio::getSynth()  //returns which synth is selected.  0 for Tx, 1 for Rx, 2 for error
 {
   uint8_t selected_synth = ax_hw_read_register_8(&config, AX_REG_PLLLOOP);
-  Log.trace(F("selected synth (register): %X\r\n"), selected_synth);
-  Log.trace(F("A or B?: %X\r\n"), selected_synth & 0x80);
+  LOG_TRACE(F("selected synth (register): %X\r\n"), selected_synth);
+  LOG_TRACE(F("A or B?: %X\r\n"), selected_synth & 0x80);
   if ((selected_synth & 0x80) == 0x80) return 1;  //it's 0x80, so it's set for B = Rx
   else return 0;  //it's a zero, so it's set for A = Tx
 }  
@@ -550,69 +783,48 @@ uint16_t Radio::getRegValue(int register_int)
 //this is for debugging so we can see the radio parameter settings
 void Radio::printParamStruct()
 {
-    Log.verbose("rx_bandwidth: %X \r\n", modulation.par.rx_bandwidth);
-    Log.verbose("f_baseband: %X \r\n", modulation.par.f_baseband);
-    Log.verbose("if_frequency: %X \r\n", modulation.par.if_frequency);
-    Log.verbose("iffreq: %X \r\n", modulation.par.iffreq);
-    Log.verbose("decimation: %X \r\n", modulation.par.decimation);
-    Log.verbose("ampl_filter: %X \r\n", modulation.par.ampl_filter);
-    Log.verbose("match1_threashold: %X \r\n", modulation.par.match1_threashold);
-    Log.verbose("match0_threashold: %X \r\n", modulation.par.match0_threashold);
-    Log.verbose("pkt_misc_flags: %X \r\n", modulation.par.pkt_misc_flags);
-    Log.verbose("tx_pll_boost_time: %X \r\n", modulation.par.tx_pll_boost_time);
-    Log.verbose("tx_pll_settle_time: %X \r\n", modulation.par.tx_pll_settle_time);
-    Log.verbose("rx_pll_boost_time: %X \r\n", modulation.par.rx_pll_boost_time);
-    Log.verbose("rx_pll_settle_time: %X \r\n", modulation.par.rx_pll_settle_time);
-    Log.verbose("rx_coarse_agc: %X \r\n", modulation.par.rx_coarse_agc);
-    Log.verbose("rx_agc_settling: %X \r\n", modulation.par.rx_agc_settling);
-    Log.verbose("rx_rssi_settling: %X \r\n", modulation.par.rx_rssi_settling);
-    Log.verbose("preamble_1_timeout: %X \r\n", modulation.par.preamble_1_timeout);
-    Log.verbose("preamble_2_timeout: %X \r\n", modulation.par.preamble_2_timeout);
-    Log.verbose("rssi_abs_thr: %X \r\n", modulation.par.rssi_abs_thr);
-    Log.verbose("perftuning_option: %X \r\n", modulation.par.perftuning_option);
+    LOG_VERBOSE("rx_bandwidth: %X \r\n", modulation.par.rx_bandwidth);
+    LOG_VERBOSE("f_baseband: %X \r\n", modulation.par.f_baseband);
+    LOG_VERBOSE("if_frequency: %X \r\n", modulation.par.if_frequency);
+    LOG_VERBOSE("iffreq: %X \r\n", modulation.par.iffreq);
+    LOG_VERBOSE("decimation: %X \r\n", modulation.par.decimation);
+    LOG_VERBOSE("ampl_filter: %X \r\n", modulation.par.ampl_filter);
+    LOG_VERBOSE("match1_threashold: %X \r\n", modulation.par.match1_threashold);
+    LOG_VERBOSE("match0_threashold: %X \r\n", modulation.par.match0_threashold);
+    LOG_VERBOSE("pkt_misc_flags: %X \r\n", modulation.par.pkt_misc_flags);
+    LOG_VERBOSE("tx_pll_boost_time: %X \r\n", modulation.par.tx_pll_boost_time);
+    LOG_VERBOSE("tx_pll_settle_time: %X \r\n", modulation.par.tx_pll_settle_time);
+    LOG_VERBOSE("rx_pll_boost_time: %X \r\n", modulation.par.rx_pll_boost_time);
+    LOG_VERBOSE("rx_pll_settle_time: %X \r\n", modulation.par.rx_pll_settle_time);
+    LOG_VERBOSE("rx_coarse_agc: %X \r\n", modulation.par.rx_coarse_agc);
+    LOG_VERBOSE("rx_agc_settling: %X \r\n", modulation.par.rx_agc_settling);
+    LOG_VERBOSE("rx_rssi_settling: %X \r\n", modulation.par.rx_rssi_settling);
+    LOG_VERBOSE("preamble_1_timeout: %X \r\n", modulation.par.preamble_1_timeout);
+    LOG_VERBOSE("preamble_2_timeout: %X \r\n", modulation.par.preamble_2_timeout);
+    LOG_VERBOSE("rssi_abs_thr: %X \r\n", modulation.par.rssi_abs_thr);
+    LOG_VERBOSE("perftuning_option: %X \r\n", modulation.par.perftuning_option);
+}
+
+void Radio::sampleChannel()
+{
+    if (!noise_floor.due(millis())) return;
+    noise_floor.sample(rssi(), millis());
 }
 
+// nothing is read here, it's the readings sampleChannel already took.  The noise floor sets the threshold, and
+// _CCA_threshold is the most it can be
 bool Radio::assess_channel(int rxlooptimer)
 {
-    // this is now a delay, not an averaging scheme.  Original implementation wasn't really averaging either because loop was resetting the first measurement
-    // could retain the last one in a global and continually update it with the current average..but lets see if this works.
-    if ((micros() - rxlooptimer) > constants::tx_delay)
-    {
-        //this could be overkill, might just need to throw out the first one, trying a max hold approach
-        int num_readings = 5;
-        int measurement_interval {500};
-        uint8_t max_rssi{0};
-        for (int i=0; i<num_readings; i++)
-        {
-          uint8_t rssi_value = rssi();
-          if (rssi_value > max_rssi) max_rssi = rssi_value;
-          delayMicroseconds(measurement_interval);          
-        }
-
-        byte rssi = max_rssi;  //rssi is the maximum reading of num_readings
-        //could these be happening too fast to give a valid answer?  right now set to 2mS
-        //if (rssi < constants::clear_threshold) Log.trace("assessed rssi: %i \r\n", rssi);
-        if (rssi > _CCA_threshold)
-        {
-            rxlooptimer = micros();
-            //Log.trace("channel not clear \r\n");
-            Log.trace(F("rssi (>thresh): %X\r\n"), rssi);
-            return false;
-        }
-        else 
-        {
-            //Log.notice("max when clear: %X\r\n", max_rssi);
-            if (max_rssi == 0) Log.notice("max is zero \r\n");
-            return true;
-        }
-    }
-    else return false;  // timer hasn't expired
+    if ((micros() - rxlooptimer) <= csma.txDelay()) return false;  // TXDELAY hasn't gone by
+    if (noise_floor.clear(_CCA_threshold)) return true;
+    LOG_TRACE(F("rssi (>thresh): %X, floor %i\r\n"), noise_floor.recent(), noise_floor.floor());
+    return false;
 }
 
 void Radio::set_cca_threshold(byte threshold)
 {
     _CCA_threshold = threshold;
-    Log.notice(F("set new threshold\r\n"));
+    LOG_NOTICE(F("set new threshold\r\n"));
 }
   
 byte Radio::get_cca_threshold()
@@ -23,6 +23,12 @@ send the morse characters.
 #include "constants.h"
 #include "efuse.h"
 #include "ExternalWatchdog.h"
+#include "afc.h"
+#include "doppler.h"
+#include "ratecontrol.h"
+#include "channel.h"
+#include "csma.h"
+#include "arq.h"
 #include <Temperature_LM75_Derived.h>
 #include <FlashStorage.h>
 #include <ArduinoLog.h>
@@ -35,7 +41,9 @@ public:
   Radio(int TX_RX_pin, int RX_TX_pin, int PA_enable_pin, int SYSCLK_pin, int AX5043_DCLK_pin, int AX5043_DATA_pin, int PIN_LED_TX_pin, int IRQ_pin);
 
   void begin(void (*spi_transfer)(unsigned char *, uint8_t), 
-    int operating_frequency, FlashStorageClass<byte> &clear_threshold);
+    int operating_frequency, FlashStorageClass<byte> &clear_threshold,
+    FlashStorageClass<ax_vco_cache> &vco_cache,
+    void (*spi_transfer_async)(unsigned char *, uint16_t, void (*)(void)) = NULL);
   
   void beaconMode();  //ASK mode to send out the satellite beacon
   void key(int chips, Efuse &efuse); // chips is the number of time segments (ASK bit times as defined by constants::bit_time) that you want to key a 1
@@ -46,21 +54,37 @@ public:
   void setReceive();
   int setTransmitFrequency(int frequency);
   int setReceiveFrequency(int frequency);
-  void transmit(byte *txqueue, int txbufflen);
+  void transmit(byte *txqueue, int txbufflen, bool continuation = false);  //starts loading the frame, transmitStep does the rest
+  bool transmitStep();  //loads more of the frame if there's room in the FIFO, never waits.  true while it's still loading
+  bool finishTransmit();  //drain and turnaround, true once it's back in receive.  false while the last frame is still going out
+  bool burstReady(int txbufflen); //true if the next frame can be appended to the burst that's on the air
+  unsigned long airtime(int txbufflen, bool continuation);  //ms a frame takes to send at the current bitrate
   bool receive();
 
   int getTransmitFrequency();
   int getReceiveFrequency();
+  void trackFrequency(int32_t rffreqoffs);  //afc, call with the RF offset of each received packet
+  FrequencyTracker afc;
+  bool startDoppler(const char *body);  //loads a schedule and ranges the synths for its first point, false if it won't do
+  void stopDoppler(bool restore = true);  //and back to the frequencies from before the schedule, unless new ones are coming
+  void serviceDoppler();  //runs the doppler schedule, call it between packets in receive
+  DopplerSchedule doppler;
+  void setRate(int index);  //quick switch between the IL2P rates (RATE_4800, RATE_9600), receive only
+  int modeRate();  //which of those we're on, -1 if it's some other mode
+  RateController rate_control;
+  LinkArq arq;  //numbers the data frames and sends the lost ones again, the loop drives it
 
   void cwMode(uint32_t duration, ExternalWatchdog &watchdog);  //used for testing
   
   //misc utility functions
   size_t reportstatus(String &response, Efuse &efuse, bool fault);
   int radioBusy();
+  bool receiving();  //sync detected, a packet is coming in
   uint8_t rssi();
   void clear_Radio_FIFO();
   uint16_t getRegValue(int register);
   void printParamStruct();
+  void saveVCOCache();  //writes new ranging results to flash
   int get_power_state();
   
   //these are all used by the AX library so have to remain public
@@ -74,7 +98,10 @@ public:
   uint8_t getSynth();  //returns which synth is selected.  0 for Tx, 1 for Rx
 
   //clear channel assessment
+  void sampleChannel();  //one RSSI reading when it's time for one, call it every pass in receive (see channel.h)
   bool assess_channel(int rxlooptimer);
+  NoiseFloor noise_floor;
+  ChannelAccess csma;  //p-persistence and the KISS parameters, the loop asks it once assess_channel says clear
   void set_cca_threshold(byte threshold);
   byte get_cca_threshold();
 
@@ -90,6 +117,17 @@ private:
   int _pin_IRQ;
   byte _CCA_threshold;
   pinfunc_t _func{2}; // definition of wire vs data mode
+  FlashStorageClass<ax_vco_cache> *_vco_cache_storage{nullptr};
+  int _tx_frequency{constants::frequency};  //as set, before afc
+  int _rx_frequency{constants::frequency};
+  int32_t txCorrection();
+  unsigned long _doppler_update{0};  //millis() of the last doppler schedule update
+  int _nominal_tx_frequency{0};  //what to go back to when the schedule's over, 0 if there isn't one running
+  int _nominal_rx_frequency{0};
+  ax_tx_job _tx_job{};  //the frame being loaded into the FIFO (or draining)
+  byte _tx_packet[512];  //the frame has to stay put until it's all in the FIFO
+  ax_modulation _rate_modulation[RATE_COUNT];  //params worked out in begin, so a rate switch is just register writes
+  uint16_t _bad_packets{0};  //last rx_pkt.bad_packets we saw
 
 };
 
@@ -0,0 +1,190 @@
+/**
+* @file ratecontrol.cpp
+* @author Tom Conrad (tom@silversat.org)
+* @brief Link-adaptive choice between the 4800 and 9600 IL2P modes
+* @version 1.0.1
+* @date 2026-10-19
+
+ratecontrol.cpp - Link-adaptive choice between the 4800 and 9600 IL2P modes
+Created by Tom Conrad, October 19, 2026.
+Released into the public domain.
+
+*/
+
+#include "ratecontrol.h"
+#include "log_levels.h"
+#define LOG_MODULE_MAX LOG_MAX_RADIO
+
+void RateController::begin(int rate, unsigned long now_ms)
+{
+  if (_rate >= 0 && rate != _rate) _switches++;
+  _rate = rate;
+  _count = 0;
+  _next = 0;
+  _requested = -1;
+  _tries = 0;
+  _accepted = -1;
+  _accept_sent = false;
+  _switch_to = -1;
+  _last_switch = now_ms;
+  _last_heard = now_ms;
+}
+
+void RateController::push(Sample sample)
+{
+  int window = min(constants::rate_window, RATE_WINDOW_MAX);
+  _window[_next] = sample;
+  _next = (_next + 1) % window;
+  if (_count < window) _count++;
+}
+
+void RateController::received(int16_t margin, uint8_t rs_corrections, unsigned long now_ms)
+{
+  push({margin, rs_corrections, false});
+  _last_heard = now_ms;
+}
+
+void RateController::failed()
+{
+  push({0, 0, true});
+}
+
+void RateController::tally(int &failures, int &good, int &measured, int32_t &margin, int &corrections)
+{
+  failures = 0;
+  good = 0;
+  measured = 0;
+  margin = 0;
+  corrections = 0;
+  for (int i = 0; i < _count; i++)
+  {
+    if (_window[i].failed) failures++;
+    else
+    {
+      good++;
+      corrections += _window[i].corrections;
+      if (_window[i].margin == RATE_NO_MARGIN) continue;
+      measured++;
+      margin += _window[i].margin;
+    }
+  }
+}
+
+// averages are compared as totals (x good, or x measured for the margin) so there's no dividing
+bool RateController::degraded()
+{
+  int failures, good, measured, corrections;
+  int32_t margin;
+  tally(failures, good, measured, margin, corrections);
+  if (failures >= constants::rate_down_failures) return true;
+  if (good == 0) return false;
+  return (corrections >= constants::rate_down_corrections * good) || ((measured > 0) && (margin < (int32_t)constants::rate_down_margin * measured));
+}
+
+// going up needs every packet's margin
+bool RateController::clean()
+{
+  int failures, good, measured, corrections;
+  int32_t margin;
+  tally(failures, good, measured, margin, corrections);
+  if (_count < min(constants::rate_window, RATE_WINDOW_MAX) || failures > 0 || measured < good) return false;
+  return (corrections <= constants::rate_up_corrections * good) && (margin >= (int32_t)constants::rate_up_margin * measured);
+}
+
+int RateController::wanted()
+{
+  if (_rate > RATE_4800 && degraded()) return _rate - 1;
+  if (_rate < RATE_COUNT - 1 && clean()) return _rate + 1;
+  return _rate;
+}
+
+int RateController::request(unsigned long now_ms)
+{
+  if (!constants::rate_adaptive || !active()) return -1;
+  if (_accepted >= 0 || _switch_to >= 0) return -1;  //already agreed on one
+
+  if (_requested >= 0)
+  {
+    if (now_ms - _request_time < constants::rate_reply_timeout) return -1;
+    if (_tries >= constants::rate_retries)
+    {
+      LOG_NOTICE(F("rate: no answer to request for %d, staying put\r\n"), _requested);
+      _requested = -1;
+      _last_switch = now_ms;  //hold off before trying again
+      return -1;
+    }
+    _tries++;
+    _request_time = now_ms;
+    return _requested;
+  }
+
+  if (now_ms - _last_switch < constants::rate_holdoff) return -1;
+  int rate = wanted();
+  if (rate == _rate) return -1;
+
+  LOG_NOTICE(F("rate: asking to go from %d to %d\r\n"), _rate, rate);
+  _requested = rate;
+  _tries = 1;
+  _request_time = now_ms;
+  return rate;
+}
+
+int RateController::control(const byte *body, int length, byte *reply, unsigned long now_ms)
+{
+  if (length < 2) return 0;
+  byte op = body[0];
+  int rate = body[1] - '0';
+  if (rate < 0 || rate >= RATE_COUNT) return 0;
+
+  if (op == 'R')
+  {
+    reply[1] = body[1];
+    // going down is always fine, going up isn't if what we're hearing says otherwise
+    if (!constants::rate_adaptive || !active() || (rate > _rate && degraded()))
+    {
+      LOG_NOTICE(F("rate: refusing %d\r\n"), rate);
+      reply[0] = 'N';
+      return 2;
+    }
+    LOG_NOTICE(F("rate: accepting %d\r\n"), rate);
+    reply[0] = 'A';
+    if (rate != _rate)
+    {
+      _accepted = rate;
+      _accept_sent = false;
+      _requested = -1;  //theirs wins
+    }
+    return 2;
+  }
+  if (op == 'A' && rate == _requested)
+  {
+    _switch_to = rate;
+    _requested = -1;
+  }
+  else if (op == 'N' && rate == _requested)
+  {
+    LOG_NOTICE(F("rate: peer refused %d\r\n"), rate);
+    _requested = -1;
+    _last_switch = now_ms;
+  }
+  return 0;
+}
+
+void RateController::transmitted()
+{
+  if (_accepted >= 0) _accept_sent = true;
+}
+
+// only call this in receive, so an accept we've sent is already on the air
+int RateController::due(unsigned long now_ms)
+{
+  if (!constants::rate_adaptive || !active()) return -1;
+  if (_switch_to >= 0) return _switch_to;
+  if (_accepted >= 0 && _accept_sent) return _accepted;
+  if (_rate > RATE_4800 && (now_ms - _last_heard > constants::rate_silence_timeout))
+  {
+    LOG_NOTICE(F("rate: nothing heard, dropping back\r\n"));
+    return RATE_4800;
+  }
+  return -1;
+}
@@ -0,0 +1,98 @@
+/**
+* @file ratecontrol.h
+* @author Tom Conrad (tom@silversat.org)
+* @brief Link-adaptive choice between the 4800 and 9600 IL2P modes
+* @version 1.0.1
+* @date 2026-10-19
+
+ratecontrol.h - Link-adaptive choice between the 4800 and 9600 IL2P modes
+Created by Tom Conrad, October 19, 2026.
+Released into the public domain.
+
+9600 moves twice the data on a good pass, 4800 has 3 dB more margin at low elevation.  This watches the last
+constants::rate_window received packets (signal over the noise floor, symbols the RS decoder had to fix, and packets
+lost to RS or CRC failures) and decides which one we should be on.  Down is quick (a couple of failures, lots of corrections or a weak
+signal), up needs a whole window of clean, strong packets, and after any switch we sit still for rate_holdoff.
+
+Both ends have to change together, so the switch is agreed with a control frame (KISS command byte
+constants::rate_control_code, never passed to the serial ports):
+
+  'R' <rate>   request, sent at the current rate
+  'A' <rate>   accept.  The accepting end switches once the transmit session carrying this is done,
+               the requesting end switches when it hears it
+  'N' <rate>   refused (it wants to go up and we're seeing a bad link)
+
+rate is '0' for 4800, '1' for 9600.  If the accept is lost the two ends are on different rates, so an end that's
+above 4800 and hasn't decoded anything for rate_silence_timeout drops back on its own.  They meet at 4800.
+An idle link ends up at 4800 that way too, and comes back up once traffic shows the link is good.
+
+The signal is the packet's RSSI less the noise floor from channel.h, both the raw RSSI register (1 dB a count).
+The register has no offset calibration (RSSIREFERENCE isn't set), so it isn't dBm, but the offset is the same in both
+and cancels.  Until the first noise floor block is done there's no margin, and only corrections and failures count.
+
+It's off by default (constants::rate_adaptive) until the margins have been checked against a real pass.
+
+Radio owns the modes and does the actual switch (Radio::setRate).
+*/
+
+#ifndef RATECONTROL_H
+#define RATECONTROL_H
+
+#include "Arduino.h"
+#include "constants.h"
+#include "ArduinoLog.h"
+
+#define RATE_4800 0
+#define RATE_9600 1
+#define RATE_COUNT 2
+#define RATE_WINDOW_MAX 16
+#define RATE_NO_MARGIN INT16_MIN  // received() without a noise floor to measure from
+
+class RateController {
+public:
+  void begin(int rate, unsigned long now_ms);  //rate we're on now, -1 if it's not one of ours (adaptation is off)
+
+  void received(int16_t margin, uint8_t rs_corrections, unsigned long now_ms);  //a good packet, RSSI counts over the noise floor
+  void failed();  //a packet lost to RS or CRC failure
+
+  int request(unsigned long now_ms);  //a rate to ask the peer for (including retries), -1 if there's nothing to ask
+  int control(const byte *body, int length, byte *reply, unsigned long now_ms);  //control frame from the peer, fills in reply and returns its length (0 for none)
+  void transmitted();  //a control frame went into the transmitter
+  int due(unsigned long now_ms);  //a rate to switch to right now, -1 if not
+
+  int rate() { return _rate; }
+  bool active() { return _rate >= 0; }
+  uint16_t switches() { return _switches; }
+
+private:
+  int wanted();  //what the window says, same as _rate if it's happy
+  bool degraded();  //bad enough to go down
+  bool clean();  //a full window good enough to go up
+  void tally(int &failures, int &good, int &measured, int32_t &margin, int &corrections);
+
+  struct Sample
+  {
+    int16_t margin;
+    uint8_t corrections;
+    bool failed;
+  };
+
+  void push(Sample sample);
+
+  Sample _window[RATE_WINDOW_MAX];
+  int _count{0};
+  int _next{0};
+
+  int _rate{-1};
+  int _requested{-1};  //outstanding request
+  int _tries{0};
+  unsigned long _request_time{0};
+  int _accepted{-1};  //we've accepted, switch after sending the 'A'
+  bool _accept_sent{false};
+  int _switch_to{-1};  //the peer accepted ours
+  unsigned long _last_switch{0};
+  unsigned long _last_heard{0};
+  uint16_t _switches{0};
+};
+
+#endif
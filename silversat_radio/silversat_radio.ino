@@ -26,8 +26,8 @@
  * some of these are a guess at the moment and probably way too large.
  * delay values are available for the time to wait after setting T/R lines and time to allow PA to stabilize
  * pa_delay is time to wait after switching off the PA (only used when switching to receive)
- * tx_delay is the delay before switching from RX to TX.  Once it switches, it sends a packet immediately.
- * clear_threshold is the threshold to declare the channel clear
+ * tx_delay is the delay before switching from RX to TX (the default KISS TXDELAY).  After that it's p-persistent CSMA, see csma.h
+ * clear_threshold is the most the threshold to declare the channel clear can be.  The threshold itself follows the noise floor (channel.h)
  * mtu_size is the mtu size defined in tnc attach.  There are 4 additional bytes for the TUN interface header.  That is all transmitted, since it's within the KISS frame on Serial interface
  * The serial interface is KISS encoded.  When prepped for transmit the processor removes the KISS formatting, but retains the KISS command byte
  * The radio adds 2 additional CRC bytes (assuming we're using HDLC and on of the two 16 bit CRCs), except in reed-solomon mode or when using RAW framing
@@ -83,6 +83,14 @@ extern char *__brkval;
 #include "radio.h"
 #include "stats.h"
 #include "PTT.h"
+#include "spi_dma.h"
+#include "eventlog.h"
+#include "txqueue.h"
+#include "aggregate.h"
+#include "headercomp.h"
+#include "lz.h"
+#include "erasure.h"
+#include "flashqueue.h"
 
 // the AX library
 #include "ax.h"
@@ -93,6 +101,8 @@ extern char *__brkval;
 #include <FlashStorage.h>
 #include <Temperature_LM75_Derived.h>
 #include <ArduinoLog.h>
+#include "log_levels.h"
+#define LOG_MODULE_MAX LOG_MAX_MAIN
 #include  "il2p.h"
 #include "il2p_crc.h"
 #include "FastCRC.h"
@@ -100,19 +110,30 @@ extern char *__brkval;
 #include "PTT.h"
 
 #define CMDBUFFSIZE 512   // this buffer can be smaller because we control the rate at which packets come in
-#define DATABUFFSIZE 8192 // how many packets do we need to buffer at most during a TCP session?
+#define DATABUFFSIZE 4096 // how many packets do we need to buffer at most during a TCP session?  The flash store takes the rest
 #define TXBUFFSIZE 512   // at most 4 256-byte packets, but if storing Packet class objects, need to figure out how big they are
 
 // globals, basically things that need to be retained for each iteration of loop()
 
 CircularBuffer<byte, CMDBUFFSIZE> cmdbuffer;
-CircularBuffer<byte, DATABUFFSIZE> databuffer;
+CircularBuffer<byte, DATABUFFSIZE> databuffer;  //Serial1 comes in here, and it's the bulk data queue
+CircularBuffer<byte, PRIORITYBUFFSIZE> priorityqueues[TXQ_BULK];  //control, relay, repeat and interactive, see txqueue.h
+CircularBuffer<byte, PRIORITYBUFFSIZE> &relaybuffer = priorityqueues[TXQ_RELAY];
 CircularBuffer<byte, TXBUFFSIZE> txbuffer;  //txbuffer should only hold decoded kiss packets (255 bytes max), probably packet class objects
 
 Packet datapacket;
 
 int cmdpacketsize{0}; // really the size of the first packet in the buffer  Should think about whether or not these could be local vs. global
-int datapacketsize{0};
+int datapacketsize{0};  // the first frame waiting in the highest priority queue that has one, then the one being encoded
+int queued[TXQ_COUNT]{};  // size of the first frame in each transmit queue
+TxScheduler tx_scheduler;
+HeaderCompressor header_compressor;  // TCP/IP headers both ways (headercomp.h)
+ErasureEncoder erasure_encoder;  // bulk transfers from Serial1 (erasure.h)
+ErasureDecoder erasure_decoder;  // and from the other end
+int tx_queue{-1};  // the queue the frame in the txbuffer came from
+byte kisspacket[512];  // and the frame as it was, so it can go back on its queue if something more important comes in
+int kisspacketsize{0};
+int serial1_frame_bytes{0};  // since the last FEND on Serial1
 //int txbufflen{0}; // size of next packet in buffer
 
 // three state variables
@@ -125,6 +146,9 @@ bool board_reset{true};   // Detects is the board was reset. It is set to true i
 // timing
 // unsigned int lastlooptime {0};  //for timing the loop (debug)
 unsigned int rxlooptimer{0}; // for determining the delay before switching modes (part of CCA)
+int burst_frames{0}; // frames sent in the current transmit session
+unsigned long session_airtime{0}; // ms of frames queued in the current transmit session, limited to constants::tx_session_budget
+unsigned long data_in_time{0}; // millis() of the last byte in on Serial1, a frame still coming in holds the transmit session
 
 Generic_LM75_10Bit tempsense(0x4B);
 
@@ -132,10 +156,17 @@ ExternalWatchdog watchdog(WDTICK);
 Efuse efuse(Current_5V, OC5V, Reset_5V);
 
 Radio radio(TX_RX, RX_TX, PAENABLE, SYSCLK, AX5043_DCLK, AX5043_DATA, PIN_LED_TX, IRQ);
+SpiDma spi_dma(SERCOM4, SELBAR);  // FIFO bursts to the AX5043 go by DMA, on the SERCOM the SPI library uses
 //DataPacket txpacket[8];  //these are not KISS encoded...unwrapped
 Command command;
 
 FlashStorage(clear_threshold, byte);
+FlashStorage(vco_cache, ax_vco_cache);  // VCO ranging results, so frequency and mode changes can skip ranging
+// the store and forward queue's flash.  Zeros after programming like the ones above, it gets erased as it's used
+__attribute__((__aligned__(256))) static const byte store_region[FLASHQUEUE_SIZE] = {};
+FlashQueue flash_queue(store_region);  // Serial1 data between passes (flashqueue.h)
+unsigned long heard_time{0};  // millis() of the last frame from the other end, for link_up()
+bool heard{false};
 byte clearthreshold{constants::clear_threshold};
 
 volatile int reset_interrupt{0};
@@ -177,8 +208,10 @@ void setup()
     // LOG_LEVEL_SILENT, LOG_LEVEL_FATAL, LOG_LEVEL_ERROR, LOG_LEVEL_WARNING, LOG_LEVEL_INFO, LOG_LEVEL_TRACE, LOG_LEVEL_VERBOSE
     // Note: if you want to fully remove all logging code, uncomment #define DISABLE_LOGGING in Logging.h
     //       this will significantly reduce your project size
+    // Note: the driver, packet and loop code is also capped per module at compile time (log_levels.h, NOTICE by default),
+    //       so going to TRACE or VERBOSE here needs the cap for that module raised too
 
-    //if (SERIAL_BUFFER_SIZE != 1024) Log.error(F("Serial buffer size is too small.  Modify RingBuffer.h \r\n"));
+    //if (SERIAL_BUFFER_SIZE != 1024) LOG_ERROR(F("Serial buffer size is too small.  Modify RingBuffer.h \r\n"));
 
     // at first start the value stored in flash will be zero.  Need to update it to the default frequency and go from there
 
@@ -189,6 +222,12 @@ void setup()
 
     clearthreshold = clear_threshold.read();
 
+    // whatever was stored and hadn't gone out before the reset
+    flash_queue.begin();
+    while (flash_queue.prepare()) watchdog.trigger();  // erasing's only done with Serial1 quiet, and it hasn't started yet
+    stats.store_waiting = flash_queue.frames();
+    if (!flash_queue.empty()) LOG_NOTICE(F("%i frames in the store\r\n"), flash_queue.frames());
+
     // define spi select and serial port differential drivers
     pinMode(SELBAR, OUTPUT); // select for the AX5043 SPI bus
     pinMode(EN0, OUTPUT);    // enable serial port differential driver
@@ -203,7 +242,7 @@ void setup()
 
     //reset indicator
     int state{0};
-    Log.notice(F("**********BOARD RESET*********\r\n"));
+    LOG_NOTICE(F("**********BOARD RESET*********\r\n"));
     for (int i=0; i<5; i++)
         {
             digitalWrite(PIN_LED_TX, state);
@@ -213,21 +252,25 @@ void setup()
 
 
     // start SPI, configure and start up the radio
-    Log.notice(F("starting up the radio\r\n"));
+    LOG_NOTICE(F("starting up the radio\r\n"));
     SPI.begin();
-    SPI.beginTransaction(SPISettings(5000000, MSBFIRST, SPI_MODE0)); // these settings seem to work, but not optimized
+    SPI.beginTransaction(SPISettings(constants::spi_clock, MSBFIRST, SPI_MODE0));
+    spi_dma.begin();
 
-    radio.begin(wiring_spi_transfer, constants::frequency, clear_threshold);
+    radio.begin(wiring_spi_transfer, constants::frequency, clear_threshold, vco_cache, wiring_spi_transfer_async);
 
     radio.printParamStruct();  //only if log level > verbose
 
+    // the two ends can't make the same CSMA draws, so seed from the chip serial number (and whatever the noise is)
+    randomSeed(*(volatile uint32_t *)0x0080A00C ^ *(volatile uint32_t *)0x0080A040 ^ radio.rssi());
+
 #ifdef SILVERSAT
     // start the I2C interface and the debug serial port
     Wire.begin();
 
     // query the temp sensor
     float patemp = tempsense.readTemperatureC();
-    Log.verbose(F("temperature of PA: %F\r\n"), patemp);
+    LOG_VERBOSE(F("temperature of PA: %F\r\n"), patemp);
     
 #endif
 
@@ -248,6 +291,8 @@ void setup()
     //il2p_testing();
     //while(1);
     
+    paint_stack();
+    LOG_NOTICE(F("free memory: %i\r\n"), freeMemory());
     loop_timer.restart();
 }
 
@@ -257,9 +302,9 @@ void loop()
     if (loop_time > stats.max_loop_time) 
     {
         stats.max_loop_time = loop_time;
-        //Log.notice("new max loop time: %lu \r\n", max_loop_time);
+        //LOG_NOTICE("new max loop time: %lu \r\n", max_loop_time);
     }
-    //if (stats.max_loop_time > 1500000) Log.warning(F("loop time over 1.5 seconds\r\n"));
+    //if (stats.max_loop_time > 1500000) LOG_WARNING(F("loop time over 1.5 seconds\r\n"));
     loop_timer.restart();
 
 #ifdef COMMANDS_ON_DEBUG_SERIAL
@@ -269,7 +314,7 @@ void loop()
         cmdbuffer.push(Serial.read()); // we add data coming in to the tail...what's at the head is the oldest packet
         if (cmdbuffer.isFull())
         {
-            Log.error(F("ERROR: CMD BUFFER OVERFLOW\r\n")); // to date, have never seen this (or the data version) ever happen.
+            LOG_ERROR(F("ERROR: CMD BUFFER OVERFLOW\r\n")); // to date, have never seen this (or the data version) ever happen.
         }
     }
 #endif
@@ -280,200 +325,263 @@ void loop()
     if (serial0_bytes > stats.max_buffer_load_s0) stats.max_buffer_load_s0 = serial0_bytes;
     while (Serial0.available() > 0)
     {
-        // Log.trace("%i\r\n", serial0_bytes);
+        // LOG_TRACE("%i\r\n", serial0_bytes);
         cmdbuffer.push(Serial0.read()); // we add data coming in to the tail...what's at the head is the oldest packet
         if (cmdbuffer.size() > stats.max_commandbuffer_load) stats.max_commandbuffer_load = cmdbuffer.size();
-        if (cmdbuffer.isFull()) Log.error(F("ERROR: CMD BUFFER OVERFLOW\r\n")); 
+        if (cmdbuffer.isFull()) LOG_ERROR(F("ERROR: CMD BUFFER OVERFLOW\r\n")); 
     }
 
     int serial1_bytes = Serial1.available();
-    if (serial1_bytes > 0) Log.trace("data in serial1 buffer\r\n");
+    if (serial1_bytes > 0) LOG_TRACE("data in serial1 buffer\r\n");
     if (serial1_bytes > stats.max_buffer_load_s1) stats.max_buffer_load_s1 = serial1_bytes;  //tracking max buffer load
 
     // data, put it into its own buffer
     while (Serial1.available() > 0)
     {
-        if (Serial1.available() > 350) Log.error(F("SERIAL BUFFER OVERFLOW"));
-        databuffer.push(Serial1.read()); // we add data coming in to the tail...what's at the head is the oldest packet delimiter
+        if (Serial1.available() > 350) LOG_ERROR(F("SERIAL BUFFER OVERFLOW"));
+        byte data = Serial1.read();
+        data_in_time = millis();
+        databuffer.push(data); // we add data coming in to the tail...what's at the head is the oldest packet delimiter
+        stats.latency.serialByte(data, databuffer.size());
+        if (data != constants::FEND) serial1_frame_bytes++;
+        else
+        {
+            if (serial1_frame_bytes > 0) route_serial1_frame(serial1_frame_bytes + 2);  // that one's complete, it might not be bulk
+            serial1_frame_bytes = 0;
+        }
         if (databuffer.size() > stats.max_databuffer_load) stats.max_databuffer_load = databuffer.size(); //tracking max buffer load
-        if (databuffer.isFull()) Log.error(F("ERROR: DATA BUFFER OVERFLOW\r\n"));
+        if (databuffer.isFull()) LOG_ERROR(F("ERROR: DATA BUFFER OVERFLOW\r\n"));
+    }
+
+    // the store's flash work, a page at a time now that Serial1's empty, and a row erased only when it's been quiet a while
+    if (flash_queue.service((serial1_frame_bytes == 0) && (millis() - data_in_time >= constants::store_idle)))
+    {
+        stats.store_waiting = flash_queue.frames();
+        stats.store_erases = flash_queue.erases;
+        stats.store_max_stall = flash_queue.max_stall;
     }
 
     // process the command buffer first - processbuff returns the size of the first packet in the buffer, returns 0 if none 
     cmdpacketsize = processbuff(cmdbuffer);
 
     //  error if buffer is growing out of bounds and no packet detected
-    if (cmdpacketsize == 0 && cmdbuffer.size() > 255) Log.error(F("buffer processing error!!!"));
+    if (cmdpacketsize == 0 && cmdbuffer.size() > 255) LOG_ERROR(F("buffer processing error!!!"));
 
     unsigned long time_to_cmd = process_timer.elapsed();
-    //Log.verbose("cmd buff processing time: %u \r\n", time_to_cmd);
+    //LOG_VERBOSE("cmd buff processing time: %u \r\n", time_to_cmd);
 
-    if (cmdpacketsize > 0) Log.verbose("command packet size: %i \r\n", cmdpacketsize);
+    if (cmdpacketsize > 0) LOG_VERBOSE("command packet size: %i \r\n", cmdpacketsize);
 
-    // process the databuffer - see note above about changing the flow
-    datapacketsize = processbuff(databuffer);
-    if (datapacketsize > 0) Log.verbose("datapacketsize: %i \r\n", datapacketsize);
+    // frames the other end didn't get go in the repeat queue (arq.h), one at a time since they're all nearly full size
+    if (arq_on())
+    {
+        radio.arq.service(millis());
+        queue_arq_repeats();
+    }
+
+    // process the transmit queues - see note above about changing the flow
+    for (int i = 0; i < TXQ_BULK; i++) queued[i] = processbuff(priorityqueues[i]);
+    int databuffer_size = databuffer.size();
+    queued[TXQ_BULK] = processbuff(databuffer);
+    if (databuffer.size() != databuffer_size) stats.latency.shifted(TXQ_BULK, databuffer_size - databuffer.size(), databuffer.size());  // junk in front of the packet
+    queued[TXQ_STORE] = link_up() ? flash_queue.peekLength() : 0;  // what's in flash goes once the other end can hear it (flashqueue.h)
+    if (arq_on() && !radio.arq.room()) queued[TXQ_INTERACTIVE] = queued[TXQ_BULK] = queued[TXQ_STORE] = 0;  // new data waits for acknowledgments (arq.h)
+    datapacketsize = 0;
+    for (int i = 0; (i < TXQ_COUNT) && (datapacketsize == 0); i++) datapacketsize = queued[i];
+    if (datapacketsize > 0) LOG_VERBOSE("datapacketsize: %i \r\n", datapacketsize);
 
     //  error if buffer is growing out of bounds and no packet detected
-    if (datapacketsize == 0 && databuffer.size() > 255) Log.error(F("buffer processing error!!!"));  
+    if (queued[TXQ_BULK] == 0 && databuffer.size() > 255) LOG_ERROR(F("buffer processing error!!!"));  
 
     //measure max interface handler time
     processing_time = process_timer.elapsed();
-    //Log.verbose("data buff processing time: %u\r\n", processing_time - time_to_cmd);
+    //LOG_VERBOSE("data buff processing time: %u\r\n", processing_time - time_to_cmd);
     if (processing_time > stats.max_interface_handler_execution_time) stats.max_interface_handler_execution_time = processing_time;
 
     //-------------end interface handler--------------
 
     //------------begin data processor----------------
 
-    // only run this if there is a complete packet in the buffer, AND the data buffer is empty or the last byte in it is 0xC0...this is to sync writes from cmdbuffer into databuffer
+    // only run this if there is a complete packet in the buffer, and room for it in the relay queue in case it's for the other end
     process_timer.restart();
-    if ((cmdpacketsize != 0 && databuffer.isEmpty()) || (cmdpacketsize != 0 && (databuffer.last() == constants::FEND)))
+    if ((cmdpacketsize != 0) && ((int)relaybuffer.available() >= cmdpacketsize))
     {
-        Log.notice(F("command received\r\n"));
-        // processcmdbuff() looks at the command code, and if its for the other end, pushes it to the data buffer
+        LOG_NOTICE(F("command received\r\n"));
+        // processcmdbuff() looks at the command code, and if its for the other end, pushes it to the relay queue
         // otherwise it pulls the packet out of the buffer and sticks it into a cmdpacket structure. (that allows for more complex parsing if needed/wanted)
         Packet cmdpacket;
         cmdpacket.packetlength = cmdpacketsize;
 
         int freemem = freeMemory();
         if (freemem < stats.free_mem_minimum) stats.free_mem_minimum = freemem;
+        stats.stack_headroom = stack_headroom();  // up to date for print stats
 
-        bool command_in_buffer = cmdpacket.processcmdbuff(cmdbuffer, databuffer);
-        // for commandcodes of 0x00 or 0xAA, it takes the packet out of the command buffer and writes it to the data buffer
-        if (command_in_buffer) command.processcommand(databuffer, cmdpacket, watchdog, efuse, radio, fault, 
+        bool command_in_buffer = cmdpacket.processcmdbuff(cmdbuffer, relaybuffer);
+        // for commandcodes of 0x00 or 0xAA, it takes the packet out of the command buffer and writes it to the relay queue
+        if (command_in_buffer) command.processcommand(databuffer, relaybuffer, cmdpacket, watchdog, efuse, radio, fault, 
             constants::frequency, clear_threshold, clearthreshold, board_reset, stats);
         // once the command has been completed the Packet instance goes out of scope and is deleted
     }
 
+    // something more important came in behind the frame waiting in the txbuffer, so that one goes back on its queue (txqueue.h)
+    if ((txbuffer.size() != 0) && tx_scheduler.preempts(tx_queue, queued) && put_back_frame(tx_queue, kisspacket, kisspacketsize))
+    {
+        LOG_TRACE(F("putting a frame back on queue %i\r\n"), tx_queue);
+        txbuffer.clear();
+        header_compressor.forget();  // the other end isn't going to see the headers it had
+        radio.arq.unsend();  // or its sequence number
+        stats.latency.shifted(tx_queue, -kisspacketsize, queue_size(tx_queue));  // its own trace is lost, the rest move back
+        queued[tx_queue] = kisspacketsize;
+        tx_queue = -1;
+    }
+
     // prepare a packet for transmit
     if (datapacketsize != 0)
     {
-        // Log.notice("there's something in the data buffer (datapacketsize !=0)\r\n");
+        // LOG_NOTICE("there's something in the data buffer (datapacketsize !=0)\r\n");
         uint32_t ax25_tx_crc_encoded;
 
         if (txbuffer.size() == 0) // just doing the next packet to keep from this process from blocking too much
         {
-            Log.trace(F("txbuffer size is zero\r\n"));
+            LOG_TRACE(F("txbuffer size is zero\r\n"));
             // we need to keep the complete KISS packet together in order to unwrap it, but we can pull the command code out
-            byte kisspacket[512]; //prepare to pull the packet out of the buffer...I re-opted for a fixed array size, so it did not have to get dynamically resized.
+            // kisspacket is a fixed array (I re-opted for a fixed array size, so it did not have to get dynamically resized), global so the frame can be put back
             unsigned char parity_data[16];
             unsigned char parity_header[2];
             unsigned char il2p_header_scrambled[13];
             unsigned char il2p_data[constants::max_packet_size];
             
-            // REMOVE the data from the databuffer...no going backsies
-            for (int i = 0; i < datapacketsize; i++) kisspacket[i] = databuffer.shift();
+            // REMOVE the data from its queue...backsies only if something more important comes in before it's on the air
+            tx_queue = tx_scheduler.pick(queued);
+            datapacketsize = queued[tx_queue];
+            kisspacketsize = datapacketsize;
+            take_frame(tx_queue, kisspacket, datapacketsize);
+            stats.latency.frameTaken(tx_queue, datapacketsize, queue_size(tx_queue));
 
             datapacket.packetlength = kiss_unwrap(kisspacket, datapacketsize, datapacket.packetbody); // kiss_unwrap returns the size of the new buffer and creates the decoded packet
-            Log.trace(F("unwrapped packet size: %i \r\n"), datapacket.packetlength);
+            LOG_TRACE(F("unwrapped packet size: %i \r\n"), datapacket.packetlength);
+            // TCP/IP headers as changes from the last frame in the connection (headercomp.h).  With ARQ on, only if it'll
+            // be numbered (compressing makes it one longer at most), or it could get there out of order with ones that are
+            bool numbered = !arq_on() || (datapacket.packetlength + 1 + ARQ_HEADER <= ARQ_FRAME_MAX);
+            if (constants::header_compression && (radio.modulation.il2p_enabled == 1) && numbered) datapacket.packetlength = compress_headers(datapacket.packetbody, datapacket.packetlength, sizeof(datapacket.packetbody));
+            // then the rest of it, if that makes it shorter (lz.h)
+            if (constants::payload_compression && (radio.modulation.il2p_enabled == 1)) datapacket.packetlength = compress_payload(datapacket.packetbody, datapacket.packetlength);
+            // small data frames behind this one in the interactive queue can share its IL2P frame (aggregate.h)
+            if (constants::aggregate_frames && (radio.modulation.il2p_enabled == 1) && (tx_queue == TXQ_INTERACTIVE)) aggregate_frames();
+            // and whatever it's come to gets a sequence number, so it can go again if it's lost (arq.h)
+            // (a repeat that's been acknowledged since it was queued is dropped, the txbuffer stays empty for the next one)
+            bool dropped = arq_on() && !arq_frame();
             datapacket.commandcode = datapacket.packetbody[0];
             /*
-            for (int i=0; i<datapacket.packetlength; i++) Log.trace("%X", datapacket.packetbody[i]);
-            Log.trace("\r\n");
+            for (int i=0; i<datapacket.packetlength; i++) LOG_TRACE("%X", datapacket.packetbody[i]);
+            LOG_TRACE("\r\n");
             */
 
             //okay, now that we have the decoded packet, we need to compute the il2p header (assuming that il2p is turned on) and prepend that to the data
             //then we need to RS encode that (using the il2p encoder, so again, only if il2p is enabled)
 
-            if (radio.modulation.il2p_enabled == 1)
+            if (!dropped && (radio.modulation.il2p_enabled == 1))
             {
                 int il2p_payload_length = datapacket.packetlength - 1;  //this is just for readability
-                Log.trace(F("Payload length in header: %X\r\n"), il2p_payload_length);
+                LOG_TRACE(F("Payload length in header: %X\r\n"), il2p_payload_length);
                 //compute the il2p header
-                Log.trace(F("construct IL2P packet\r\n"));
+                LOG_TRACE(F("construct IL2P packet\r\n"));
                 //unsigned char il2p_header_precoded[13]{0xEB, 0xE3, 0x53, 0x76, 0x76, 0x77, 0x6B, 0x23, 0x53, 0x36, 0x76, 0x77, 0x10};  //for KC3VVW
                 unsigned char il2p_header_precoded[13]{0xF7, 0xF0, 0x52, 0x78, 0x67, 0x77, 0x77, 0x30, 0x52, 0x38, 0x67, 0x77, 0x10};  //for WP2XGW
                 //we're not including the command byte in the payload, but it's in datapacket.packetbody, so there's bunch of +/-1's here and there
                 for (int i=2; i<12; i++) il2p_header_precoded[i] |= ((il2p_payload_length >> (11-i)) & 0x01) << 7;
 
                 //scramble it
-                Log.trace(F("scrambling header\r\n"));
+                LOG_TRACE(F("scrambling header\r\n"));
                 il2p_scramble_block(il2p_header_precoded, il2p_header_scrambled, 13);
-                Log.verbose(F("scrambled header: \r\n"));
-                for (int i = 0; i < 13; i++) Log.verbose("%X, ", il2p_header_scrambled[i]);
-                Log.verbose("\r\n");
+                LOG_VERBOSE(F("scrambled header: \r\n"));
+                if (LOG_ON(LOG_LEVEL_VERBOSE)) for (int i = 0; i < 13; i++) LOG_VERBOSE("%X, ", il2p_header_scrambled[i]);
+                LOG_VERBOSE("\r\n");
 
                 //now encode it
-                Log.trace(F("encoding header\r\n"));
+                LOG_TRACE(F("encoding header\r\n"));
                 //il2p_encode_rs(il2p_header_scrambled, header_size, parity_size, parity);
                 il2p_encode_rs(il2p_header_scrambled, 13, 2, parity_header);
-                Log.verbose(F("parity:\r\n"));
-                for (int i = 0; i < 2; i++)  Log.verbose("%X, ", parity_header[i]);   
+                LOG_VERBOSE(F("parity:\r\n"));
+                if (LOG_ON(LOG_LEVEL_VERBOSE)) for (int i = 0; i < 2; i++)  LOG_VERBOSE("%X, ", parity_header[i]);   
                 
                 //now we get to add the data...yay!
                 //scramble the block
-                Log.trace(F("scrambling data\r\n"));
+                LOG_TRACE(F("scrambling data\r\n"));
                 il2p_scramble_block(datapacket.packetbody+1, il2p_data, il2p_payload_length); //taking out the command code byte
                 IL2P_CRC il2p_crc;
                 uint16_t ax25_tx_crc = il2p_crc.calculate_AX25(datapacket.packetbody+1, il2p_payload_length);
-                //for (int i = 1; i < il2p_payload_length+1; i++)  Log.notice("%X, ", datapacket.packetbody[i]);   //print out the packet body
-                //Log.notice("\r\n");
-                //Log.notice("AX25 CRC (TX) = %X\r\n", ax25_tx_crc);
+                //for (int i = 1; i < il2p_payload_length+1; i++)  LOG_NOTICE("%X, ", datapacket.packetbody[i]);   //print out the packet body
+                //LOG_NOTICE("\r\n");
+                //LOG_NOTICE("AX25 CRC (TX) = %X\r\n", ax25_tx_crc);
                 ax25_tx_crc_encoded = il2p_crc.encode_crc(ax25_tx_crc);
 
                 //now encode that
-                Log.trace(F("encoding data\r\n"));
+                LOG_TRACE(F("encoding data\r\n"));
                 il2p_encode_rs(il2p_data, il2p_payload_length, 16, parity_data);
                 datapacket.packetlength += 31; //16 parity bytes + 15 header bytes
             }
 
-            if (radio.modulation.il2p_enabled == 1)
+            if (dropped) LOG_TRACE(F("arq: dropped a repeat that's been acknowledged\r\n"));
+            else if (radio.modulation.il2p_enabled == 1)
             {   
-                Log.trace(F("initial txbuffer size: %i\r\n"), txbuffer.size());
+                LOG_TRACE(F("initial txbuffer size: %i\r\n"), txbuffer.size());
                 unsigned char il2p_framing[3]{0xF1, 0x5E, 0x48};
                 
                 //re-add the command byte
-                Log.trace(F("adding the command byte\r\n"));
+                LOG_TRACE(F("adding the command byte\r\n"));
                 txbuffer.push(datapacket.commandcode);
 
                 //first the framing bytes
-                Log.trace(F("adding on the IL2P framing bytes\r\n"));
+                LOG_TRACE(F("adding on the IL2P framing bytes\r\n"));
                 for (int i=0; i< 3; i++) txbuffer.push(il2p_framing[i]);
                 datapacket.packetlength += 3; //add the three bytes to the total
                 
                 //next the header
-                Log.trace(F("pushing the IL2P header\r\n"));
+                LOG_TRACE(F("pushing the IL2P header\r\n"));
                 for (int i = 0; i < 13; i++) txbuffer.push(il2p_header_scrambled[i]);
 
                 //next the header parity
-                Log.trace(F("pushing the IL2P header parity\r\n"));
+                LOG_TRACE(F("pushing the IL2P header parity\r\n"));
                 for (int i = 0; i < 2; i++) txbuffer.push(parity_header[i]);
 
                 //next the data (scrambled)
-                Log.trace(F("pushing the IL2P data\r\n"));
+                LOG_TRACE(F("pushing the IL2P data\r\n"));
                 for (int i = 0; i < (datapacket.packetlength-1)-3-31; i++) txbuffer.push(il2p_data[i]); //one less because of the command byte, three less for the framing
 
                 //and add the parity next
-                Log.trace(F("pushing the IL2P data parity\r\n"));
+                LOG_TRACE(F("pushing the IL2P data parity\r\n"));
                 for (int i = 0; i < 16; i++)
                 {
-                    // Log.notice(("%X , %X\r\n"), i, parity_data[i]);
+                    // LOG_NOTICE(("%X , %X\r\n"), i, parity_data[i]);
                     txbuffer.push(parity_data[i]);
                 }
                 //here is where we can add the CRC
-                uint8_t crc_buffer[255];
-                txbuffer.copyToArray(crc_buffer);
-                IL2P_CRC il2p_crc;
-                Log.verbose(F("first buffer byte: %X\r\n"), *(crc_buffer+4));  //don't include the cmd and framing bytes = 4
-                Log.verbose(F("last buffer byte: %X\r\n"), *(crc_buffer+txbuffer.size()-1));
+                if (LOG_ON(LOG_LEVEL_VERBOSE))  //the copy is only for this
+                {
+                    uint8_t crc_buffer[255];
+                    txbuffer.copyToArray(crc_buffer);
+                    LOG_VERBOSE(F("first buffer byte: %X\r\n"), *(crc_buffer+4));  //don't include the cmd and framing bytes = 4
+                    LOG_VERBOSE(F("last buffer byte: %X\r\n"), *(crc_buffer+txbuffer.size()-1));
+                }
                 
-                Log.trace(F("pushing the IL2P CRC\r\n"));
-                Log.trace(F("Tx CRC: %X\r\n"), ax25_tx_crc_encoded);
+                LOG_TRACE(F("pushing the IL2P CRC\r\n"));
+                LOG_TRACE(F("Tx CRC: %X\r\n"), ax25_tx_crc_encoded);
                 txbuffer.push((uint8_t)((ax25_tx_crc_encoded & 0xFF000000)>>24));
                 txbuffer.push((uint8_t)((ax25_tx_crc_encoded & 0x00FF0000)>>16));
                 txbuffer.push((uint8_t)((ax25_tx_crc_encoded & 0x0000FF00)>>8));
                 txbuffer.push((uint8_t)(ax25_tx_crc_encoded & 0x000000FF));
                 datapacket.packetlength += 4;
-                //Log.verbose(F("Buffered Packet \r\n"));
-                //for (int i=0; i<txbuffer.size(); i++) Log.verbose(F("Index: %d  Data: %X \r\n"), i, txbuffer[i]);
+                //LOG_VERBOSE(F("Buffered Packet \r\n"));
+                //for (int i=0; i<txbuffer.size(); i++) LOG_VERBOSE(F("Index: %d  Data: %X \r\n"), i, txbuffer[i]);
             }
             else
             {
                 // push the unwrapped packet onto the tx buffer
-                Log.notice(F("pushing packet into txbuffer\r\n"));
+                LOG_NOTICE(F("pushing packet into txbuffer\r\n"));
                 for (int i = 0; i < datapacket.packetlength; i++) txbuffer.push(datapacket.packetbody[i]);
             }   
+            if (!dropped) stats.latency.encoded();
         }
     }
 
@@ -485,38 +593,61 @@ void loop()
     process_timer.restart();
     if (transmit == true)
     {
-        // Log.notice("reset interrupt: %X\r\n", reset_interrupt);
+        // LOG_NOTICE("reset interrupt: %X\r\n", reset_interrupt);
         if (reset_interrupt == 1)
         {
             digitalWrite(PAENABLE, LOW); // turn off the PA
             digitalWrite(PIN_LED_TX, LOW);
             //read the register to clear the interrupt
             ax_hw_read_register_16(&radio.config, AX_REG_RADIOEVENTREQ);
-            Log.verbose("clearing the interrupt\r\n");
+            LOG_VERBOSE("clearing the interrupt\r\n");
             reset_interrupt = 0;
         }
+        // the last frame goes into the FIFO a chunk at a time as there's room, nothing here waits on the radio
+        bool loading = radio.transmitStep();
         int busy_radio{radio.radioBusy()};
-        //Log.notice(F("radio busy?: %X\r\n"), busy_radio);
+        //LOG_NOTICE(F("radio busy?: %X\r\n"), busy_radio);
+
+        // a session carries as many frames as fit in the airtime budget (the first one always goes).  It stays up while
+        // the next frame is still coming in on Serial1, tncattach tends to send a whole TCP window at once
+        bool next_fits = (txbuffer.size() != 0) && ((burst_frames == 0) ||
+            (session_airtime + radio.airtime(datapacket.packetlength, busy_radio == 1) <= constants::tx_session_budget));
+        bool more_coming = (datapacketsize != 0) || (!databuffer.isEmpty() && (millis() - data_in_time < constants::tx_session_hold));
+        bool budget_spent = (session_airtime >= constants::tx_session_budget) || ((txbuffer.size() != 0) && !next_fits);
+
+        if (!loading) stats.latency.committed();  // the first pass that finds it all in the FIFO
 
-        if (datapacketsize == 0 && txbuffer.size() == 0) // datapacketsize should still be nonzero until the buffer is processed again (next loop)
+        if (loading)
         {
-            //radio busy will only show idle as long as it's in FULLTX
-            transmit = false; // change state and we should drop out of loop
-            Log.notice("current power state: %X\r\n", radio.get_power_state());
-            while (busy_radio == 1)
+            // still loading the last frame, come back next pass
+        }
+        // datapacketsize should still be nonzero until the buffer is processed again (next loop)
+        // a session that has used its airtime also drops back to receive once the last frame is out, so we don't hog the channel
+        else if ((txbuffer.size() == 0 && !more_coming) || (budget_spent && busy_radio == 0))
+        {
+            // drain, then turnaround.  finishTransmit is false while the last frame is still on the air
+            unsigned long turnaround_start = micros();
+            if (radio.finishTransmit())
             {
-                busy_radio = radio.radioBusy();
-                //Log.notice(F("radio busy (rx): %X\r\n"), busy_radio);
-
+                unsigned long turnaround_time = micros() - turnaround_start;
+                if (turnaround_time > stats.max_rx_turnaround_time) stats.max_rx_turnaround_time = turnaround_time;
+                transmit = false; // change state and we should drop out of loop
+                stats.latency.sessionDone();
+                rxlooptimer = micros();  // TXDELAY counts from the end of what we sent too
+                event_log.add(EV_FULL_RX, burst_frames);
+                burst_frames = 0;
+                session_airtime = 0;
             }
-            radio.setReceive(); 
-            Log.notice(F("State changed to FULL_RX\r\n"));
         }
-        else if (busy_radio == 0) // radio is idle, so we can transmit a packet, keep this non-blocking if it's active so we can process the next packet
+        // radio is idle, so we can transmit a packet, keep this non-blocking if it's active so we can process the next packet
+        // if it's still sending the last one and there's room in the FIFO, stream this one in behind it (burst) with a short sync instead of a new preamble
+        else if (next_fits && ((busy_radio == 0) || ((busy_radio == 1) && radio.burstReady(datapacket.packetlength))))
         {
-            Log.notice(F("transmitting packet\r\n"));
-            Log.verbose(F("datapacket.packetlength: %i\r\n"), datapacket.packetlength);
-            Log.verbose(F("txbuffer.size: %i\r\n"), txbuffer.size());
+            bool continuation = (busy_radio == 1);
+            session_airtime += radio.airtime(datapacket.packetlength, continuation);
+            event_log.add(continuation ? EV_BURST : EV_TRANSMIT);
+            LOG_VERBOSE(F("datapacket.packetlength: %i\r\n"), datapacket.packetlength);
+            LOG_VERBOSE(F("txbuffer.size: %i\r\n"), txbuffer.size());
             byte txqueue[512];  //allowing for future larger packets
 
             // clear the transmitted packet out of the buffer and stick it in the txqueue
@@ -526,25 +657,31 @@ void loop()
             // TODO: alternatively see if this compiles without recasting the txbuffer and passing it directly.
             //txbuffer.copyToArray(txqueue);  //can't do this, it doesn't empty the buffer...but maybe just clear it?
             for (int i = 0; i < datapacket.packetlength; i++) txqueue[i] = txbuffer.shift();
-            // transmit the decoded buffer, this is blocking except for when the last chunk is committed.
-            // this is because we're sitting and checking the FIFOCOUNT register until there's enough room for the final chunk.
-            radio.transmit(txqueue, datapacket.packetlength);
-            Log.verbose(F("databufflen (post transmit): %i\r\n"), databuffer.size());
-            Log.verbose(F("cmdbufflen (post transmit): %i\r\n"), cmdbuffer.size());
-            Log.verbose(F("datapacket.packetlength (post transmit): %i\r\n"), txbuffer.size());
-
-            if (databuffer.size() > 4096)
+            // start transmitting the decoded buffer.  Whatever doesn't fit in the FIFO yet goes in on later passes (radio.transmitStep)
+            stats.latency.started();
+            radio.transmit(txqueue, datapacket.packetlength, continuation);
+            if (txqueue[0] == constants::rate_control_code) radio.rate_control.transmitted();  // an accept switches us once it's out
+            if (txqueue[0] == constants::aggregate_code) stats.aggregates++;
+            radio.arq.transmitted();
+            if (tx_queue == TXQ_STORE) store_sent();
+            burst_frames++;
+            stats.tx_frames[tx_queue]++;
+            LOG_VERBOSE(F("databufflen (post transmit): %i\r\n"), databuffer.size());
+            LOG_VERBOSE(F("cmdbufflen (post transmit): %i\r\n"), cmdbuffer.size());
+            LOG_VERBOSE(F("datapacket.packetlength (post transmit): %i\r\n"), txbuffer.size());
+
+            if (databuffer.size() > DATABUFFSIZE / 2)
             {
-                Log.warning(F("DATABUFFER at half full\r\n"));
-                Log.warning(F("buffer size: %d\r\n"), databuffer.size());
+                LOG_WARNING(F("DATABUFFER at half full\r\n"));
+                LOG_WARNING(F("buffer size: %d\r\n"), databuffer.size());
             }
-            if (stats.max_buffer_load_s0 > 350)  Log.warning(F("serial0 buffer overflow\r\n"));
-            if (stats.max_buffer_load_s1 > 350)  Log.warning(F("serial1 buffer overflow\r\n"));
-            Log.trace(F("freememory: %d\r\n"),freeMemory());
+            if (stats.max_buffer_load_s0 > 350)  LOG_WARNING(F("serial0 buffer overflow\r\n"));
+            if (stats.max_buffer_load_s1 > 350)  LOG_WARNING(F("serial1 buffer overflow\r\n"));
+            LOG_TRACE(F("freememory: %d\r\n"),freeMemory());
         }
         else if (busy_radio > 1)
         {
-            Log.notice(F("we're in another state somehow!!! %X"), busy_radio);
+            LOG_NOTICE(F("we're in another state somehow!!! %X"), busy_radio);
 
         }
     }
@@ -561,42 +698,71 @@ void loop()
             // rxpacket is the KISS encoded packet, 2x max packet size plus 2 C0
             // currently set for 256 byte packets, but this could be scaled if memory is an issue, who's going to send 256 escape characters?
             byte rxpacket[514];
-            Log.notice(F("got a packet!\r\n"));
-            Log.trace(F("packet length: %i\r\n"), radio.rx_pkt.length); // it looks like the two crc bytes are still being sent (or it's assumed they're there?)
-            Log.trace(F("freememory: %d\r\n"),freeMemory());
+            stats.latency.decoded(radio.rx_pkt.drained);
+            event_log.add(EV_RECEIVED, radio.rx_pkt.length);
+            LOG_TRACE(F("packet length: %i\r\n"), radio.rx_pkt.length); // it looks like the two crc bytes are still being sent (or it's assumed they're there?)
+            LOG_TRACE(F("freememory: %d\r\n"),freeMemory());
             rxlooptimer = micros();
+            heard = true;  // it's a pass, the store can go (flashqueue.h)
+            heard_time = millis();
+            radio.trackFrequency(radio.rx_pkt.rffreqoffs);  // afc
             int rxpacketlength{0};
             // if it's HDLC, then the "address byte" (actually the KISS command byte) is in rx_pkt.data[0], because there's no length byte
             // otherwise it's in rx_pkt.data.  Also HDLC adds the 2 crc bytes, but raw format doesn't have them.  RAW format adds a length byte
             // by default we're sending out data (cmd byte 0x00), if it's 0xAA, then it's a command destined for the base/avoinics endpoint
 
-            //for (int i=0; i<radio.rx_pkt.length;i++) Log.verbose(F("rx data: %d, %X\r\n"), i, radio.rx_pkt.data[i]);
+            //for (int i=0; i<radio.rx_pkt.length;i++) LOG_VERBOSE(F("rx data: %d, %X\r\n"), i, radio.rx_pkt.data[i]);
 
             // So in this case we want the first byte (yes, we do) and we don't want the last 2 (for CRC-16..which hdlc has left for us)
             int command_offset = 1;
             if ((radio.modulation.framing & 0xE) == AX_FRAMING_MODE_HDLC || (radio.modulation.il2p_enabled)) command_offset=0;
             //for il2p, i removed the length byte in ax.cpp
 
-            if (radio.modulation.il2p_enabled)
+            int rxbodylength = radio.rx_pkt.length;
+            if (!radio.modulation.il2p_enabled) rxbodylength = radio.rx_pkt.length-2+command_offset; // remove the 2 extra bytes from the received packet length
+            rxpacketlength = kiss_encapsulate(radio.rx_pkt.data+command_offset, rxbodylength, rxpacket);
+            LOG_TRACE(F("kiss packet length: %d\r\n"),rxpacketlength);
+            LOG_TRACE(F("command byte: %X\r\n"), radio.rx_pkt.data[command_offset]);
+
+            if (radio.rx_pkt.data[command_offset] == constants::rate_control_code)
             {
-                rxpacketlength = kiss_encapsulate(radio.rx_pkt.data+command_offset, radio.rx_pkt.length, rxpacket);
+                // rate control from the other radio (see ratecontrol.h), it stops here
+                byte reply[2];
+                int reply_length = radio.rate_control.control(radio.rx_pkt.data + command_offset + 1, radio.rx_pkt.length - 1, reply, millis());
+                if (reply_length > 0 && !queue_rate_control(reply[0], reply[1])) LOG_NOTICE(F("rate: no room for the reply\r\n"));
             }
-            else
+            else if (radio.rx_pkt.data[command_offset] == constants::erasure_code)
             {
-                rxpacketlength = kiss_encapsulate(radio.rx_pkt.data+command_offset, radio.rx_pkt.length-2+command_offset, rxpacket); // remove the 2 extra bytes from the received packet length
+                // a bulk transfer (erasure.h), out on Serial1 a block at a time
+                erasure_decoder.received(radio.rx_pkt.data + command_offset, rxbodylength, millis());
+                write_erasure_frames();
+                stats.latency.written();
             }
-            Log.trace(F("kiss packet length: %d\r\n"),rxpacketlength);
-            Log.trace(F("command byte: %X\r\n"), radio.rx_pkt.data[command_offset]);
-
-            if (radio.rx_pkt.data[command_offset] != 0xAA) // packet.data is type byte
+            else if (radio.arq.arq(radio.rx_pkt.data[command_offset]))
+            {
+                // numbered frames (arq.h), out on Serial1 in order.  This one might be next, and it might fill a gap
+                int length = radio.arq.received(radio.rx_pkt.data + command_offset, rxbodylength, millis());
+                if (length > 0) receive_data_frame(radio.rx_pkt.data + command_offset + ARQ_HEADER, length);
+                write_held_frames();
+                stats.latency.written();
+            }
+            else if ((radio.rx_pkt.data[command_offset] == constants::aggregate_code) || (data_frame(radio.rx_pkt.data[command_offset]) && (radio.rx_pkt.data[command_offset] != 0x00)))
+            {
+                // several data frames in one (aggregate.h), or one that's been compressed (headercomp.h, lz.h)
+                receive_data_frame(radio.rx_pkt.data + command_offset, rxbodylength);
+                stats.latency.written();
+            }
+            else if (radio.rx_pkt.data[command_offset] != 0xAA) // packet.data is type byte
             {
                 // there are only 2 endpoints, data (Serial1) or command responses (Serial0), rx_pkt is an instance of the ax_packet structure that includes the metadata
                 Serial1.write(rxpacket, rxpacketlength); // so it's data..send it to payload or to the proxy
+                stats.latency.written();
             }
             else
             {
                 // so it's a command response , assumption is first byte of command or response is 0xAA..indicating that it goes to Avionics.
                 Serial0.write(rxpacket, rxpacketlength);
+                stats.latency.written();
                 // duplicate it on Serial
 #ifdef COMMANDS_ON_DEBUG_SERIAL
                 Serial.write(rxpacket, rxpacketlength);
@@ -605,30 +771,49 @@ void loop()
         }
         else
         { // the fifo is empty
-            bool channelclear = radio.assess_channel(rxlooptimer);
-            //Log.notice("channel clear?: %d\r\n", channelclear);
+            stats.latency.receiving(radio.receiving());  // catches the sync, for rx latency
+            radio.sampleChannel();  // background RSSI for the noise floor and CCA
+            radio.serviceDoppler();  // between packets is the time to move the synths
+            // and to change rates
+            int new_rate = radio.rate_control.due(millis());
+            if ((new_rate >= 0) && (radio.radioBusy() == 0)) radio.setRate(new_rate);
+            int wanted_rate = radio.rate_control.request(millis());
+            if (wanted_rate >= 0) queue_rate_control('R', '0' + wanted_rate);
+            // a bulk transfer that's gone quiet gets written out as it is
+            erasure_decoder.service(millis());
+            write_erasure_frames();
+            // frames from behind a gap that's been given up on, and an ack when there's nothing going back for it to ride on (arq.h)
+            if (arq_on())
+            {
+                write_held_frames();
+                if ((datapacketsize == 0) && (txbuffer.size() == 0) && radio.arq.ackDue(millis()) && !queue_arq_ack()) LOG_NOTICE(F("arq: no room for an ack\r\n"));
+            }
             //new idea if we're receiving then the radio state is not going to be in the 0x0C state until it times out
             //may not need a big delay either...or any?
-            if (((datapacketsize != 0) || (txbuffer.size() != 0)) && (radio.radioBusy() == 0) && (channelclear == true))  //when receiving the radio state bounces between 0x0C and 0x0E until it actually starts receiving 0x0F
+            if (((datapacketsize != 0) || (txbuffer.size() != 0)) && (radio.radioBusy() == 0) && radio.assess_channel(rxlooptimer) && radio.csma.persist(micros()))  //when receiving the radio state bounces between 0x0C and 0x0E until it actually starts receiving 0x0F
             //if ((datapacketsize != 0) && channelclear == true )
             {
                 //bool channelclear = radio.assess_channel(rxlooptimer);
-                //Log.notice("channel clear?: %d\r\n", channelclear);
+                //LOG_NOTICE("channel clear?: %d\r\n", channelclear);
                 // there's something in the tx buffers and the channel is clear
-                Log.notice(F("delay %lu\r\n"), micros() - rxlooptimer); // for debug to see what actual delay is
+                unsigned long rx_delay = micros() - rxlooptimer;  // for debug to see what actual delay is
                 rxlooptimer = micros();                                 // reset the receive loop timer to current micros()
+                unsigned long turnaround_start = micros();
                 radio.setTransmit();                  // this also changes the radio.config parameter for the TX path to single ended
-                Log.notice (F("State changed to FULL_TX\r\n"));
+                unsigned long turnaround_time = micros() - turnaround_start;
+                if (turnaround_time > stats.max_tx_turnaround_time) stats.max_tx_turnaround_time = turnaround_time;
+                event_log.add(EV_FULL_TX, rx_delay);
                 ptt.trigger(PTT_flag); //ptt is retriggered when changing state to transmit and when transmitting
                 transmit = true;
             }
+            else if ((datapacketsize == 0) && (txbuffer.size() == 0)) drain_event_log();  // nothing to do, so catch up on the log
         }
     }
 
     //measure max receive handler execution time
     processing_time = process_timer.elapsed();
     if (processing_time > stats.max_receive_handler_execution_time) stats.max_receive_handler_execution_time = processing_time;
-    if (stats.max_receive_handler_execution_time > 1000000) Log.notice(F("execution time greater than 1 sec \r\n"));
+    if (stats.max_receive_handler_execution_time > 1000000) LOG_NOTICE(F("execution time greater than 1 sec \r\n"));
     //-------------end receive handler--------------
     watchdog.trigger(); // I believe it's enough to just trigger the watchdog once per loop.  If it branches to commands, it's handled there.
     fault = efuse.overcurrent(transmit);   
@@ -650,12 +835,389 @@ void wiring_spi_transfer(byte *data, uint8_t length)
     digitalWrite(SELBAR, HIGH); // deselect
 }
 
+// same thing by DMA, returns straight away and done gets called from the DMAC interrupt.  spi_dma does the selects.
+void wiring_spi_transfer_async(byte *data, uint16_t length, void (*done)(void))
+{
+    spi_dma.transfer(data, length, done);
+}
+
+// the deferred log (eventlog.h) only goes out when the loop is idle, and only what the serial buffer takes without
+// waiting.  A few lines a pass so an idle pass stays short too.
+void drain_event_log()
+{
+    char line[EVENT_LOG_LINE];
+    for (int i = 0; (i < 4) && (Serial.availableForWrite() >= EVENT_LOG_LINE) && event_log.next(line); i++) Serial.write(line);
+}
+
+// rate control frames go out ahead of everything else (txqueue.h), the sooner both ends switch the better
+bool queue_rate_control(byte op, byte rate)
+{
+    CircularBuffer<byte, PRIORITYBUFFSIZE> &controlbuffer = priorityqueues[TXQ_CONTROL];
+    if (controlbuffer.available() < 5) return false;
+    controlbuffer.push(constants::FEND);
+    controlbuffer.push(constants::rate_control_code);
+    controlbuffer.push(op);
+    controlbuffer.push(rate);
+    controlbuffer.push(constants::FEND);
+    return true;
+}
+
+// a frame from Serial1 has just been completed at the end of the databuffer.  KISS parameter frames are for us, and
+// small ones go in the interactive queue.  length includes both FENDs
+void route_serial1_frame(int length)
+{
+    int size = databuffer.size();
+    if ((length > size) || (databuffer[size - length] != constants::FEND)) return;
+    if (erasure_frame(length)) return;  // a bulk transfer takes everything
+    if (store_frame(length)) return;  // between passes data goes to flash
+    if (length > constants::interactive_frame_max) return;
+    CircularBuffer<byte, PRIORITYBUFFSIZE> &interactivebuffer = priorityqueues[TXQ_INTERACTIVE];
+    byte frame[256];  // interactive_frame_max is a const, not a constexpr, so this is just big enough
+    if (length > (int)sizeof(frame)) return;
+    for (int i = length - 1; i >= 0; i--) frame[i] = databuffer.pop();
+
+    // TXDELAY, P and SlotTime (see csma.h)
+    if ((frame[1] >= KISS_TXDELAY) && (frame[1] <= KISS_SLOTTIME))
+    {
+        byte parameter[256];
+        if (kiss_unwrap(frame, length, parameter) >= 2) radio.csma.parameter(parameter[0], parameter[1]);
+        databuffer.push(constants::FEND);  // the opening FEND might have been the closing one of the frame before
+        stats.latency.shifted(TXQ_BULK, 0, databuffer.size());  // drops its trace
+    }
+    else if ((int)interactivebuffer.available() >= length)
+    {
+        for (int i = 0; i < length; i++) interactivebuffer.push(frame[i]);
+        databuffer.push(constants::FEND);
+        stats.latency.moved(TXQ_INTERACTIVE, size, interactivebuffer.size());
+    }
+    // no room, so it stays bulk
+    else for (int i = 0; i < length; i++) databuffer.push(frame[i]);
+}
+
+// while a bulk transfer is on, data frames from Serial1 go through the erasure encoder (erasure.h) and it's the packets
+// that go in the databuffer.  The frames that start and stop one stop here too.  false for anything else
+bool erasure_frame(int length)
+{
+    int size = databuffer.size();
+    byte command = databuffer[size - length + 1];
+    if ((command != constants::erasure_code) && ((command != 0x00) || !erasure_encoder.active())) return false;
+    byte frame[512];
+    byte body[sizeof(frame)];
+    if (length > (int)sizeof(frame)) return false;
+    for (int i = length - 1; i >= 0; i--) frame[i] = databuffer.pop();
+    databuffer.push(constants::FEND);  // the opening FEND might have been the closing one of the frame before
+    stats.latency.shifted(TXQ_BULK, 0, databuffer.size());  // drops its trace
+    int body_length = kiss_unwrap(frame, length, body);
+
+    if (command == constants::erasure_code)
+    {
+        if ((body_length < 2) || ((body[1] != 'S') && (body[1] != 'E'))) return true;
+        if (erasure_encoder.active())
+        {
+            erasure_encoder.stop();
+            queue_erasure_packets();
+            LOG_NOTICE(F("bulk transfer sent: %l blocks, %l repair packets\r\n"), erasure_encoder.blocks, erasure_encoder.repairs);
+        }
+        if (body[1] == 'S') erasure_encoder.start((body_length > 2) ? body[2] : constants::erasure_repair);
+        return true;
+    }
+    int offset{1};
+    while (offset < body_length)
+    {
+        int taken = erasure_encoder.write(body + offset, body_length - offset);
+        offset += taken;
+        if ((queue_erasure_packets() == 0) && (taken == 0)) break;
+    }
+    return true;
+}
+
+// the packets the erasure encoder has ready go on the end of the databuffer, returns how many
+int queue_erasure_packets()
+{
+    byte packet[ERASURE_PACKET];
+    byte kissframe[2 * ERASURE_PACKET + 2];
+    int count{0};
+    int length;
+    while ((length = erasure_encoder.next(packet)) > 0)
+    {
+        count++;
+        int kisslength = kiss_encapsulate(packet, length, kissframe);
+        if ((int)databuffer.available() < kisslength - 1)
+        {
+            LOG_ERROR(F("ERROR: DATA BUFFER OVERFLOW\r\n"));
+            continue;
+        }
+        for (int i = 1; i < kisslength; i++) databuffer.push(kissframe[i]);  // there's a FEND in front of it already
+    }
+    stats.erasure_packets += count;
+    return count;
+}
+
+// what the erasure decoder has, out on Serial1, and how the transfer went when it's over
+void write_erasure_frames()
+{
+    byte frame[ERASURE_SYMBOL + 1];
+    int length;
+    while ((length = erasure_decoder.next(frame)) > 0) write_data_frame(frame, length);
+    ErasureReport ended;
+    if (!erasure_decoder.finished(ended)) return;
+    stats.erasure_report = ended;
+    LOG_NOTICE(F("bulk transfer %i received: %l blocks, %l recovered, %l lost, margin %i lowest, %l total\r\n"), ended.transfer, ended.blocks,
+        ended.recovered, ended.lost, ended.margin_min, ended.margin_total);
+}
+
+// the other end has been heard from lately, so it's a pass.  The ground station's always in one as far as it's
+// concerned, it's the satellite that has to wait, and the ground only uses the store when the databuffer's filling up
+bool link_up()
+{
+#ifdef SILVERSAT_GROUND
+    return true;
+#else
+    return heard && (millis() - heard_time < constants::store_link_timeout);
+#endif
+}
+
+// a data frame from Serial1 goes to flash (flashqueue.h) between passes, behind anything that's already there so it
+// all stays in order, and in a pass if the databuffer's half full.  Small ones in a pass are interactive and go live.
+// false if it stays where it is
+bool store_frame(int length)
+{
+    int size = databuffer.size();
+    if (!constants::store_forward || (length > FLASHQUEUE_FRAME_MAX) || (databuffer[size - length + 1] != 0x00)) return false;
+    if (link_up() && ((length <= constants::interactive_frame_max) || (flash_queue.empty() && (size <= DATABUFFSIZE / 2)))) return false;
+    byte frame[FLASHQUEUE_FRAME_MAX];
+    for (int i = length - 1; i >= 0; i--) frame[i] = databuffer.pop();
+    if (!flash_queue.append(frame, length))
+    {
+        // full, so it's the databuffer, like before there was a store
+        for (int i = 0; i < length; i++) databuffer.push(frame[i]);
+        stats.store_full++;
+        return length > constants::interactive_frame_max;
+    }
+    databuffer.push(constants::FEND);  // the opening FEND might have been the closing one of the frame before
+    stats.latency.shifted(TXQ_BULK, 0, databuffer.size());  // drops its trace
+    stats.store_frames++;
+    stats.store_waiting = flash_queue.frames();
+    stats.store_erases = flash_queue.erases;
+    return true;
+}
+
+// the frame from the store is on the air, so it's done with
+void store_sent()
+{
+    flash_queue.acknowledge();
+    stats.store_waiting = flash_queue.frames();
+}
+
+// a data frame or an aggregate of them from the other end
+void receive_data_frame(const byte *frame, int length)
+{
+    if (frame[0] == constants::aggregate_code)
+    {
+        // each goes out on Serial1 as its own KISS frame
+        const byte *subframe;
+        int subframe_length;
+        int offset{0};
+        while ((subframe_length = aggregate_next(frame, length, offset, subframe)) > 0) write_data_frame(subframe, subframe_length);
+        if (subframe_length < 0) LOG_WARNING(F("bad aggregate\r\n"));
+    }
+    else if (data_frame(frame[0])) write_data_frame(frame, length);
+}
+
+// ARQ needs IL2P for the frame size, same as the compression
+bool arq_on()
+{
+    return constants::arq_enabled && (radio.modulation.il2p_enabled == 1);
+}
+
+// the frame in datapacket is about to be encoded.  New data frames from Serial1 get numbered, the ones going again
+// and the acks get the latest acknowledgment for the other direction.  false if it's a repeat that isn't needed now
+bool arq_frame()
+{
+    byte command = datapacket.packetbody[0];
+    if ((tx_queue == TXQ_CONTROL) && (command == constants::arq_ack_code)) datapacket.packetlength = radio.arq.ack(datapacket.packetbody);
+    else if ((tx_queue == TXQ_REPEAT) && (command == constants::arq_data_code)) return radio.arq.resend(datapacket.packetbody, millis());
+    else if (((tx_queue == TXQ_INTERACTIVE) || (tx_queue == TXQ_BULK) || (tx_queue == TXQ_STORE)) && ((command == constants::aggregate_code) || data_frame(command)))
+    {
+        datapacket.packetlength = radio.arq.send(datapacket.packetbody, datapacket.packetlength, sizeof(datapacket.packetbody), millis());
+    }
+    return true;
+}
+
+// frames the other end sent before a lost one, that were waiting for it
+void write_held_frames()
+{
+    byte frame[ARQ_FRAME_MAX];
+    int length;
+    while ((length = radio.arq.next(frame)) > 0) receive_data_frame(frame, length);
+}
+
+// frames that need to go again, while there's room for a full one in the repeat queue
+void queue_arq_repeats()
+{
+    CircularBuffer<byte, PRIORITYBUFFSIZE> &repeatbuffer = priorityqueues[TXQ_REPEAT];
+    byte frame[ARQ_FRAME_MAX];
+    byte kissframe[2 * ARQ_FRAME_MAX + 2];
+    while (repeatbuffer.available() >= sizeof(kissframe))
+    {
+        int length = radio.arq.repeat(frame, millis());
+        if (length == 0) break;
+        int kisslength = kiss_encapsulate(frame, length, kissframe);
+        for (int i = 0; i < kisslength; i++) repeatbuffer.push(kissframe[i]);
+    }
+}
+
+// an ack on its own goes out with the control frames, it's just a placeholder until arq_frame fills it in
+bool queue_arq_ack()
+{
+    CircularBuffer<byte, PRIORITYBUFFSIZE> &controlbuffer = priorityqueues[TXQ_CONTROL];
+    if (controlbuffer.available() < 5) return false;
+    controlbuffer.push(constants::FEND);
+    controlbuffer.push(constants::arq_ack_code);
+    controlbuffer.push(0x00);
+    controlbuffer.push(0x00);
+    controlbuffer.push(constants::FEND);
+    return true;
+}
+
+// packs data frames from the interactive queue in behind the one that's already in datapacket, while they fit.  They
+// come off the queue into kisspacket behind the first one, so if it all gets preempted they go back in order
+void aggregate_frames()
+{
+    CircularBuffer<byte, PRIORITYBUFFSIZE> &interactivebuffer = priorityqueues[TXQ_INTERACTIVE];
+    if (!data_frame(datapacket.packetbody[0])) return;
+    byte aggregate[255];
+    int length = aggregate_add(aggregate, 0, datapacket.packetbody, datapacket.packetlength);
+    int frames{1};
+    while (true)
+    {
+        // processbuff leaves the FEND at the head, so the command byte is [1].  Unwrapping never makes a frame longer,
+        // and header compression makes it one longer at most
+        int next = processbuff(interactivebuffer);
+        if ((next == 0) || (interactivebuffer[1] != 0x00) || !aggregate_fits(length, next - 1)) break;
+        if (kisspacketsize + next > (int)sizeof(kisspacket)) break;
+        take_frame(TXQ_INTERACTIVE, kisspacket + kisspacketsize, next);
+        stats.latency.frameTaken(TXQ_INTERACTIVE, next, interactivebuffer.size());
+        byte frame[255];
+        int frame_length = kiss_unwrap(kisspacket + kisspacketsize, next, frame);
+        if (constants::header_compression) frame_length = compress_headers(frame, frame_length, sizeof(frame));
+        if (constants::payload_compression) frame_length = compress_payload(frame, frame_length);
+        kisspacketsize += next;
+        int added = aggregate_add(aggregate, length, frame, frame_length);
+        if (added == 0) continue;  // an empty frame, it's gone now anyway
+        length = added;
+        frames++;
+    }
+    if (frames == 1) return;
+    memcpy(datapacket.packetbody, aggregate, length);
+    datapacket.packetlength = length;
+    datapacketsize = kisspacketsize;
+    stats.aggregated_frames += frames;
+    LOG_TRACE(F("aggregated %i frames, %i bytes\r\n"), frames, length);
+}
+
+int compress_headers(byte *frame, int length, int size)
+{
+    int compressed = header_compressor.compress(frame, length, size);
+    if (frame[0] == constants::hc_compressed_code) stats.hc_compressed++;
+    stats.hc_saved += length - compressed;
+    return compressed;
+}
+
+// commands for the other end have to get there as they are, so only data frames get compressed
+int compress_payload(byte *frame, int length)
+{
+    if (!data_frame(frame[0])) return length;
+    int packed = lz_pack(frame, length);
+    if (packed != length) stats.lz_frames++;
+    stats.lz_saved += length - packed;
+    return packed;
+}
+
+// for Serial1, however it's been compressed
+bool data_frame(byte command)
+{
+    return (command == 0x00) || header_compressor.compressed(command) || (command == constants::lz_code);
+}
+
+// a data frame from the other end out on Serial1.  LZ (lz.h) is the last thing done to it, so it's the first undone
+void write_data_frame(const byte *frame, int length)
+{
+    byte unpacked[LZ_MAX_INPUT];
+    byte body[255 + HC_HEADER_MAX];
+    byte kissframe[2 * sizeof(body) + 2];
+    if (frame[0] == constants::lz_code)
+    {
+        length = lz_unpack(frame, length, unpacked, sizeof(unpacked));
+        if (length == 0)
+        {
+            stats.lz_dropped++;
+            LOG_NOTICE(F("dropped a bad LZ frame\r\n"));
+            return;
+        }
+        frame = unpacked;
+    }
+    if (frame[0] != 0x00)
+    {
+        length = header_compressor.decompress(frame, length, body, sizeof(body));
+        if (length == 0)
+        {
+            stats.hc_dropped++;
+            LOG_NOTICE(F("dropped a compressed frame\r\n"));
+            return;
+        }
+        frame = body;
+    }
+    int kisslength = kiss_encapsulate((byte *)frame, length, kissframe);
+    Serial1.write(kissframe, kisslength);
+}
+
+// the databuffer is a different size from the other queues, and the store isn't in RAM at all
+int queue_size(int queue)
+{
+    if (queue == TXQ_STORE) return flash_queue.bytes();
+    return (queue == TXQ_BULK) ? databuffer.size() : priorityqueues[queue].size();
+}
+
+// a frame from the store is only looked at, it stays in flash until it's on the air
+void take_frame(int queue, byte *frame, int length)
+{
+    if (queue == TXQ_STORE) flash_queue.peek(frame);
+    else if (queue == TXQ_BULK) txq_take(databuffer, frame, length);
+    else txq_take(priorityqueues[queue], frame, length);
+}
+
+bool put_back_frame(int queue, const byte *frame, int length)
+{
+    if (queue == TXQ_STORE) return true;
+    if (queue == TXQ_BULK) return txq_put_back(databuffer, frame, length);
+    return txq_put_back(priorityqueues[queue], frame, length);
+}
+
 int freeMemory() 
 {
   char top;
   return &top - reinterpret_cast<char*>(sbrk(0));
 }
 
+// freeMemory() only knows where the stack is when it's called.  The free RAM gets painted at the end of setup(), and
+// however much is still paint is what the deepest call since has left
+#define STACK_PAINT 0xA5
+
+void paint_stack()
+{
+  char top;
+  for (char *p = reinterpret_cast<char*>(sbrk(0)); p < &top - 64; p++) *p = STACK_PAINT;
+}
+
+int stack_headroom()
+{
+  char top;
+  char *p = reinterpret_cast<char*>(sbrk(0));
+  while ((p < &top) && (*p == (char)STACK_PAINT)) p++;
+  return p - reinterpret_cast<char*>(sbrk(0));
+}
+
 void ISR()
 {
 //we got an interrupt, so turn off the PA
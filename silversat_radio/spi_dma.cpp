@@ -0,0 +1,130 @@
+/**
+* @file spi_dma.cpp
+* @author Tom Conrad (tom@silversat.org)
+* @brief DMA transfers on the AX5043 SPI bus
+* @version 1.0.1
+* @date 2026-10-19
+
+spi_dma.cpp - DMA transfers on the AX5043 SPI bus
+Created by Tom Conrad, October 19, 2026.
+Released into the public domain.
+
+Channel 0 reads the SERCOM's DATA into the buffer on RXC, channel 1 writes the buffer to DATA on DRE.  The transmit
+side can only get a couple of bytes ahead of the receive side, so doing it in place is safe.
+*/
+
+#include "spi_dma.h"
+
+// the DMAC wants these 16 byte aligned.  Tables for both channels, only used if nothing else set the DMAC up first
+static DmacDescriptor descriptor[SPI_DMA_TX_CHANNEL + 1] __attribute__((aligned(16)));
+static DmacDescriptor writeback[SPI_DMA_TX_CHANNEL + 1] __attribute__((aligned(16)));
+
+static SpiDma *instance{nullptr};
+
+// SERCOMn's triggers are SERCOM0's plus 2n
+static uint8_t trigger(Sercom *sercom, uint8_t sercom0_trigger)
+{
+  Sercom *sercoms[] = SERCOM_INSTS;
+  for (uint8_t i = 0; i < sizeof(sercoms) / sizeof(sercoms[0]); i++)
+  {
+    if (sercoms[i] == sercom) return sercom0_trigger + 2 * i;
+  }
+  return 0;  //software trigger only, a transfer never finishes.  Not a SERCOM, which is a wiring mistake
+}
+
+static void resetChannel(uint8_t channel)
+{
+  DMAC->CHID.reg = DMAC_CHID_ID(channel);
+  DMAC->CHCTRLA.bit.ENABLE = 0;
+  DMAC->CHCTRLA.bit.SWRST = 1;
+  while (DMAC->CHCTRLA.bit.SWRST);
+}
+
+SpiDma::SpiDma(Sercom *sercom, int select_pin)
+{
+  _sercom = sercom;
+  _pin_select = select_pin;
+}
+
+void SpiDma::begin()
+{
+  instance = this;
+
+  // the DMAC is set up once, by whoever gets there first.  A reset now would stop anyone else's transfers
+  if (!DMAC->CTRL.bit.DMAENABLE)
+  {
+    PM->AHBMASK.bit.DMAC_ = 1;
+    PM->APBBMASK.bit.DMAC_ = 1;
+
+    DMAC->CTRL.bit.SWRST = 1;
+    while (DMAC->CTRL.bit.SWRST);
+    DMAC->BASEADDR.reg = (uint32_t)descriptor;
+    DMAC->WRBADDR.reg = (uint32_t)writeback;
+    DMAC->CTRL.reg = DMAC_CTRL_DMAENABLE | DMAC_CTRL_LVLEN(0xF);
+  }
+  _descriptor = (DmacDescriptor *)DMAC->BASEADDR.reg;
+
+  // receive channel, this is the one that says we're done
+  resetChannel(SPI_DMA_RX_CHANNEL);
+  DMAC->CHCTRLB.reg = DMAC_CHCTRLB_LVL(0) | DMAC_CHCTRLB_TRIGSRC(trigger(_sercom, SERCOM0_DMAC_ID_RX)) | DMAC_CHCTRLB_TRIGACT_BEAT;
+  DMAC->CHINTENSET.reg = DMAC_CHINTENSET_TCMPL;
+
+  // transmit channel
+  resetChannel(SPI_DMA_TX_CHANNEL);
+  DMAC->CHCTRLB.reg = DMAC_CHCTRLB_LVL(0) | DMAC_CHCTRLB_TRIGSRC(trigger(_sercom, SERCOM0_DMAC_ID_TX)) | DMAC_CHCTRLB_TRIGACT_BEAT;
+
+  NVIC_SetPriority(DMAC_IRQn, 1);
+  NVIC_EnableIRQ(DMAC_IRQn);
+}
+
+void SpiDma::transfer(unsigned char *data, uint16_t length, void (*done)(void))
+{
+  while (_busy);
+  _busy = true;
+  _done = done;
+
+  // with an incrementing address the DMAC wants the address one past the end
+  _descriptor[SPI_DMA_RX_CHANNEL].BTCTRL.reg = DMAC_BTCTRL_VALID | DMAC_BTCTRL_BEATSIZE_BYTE | DMAC_BTCTRL_DSTINC;
+  _descriptor[SPI_DMA_RX_CHANNEL].BTCNT.reg = length;
+  _descriptor[SPI_DMA_RX_CHANNEL].SRCADDR.reg = (uint32_t)&_sercom->SPI.DATA.reg;
+  _descriptor[SPI_DMA_RX_CHANNEL].DSTADDR.reg = (uint32_t)(data + length);
+  _descriptor[SPI_DMA_RX_CHANNEL].DESCADDR.reg = 0;
+
+  _descriptor[SPI_DMA_TX_CHANNEL].BTCTRL.reg = DMAC_BTCTRL_VALID | DMAC_BTCTRL_BEATSIZE_BYTE | DMAC_BTCTRL_SRCINC;
+  _descriptor[SPI_DMA_TX_CHANNEL].BTCNT.reg = length;
+  _descriptor[SPI_DMA_TX_CHANNEL].SRCADDR.reg = (uint32_t)(data + length);
+  _descriptor[SPI_DMA_TX_CHANNEL].DSTADDR.reg = (uint32_t)&_sercom->SPI.DATA.reg;
+  _descriptor[SPI_DMA_TX_CHANNEL].DESCADDR.reg = 0;
+
+  // anything left over in the receive buffer would end up at the front of ours
+  while (_sercom->SPI.INTFLAG.bit.RXC) (void)_sercom->SPI.DATA.reg;
+
+  digitalWrite(_pin_select, LOW);  // select
+
+  // receive first, so it's ready for the first byte
+  DMAC->CHID.reg = DMAC_CHID_ID(SPI_DMA_RX_CHANNEL);
+  DMAC->CHCTRLA.bit.ENABLE = 1;
+  DMAC->CHID.reg = DMAC_CHID_ID(SPI_DMA_TX_CHANNEL);
+  DMAC->CHCTRLA.bit.ENABLE = 1;
+}
+
+void SpiDma::isr()
+{
+  DMAC->CHID.reg = DMAC_CHID_ID(SPI_DMA_TX_CHANNEL);
+  DMAC->CHINTFLAG.reg = DMAC_CHINTFLAG_MASK;  // no interrupt enabled on this one, just tidy up
+
+  DMAC->CHID.reg = DMAC_CHID_ID(SPI_DMA_RX_CHANNEL);
+  if (DMAC->CHINTFLAG.bit.TCMPL)
+  {
+    DMAC->CHINTFLAG.reg = DMAC_CHINTFLAG_TCMPL;
+    digitalWrite(_pin_select, HIGH);  // deselect
+    _busy = false;
+    // done is allowed to start another transfer (ax_hw chains the FIFO commit this way)
+    if (_done) _done();
+  }
+}
+
+extern "C" void DMAC_Handler(void)
+{
+  if (instance) instance->isr();
+}
@@ -0,0 +1,52 @@
+/**
+* @file spi_dma.h
+* @author Tom Conrad (tom@silversat.org)
+* @brief DMA transfers on the AX5043 SPI bus
+* @version 1.0.1
+* @date 2026-10-19
+
+spi_dma.h - DMA transfers on the AX5043 SPI bus
+Created by Tom Conrad, October 19, 2026.
+Released into the public domain.
+
+The SPI library does a byte at a time with the processor waiting on every one.  For FIFO bursts that's
+most of the time it takes to load a packet.  This runs the same transfer (full duplex, in place, so the status
+and read data come back over the buffer just like SPI.transfer) on two DMA channels and calls done from the
+DMAC interrupt when it's finished.  The chip select is handled here, since it has to go high at the end.
+
+SPI.begin() and SPI.beginTransaction() still set up the SERCOM; this only moves the bytes.  The SERCOM is whichever
+one the board's SPI is on (SERCOM4 on ours), and the DMA triggers are picked to match.
+Don't touch the buffer or do another SPI transfer until done is called.
+
+The DMAC is shared by the whole chip.  begin() only resets and sets it up if nothing has enabled it yet.  If something
+has, its descriptor tables are used, and only this one's two channels are reset.  Those two (SPI_DMA_RX_CHANNEL and
+SPI_DMA_TX_CHANNEL) and DMAC_Handler have to be left to this, the same as with any other DMA library.
+*/
+
+#ifndef SPI_DMA_H
+#define SPI_DMA_H
+
+#include "Arduino.h"
+
+#define SPI_DMA_RX_CHANNEL 0
+#define SPI_DMA_TX_CHANNEL 1
+
+class SpiDma {
+public:
+  SpiDma(Sercom *sercom, int select_pin);
+
+  void begin();
+  void transfer(unsigned char *data, uint16_t length, void (*done)(void));
+  bool busy() { return _busy; }
+
+  void isr();  // called from DMAC_Handler
+
+private:
+  Sercom *_sercom;
+  int _pin_select;
+  DmacDescriptor *_descriptor{nullptr};  //the DMAC's tables, indexed by channel
+  volatile bool _busy{false};
+  void (*_done)(void){nullptr};
+};
+
+#endif
@@ -14,6 +14,9 @@ Released into the public domain.
 #ifndef STATS_H
 #define STATS_H
 
+#include "latency.h"
+#include "erasure.h"
+
 struct Stats
 {
     // process timers
@@ -23,6 +26,10 @@ struct Stats
     unsigned long max_data_processor_execution_time{0};
     unsigned long max_receive_handler_execution_time{0};
 
+    // tx/rx turnaround (setTransmit/setReceive), microseconds
+    unsigned long max_tx_turnaround_time{0};
+    unsigned long max_rx_turnaround_time{0};
+
     // debug variable
     int max_buffer_load_s0{0};
     int max_buffer_load_s1{0};
@@ -32,6 +39,33 @@ struct Stats
 
     // memory tracking
     int free_mem_minimum{32000};
+    int stack_headroom{0};  //bytes the stack has never come down into since setup, see stack_headroom() in the sketch
+
+    // frames sent from each transmit queue (txqueue.h)
+    unsigned long tx_frames[TXQ_COUNT]{};
+    // IL2P frames carrying more than one KISS frame, and the KISS frames in them (aggregate.h)
+    unsigned long aggregates{0};
+    unsigned long aggregated_frames{0};
+    // header compression (headercomp.h): frames sent compressed, bytes that saved, and received ones that couldn't be put back together
+    unsigned long hc_compressed{0};
+    long hc_saved{0};
+    unsigned long hc_dropped{0};
+    // payload compression (lz.h): frames that came out shorter, bytes that saved, received ones that wouldn't decompress
+    unsigned long lz_frames{0};
+    long lz_saved{0};
+    unsigned long lz_dropped{0};
+    // bulk transfers, packets sent and the last one received (erasure.h)
+    unsigned long erasure_packets{0};
+    ErasureReport erasure_report{};
+    // store and forward (flashqueue.h): frames that went to flash, ones that didn't fit, and what's there now
+    unsigned long store_frames{0};
+    unsigned long store_full{0};
+    int store_waiting{0};
+    unsigned long store_erases{0};  //since the reset
+    unsigned long store_max_stall{0};  //us, the longest the processor stopped for the store's flash
+
+    // where the time goes, stage by stage (command 0x22)
+    LatencyTracer latency;
 };
 
 #endif
\ No newline at end of file
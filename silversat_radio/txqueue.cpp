@@ -0,0 +1,49 @@
+/**
+* @file txqueue.cpp
+* @author Tom Conrad (tom@silversat.org)
+* @brief Transmit queues by class, and the scheduler that picks the next frame
+* @version 1.0.1
+* @date 2026-10-19
+
+txqueue.cpp - Transmit queues by class, and the scheduler that picks the next frame
+Created by Tom Conrad, October 19, 2026.
+Released into the public domain.
+
+*/
+
+#include "txqueue.h"
+
+int TxScheduler::pick(const int sizes[TXQ_COUNT])
+{
+  int queue = -1;
+  // anything that's waited long enough, highest priority first
+  for (int i = 0; i < TXQ_COUNT && queue < 0; i++)
+  {
+    if (sizes[i] != 0 && _passed[i] >= constants::tx_starvation_frames) queue = i;
+  }
+  // otherwise strict priority
+  for (int i = 0; i < TXQ_COUNT && queue < 0; i++)
+  {
+    if (sizes[i] != 0) queue = i;
+  }
+  if (queue < 0) return -1;
+  _starved = (_passed[queue] >= constants::tx_starvation_frames);
+
+  for (int i = 0; i < TXQ_COUNT; i++)
+  {
+    if (i == queue || sizes[i] == 0) _passed[i] = 0;
+    else if (_passed[i] < 255) _passed[i]++;
+  }
+  return queue;
+}
+
+bool TxScheduler::preempts(int queue, const int sizes[TXQ_COUNT])
+{
+  // one that was let through for starvation doesn't get bumped
+  if (queue < 0 || _starved) return false;
+  for (int i = 0; i < queue; i++)
+  {
+    if (sizes[i] != 0) return true;
+  }
+  return false;
+}
@@ -0,0 +1,82 @@
+/**
+* @file txqueue.h
+* @author Tom Conrad (tom@silversat.org)
+* @brief Transmit queues by class, and the scheduler that picks the next frame
+* @version 1.0.1
+* @date 2026-10-19
+
+txqueue.h - Transmit queues by class, and the scheduler that picks the next frame
+Created by Tom Conrad, October 19, 2026.
+Released into the public domain.
+
+Everything used to go out through the databuffer in the order it came in, so a relay command from Serial0 could sit
+behind 8 KB of payload data (7 seconds at 9600), and could only be added at all when the databuffer happened to end
+on a FEND.  Now there's a queue per class, highest priority first:
+
+  TXQ_CONTROL       frames the radio makes itself (rate control)
+  TXQ_RELAY         commands and responses for the other end (0xAA, from Serial0 or the callsign command)
+  TXQ_REPEAT        Serial1 frames the other end didn't get, going again (arq.h)
+  TXQ_INTERACTIVE   small frames from Serial1, at most constants::interactive_frame_max bytes KISS encoded
+                    (TCP ACKs, DNS, keystrokes)
+  TXQ_BULK          everything else from Serial1.  This is the databuffer
+  TXQ_STORE         Serial1 data stored in flash between passes, once the other end's heard from (flashqueue.h)
+
+Serial1 bytes all land in the databuffer.  A frame that turns out to be small is moved off the end of it into the
+interactive queue as soon as its closing FEND comes in (or stays put if that queue is full).  The other queues only
+ever get whole frames.
+
+The scheduler is strict priority, except that a queue with a frame waiting that's been passed over
+constants::tx_starvation_frames times in a row goes next, so bulk keeps moving under a steady stream of small stuff.
+A frame that's been encoded but not handed to the radio yet gets put back on its queue if something more important
+comes in, so a command waits for at most the frame that's on the air.
+*/
+
+#ifndef TXQUEUE_H
+#define TXQUEUE_H
+
+#include "Arduino.h"
+#include "constants.h"
+#include <CircularBuffer.hpp>
+
+#ifndef PRIORITYBUFFSIZE
+#define PRIORITYBUFFSIZE 512 // each of the control, relay, repeat and interactive queues
+#endif
+
+enum tx_class
+{
+  TXQ_CONTROL,
+  TXQ_RELAY,
+  TXQ_REPEAT,
+  TXQ_INTERACTIVE,
+  TXQ_BULK,
+  TXQ_STORE,
+  TXQ_COUNT
+};
+
+class TxScheduler {
+public:
+  int pick(const int sizes[TXQ_COUNT]);  //sizes of the first complete frame in each queue (0 for none), returns the queue to take from, -1 if nothing
+  bool preempts(int queue, const int sizes[TXQ_COUNT]);  //true if there's a frame waiting that should go before one from queue
+
+private:
+  uint8_t _passed[TXQ_COUNT]{};  //frames that went ahead of the one waiting in each queue
+  bool _starved{false};  //the last pick was for starvation
+};
+
+// the databuffer is bigger than the others, so these are templates
+template <size_t S>
+void txq_take(CircularBuffer<byte, S> &queue, byte *frame, int length)
+{
+  for (int i = 0; i < length; i++) frame[i] = queue.shift();
+}
+
+// back on the front of the queue, false if it doesn't fit any more
+template <size_t S>
+bool txq_put_back(CircularBuffer<byte, S> &queue, const byte *frame, int length)
+{
+  if ((int)queue.available() < length) return false;
+  for (int i = length - 1; i >= 0; i--) queue.unshift(frame[i]);
+  return true;
+}
+
+#endif